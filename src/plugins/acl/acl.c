@@ -19,6 +19,7 @@
 #include <vnet/plugin/plugin.h>
 #include <acl/acl.h>
 
+#include <vppinfra/random.h>
 #include <vnet/l2/l2_classify.h>
 #include <vnet/classify/input_acl.h>
 #include <vpp/app/version.h>
@@ -173,14 +174,43 @@ vl_api_acl_plugin_control_ping_t_handler (vl_api_acl_plugin_control_ping_t *
   /* *INDENT-ON* */
 }
 
+static void
+acl_rules_free (void *rules)
+{
+  vec_free (rules);
+}
+
+/*
+ * Swap the rules of an ACL the workers may be matching against.
+ * The linear match reads the count and the rules separately, so the
+ * count must never cover more rules than any version it may see has.
+ */
+static void
+acl_rules_replace (vlib_main_t * vm, acl_list_t * a,
+		   acl_rule_t * rules, u32 count)
+{
+  acl_rule_t *old_rules = a->rules;
+
+  a->count = clib_min (a->count, count);
+  vlib_rcu_synchronize (vm);
+  a->rules = rules;
+  CLIB_MEMORY_BARRIER ();
+  a->count = count;
+
+  if (old_rules)
+    vlib_rcu_call (vm, acl_rules_free, old_rules);
+}
+
 static int
 acl_add_list (u32 count, vl_api_acl_rule_t rules[],
 	      u32 * acl_list_index, u8 * tag)
 {
   acl_main_t *am = &acl_main;
+  vlib_main_t *vm = am->vlib_main;
   acl_list_t *a;
   acl_rule_t *r;
   acl_rule_t *acl_new_rules = 0;
+  u8 need_barrier_sync = 0;
   int i;
 
   if (*acl_list_index != ~0)
@@ -235,26 +265,47 @@ acl_add_list (u32 count, vl_api_acl_rule_t rules[],
       r->tcp_flags_mask = rules[i].tcp_flags_mask;
     }
 
+  /*
+   * This runs without the worker barrier. The workers read the ACL pool,
+   * so they are stopped only if it is about to move.
+   */
   if (~0 == *acl_list_index)
     {
       /* Get ACL index */
+      pool_get_aligned_will_expand (am->acls, need_barrier_sync,
+				    CLIB_CACHE_LINE_BYTES);
+      if (need_barrier_sync)
+	vlib_worker_thread_barrier_sync (vm);
       pool_get_aligned (am->acls, a, CLIB_CACHE_LINE_BYTES);
       memset (a, 0, sizeof (*a));
+      if (need_barrier_sync)
+	vlib_worker_thread_barrier_release (vm);
       /* Will return the newly allocated ACL index */
       *acl_list_index = a - am->acls;
+      a->rules = acl_new_rules;
+      a->count = count;
+      memcpy (a->tag, tag, sizeof (a->tag));
+      hash_acl_add (am, *acl_list_index);
     }
   else
     {
+      /*
+       * The hash lookup structures of the interfaces the ACL is applied
+       * on are rebuilt in place, so the workers match linearly until
+       * they are complete.
+       */
+      am->hash_lookup_paused++;
+      vlib_rcu_synchronize (vm);
+
       a = am->acls + *acl_list_index;
       hash_acl_delete (am, *acl_list_index);
-      /* Get rid of the old rules */
-      if (a->rules)
-	vec_free (a->rules);
+      acl_rules_replace (vm, a, acl_new_rules, count);
+      memcpy (a->tag, tag, sizeof (a->tag));
+      hash_acl_add (am, *acl_list_index);
+
+      CLIB_MEMORY_BARRIER ();
+      am->hash_lookup_paused--;
     }
-  a->rules = acl_new_rules;
-  a->count = count;
-  memcpy (a->tag, tag, sizeof (a->tag));
-  hash_acl_add (am, *acl_list_index);
   clib_mem_set_heap (oldheap);
   return 0;
 }
@@ -2259,6 +2310,9 @@ acl_plugin_api_hookup (vlib_main_t * vm)
   foreach_acl_plugin_api_msg;
 #undef _
 
+  /* acl_add_list () keeps the workers running, see there */
+  api_main.is_mp_safe[VL_API_ACL_ADD_REPLACE + am->msg_id_base] = 1;
+
   return 0;
 }
 
@@ -2379,6 +2433,10 @@ acl_sw_interface_add_del (vnet_main_t * vnm, u32 sw_if_index, u32 is_add)
       macip_acl_interface_del_acl (am, sw_if_index);
       acl_interface_reset_inout_acls (sw_if_index, 0);
       acl_interface_reset_inout_acls (sw_if_index, 1);
+      /* the next interface with this index starts with the default mode */
+      if (sw_if_index < vec_len (am->lookup_mode_by_sw_if_index))
+	am->lookup_mode_by_sw_if_index[sw_if_index] =
+	  ACL_LOOKUP_MODE_TSS_PRIORITY;
     }
   return 0;
 }
@@ -2387,6 +2445,48 @@ VNET_SW_INTERFACE_ADD_DEL_FUNCTION (acl_sw_interface_add_del);
 
 
 
+static char *acl_lookup_mode_names[] = {
+  [ACL_LOOKUP_MODE_TSS_PRIORITY] = "tss-priority",
+  [ACL_LOOKUP_MODE_TSS] = "tss",
+  [ACL_LOOKUP_MODE_LINEAR] = "linear",
+};
+
+static u8 *
+format_acl_lookup_mode (u8 * s, va_list * args)
+{
+  acl_lookup_mode_t mode = va_arg (*args, acl_lookup_mode_t);
+
+  if (mode < ACL_N_LOOKUP_MODES)
+    return format (s, "%s", acl_lookup_mode_names[mode]);
+  return format (s, "unknown %d", mode);
+}
+
+static uword
+unformat_acl_lookup_mode (unformat_input_t * input, va_list * args)
+{
+  acl_lookup_mode_t *modep = va_arg (*args, acl_lookup_mode_t *);
+  acl_lookup_mode_t mode;
+
+  for (mode = 0; mode < ACL_N_LOOKUP_MODES; mode++)
+    if (unformat (input, acl_lookup_mode_names[mode]))
+      {
+	*modep = mode;
+	return 1;
+      }
+  return 0;
+}
+
+static void
+acl_set_lookup_mode (acl_main_t * am, u32 sw_if_index,
+		     acl_lookup_mode_t mode)
+{
+  void *oldheap = acl_set_heap (am);
+  vec_validate_init_empty (am->lookup_mode_by_sw_if_index, sw_if_index,
+			   ACL_LOOKUP_MODE_TSS_PRIORITY);
+  am->lookup_mode_by_sw_if_index[sw_if_index] = mode;
+  clib_mem_set_heap (oldheap);
+}
+
 static clib_error_t *
 acl_set_aclplugin_fn (vlib_main_t * vm,
 		      unformat_input_t * input, vlib_cli_command_t * cmd)
@@ -2396,6 +2496,8 @@ acl_set_aclplugin_fn (vlib_main_t * vm,
   u32 val = 0;
   u32 eh_val = 0;
   uword memory_size = 0;
+  u32 sw_if_index = ~0;
+  acl_lookup_mode_t mode;
   acl_main_t *am = &acl_main;
 
   if (unformat (input, "skip-ipv6-extension-header %u %u", &eh_val, &val))
@@ -2411,6 +2513,13 @@ acl_set_aclplugin_fn (vlib_main_t * vm,
       am->use_hash_acl_matching = (val != 0);
       goto done;
     }
+  if (unformat (input, "interface %U lookup-mode %U",
+		unformat_vnet_sw_interface, am->vnet_main, &sw_if_index,
+		unformat_acl_lookup_mode, &mode))
+    {
+      acl_set_lookup_mode (am, sw_if_index, mode);
+      goto done;
+    }
   if (unformat (input, "l4-match-nonfirst-fragment %u", &val))
     {
       am->l4_match_nonfirst_fragment = (val != 0);
@@ -2736,7 +2845,8 @@ acl_plugin_show_interface (acl_main_t * am, u32 sw_if_index, int show_acl)
       if ((sw_if_index != ~0) && (sw_if_index != swi))
 	continue;
 
-      vlib_cli_output (vm, "sw_if_index %d:\n", swi);
+      vlib_cli_output (vm, "sw_if_index %d: lookup mode %U\n", swi,
+		       format_acl_lookup_mode, acl_lookup_mode (am, swi));
 
       if ((swi < vec_len (am->input_acl_vec_by_sw_if_index)) &&
 	  (vec_len (am->input_acl_vec_by_sw_if_index[swi]) > 0))
@@ -2829,8 +2939,13 @@ acl_plugin_show_sessions (acl_main_t * am,
   vnet_sw_interface_t *swif;
 
   {
-    u64 n_adds = am->fa_session_total_adds;
-    u64 n_dels = am->fa_session_total_dels;
+    u64 n_adds = 0;
+    u64 n_dels = 0;
+    for (wk = 0; wk < vec_len (am->per_worker_data); wk++)
+      {
+	n_adds += am->per_worker_data[wk].fa_session_total_adds;
+	n_dels += am->per_worker_data[wk].fa_session_total_dels;
+      }
     vlib_cli_output (vm, "Sessions total: add %lu - del %lu = %lu", n_adds,
 		     n_dels, n_adds - n_dels);
   }
@@ -2856,14 +2971,11 @@ acl_plugin_show_sessions (acl_main_t * am,
 	  vlib_cli_output (vm, "    last active time: %lu",
 			   sess->last_active_time);
 	  vlib_cli_output (vm, "    thread index: %u", sess->thread_index);
-	  vlib_cli_output (vm, "    link enqueue time: %lu",
-			   sess->link_enqueue_time);
-	  vlib_cli_output (vm, "    link next index: %u",
-			   sess->link_next_idx);
-	  vlib_cli_output (vm, "    link prev index: %u",
-			   sess->link_prev_idx);
-	  vlib_cli_output (vm, "    link list id: %u", sess->link_list_id);
+	  vlib_cli_output (vm, "    timer handle: %u", sess->timer_handle);
 	}
+      vlib_cli_output (vm, "  connections: add %lu - del %lu = %lu",
+		       pw->fa_session_total_adds, pw->fa_session_total_dels,
+		       pw->fa_session_total_adds - pw->fa_session_total_dels);
       vlib_cli_output (vm, "  connection add/del stats:", wk);
       pool_foreach (swif, im->sw_interfaces, (
 					       {
@@ -2893,36 +3005,24 @@ acl_plugin_show_sessions (acl_main_t * am,
 					       }
 		    ));
 
-      vlib_cli_output (vm, "  connection timeout type lists:", wk);
-      u8 tt = 0;
-      for (tt = 0; tt < ACL_N_TIMEOUTS; tt++)
-	{
-	  u32 head_session_index = pw->fa_conn_list_head[tt];
-	  vlib_cli_output (vm, "  fa_conn_list_head[%d]: %d", tt,
-			   head_session_index);
-	  if (~0 != head_session_index)
-	    {
-	      fa_session_t *sess = pw->fa_sessions_pool + head_session_index;
-	      vlib_cli_output (vm, "    last active time: %lu",
-			       sess->last_active_time);
-	      vlib_cli_output (vm, "    link enqueue time: %lu",
-			       sess->link_enqueue_time);
-	    }
-	}
-
-      vlib_cli_output (vm, "  Next expiry time: %lu", pw->next_expiry_time);
-      vlib_cli_output (vm, "  Requeue until time: %lu",
-		       pw->requeue_until_time);
-      vlib_cli_output (vm, "  Current time wait interval: %lu",
-		       pw->current_time_wait_interval);
+      vlib_cli_output (vm, "  idle timer wheel:");
+      vlib_cli_output (vm, "    timers: %u",
+		       pool_elts (pw->session_timer_wheel.timers));
+      vlib_cli_output (vm, "    last run time: %.3f",
+		       pw->session_timer_wheel.last_run_time);
+      vlib_cli_output (vm, "    next run time: %.3f",
+		       pw->session_timer_wheel.next_run_time);
+      vlib_cli_output (vm, "    expired backlog: %u",
+		       vec_len (pw->expired_sessions) - pw->expired_cursor);
+      vlib_cli_output (vm, "  Pending session inserts: %u",
+		       vec_len (pw->pending_session_kvs));
       vlib_cli_output (vm, "  Count of deleted sessions: %lu",
 		       pw->cnt_deleted_sessions);
       vlib_cli_output (vm, "  Delete already deleted: %lu",
 		       pw->cnt_already_deleted_sessions);
       vlib_cli_output (vm, "  Session timers restarted: %lu",
 		       pw->cnt_session_timer_restarted);
-      vlib_cli_output (vm, "  Swipe until this time: %lu",
-		       pw->swipe_end_time);
+      vlib_cli_output (vm, "  Clear cursor: %u", pw->clear_cursor);
       vlib_cli_output (vm, "  sw_if_index serviced bitmap: %U",
 		       format_bitmap_hex, pw->serviced_sw_if_index_bitmap);
       vlib_cli_output (vm, "  pending clear intfc bitmap : %U",
@@ -3038,6 +3138,20 @@ acl_plugin_print_pae (vlib_main_t * vm, int j, applied_hash_ace_entry_t * pae)
 		   pae->tail_applied_entry_index, pae->hitcount);
 }
 
+static void
+acl_plugin_print_mask_info (vlib_main_t * vm, char *dir,
+			    applied_hash_acl_info_t * pal)
+{
+  hash_applied_mask_info_t *minfo;
+  u8 *s = 0;
+
+  vec_foreach (minfo, pal->mask_type_by_priority)
+    s = format (s, " %d@%d", minfo->mask_type_index,
+		minfo->first_applied_entry_index);
+  vlib_cli_output (vm, "  %s lookup mask types@first entry:%v", dir, s);
+  vec_free (s);
+}
+
 static void
 acl_plugin_show_tables_applied_info (acl_main_t * am, u32 sw_if_index)
 {
@@ -3064,6 +3178,7 @@ acl_plugin_show_tables_applied_info (acl_main_t * am, u32 sw_if_index)
 			   format_bitmap_hex, pal->mask_type_index_bitmap);
 	  vlib_cli_output (vm, "  input applied acls: %U", format_vec32,
 			   pal->applied_acls, "%d");
+	  acl_plugin_print_mask_info (vm, "input", pal);
 	}
       if (swi < vec_len (am->input_hash_entry_vec_by_sw_if_index))
 	{
@@ -3086,6 +3201,7 @@ acl_plugin_show_tables_applied_info (acl_main_t * am, u32 sw_if_index)
 			   format_bitmap_hex, pal->mask_type_index_bitmap);
 	  vlib_cli_output (vm, "  output applied acls: %U", format_vec32,
 			   pal->applied_acls, "%d");
+	  acl_plugin_print_mask_info (vm, "output", pal);
 	}
       if (swi < vec_len (am->output_hash_entry_vec_by_sw_if_index))
 	{
@@ -3180,10 +3296,304 @@ acl_clear_aclplugin_fn (vlib_main_t * vm,
   return error;
 }
 
+/*
+ * Lookup microbenchmark. Synthetic IPv4 rule sets, in the spirit of
+ * ClassBench: prefix lengths mostly on octet boundaries, mostly wildcard
+ * source ports, destination ports exact, wildcard or in a range.
+ */
+static u32
+acl_bench_prefix_len (u32 * seed)
+{
+  static u8 octet_plens[] = { 0, 8, 16, 24, 32 };
+  u32 rnd = random_u32 (seed);
+
+  if (rnd & 3)
+    return octet_plens[(rnd >> 2) % ARRAY_LEN (octet_plens)];
+  return (rnd >> 2) % 33;
+}
+
+static void
+acl_bench_port_range (u32 * seed, int mostly_any, u16 * first, u16 * last)
+{
+  u32 rnd = random_u32 (seed);
+  u16 port = rnd >> 16;
+
+  switch ((rnd & 0xff) % (mostly_any ? 8 : 4))
+    {
+    case 1:
+      *first = *last = port;
+      break;
+    case 2:
+      *first = (rnd & 0x100) ? 1024 : 0;
+      *last = (rnd & 0x100) ? 65535 : 1023;
+      break;
+    case 3:
+      *first = port;
+      *last = port + (rnd >> 9 & 0x3ff);
+      if (*last < *first)
+	*last = 65535;
+      break;
+    default:
+      *first = 0;
+      *last = 65535;
+      break;
+    }
+}
+
+static u32
+acl_bench_addr (u32 * seed, u32 plen)
+{
+  u32 mask = plen ? ~0U << (32 - plen) : 0;
+  return random_u32 (seed) & mask;
+}
+
+static void
+acl_bench_make_rule (vl_api_acl_rule_t * r, u32 * seed)
+{
+  u32 addr;
+  u16 first, last;
+  u32 rnd = random_u32 (seed);
+
+  memset (r, 0, sizeof (*r));
+  r->is_permit = rnd & 1;
+  r->src_ip_prefix_len = acl_bench_prefix_len (seed);
+  addr = clib_host_to_net_u32 (acl_bench_addr (seed, r->src_ip_prefix_len));
+  clib_memcpy (r->src_ip_addr, &addr, sizeof (addr));
+  r->dst_ip_prefix_len = acl_bench_prefix_len (seed);
+  addr = clib_host_to_net_u32 (acl_bench_addr (seed, r->dst_ip_prefix_len));
+  clib_memcpy (r->dst_ip_addr, &addr, sizeof (addr));
+
+  switch ((rnd >> 1) % 8)
+    {
+    case 0:
+      r->proto = 0;
+      r->dstport_or_icmpcode_last = r->srcport_or_icmptype_last = 65535;
+      return;
+    case 1:
+    case 2:
+    case 3:
+    case 4:
+      r->proto = IPPROTO_TCP;
+      break;
+    default:
+      r->proto = IPPROTO_UDP;
+      break;
+    }
+  acl_bench_port_range (seed, 1, &first, &last);
+  r->srcport_or_icmptype_first = clib_host_to_net_u16 (first);
+  r->srcport_or_icmptype_last = clib_host_to_net_u16 (last);
+  acl_bench_port_range (seed, 0, &first, &last);
+  r->dstport_or_icmpcode_first = clib_host_to_net_u16 (first);
+  r->dstport_or_icmpcode_last = clib_host_to_net_u16 (last);
+}
+
+static u16
+acl_bench_port (u32 * seed, u16 first_net, u16 last_net)
+{
+  u16 first = clib_net_to_host_u16 (first_net);
+  u16 last = clib_net_to_host_u16 (last_net);
+  return first + random_u32 (seed) % ((u32) last - first + 1);
+}
+
+/* Most packets hit a rule picked at random, the rest are random */
+static void
+acl_bench_make_packet (fa_5tuple_t * pkt, vl_api_acl_rule_t * rules,
+		       u32 sw_if_index, u32 * seed)
+{
+  vl_api_acl_rule_t *r;
+  u32 addr, mask;
+
+  memset (pkt, 0, sizeof (*pkt));
+  pkt->pkt.sw_if_index = sw_if_index;
+  pkt->pkt.is_input = 1;
+  pkt->pkt.l4_valid = 1;
+
+  if ((random_u32 (seed) & 3) == 0)
+    {
+      pkt->addr[0].ip4.as_u32 = random_u32 (seed);
+      pkt->addr[1].ip4.as_u32 = random_u32 (seed);
+      pkt->l4.proto = (random_u32 (seed) & 1) ? IPPROTO_TCP : IPPROTO_UDP;
+      pkt->l4.port[0] = random_u32 (seed);
+      pkt->l4.port[1] = random_u32 (seed);
+    }
+  else
+    {
+      r = rules + random_u32 (seed) % vec_len (rules);
+      clib_memcpy (&addr, r->src_ip_addr, sizeof (addr));
+      mask = r->src_ip_prefix_len ? ~0U << (32 - r->src_ip_prefix_len) : 0;
+      pkt->addr[0].ip4.as_u32 = clib_host_to_net_u32
+	((clib_net_to_host_u32 (addr) & mask) | (random_u32 (seed) & ~mask));
+      clib_memcpy (&addr, r->dst_ip_addr, sizeof (addr));
+      mask = r->dst_ip_prefix_len ? ~0U << (32 - r->dst_ip_prefix_len) : 0;
+      pkt->addr[1].ip4.as_u32 = clib_host_to_net_u32
+	((clib_net_to_host_u32 (addr) & mask) | (random_u32 (seed) & ~mask));
+      pkt->l4.proto = r->proto ? r->proto : IPPROTO_TCP;
+      pkt->l4.port[0] = acl_bench_port (seed, r->srcport_or_icmptype_first,
+					r->srcport_or_icmptype_last);
+      pkt->l4.port[1] = acl_bench_port (seed, r->dstport_or_icmpcode_first,
+					r->dstport_or_icmpcode_last);
+    }
+  if (pkt->l4.proto == IPPROTO_TCP)
+    {
+      pkt->pkt.tcp_flags = TCP_FLAG_SYN;
+      pkt->pkt.tcp_flags_valid = 1;
+    }
+}
+
+static clib_error_t *
+acl_test_lookup_bench_fn (vlib_main_t * vm,
+			  unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  acl_main_t *am = &acl_main;
+  u32 n_rules = 10000, n_acls = 1, n_packets = 100000, seed = 0xdeadbeef;
+  vl_api_acl_rule_t *rules = 0;
+  fa_5tuple_t *pkts = 0;
+  u64 *results[ACL_N_LOOKUP_MODES] = { 0 };
+  u32 *acl_indices = 0;
+  u32 sw_if_index, i, j, n_mismatch = 0;
+  acl_lookup_mode_t mode, modes[] = { ACL_LOOKUP_MODE_TSS,
+    ACL_LOOKUP_MODE_TSS_PRIORITY
+  };
+  applied_hash_acl_info_t *pal;
+  clib_error_t *error = 0;
+  u8 tag[64];
+  int rv;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "rules %u", &n_rules))
+	;
+      else if (unformat (input, "acls %u", &n_acls))
+	;
+      else if (unformat (input, "packets %u", &n_packets))
+	;
+      else if (unformat (input, "seed %u", &seed))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+  if (n_acls == 0 || n_rules < n_acls || n_packets == 0)
+    return clib_error_return (0, "need at least a rule per acl and a packet");
+
+  if (!am->use_hash_acl_matching)
+    return clib_error_return (0, "hash-based matching is disabled");
+
+  /* apply the ACLs on an sw_if_index no interface uses */
+  sw_if_index = pool_len (am->vnet_main->interface_main.sw_interfaces);
+
+  vec_validate (rules, n_rules - 1);
+  for (i = 0; i < n_rules; i++)
+    acl_bench_make_rule (rules + i, &seed);
+
+  memset (tag, 0, sizeof (tag));
+  for (i = 0; i < n_acls; i++)
+    {
+      u32 acl_index = ~0;
+      u32 first = i * (n_rules / n_acls);
+      u32 count = (i == n_acls - 1) ? n_rules - first : n_rules / n_acls;
+
+      rv = acl_add_list (count, rules + first, &acl_index, tag);
+      if (rv)
+	{
+	  error = clib_error_return (0, "acl_add_list returned %d", rv);
+	  goto done;
+	}
+      vec_add1 (acl_indices, acl_index);
+      hash_acl_apply (am, sw_if_index, 1, acl_index);
+    }
+
+  vec_validate (pkts, n_packets - 1);
+  for (i = 0; i < n_packets; i++)
+    acl_bench_make_packet (pkts + i, rules, sw_if_index, &seed);
+
+  pal = vec_elt_at_index (am->input_applied_hash_acl_info_by_sw_if_index,
+			  sw_if_index);
+  vlib_cli_output (vm, "%u rules in %u acls, %u mask types, %u packets",
+		   n_rules, n_acls, vec_len (pal->mask_type_by_priority),
+		   n_packets);
+
+  for (j = 0; j < ARRAY_LEN (modes); j++)
+    {
+      u32 n_matched = 0;
+      u64 start, elapsed;
+
+      mode = modes[j];
+      acl_set_lookup_mode (am, sw_if_index, mode);
+      vec_validate (results[mode], n_packets - 1);
+
+      start = clib_cpu_time_now ();
+      for (i = 0; i < n_packets; i++)
+	{
+	  u32 acl_match = ~0, rule_match = ~0, trace_bitmap = 0;
+
+	  hash_multi_acl_match_5tuple (sw_if_index, pkts + i, 0, 0, 1,
+				       &acl_match, &rule_match,
+				       &trace_bitmap);
+	  results[mode][i] = ((u64) acl_match << 32) | rule_match;
+	}
+      elapsed = clib_cpu_time_now () - start;
+
+      for (i = 0; i < n_packets; i++)
+	n_matched += (results[mode][i] != ~0ULL);
+      vlib_cli_output (vm, "%-14U %8.1f ns/lookup %8.1f clocks/lookup, "
+		       "%u matched", format_acl_lookup_mode, mode,
+		       elapsed * vm->clib_time.seconds_per_clock * 1e9 /
+		       n_packets, (f64) elapsed / n_packets, n_matched);
+    }
+
+  for (i = 0; i < n_packets; i++)
+    n_mismatch += (results[ACL_LOOKUP_MODE_TSS][i] !=
+		   results[ACL_LOOKUP_MODE_TSS_PRIORITY][i]);
+  if (n_mismatch)
+    error = clib_error_return (0, "%u lookups differ between modes",
+			       n_mismatch);
+
+done:
+  for (i = vec_len (acl_indices); i > 0; i--)
+    {
+      hash_acl_unapply (am, sw_if_index, 1, acl_indices[i - 1]);
+      acl_del_list (acl_indices[i - 1]);
+    }
+  if (sw_if_index < vec_len (am->lookup_mode_by_sw_if_index))
+    acl_set_lookup_mode (am, sw_if_index, ACL_LOOKUP_MODE_TSS_PRIORITY);
+  vec_free (acl_indices);
+  vec_free (rules);
+  vec_free (pkts);
+  for (j = 0; j < ARRAY_LEN (results); j++)
+    vec_free (results[j]);
+  return error;
+}
+
+static clib_error_t *
+acl_test_conns_bench_fn (vlib_main_t * vm,
+			 unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  acl_main_t *am = &acl_main;
+  u32 n_sessions = 100000, seed = 0xdeadbeef;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "sessions %u", &n_sessions))
+	;
+      else if (unformat (input, "seed %u", &seed))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+  if (n_sessions == 0)
+    return clib_error_return (0, "need at least one session");
+
+  /* the sessions live on the plugin heap, make sure it exists */
+  clib_mem_set_heap (acl_set_heap (am));
+  return acl_fa_session_bench (vm, n_sessions, seed);
+}
+
  /* *INDENT-OFF* */
 VLIB_CLI_COMMAND (aclplugin_set_command, static) = {
     .path = "set acl-plugin",
-    .short_help = "set acl-plugin session timeout {{udp idle}|tcp {idle|transient}} <seconds>",
+    .short_help = "set acl-plugin session timeout {{udp idle}|tcp {idle|transient}} <seconds> | interface <interface> lookup-mode {tss-priority|tss|linear}",
     .function = acl_set_aclplugin_fn,
 };
 
@@ -3234,6 +3644,18 @@ VLIB_CLI_COMMAND (aclplugin_clear_command, static) = {
     .short_help = "clear acl-plugin sessions",
     .function = acl_clear_aclplugin_fn,
 };
+
+VLIB_CLI_COMMAND (aclplugin_test_lookup_bench_command, static) = {
+    .path = "test acl-plugin lookup-bench",
+    .short_help = "test acl-plugin lookup-bench [rules N] [acls N] [packets N] [seed N]",
+    .function = acl_test_lookup_bench_fn,
+};
+
+VLIB_CLI_COMMAND (aclplugin_test_conns_bench_command, static) = {
+    .path = "test acl-plugin conns-bench",
+    .short_help = "test acl-plugin conns-bench [sessions N] [seed N]",
+    .function = acl_test_conns_bench_fn,
+};
 /* *INDENT-ON* */
 
 static clib_error_t *
@@ -3324,17 +3746,11 @@ acl_init (vlib_main_t * vm)
   vec_validate (am->per_worker_data, tm->n_vlib_mains - 1);
   {
     u16 wk;
-    u8 tt;
     for (wk = 0; wk < vec_len (am->per_worker_data); wk++)
       {
 	acl_fa_per_worker_data_t *pw = &am->per_worker_data[wk];
-	vec_validate (pw->fa_conn_list_head, ACL_N_TIMEOUTS - 1);
-	vec_validate (pw->fa_conn_list_tail, ACL_N_TIMEOUTS - 1);
-	for (tt = 0; tt < ACL_N_TIMEOUTS; tt++)
-	  {
-	    pw->fa_conn_list_head[tt] = ~0;
-	    pw->fa_conn_list_tail[tt] = ~0;
-	  }
+	/* the timer wheels come with the session pools */
+	pw->clear_cursor = ~0;
       }
   }
 
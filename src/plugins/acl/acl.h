@@ -128,6 +128,19 @@ typedef struct
   u32 refcount;
 } ace_mask_type_entry_t;
 
+/*
+ * How the ACLs applied on an interface are matched
+ */
+typedef enum {
+  /* probe the mask types in rule order, stop when no better match is possible */
+  ACL_LOOKUP_MODE_TSS_PRIORITY = 0,
+  /* probe all the mask types */
+  ACL_LOOKUP_MODE_TSS,
+  /* walk the rules */
+  ACL_LOOKUP_MODE_LINEAR,
+  ACL_N_LOOKUP_MODES,
+} acl_lookup_mode_t;
+
 typedef struct {
   /* mheap to hold all the ACL module related allocations, other than hash */
   void *acl_mheap;
@@ -166,6 +179,10 @@ typedef struct {
 
   /* Do we use hash-based ACL matching or linear */
   int use_hash_acl_matching;
+  /* Non-zero while an applied ACL is replaced, match linearly meanwhile */
+  volatile u32 hash_lookup_paused;
+  /* acl_lookup_mode_t by sw_if_index, if hash-based matching is used */
+  u8 *lookup_mode_by_sw_if_index;
 
   /* a pool of all mask types present in all ACEs */
   ace_mask_type_entry_t *ace_mask_type_pool;
@@ -197,9 +214,6 @@ typedef struct {
   u32 fa_cleaner_node_index;
   /* FA session timeouts, in seconds */
   u32 session_timeout_sec[ACL_N_TIMEOUTS];
-  /* total session adds/dels */
-  u64 fa_session_total_adds;
-  u64 fa_session_total_dels;
 
   /* L2 datapath glue */
 
@@ -317,5 +331,13 @@ AH has a special treatment of its length, it is in 32-bit words, not 64-bit word
 
 extern acl_main_t acl_main;
 
+static inline acl_lookup_mode_t
+acl_lookup_mode (acl_main_t * am, u32 sw_if_index)
+{
+  if (sw_if_index < vec_len (am->lookup_mode_by_sw_if_index))
+    return am->lookup_mode_by_sw_if_index[sw_if_index];
+  return ACL_LOOKUP_MODE_TSS_PRIORITY;
+}
+
 
 #endif
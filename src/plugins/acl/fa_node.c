@@ -19,6 +19,7 @@
 #include <vnet/vnet.h>
 #include <vnet/pg/pg.h>
 #include <vppinfra/error.h>
+#include <vppinfra/random.h>
 #include <acl/acl.h>
 #include <vppinfra/bihash_40_8.h>
 
@@ -334,7 +335,8 @@ multi_acl_match_5tuple (u32 sw_if_index, fa_5tuple_t * pkt_5tuple, int is_l2,
                        u32 * rule_match_p, u32 * trace_bitmap)
 {
   acl_main_t *am = &acl_main;
-  if (am->use_hash_acl_matching) {
+  if (am->use_hash_acl_matching && !am->hash_lookup_paused
+      && acl_lookup_mode(am, sw_if_index) != ACL_LOOKUP_MODE_LINEAR) {
     return hash_multi_acl_match_5tuple(sw_if_index, pkt_5tuple, is_l2, is_ip6,
                                  is_input, acl_match_p, rule_match_p, trace_bitmap);
   } else {
@@ -602,32 +604,26 @@ fa_session_get_shortest_timeout(acl_main_t * am)
 }
 
 /*
- * Get the timeout of the session in a list since its enqueue time.
+ * Get the idle timeout of a session.
  */
 
 static u64
-fa_session_get_list_timeout (acl_main_t * am, fa_session_t * sess)
+fa_session_get_timeout (acl_main_t * am, fa_session_t * sess)
 {
   u64 timeout = am->vlib_main->clib_time.clocks_per_second;
-  /*
-   * we have the shortest possible timeout type in all the lists
-   * (see README-multicore for the rationale)
-   */
-  timeout *= fa_session_get_shortest_timeout(am);
+  int timeout_type = fa_session_get_timeout_type (am, sess);
+  timeout *= am->session_timeout_sec[timeout_type];
   return timeout;
 }
 
 /*
- * Get the idle timeout of a session.
+ * The session timer wheels run in seconds, the sessions in CPU clocks.
  */
 
-static u64
-fa_session_get_timeout (acl_main_t * am, fa_session_t * sess)
+static inline f64
+acl_fa_time_sec (acl_main_t * am, u64 now)
 {
-  u64 timeout = am->vlib_main->clib_time.clocks_per_second;
-  int timeout_type = fa_session_get_timeout_type (am, sess);
-  timeout *= am->session_timeout_sec[timeout_type];
-  return timeout;
+  return now * am->vlib_main->clib_time.seconds_per_clock;
 }
 
 static void
@@ -635,10 +631,16 @@ acl_fa_verify_init_sessions (acl_main_t * am)
 {
   if (!am->fa_sessions_hash_is_initialized) {
     u16 wk;
-    /* Allocate the per-worker sessions pools */
+    f64 now = acl_fa_time_sec(am, clib_cpu_time_now ());
+    /* Allocate the per-worker sessions pools and idle timer wheels */
     for (wk = 0; wk < vec_len (am->per_worker_data); wk++) {
       acl_fa_per_worker_data_t *pw = &am->per_worker_data[wk];
       pool_alloc_aligned(pw->fa_sessions_pool, am->fa_conn_table_max_entries, CLIB_CACHE_LINE_BYTES);
+      tw_timer_wheel_init_2t_1w_2048sl (&pw->session_timer_wheel, 0,
+                                        ACL_FA_SESSION_TIMER_TICK,
+                                        am->fa_max_deleted_sessions_per_interval);
+      /* start counting the ticks from now rather than from the epoch */
+      pw->session_timer_wheel.last_run_time = now;
     }
 
     /* ... and the interface session hash table */
@@ -657,93 +659,63 @@ static inline fa_session_t *get_session_ptr(acl_main_t *am, u16 thread_index, u3
   return sess;
 }
 
-static inline int is_valid_session_ptr(acl_main_t *am, u16 thread_index, fa_session_t *sess)
-{
-  acl_fa_per_worker_data_t *pw = &am->per_worker_data[thread_index];
-  return ((sess != 0) && ((sess - pw->fa_sessions_pool) < pool_len(pw->fa_sessions_pool)));
-}
+/*
+ * Arm the idle timer of a session to fire when the session times out,
+ * unless it sees more packets by then. Never wait longer than
+ * the shortest of the timeouts: the threads that do not own
+ * the session may change its timeout type without touching
+ * the timer (see README-multicore for the rationale).
+ */
 
 static void
-acl_fa_conn_list_add_session (acl_main_t * am, fa_full_session_id_t sess_id, u64 now)
+acl_fa_session_timer_start (acl_main_t * am, acl_fa_per_worker_data_t * pw,
+                            fa_session_t * sess, u32 session_index, u64 now)
 {
-  fa_session_t *sess = get_session_ptr(am, sess_id.thread_index, sess_id.session_index);
-  u8 list_id = fa_session_get_timeout_type(am, sess);
-  uword thread_index = os_get_thread_index ();
-  acl_fa_per_worker_data_t *pw = &am->per_worker_data[thread_index];
-  /* the retrieved session thread index must be necessarily the same as the one in the key */
-  ASSERT (sess->thread_index == sess_id.thread_index);
-  /* the retrieved session thread index must be the same as current thread */
-  ASSERT (sess->thread_index == thread_index);
-  sess->link_enqueue_time = now;
-  sess->link_list_id = list_id;
-  sess->link_next_idx = ~0;
-  sess->link_prev_idx = pw->fa_conn_list_tail[list_id];
-  if (~0 != pw->fa_conn_list_tail[list_id]) {
-    fa_session_t *prev_sess = get_session_ptr(am, thread_index, pw->fa_conn_list_tail[list_id]);
-    prev_sess->link_next_idx = sess_id.session_index;
-    /* We should never try to link with a session on another thread */
-    ASSERT(prev_sess->thread_index == sess->thread_index);
-  }
-  pw->fa_conn_list_tail[list_id] = sess_id.session_index;
-  pw->serviced_sw_if_index_bitmap = clib_bitmap_set(pw->serviced_sw_if_index_bitmap, sess->sw_if_index, 1);
-
-  if (~0 == pw->fa_conn_list_head[list_id]) {
-    pw->fa_conn_list_head[list_id] = sess_id.session_index;
-  }
+  void *oldheap = clib_mem_set_heap(am->acl_mheap);
+  u64 timeout_time = sess->last_active_time + fa_session_get_timeout (am, sess);
+  u64 wait_time = (timeout_time > now) ? timeout_time - now : 0;
+  u64 ticks;
+
+  wait_time = clib_min(wait_time, fa_session_get_shortest_timeout(am) *
+                                  am->vlib_main->clib_time.clocks_per_second);
+  ticks = 1 + acl_fa_time_sec(am, wait_time) / ACL_FA_SESSION_TIMER_TICK;
+  ticks = clib_min(ticks, ACL_FA_SESSION_TIMER_MAX_TICKS);
+  /* a single timer per session, so the timer handle is the session index */
+  sess->timer_handle = tw_timer_start_2t_1w_2048sl (&pw->session_timer_wheel,
+                                                    session_index, 0, ticks);
+  clib_mem_set_heap (oldheap);
 }
 
-static int
-acl_fa_conn_list_delete_session (acl_main_t *am, fa_full_session_id_t sess_id)
+static void
+acl_fa_session_timer_stop (acl_main_t * am, acl_fa_per_worker_data_t * pw,
+                           fa_session_t * sess)
 {
-  uword thread_index = os_get_thread_index ();
-  acl_fa_per_worker_data_t *pw = &am->per_worker_data[thread_index];
-  if (thread_index != sess_id.thread_index) {
-    /* If another thread attempts to delete the session, fail it. */
-#ifdef FA_NODE_VERBOSE_DEBUG
-    clib_warning("thread id in key %d != curr thread index, not deleting");
-#endif
-    return 0;
-  }
-  fa_session_t *sess = get_session_ptr(am, sess_id.thread_index, sess_id.session_index);
-  /* we should never try to delete the session with another thread index */
-  ASSERT(sess->thread_index == thread_index);
-  if (~0 != sess->link_prev_idx) {
-    fa_session_t *prev_sess = get_session_ptr(am, thread_index, sess->link_prev_idx);
-    /* the previous session must be in the same list as this one */
-    ASSERT(prev_sess->link_list_id == sess->link_list_id);
-    prev_sess->link_next_idx = sess->link_next_idx;
-  }
-  if (~0 != sess->link_next_idx) {
-    fa_session_t *next_sess = get_session_ptr(am, thread_index, sess->link_next_idx);
-    /* The next session must be in the same list as the one we are deleting */
-    ASSERT(next_sess->link_list_id == sess->link_list_id);
-    next_sess->link_prev_idx = sess->link_prev_idx;
-  }
-  if (pw->fa_conn_list_head[sess->link_list_id] == sess_id.session_index) {
-    pw->fa_conn_list_head[sess->link_list_id] = sess->link_next_idx;
-  }
-  if (pw->fa_conn_list_tail[sess->link_list_id] == sess_id.session_index) {
-    pw->fa_conn_list_tail[sess->link_list_id] = sess->link_prev_idx;
+  if (~0 != sess->timer_handle) {
+    void *oldheap = clib_mem_set_heap(am->acl_mheap);
+    tw_timer_stop_2t_1w_2048sl (&pw->session_timer_wheel, sess->timer_handle);
+    sess->timer_handle = ~0;
+    clib_mem_set_heap (oldheap);
   }
-  return 1;
 }
 
 static int
 acl_fa_restart_timer_for_session (acl_main_t * am, u64 now, fa_full_session_id_t sess_id)
 {
-  if (acl_fa_conn_list_delete_session(am, sess_id)) {
-    acl_fa_conn_list_add_session(am, sess_id, now);
-    return 1;
-  } else {
+  uword thread_index = os_get_thread_index ();
+  if (thread_index != sess_id.thread_index) {
     /*
-     * Our thread does not own this connection, so we can not delete
-     * The session. To avoid the complicated signaling, we simply
-     * pick the list waiting time to be the shortest of the timeouts.
-     * This way we do not have to do anything special, and let
-     * the regular requeue check take care of everything.
+     * Our thread does not own this connection, so we can not touch
+     * its timer. To avoid the complicated signaling, the timers
+     * never wait for longer than the shortest of the timeouts,
+     * and the owner's expiry check takes care of everything.
      */
     return 0;
   }
+  acl_fa_per_worker_data_t *pw = &am->per_worker_data[thread_index];
+  fa_session_t *sess = get_session_ptr(am, sess_id.thread_index, sess_id.session_index);
+  acl_fa_session_timer_stop(am, pw, sess);
+  acl_fa_session_timer_start(am, pw, sess, sess_id.session_index, now);
+  return 1;
 }
 
 
@@ -765,83 +737,152 @@ acl_fa_delete_session (acl_main_t * am, u32 sw_if_index, fa_full_session_id_t se
 {
   void *oldheap = clib_mem_set_heap(am->acl_mheap);
   fa_session_t *sess = get_session_ptr(am, sess_id.thread_index, sess_id.session_index);
+  acl_fa_per_worker_data_t *pw = &am->per_worker_data[sess_id.thread_index];
   ASSERT(sess->thread_index == os_get_thread_index ());
+  acl_fa_session_timer_stop(am, pw, sess);
   BV (clib_bihash_add_del) (&am->fa_sessions_hash,
 			    &sess->info.kv, 0);
-  acl_fa_per_worker_data_t *pw = &am->per_worker_data[sess_id.thread_index];
   pool_put_index (pw->fa_sessions_pool, sess_id.session_index);
-  /* Deleting from timer structures not needed,
-     as the caller must have dealt with the timers. */
   vec_validate (pw->fa_session_dels_by_sw_if_index, sw_if_index);
   clib_mem_set_heap (oldheap);
   pw->fa_session_dels_by_sw_if_index[sw_if_index]++;
-  clib_smp_atomic_add(&am->fa_session_total_dels, 1);
+  pw->fa_session_total_dels++;
 }
 
+/*
+ * The session limit is global, but the other workers' counters are only
+ * summed every few adds, or when the table looks full. In between, the
+ * table may overshoot by at most a few sessions per worker.
+ */
+
 static int
 acl_fa_can_add_session (acl_main_t * am, int is_input, u32 sw_if_index)
 {
+  u16 thread_index = os_get_thread_index ();
+  acl_fa_per_worker_data_t *pw = &am->per_worker_data[thread_index];
   u64 curr_sess_count;
-  curr_sess_count = am->fa_session_total_adds - am->fa_session_total_dels;
-  return (curr_sess_count < am->fa_conn_table_max_entries);
-}
+  u16 wk;
 
-static u64
-acl_fa_get_list_head_expiry_time(acl_main_t *am, acl_fa_per_worker_data_t *pw, u64 now, u16 thread_index, int timeout_type)
-{
-  fa_session_t *sess = get_session_ptr(am, thread_index, pw->fa_conn_list_head[timeout_type]);
-  /*
-   * We can not check just the index here because inbetween the worker thread might
-   * dequeue the connection from the head just as we are about to check it.
-   */
-  if (!is_valid_session_ptr(am, thread_index, sess)) {
-    return ~0LL; // infinity.
-  } else {
-    u64 timeout_time =
-              sess->link_enqueue_time + fa_session_get_list_timeout (am, sess);
-    return timeout_time;
+  curr_sess_count = pw->fa_session_total_adds - pw->fa_session_total_dels;
+  if (PREDICT_TRUE (curr_sess_count + pw->fa_session_others_count <
+                    am->fa_conn_table_max_entries
+                    && pw->fa_session_total_adds - pw->fa_session_others_count_adds <
+                    ACL_FA_SESSION_COUNT_REFRESH_ADDS))
+    return 1;
+
+  pw->fa_session_others_count = 0;
+  for (wk = 0; wk < vec_len (am->per_worker_data); wk++) {
+    acl_fa_per_worker_data_t *opw = &am->per_worker_data[wk];
+    if (wk != thread_index)
+      pw->fa_session_others_count +=
+        opw->fa_session_total_adds - opw->fa_session_total_dels;
   }
+  pw->fa_session_others_count_adds = pw->fa_session_total_adds;
+  return (curr_sess_count + pw->fa_session_others_count <
+          am->fa_conn_table_max_entries);
+}
+
+/*
+ * The sessions added while processing a frame are put into the hash
+ * in one batch once the frame is done. Until then, they are found
+ * through a small open addressing table indexed by the key hash.
+ */
+
+static inline u32
+acl_fa_pending_session_slot (clib_bihash_kv_40_8_t * kv)
+{
+  return clib_bihash_hash_40_8 (kv) & (ACL_FA_PENDING_SESSION_SLOTS - 1);
 }
 
 static int
-acl_fa_conn_time_to_check (acl_main_t *am, acl_fa_per_worker_data_t *pw, u64 now, u16 thread_index, u32 session_index)
+acl_fa_find_pending_session (acl_fa_per_worker_data_t * pw, fa_5tuple_t * p5tuple,
+                             clib_bihash_kv_40_8_t * pvalue_sess)
 {
-  fa_session_t *sess = get_session_ptr(am, thread_index, session_index);
-  u64 timeout_time =
-              sess->link_enqueue_time + fa_session_get_list_timeout (am, sess);
-  return (timeout_time < now) || (sess->link_enqueue_time <= pw->swipe_end_time);
+  clib_bihash_kv_40_8_t *kv;
+  u32 slot, index;
+
+  if (PREDICT_TRUE (0 == vec_len (pw->pending_session_kvs)))
+    return 0;
+
+  slot = acl_fa_pending_session_slot (&p5tuple->kv);
+  while ((index = pw->pending_session_slots[slot])) {
+    kv = vec_elt_at_index (pw->pending_session_kvs, index - 1);
+    if (0 == memcmp (kv->key, p5tuple->kv.key, sizeof (kv->key))) {
+      *pvalue_sess = *kv;
+      return 1;
+    }
+    slot = (slot + 1) & (ACL_FA_PENDING_SESSION_SLOTS - 1);
+  }
+  return 0;
+}
+
+static void
+acl_fa_flush_pending_sessions (acl_main_t * am, acl_fa_per_worker_data_t * pw)
+{
+  clib_bihash_kv_40_8_t *kv;
+  u32 slot;
+
+  if (0 == vec_len (pw->pending_session_kvs))
+    return;
+
+  void *oldheap = clib_mem_set_heap(am->acl_mheap);
+  BV (clib_bihash_add_del_batch) (&am->fa_sessions_hash, pw->pending_session_kvs,
+                                  vec_len (pw->pending_session_kvs), 1);
+  clib_mem_set_heap (oldheap);
+
+  /* all the entries go, so just clear the whole run from each home slot */
+  vec_foreach (kv, pw->pending_session_kvs)
+  {
+    slot = acl_fa_pending_session_slot (kv);
+    while (pw->pending_session_slots[slot]) {
+      pw->pending_session_slots[slot] = 0;
+      slot = (slot + 1) & (ACL_FA_PENDING_SESSION_SLOTS - 1);
+    }
+  }
+  _vec_len (pw->pending_session_kvs) = 0;
 }
 
 /*
- * see if there are sessions ready to be checked,
- * do the maintenance (requeue or delete), and
- * return the total number of sessions reclaimed.
+ * Run the idle timer wheel into the backlog of expired sessions, then
+ * look at no more than fa_max_deleted_sessions_per_interval of them:
+ * requeue the sessions that saw some activity since their timer was
+ * started, delete the others. The wheel is only run once the backlog
+ * is empty, so a tick with many expirations is spread over several runs.
+ * Return the number of expired timers looked at.
  */
 static int
 acl_fa_check_idle_sessions(acl_main_t *am, u16 thread_index, u64 now)
 {
   acl_fa_per_worker_data_t *pw = &am->per_worker_data[thread_index];
+  tw_timer_wheel_2t_1w_2048sl_t *tw = &pw->session_timer_wheel;
   fa_full_session_id_t fsid;
   fsid.thread_index = thread_index;
   int total_expired = 0;
-
-  {
-    u8 tt = 0;
-    for(tt = 0; tt < ACL_N_TIMEOUTS; tt++) {
-      while((vec_len(pw->expired) < am->fa_max_deleted_sessions_per_interval)
-	    && (~0 != pw->fa_conn_list_head[tt])
-	    && (acl_fa_conn_time_to_check(am, pw, now, thread_index,
-					  pw->fa_conn_list_head[tt]))) {
-	fsid.session_index = pw->fa_conn_list_head[tt];
-	vec_add1(pw->expired, fsid.session_index);
-	acl_fa_conn_list_delete_session(am, fsid);
-      }
+  u32 *psid, end;
+
+  if (0 == vec_len (pw->expired_sessions)) {
+    void *oldheap = clib_mem_set_heap(am->acl_mheap);
+    tw->max_expirations = am->fa_max_deleted_sessions_per_interval;
+    pw->expired_sessions =
+      tw_timer_expire_timers_vec_2t_1w_2048sl (tw, acl_fa_time_sec(am, now),
+                                               pw->expired_sessions);
+    clib_mem_set_heap (oldheap);
+    pw->expired_cursor = 0;
+    /* the timers are gone from the wheel */
+    vec_foreach (psid, pw->expired_sessions)
+    {
+      if (!pool_is_free_index (pw->fa_sessions_pool, *psid))
+        get_session_ptr(am, thread_index, *psid)->timer_handle = ~0;
     }
   }
 
-  u32 *psid = NULL;
-  vec_foreach (psid, pw->expired)
+  end = clib_min (vec_len (pw->expired_sessions),
+                  pw->expired_cursor + am->fa_max_deleted_sessions_per_interval);
+  total_expired = end - pw->expired_cursor;
+
+  for (; pw->expired_cursor < end; pw->expired_cursor++)
   {
+    psid = vec_elt_at_index (pw->expired_sessions, pw->expired_cursor);
     fsid.session_index = *psid;
     if (!pool_is_free_index (pw->fa_sessions_pool, fsid.session_index))
       {
@@ -849,23 +890,29 @@ acl_fa_check_idle_sessions(acl_main_t *am, u16 thread_index, u64 now)
 	u32 sw_if_index = sess->sw_if_index;
 	u64 sess_timeout_time =
 	  sess->last_active_time + fa_session_get_timeout (am, sess);
+	/*
+	 * The session got a new timer while waiting in the backlog:
+	 * it saw activity, or it is a new session in a reused pool entry.
+	 */
+	if (~0 != sess->timer_handle)
+	  continue;
 	if ((now < sess_timeout_time) && (0 == clib_bitmap_get(pw->pending_clear_sw_if_index_bitmap, sw_if_index)))
 	  {
 #ifdef FA_NODE_VERBOSE_DEBUG
 	    clib_warning ("ACL_FA_NODE_CLEAN: Restarting timer for session %d",
-	       (int) session_index);
+	       (int) fsid.session_index);
 #endif
 	    /* There was activity on the session, so the idle timeout
-	       has not passed. Enqueue for another time period. */
+	       has not passed. Wait for the rest of it. */
 
-	    acl_fa_conn_list_add_session(am, fsid, now);
+	    acl_fa_session_timer_start(am, pw, sess, fsid.session_index, now);
 	    pw->cnt_session_timer_restarted++;
 	  }
 	else
 	  {
 #ifdef FA_NODE_VERBOSE_DEBUG
 	    clib_warning ("ACL_FA_NODE_CLEAN: Deleting session %d",
-	       (int) session_index);
+	       (int) fsid.session_index);
 #endif
 	    acl_fa_delete_session (am, sw_if_index, fsid);
 	    pw->cnt_deleted_sessions++;
@@ -876,30 +923,59 @@ acl_fa_check_idle_sessions(acl_main_t *am, u16 thread_index, u64 now)
 	pw->cnt_already_deleted_sessions++;
       }
   }
-  total_expired = vec_len(pw->expired);
-  /* zero out the vector which we have acted on */
-  if (pw->expired)
-    _vec_len (pw->expired) = 0;
-  /* if we were advancing and reached the end
-   * (no more sessions to recycle), reset the fast-forward timestamp */
-
-  if (pw->swipe_end_time && 0 == total_expired)
-    pw->swipe_end_time = 0;
+  if (pw->expired_cursor == vec_len (pw->expired_sessions))
+    _vec_len (pw->expired_sessions) = 0;
   return (total_expired);
 }
 
+/*
+ * Delete the sessions on the interfaces pending the clear,
+ * walking a bounded number of session pool entries at a time.
+ * Return the number of entries walked, zero once done.
+ */
+static int
+acl_fa_clear_sessions (acl_main_t * am, u16 thread_index)
+{
+  acl_fa_per_worker_data_t *pw = &am->per_worker_data[thread_index];
+  u32 end = clib_min (pw->clear_cursor + ACL_FA_CLEAR_SESSIONS_PER_INTERVAL,
+                      pool_len (pw->fa_sessions_pool));
+  int n_walked = end - pw->clear_cursor;
+  fa_full_session_id_t fsid;
+  fsid.thread_index = thread_index;
+
+  for (; pw->clear_cursor < end; pw->clear_cursor++) {
+    fa_session_t *sess = get_session_ptr(am, thread_index, pw->clear_cursor);
+    if (sess && clib_bitmap_get(pw->pending_clear_sw_if_index_bitmap, sess->sw_if_index)) {
+      fsid.session_index = pw->clear_cursor;
+      acl_fa_delete_session (am, sess->sw_if_index, fsid);
+      pw->cnt_deleted_sessions++;
+    }
+  }
+  return n_walked;
+}
+
 always_inline void
 acl_fa_try_recycle_session (acl_main_t * am, int is_input, u16 thread_index, u32 sw_if_index)
 {
-  /* try to recycle a TCP transient session */
+  /* try to recycle a TCP transient session, among the few after the last one looked at */
   acl_fa_per_worker_data_t *pw = &am->per_worker_data[thread_index];
-  u8 timeout_type = ACL_TIMEOUT_TCP_TRANSIENT;
+  u32 n_sessions = pool_len (pw->fa_sessions_pool);
   fa_full_session_id_t sess_id;
-  sess_id.session_index = pw->fa_conn_list_head[timeout_type];
-  if (~0 != sess_id.session_index) {
-    sess_id.thread_index = thread_index;
-    acl_fa_conn_list_delete_session(am, sess_id);
-    acl_fa_delete_session(am, sw_if_index, sess_id);
+  int i;
+
+  /* the session might be one added by this frame */
+  acl_fa_flush_pending_sessions (am, pw);
+
+  sess_id.thread_index = thread_index;
+  for (i = 0; i < ACL_FA_RECYCLE_PROBES && n_sessions; i++) {
+    if (pw->recycle_cursor >= n_sessions)
+      pw->recycle_cursor = 0;
+    sess_id.session_index = pw->recycle_cursor++;
+    fa_session_t *sess = get_session_ptr(am, thread_index, sess_id.session_index);
+    if (sess && (ACL_TIMEOUT_TCP_TRANSIENT == fa_session_get_timeout_type(am, sess))) {
+      acl_fa_delete_session(am, sess->sw_if_index, sess_id);
+      return;
+    }
   }
 }
 
@@ -911,8 +987,14 @@ acl_fa_add_session (acl_main_t * am, int is_input, u32 sw_if_index, u64 now,
   clib_bihash_kv_40_8_t kv;
   fa_full_session_id_t f_sess_id;
   uword thread_index = os_get_thread_index();
-  void *oldheap = clib_mem_set_heap(am->acl_mheap);
   acl_fa_per_worker_data_t *pw = &am->per_worker_data[thread_index];
+  u32 slot;
+
+  /* keep the pending session table sparse */
+  if (vec_len (pw->pending_session_kvs) >= ACL_FA_PENDING_SESSION_SLOTS / 2)
+    acl_fa_flush_pending_sessions (am, pw);
+
+  void *oldheap = clib_mem_set_heap(am->acl_mheap);
 
   f_sess_id.thread_index = thread_index;
   fa_session_t *sess;
@@ -932,21 +1014,23 @@ acl_fa_add_session (acl_main_t * am, int is_input, u32 sw_if_index, u64 now,
   sess->sw_if_index = sw_if_index;
   sess->tcp_flags_seen.as_u16 = 0;
   sess->thread_index = thread_index;
-  sess->link_list_id = ~0;
-  sess->link_prev_idx = ~0;
-  sess->link_next_idx = ~0;
-
-
+  sess->timer_handle = ~0;
 
   ASSERT(am->fa_sessions_hash_is_initialized == 1);
-  BV (clib_bihash_add_del) (&am->fa_sessions_hash,
-			    &kv, 1);
-  acl_fa_conn_list_add_session(am, f_sess_id, now);
+  /* the hash insert waits for the end of the frame */
+  vec_add1 (pw->pending_session_kvs, kv);
+  slot = acl_fa_pending_session_slot (&kv);
+  while (pw->pending_session_slots[slot])
+    slot = (slot + 1) & (ACL_FA_PENDING_SESSION_SLOTS - 1);
+  pw->pending_session_slots[slot] = vec_len (pw->pending_session_kvs);
+
+  acl_fa_session_timer_start(am, pw, sess, f_sess_id.session_index, now);
+  pw->serviced_sw_if_index_bitmap = clib_bitmap_set(pw->serviced_sw_if_index_bitmap, sw_if_index, 1);
 
   vec_validate (pw->fa_session_adds_by_sw_if_index, sw_if_index);
   clib_mem_set_heap (oldheap);
   pw->fa_session_adds_by_sw_if_index[sw_if_index]++;
-  clib_smp_atomic_add(&am->fa_session_total_adds, 1);
+  pw->fa_session_total_adds++;
   return sess;
 }
 
@@ -980,6 +1064,7 @@ acl_fa_node_fn (vlib_main_t * vm,
   vlib_node_runtime_t *error_node;
   u64 now = clib_cpu_time_now ();
   uword thread_index = os_get_thread_index ();
+  acl_fa_per_worker_data_t *pw = &am->per_worker_data[thread_index];
 
   from = vlib_frame_vector_args (frame);
   n_left_from = frame->n_vectors;
@@ -1049,7 +1134,8 @@ acl_fa_node_fn (vlib_main_t * vm,
 	  if (acl_fa_ifc_has_sessions (am, sw_if_index0))
 	    {
 	      if (acl_fa_find_session
-		  (am, sw_if_index0, &kv_sess, &value_sess))
+		  (am, sw_if_index0, &kv_sess, &value_sess)
+		  || acl_fa_find_pending_session (pw, &kv_sess, &value_sess))
 		{
 		  trace_bitmap |= 0x80000000;
 		  error0 = ACL_FA_ERROR_ACL_EXIST_SESSION;
@@ -1169,6 +1255,14 @@ acl_fa_node_fn (vlib_main_t * vm,
       vlib_put_next_frame (vm, node, next_index, n_left_to_next);
     }
 
+  /* Put the sessions created by this frame into the hash in one go */
+  acl_fa_flush_pending_sessions (am, pw);
+  /* ... and expire some idle sessions, if a timer tick has passed */
+  if (PREDICT_FALSE (pw->fa_session_total_adds != pw->fa_session_total_dels
+		     && (vec_len (pw->expired_sessions)
+		         || acl_fa_time_sec (am, now) >= pw->session_timer_wheel.next_run_time)))
+    acl_fa_check_idle_sessions (am, thread_index, now);
+
   vlib_node_increment_counter (vm, acl_fa_node->index,
 			       ACL_FA_ERROR_ACL_CHECK, pkts_acl_checked);
   vlib_node_increment_counter (vm, acl_fa_node->index,
@@ -1316,12 +1410,12 @@ acl_fa_worker_conn_cleaner_process(vlib_main_t * vm,
    /* allow another interrupt to be queued */
    pw->interrupt_is_pending = 0;
    if (pw->clear_in_process) {
-     if (0 == pw->swipe_end_time) {
+     if (~0 == pw->clear_cursor) {
        /*
         * Someone has just set the flag to start clearing.
-        * we do this by combing through the connections up to a "time T"
-        * which is now, and requeueing everything except the expired
-        * connections and those matching the interface(s) being cleared.
+        * we do this by walking the session pool from the start,
+        * a bounded number of entries per interrupt, and deleting
+        * the connections matching the interface(s) being cleared.
         */
 
        /*
@@ -1356,16 +1450,16 @@ acl_fa_worker_conn_cleaner_process(vlib_main_t * vm,
                       format_bitmap_hex, pw->pending_clear_sw_if_index_bitmap,
                       format_bitmap_hex, pw->serviced_sw_if_index_bitmap);
 #endif
-         /* swipe through the connection lists until enqueue timestamps become above "now" */
-         pw->swipe_end_time = now;
+         /* walk the session pool from its start */
+         pw->clear_cursor = 0;
        }
      }
    }
    num_expired = acl_fa_check_idle_sessions(am, thread_index, now);
    // clib_warning("WORKER-CLEAR: checked %d sessions (clear_in_progress: %d)", num_expired, pw->clear_in_process);
    if (pw->clear_in_process) {
-     if (0 == num_expired) {
-       /* we were clearing but we could not process any more connections. time to stop. */
+     if (0 == acl_fa_clear_sessions(am, thread_index)) {
+       /* we were clearing and have walked all the sessions. time to stop. */
        clib_bitmap_zero(pw->pending_clear_sw_if_index_bitmap);
        pw->clear_in_process = 0;
 #ifdef FA_NODE_VERBOSE_DEBUG
@@ -1444,32 +1538,20 @@ acl_fa_session_cleaner_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
       next_expire = now + am->fa_current_cleaner_timer_wait_interval;
       int has_pending_conns = 0;
       u16 ti;
-      u8 tt;
 
       /*
-       * walk over all per-thread list heads of different timeouts,
-       * and see if there are any connections pending.
-       * If there aren't - we do not need to wake up until the
-       * worker code signals that it has added a connection.
-       *
-       * Also, while we are at it, calculate the earliest we need to wake up.
+       * see if any of the threads has connections, whose idle
+       * timer wheels need to be run. If there aren't - we do not
+       * need to wake up until the worker code signals that
+       * it has added a connection.
        */
       for(ti = 0; ti < vec_len(vlib_mains); ti++) {
         if (ti >= vec_len(am->per_worker_data)) {
           continue;
         }
         acl_fa_per_worker_data_t *pw = &am->per_worker_data[ti];
-        for(tt = 0; tt < vec_len(pw->fa_conn_list_head); tt++) {
-          u64 head_expiry = acl_fa_get_list_head_expiry_time(am, pw, now, ti, tt);
-          if ((head_expiry < next_expire) && !pw->interrupt_is_pending) {
-#ifdef FA_NODE_VERBOSE_DEBUG
-            clib_warning("Head expiry: %lu, now: %lu, next_expire: %lu (worker: %d, tt: %d)", head_expiry, now, next_expire, ti, tt);
-#endif
-            next_expire = head_expiry;
-	  }
-          if (~0 != pw->fa_conn_list_head[tt]) {
-            has_pending_conns = 1;
-          }
+        if (pw->fa_session_total_adds != pw->fa_session_total_dels) {
+          has_pending_conns = 1;
         }
       }
 
@@ -1559,6 +1641,8 @@ acl_fa_session_cleaner_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
                   {
                     pw0->pending_clear_sw_if_index_bitmap = clib_bitmap_dup(clear_sw_if_index_bitmap);
                   }
+                pw0->clear_cursor = ~0;
+                CLIB_MEMORY_BARRIER ();
                 pw0->clear_in_process = 1;
               }
             }
@@ -1710,6 +1794,100 @@ acl_fa_enable_disable (u32 sw_if_index, int is_input, int enable_disable)
     }
 }
 
+/*
+ * Connection setup benchmark: run the session part of the datapath
+ * a frame at a time over n_sessions synthetic TCP 5-tuples on an
+ * sw_if_index no interface uses. The first pass creates a session
+ * for each tuple, the second one finds them, then they are deleted.
+ */
+clib_error_t *
+acl_fa_session_bench (vlib_main_t * vm, u32 n_sessions, u32 seed)
+{
+  acl_main_t *am = &acl_main;
+  uword thread_index = os_get_thread_index ();
+  acl_fa_per_worker_data_t *pw;
+  u32 sw_if_index = pool_len (am->vnet_main->interface_main.sw_interfaces);
+  fa_5tuple_t *pkts = 0, kv_sess;
+  clib_bihash_kv_40_8_t value_sess;
+  fa_full_session_id_t fsid;
+  u32 i, n_new = 0, n_exist = 0, n_refused = 0, n_deleted = 0;
+  u64 start, elapsed[2];
+  int pass;
+
+  void *oldheap = clib_mem_set_heap (am->acl_mheap);
+  acl_fa_verify_init_sessions (am);
+  clib_mem_set_heap (oldheap);
+  pw = &am->per_worker_data[thread_index];
+
+  vec_validate (pkts, n_sessions - 1);
+  for (i = 0; i < n_sessions; i++) {
+    fa_5tuple_t *pkt = pkts + i;
+    pkt->addr[0].ip4.as_u32 = random_u32 (&seed);
+    pkt->addr[1].ip4.as_u32 = random_u32 (&seed);
+    pkt->l4.port[0] = random_u32 (&seed);
+    pkt->l4.port[1] = random_u32 (&seed);
+    pkt->l4.proto = IPPROTO_TCP;
+    pkt->l4.lsb_of_sw_if_index = sw_if_index & 0xffff;
+    pkt->pkt.tcp_flags = TCP_FLAG_SYN;
+    pkt->pkt.tcp_flags_valid = 1;
+    pkt->pkt.l4_valid = 1;
+  }
+
+  for (pass = 0; pass < 2; pass++) {
+    start = clib_cpu_time_now ();
+    for (i = 0; i < n_sessions; i++) {
+      u64 now = clib_cpu_time_now ();
+      acl_make_5tuple_session_key (1, pkts + i, &kv_sess);
+      if (acl_fa_find_session (am, sw_if_index, &kv_sess, &value_sess)
+          || acl_fa_find_pending_session (pw, &kv_sess, &value_sess)) {
+        fsid.as_u64 = value_sess.value;
+        acl_fa_track_session (am, 1, sw_if_index, now,
+                              get_session_ptr(am, fsid.thread_index, fsid.session_index),
+                              pkts + i);
+        n_exist++;
+      } else if (acl_fa_can_add_session (am, 1, sw_if_index)) {
+        fa_session_t *sess = acl_fa_add_session (am, 1, sw_if_index, now, &kv_sess);
+        acl_fa_track_session (am, 1, sw_if_index, now, sess, pkts + i);
+        n_new++;
+      } else {
+        n_refused++;
+      }
+      /* end of a frame */
+      if ((i + 1) % VLIB_FRAME_SIZE == 0 || i + 1 == n_sessions) {
+        acl_fa_flush_pending_sessions (am, pw);
+        if (vec_len (pw->expired_sessions)
+            || acl_fa_time_sec (am, now) >= pw->session_timer_wheel.next_run_time)
+          acl_fa_check_idle_sessions (am, thread_index, now);
+      }
+    }
+    elapsed[pass] = clib_cpu_time_now () - start;
+  }
+
+  vlib_cli_output (vm, "%u sessions: %u new, %u existing, %u refused",
+                   n_sessions, n_new, n_exist, n_refused);
+  vlib_cli_output (vm, "setup:  %10.0f conns/s %8.1f clocks/packet",
+                   n_sessions / acl_fa_time_sec (am, elapsed[0]),
+                   (f64) elapsed[0] / n_sessions);
+  vlib_cli_output (vm, "lookup: %10.0f pkts/s  %8.1f clocks/packet",
+                   n_sessions / acl_fa_time_sec (am, elapsed[1]),
+                   (f64) elapsed[1] / n_sessions);
+
+  /* clean up */
+  fsid.thread_index = thread_index;
+  for (i = 0; i < pool_len (pw->fa_sessions_pool); i++) {
+    fa_session_t *sess = get_session_ptr(am, thread_index, i);
+    if (sess && sess->sw_if_index == sw_if_index) {
+      fsid.session_index = i;
+      acl_fa_delete_session (am, sw_if_index, fsid);
+      n_deleted++;
+    }
+  }
+  pw->serviced_sw_if_index_bitmap = clib_bitmap_set(pw->serviced_sw_if_index_bitmap, sw_if_index, 0);
+  vlib_cli_output (vm, "deleted %u sessions", n_deleted);
+  vec_free (pkts);
+  return 0;
+}
+
 void
 show_fa_sessions_hash(vlib_main_t * vm, u32 verbose)
 {
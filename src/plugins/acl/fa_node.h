@@ -3,6 +3,7 @@
 
 #include <stddef.h>
 #include <vppinfra/bihash_40_8.h>
+#include <vppinfra/tw_timer_2t_1w_2048sl.h>
 
 #define TCP_FLAG_FIN    0x01
 #define TCP_FLAG_SYN    0x02
@@ -19,6 +20,17 @@
 #define ACL_FA_CONN_TABLE_DEFAULT_HASH_MEMORY_SIZE (1<<30)
 #define ACL_FA_CONN_TABLE_DEFAULT_MAX_ENTRIES 1000000
 
+/* Session idle timer wheel tick, in seconds, and longest timer */
+#define ACL_FA_SESSION_TIMER_TICK 0.1
+#define ACL_FA_SESSION_TIMER_MAX_TICKS 2047
+/* Slots of the per-frame pending session table, a power of 2 */
+#define ACL_FA_PENDING_SESSION_SLOTS (2 * VLIB_FRAME_SIZE)
+/* Sessions looked at per interval when clearing, or when recycling */
+#define ACL_FA_CLEAR_SESSIONS_PER_INTERVAL 4096
+#define ACL_FA_RECYCLE_PROBES 16
+/* Own session adds between the sums of the other workers' session counts */
+#define ACL_FA_SESSION_COUNT_REFRESH_ADDS 64
+
 typedef union {
   u64 as_u64;
   struct {
@@ -63,12 +75,9 @@ typedef struct {
     u16 as_u16;
   } tcp_flags_seen; ;     /* +2 bytes = 62 */
   u16 thread_index;          /* +2 bytes = 64 */
-  u64 link_enqueue_time;  /* 8 byte = 8 */
-  u32 link_prev_idx;      /* +4 bytes = 12 */
-  u32 link_next_idx;      /* +4 bytes = 16 */
-  u8 link_list_id;        /* +1 bytes = 17 */
-  u8 reserved1[7];        /* +7 bytes = 24 */
-  u64 reserved2[5];       /* +5*8 bytes = 64 */
+  u32 timer_handle;       /* 4 bytes = 4 */
+  u8 reserved1[4];        /* +4 bytes = 8 */
+  u64 reserved2[7];       /* +7*8 bytes = 64 */
 } fa_session_t;
 
 
@@ -106,28 +115,33 @@ CT_ASSERT_EQUAL(fa_full_session_id_size_is_64, sizeof(fa_full_session_id_t), siz
 typedef struct {
   /* The pool of sessions managed by this worker */
   fa_session_t *fa_sessions_pool;
-  /* per-worker ACL_N_TIMEOUTS of conn lists */
-  u32 *fa_conn_list_head;
-  u32 *fa_conn_list_tail;
+  /* idle timers of the sessions, one per session */
+  tw_timer_wheel_2t_1w_2048sl_t session_timer_wheel;
+  /* sessions whose timers expired, and the next one of them to look at */
+  u32 *expired_sessions;
+  u32 expired_cursor;
+  /* sessions added by the current frame, put in the hash once it is done */
+  clib_bihash_kv_40_8_t *pending_session_kvs;
+  /* 1 + index in pending_session_kvs, by key hash, 0 if free */
+  u32 pending_session_slots[ACL_FA_PENDING_SESSION_SLOTS];
   /* adds and deletes per-worker-per-interface */
   u64 *fa_session_dels_by_sw_if_index;
   u64 *fa_session_adds_by_sw_if_index;
-  /* Vector of expired connections retrieved from lists */
-  u32 *expired;
-  /* the earliest next expiry time */
-  u64 next_expiry_time;
-  /* if not zero, look at all the elements until their enqueue timestamp is after below one */
-  u64 requeue_until_time;
-  /* Current time between the checks */
-  u64 current_time_wait_interval;
+  /* adds and deletes per-worker */
+  u64 fa_session_total_adds;
+  u64 fa_session_total_dels;
+  /* sessions of the other workers when last summed, and our adds by then */
+  u64 fa_session_others_count;
+  u64 fa_session_others_count_adds;
+  /* next session to look at when clearing (~0 if not started yet) or recycling */
+  u32 clear_cursor;
+  u32 recycle_cursor;
   /* Counter of how many sessions we did delete */
   u64 cnt_deleted_sessions;
-  /* Counter of already deleted sessions being deleted - should not increment unless a bug */
+  /* Counter of expired timers of sessions deleted while in the expired backlog */
   u64 cnt_already_deleted_sessions;
-  /* Number of times we requeued a session to a head of the list */
+  /* Number of times the timer of a session with recent activity was restarted */
   u64 cnt_session_timer_restarted;
-  /* swipe up to this enqueue time, rather than following the timeouts */
-  u64 swipe_end_time;
   /* bitmap of sw_if_index serviced by this worker */
   uword *serviced_sw_if_index_bitmap;
   /* bitmap of sw_if_indices to clear. set by main thread, cleared by worker */
@@ -170,5 +184,7 @@ void acl_fa_enable_disable(u32 sw_if_index, int is_input, int enable_disable);
 
 void show_fa_sessions_hash(vlib_main_t * vm, u32 verbose);
 
+clib_error_t *acl_fa_session_bench(vlib_main_t * vm, u32 n_sessions, u32 seed);
+
 
 #endif
@@ -63,8 +63,14 @@ match_portranges(acl_main_t *am, fa_5tuple_t *match, u32 index)
            ((r->dst_port_or_code_first <= match->l4.port[1]) && r->dst_port_or_code_last >= match->l4.port[1]) );
 }
 
+/*
+ * The mask types are probed in the order of the first applied entry using
+ * each of them. The applied entries are in rule order, so with prune set,
+ * once there is a match in front of the first entry of the next mask type,
+ * none of the remaining mask types can give a better one.
+ */
 static u32
-multi_acl_match_get_applied_ace_index(acl_main_t *am, fa_5tuple_t *match)
+multi_acl_match_get_applied_ace_index(acl_main_t *am, fa_5tuple_t *match, int prune)
 {
   clib_bihash_kv_48_8_t kv;
   clib_bihash_kv_48_8_t result;
@@ -75,6 +81,7 @@ multi_acl_match_get_applied_ace_index(acl_main_t *am, fa_5tuple_t *match)
   u64 *pkey;
   int mask_type_index;
   u32 curr_match_index = ~0;
+  hash_applied_mask_info_t *minfo;
 
   u32 sw_if_index = match->pkt.sw_if_index;
   u8 is_input = match->pkt.is_input;
@@ -85,11 +92,12 @@ multi_acl_match_get_applied_ace_index(acl_main_t *am, fa_5tuple_t *match)
   DBG("TRYING TO MATCH: %016llx %016llx %016llx %016llx %016llx %016llx",
 	       pmatch[0], pmatch[1], pmatch[2], pmatch[3], pmatch[4], pmatch[5]);
 
-  for(mask_type_index=0; mask_type_index < pool_len(am->ace_mask_type_pool); mask_type_index++) {
-    if (!clib_bitmap_get(vec_elt_at_index((*applied_hash_acls), sw_if_index)->mask_type_index_bitmap, mask_type_index)) {
-      /* This bit is not set. Avoid trying to match */
-      continue;
+  vec_foreach(minfo, vec_elt_at_index((*applied_hash_acls), sw_if_index)->mask_type_by_priority) {
+    if (prune && (curr_match_index < minfo->first_applied_entry_index)) {
+      DBG("Pruning the lookup at mask type %d", minfo->mask_type_index);
+      break;
     }
+    mask_type_index = minfo->mask_type_index;
     ace_mask_type_entry_t *mte = vec_elt_at_index(am->ace_mask_type_pool, mask_type_index);
     pmatch = (u64 *)match;
     pmask = (u64 *)&mte->mask;
@@ -259,6 +267,9 @@ applied_hash_entries_analyze(acl_main_t *am, applied_hash_ace_entry_t **applied_
    */
 }
 
+static void
+hash_acl_build_applied_mask_info(acl_main_t *am, u32 sw_if_index, u8 is_input);
+
 static void *
 hash_acl_set_heap(acl_main_t *am)
 {
@@ -379,6 +390,7 @@ hash_acl_apply(acl_main_t *am, u32 sw_if_index, u8 is_input, int acl_index)
     activate_applied_ace_hash_entry(am, sw_if_index, is_input, applied_hash_aces, new_index);
   }
   applied_hash_entries_analyze(am, applied_hash_aces);
+  hash_acl_build_applied_mask_info(am, sw_if_index, is_input);
 done:
   clib_mem_set_heap (oldheap);
 }
@@ -519,6 +531,36 @@ hash_acl_build_applied_lookup_bitmap(acl_main_t *am, u32 sw_if_index, u8 is_inpu
   clib_bitmap_free(old_lookup_bitmap);
 }
 
+static void
+hash_acl_build_applied_mask_info(acl_main_t *am, u32 sw_if_index, u8 is_input)
+{
+  int i;
+  uword *seen_bitmap = 0;
+  hash_applied_mask_info_t *new_mask_info = 0;
+  hash_applied_mask_info_t *minfo;
+  applied_hash_ace_entry_t **applied_hash_aces = get_applied_hash_aces(am, is_input, sw_if_index);
+  applied_hash_acl_info_t **applied_hash_acls = is_input ? &am->input_applied_hash_acl_info_by_sw_if_index
+                                                         : &am->output_applied_hash_acl_info_by_sw_if_index;
+  applied_hash_acl_info_t *pal = vec_elt_at_index((*applied_hash_acls), sw_if_index);
+
+  /* the applied entries are in rule order, so is the first use of each mask type */
+  for(i=0; i < vec_len((*applied_hash_aces)); i++) {
+    applied_hash_ace_entry_t *pae = vec_elt_at_index((*applied_hash_aces), i);
+    hash_acl_info_t *ha = vec_elt_at_index(am->hash_acl_infos, pae->acl_index);
+    u32 mask_type_index = vec_elt_at_index(ha->rules, pae->hash_ace_info_index)->mask_type_index;
+    if (clib_bitmap_get(seen_bitmap, mask_type_index))
+      continue;
+    seen_bitmap = clib_bitmap_set(seen_bitmap, mask_type_index, 1);
+    vec_add2(new_mask_info, minfo, 1);
+    minfo->mask_type_index = mask_type_index;
+    minfo->first_applied_entry_index = i;
+  }
+  hash_applied_mask_info_t *old_mask_info = pal->mask_type_by_priority;
+  pal->mask_type_by_priority = new_mask_info;
+  vec_free(old_mask_info);
+  clib_bitmap_free(seen_bitmap);
+}
+
 void
 hash_acl_unapply(acl_main_t *am, u32 sw_if_index, u8 is_input, int acl_index)
 {
@@ -587,6 +629,7 @@ hash_acl_unapply(acl_main_t *am, u32 sw_if_index, u8 is_input, int acl_index)
 
   /* After deletion we might not need some of the mask-types anymore... */
   hash_acl_build_applied_lookup_bitmap(am, sw_if_index, is_input);
+  hash_acl_build_applied_mask_info(am, sw_if_index, is_input);
   clib_mem_set_heap (oldheap);
 }
 
@@ -739,7 +782,8 @@ assign_mask_type_index(acl_main_t *am, fa_5tuple_t *mask)
   u32 mask_type_index = find_mask_type_index(am, mask);
   ace_mask_type_entry_t *mte;
   if(~0 == mask_type_index) {
-    pool_get_aligned (am->ace_mask_type_pool, mte, CLIB_CACHE_LINE_BYTES);
+    /* the workers read the pool while matching */
+    vlib_pool_get_aligned_mt (am->ace_mask_type_pool, mte, CLIB_CACHE_LINE_BYTES);
     mask_type_index = mte - am->ace_mask_type_pool;
     clib_memcpy(&mte->mask, mask, sizeof(mte->mask));
     mte->refcount = 0;
@@ -873,7 +917,8 @@ hash_multi_acl_match_5tuple (u32 sw_if_index, fa_5tuple_t * pkt_5tuple, int is_l
 {
   acl_main_t *am = &acl_main;
   applied_hash_ace_entry_t **applied_hash_aces = get_applied_hash_aces(am, is_input, sw_if_index);
-  u32 match_index = multi_acl_match_get_applied_ace_index(am, pkt_5tuple);
+  int prune = (acl_lookup_mode(am, sw_if_index) == ACL_LOOKUP_MODE_TSS_PRIORITY);
+  u32 match_index = multi_acl_match_get_applied_ace_index(am, pkt_5tuple, prune);
   if (match_index < vec_len((*applied_hash_aces))) {
     applied_hash_ace_entry_t *pae = vec_elt_at_index((*applied_hash_aces), match_index);
     pae->hitcount++;
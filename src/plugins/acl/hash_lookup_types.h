@@ -74,12 +74,29 @@ typedef struct {
   u8 action;
 } applied_hash_ace_entry_t;
 
+/*
+ * A mask type probed by the lookup on a given sw_if_index/direction
+ */
+typedef struct {
+  u32 mask_type_index;
+  /*
+   * index of the first applied entry with this mask type, i.e.
+   * the best match a lookup with this mask type can give
+   */
+  u32 first_applied_entry_index;
+} hash_applied_mask_info_t;
+
 typedef struct {
    /*
     * A logical OR of all the applied_ace_hash_entry_t=>
     *                            hash_ace_info_t=>mask_type_index bits set
     */
    uword *mask_type_index_bitmap;
+   /*
+    * The same mask types, ordered by their first applied entry,
+    * which is the order the lookup probes them in
+    */
+   hash_applied_mask_info_t *mask_type_by_priority;
    /* applied ACLs so we can track them independently from main ACL module */
    u32 *applied_acls;
 } applied_hash_acl_info_t;
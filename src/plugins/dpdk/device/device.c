@@ -357,6 +357,14 @@ dpdk_buffer_tx_offload (dpdk_device_t * xd, vlib_buffer_t * b,
   ol_flags |= ip_cksum ? PKT_TX_IP_CKSUM : 0;
   ol_flags |= tcp_cksum ? PKT_TX_TCP_CKSUM : 0;
   ol_flags |= udp_cksum ? PKT_TX_UDP_CKSUM : 0;
+
+  /* Have the nic split tcp super-segments */
+  if (b->flags & VNET_BUFFER_F_GSO)
+    {
+      mb->l4_len = vnet_buffer2 (b)->gso.l4_hdr_sz;
+      mb->tso_segsz = vnet_buffer2 (b)->gso.size;
+      ol_flags |= PKT_TX_TCP_SEG;
+    }
   mb->ol_flags |= ol_flags;
 
   /* we are trying to help compiler here by using local ol_flags with known
@@ -189,6 +189,7 @@ typedef struct
 #define DPDK_DEVICE_FLAG_BOND_SLAVE_UP      (1 << 8)
 #define DPDK_DEVICE_FLAG_TX_OFFLOAD         (1 << 9)
 #define DPDK_DEVICE_FLAG_INTEL_PHDR_CKSUM   (1 << 10)
+#define DPDK_DEVICE_FLAG_TSO                (1 << 11)
 
   u16 nb_tx_desc;
     CLIB_CACHE_LINE_ALIGN_MARK (cacheline1);
@@ -293,7 +294,8 @@ void dpdk_hqos_metadata_set (dpdk_device_hqos_per_worker_thread_t * hqos,
   _ (num_tx_queues) \
   _ (num_rx_desc) \
   _ (num_tx_desc) \
-  _ (rss_fn)
+  _ (rss_fn) \
+  _ (rss_symmetric)
 
 typedef struct
 {
@@ -322,6 +324,7 @@ typedef struct
   u8 no_multi_seg;
   u8 enable_tcp_udp_checksum;
   u8 no_tx_checksum_offload;
+  u8 enable_tso;
 
   /* Required config parameters */
   u8 coremask_set_manually;
@@ -18,6 +18,7 @@
 #include <vppinfra/format.h>
 #include <vppinfra/bitmap.h>
 #include <vppinfra/linux/sysfs.h>
+#include <vppinfra/toeplitz.h>
 #include <vlib/unix/unix.h>
 
 #include <vnet/ethernet/ethernet.h>
@@ -335,6 +336,12 @@ dpdk_lib_init (dpdk_main_t * dm)
       if (dm->conf->no_tx_checksum_offload == 0)
 	xd->tx_conf.txq_flags &= ~ETH_TXQ_FLAGS_NOXSUMS;
 
+      /* TSO needs checksum offload and chained mbufs */
+      if (dm->conf->enable_tso && dm->conf->no_tx_checksum_offload == 0
+	  && dm->conf->no_multi_seg == 0
+	  && (dev_info.tx_offload_capa & DEV_TX_OFFLOAD_TCP_TSO))
+	xd->flags |= DPDK_DEVICE_FLAG_TSO;
+
       if (dm->conf->no_multi_seg)
 	{
 	  xd->tx_conf.txq_flags |= ETH_TXQ_FLAGS_NOMULTSEGS;
@@ -373,6 +380,17 @@ dpdk_lib_init (dpdk_main_t * dm)
 	      ETH_RSS_IP | ETH_RSS_UDP | ETH_RSS_TCP;
 	  else
 	    xd->port_conf.rx_adv_conf.rss_conf.rss_hf = devconf->rss_fn;
+
+	  if (devconf->rss_symmetric)
+	    {
+	      static u8 rss_symmetric_key[CLIB_TOEPLITZ_SYMMETRIC_KEY_SIZE];
+
+	      clib_toeplitz_symmetric_key (rss_symmetric_key,
+					   sizeof (rss_symmetric_key));
+	      xd->port_conf.rx_adv_conf.rss_conf.rss_key = rss_symmetric_key;
+	      xd->port_conf.rx_adv_conf.rss_conf.rss_key_len =
+		sizeof (rss_symmetric_key);
+	    }
 	}
       else
 	xd->rx_q_used = 1;
@@ -644,6 +662,10 @@ dpdk_lib_init (dpdk_main_t * dm)
 	if (xd->flags & DPDK_DEVICE_FLAG_TX_OFFLOAD)
 	  hi->flags |= VNET_HW_INTERFACE_FLAG_SUPPORTS_TX_L4_CKSUM_OFFLOAD;
 
+      if ((xd->flags & DPDK_DEVICE_FLAG_TSO)
+	  && (xd->flags & DPDK_DEVICE_FLAG_TX_OFFLOAD))
+	hi->flags |= VNET_HW_INTERFACE_FLAG_SUPPORTS_GSO;
+
       dpdk_device_setup (xd);
 
       if (vec_len (xd->errors))
@@ -837,6 +859,8 @@ dpdk_device_config (dpdk_config_main_t * conf, vlib_pci_addr_t pci_addr,
 	  if (error)
 	    break;
 	}
+      else if (unformat (input, "rss-symmetric"))
+	devconf->rss_symmetric = 1;
       else if (unformat (input, "vlan-strip-offload off"))
 	devconf->vlan_strip_offload = DPDK_DEVICE_VLAN_STRIP_OFF;
       else if (unformat (input, "vlan-strip-offload on"))
@@ -923,6 +947,9 @@ dpdk_config (vlib_main_t * vm, unformat_input_t * input)
       else if (unformat (input, "no-tx-checksum-offload"))
 	conf->no_tx_checksum_offload = 1;
 
+      else if (unformat (input, "enable-tso"))
+	conf->enable_tso = 1;
+
       else if (unformat (input, "decimal-interface-names"))
 	conf->interface_name_format_decimal = 1;
 
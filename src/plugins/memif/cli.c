@@ -35,6 +35,7 @@ memif_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
   u32 ring_size = MEMIF_DEFAULT_RING_SIZE;
   memif_create_if_args_t args = { 0 };
   args.buffer_size = MEMIF_DEFAULT_BUFFER_SIZE;
+  args.is_zero_copy = 1;
   u32 rx_queues = MEMIF_DEFAULT_RX_QUEUES;
   u32 tx_queues = MEMIF_DEFAULT_TX_QUEUES;
 
@@ -64,6 +65,8 @@ memif_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
 	args.is_master = 0;
       else if (unformat (line_input, "mode ip"))
 	args.mode = MEMIF_INTERFACE_MODE_IP;
+      else if (unformat (line_input, "no-zero-copy"))
+	args.is_zero_copy = 0;
       else if (unformat (line_input, "hw-addr %U",
 			 unformat_ethernet_address, args.hw_addr))
 	args.hw_addr_set = 1;
@@ -113,7 +116,7 @@ VLIB_CLI_COMMAND (memif_create_command, static) = {
   .short_help = "create memif [id <id>] [socket <path>] "
                 "[ring-size <size>] [buffer-size <size>] [hw-addr <mac-address>] "
 		"<master|slave> [rx-queues <number>] [tx-queues <number>] "
-		"[mode ip] [secret <string>]",
+		"[mode ip] [secret <string>] [no-zero-copy]",
   .function = memif_create_command_fn,
 };
 /* *INDENT-ON* */
@@ -31,7 +31,8 @@
 #define foreach_memif_tx_func_error	       \
 _(NO_FREE_SLOTS, "no free tx slots")           \
 _(TRUNC_PACKET, "packet > buffer size -- truncated in tx ring") \
-_(PENDING_MSGS, "pending msgs in tx ring")
+_(PENDING_MSGS, "pending msgs in tx ring") \
+_(BAD_TAIL, "tail beyond posted slots -- ignored")
 
 typedef enum
 {
@@ -253,6 +254,158 @@ retry:
   return frame->n_vectors;
 }
 
+/**
+ * @brief Point tx ring descriptors at the buffers of one packet
+ *
+ * The buffers are owned by the ring until the master moves the tail past
+ * them.
+ *
+ * @return number of slots used, 0 if the packet does not fit
+ */
+static_always_inline u16
+memif_zc_buffer_to_tx_ring (vlib_main_t * vm, memif_if_t * mif,
+			    memif_queue_t * mq, u32 bi, u16 head, u16 mask,
+			    u16 free_slots)
+{
+  memif_ring_t *ring = mq->ring;
+  vlib_buffer_t *b0 = vlib_get_buffer (vm, bi);
+  memif_desc_t *d;
+  u16 n_slots = 1, slot;
+
+  /* chained packets need one slot per buffer */
+  if (PREDICT_FALSE (b0->flags & VLIB_BUFFER_NEXT_PRESENT))
+    {
+      vlib_buffer_t *b = b0;
+      while (b->flags & VLIB_BUFFER_NEXT_PRESENT)
+	{
+	  b = vlib_get_buffer (vm, b->next_buffer);
+	  n_slots++;
+	}
+    }
+
+  if (PREDICT_FALSE (n_slots > free_slots))
+    return 0;
+
+  while (1)
+    {
+      slot = head++ & mask;
+      d = &ring->desc[slot];
+      d->region = memif_buffer_region (b0);
+      d->offset = memif_buffer_offset (mif, d->region,
+				       vlib_buffer_get_current (b0));
+      d->buffer_length = d->length = b0->current_length;
+      mq->buffers[slot] = bi;
+      if ((b0->flags & VLIB_BUFFER_NEXT_PRESENT) == 0)
+	{
+	  d->flags = 0;
+	  break;
+	}
+      d->flags = MEMIF_DESC_FLAG_NEXT;
+      bi = b0->next_buffer;
+      b0 = vlib_get_buffer (vm, bi);
+    }
+
+  return n_slots;
+}
+
+static_always_inline uword
+memif_interface_tx_zc_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
+			      vlib_frame_t * frame, memif_if_t * mif)
+{
+  u8 qid;
+  memif_ring_t *ring;
+  u32 *buffers = vlib_frame_args (frame);
+  u32 n_left = frame->n_vectors;
+  u16 ring_size, mask;
+  u16 head, tail;
+  u16 free_slots, n_slots;
+  u32 thread_index = vlib_get_thread_index ();
+  u8 tx_queues = vec_len (mif->tx_queues);
+  memif_queue_t *mq;
+  int n_retries = 5;
+
+  if (tx_queues < vec_len (vlib_mains))
+    {
+      qid = thread_index % tx_queues;
+      clib_spinlock_lock_if_init (&mif->lockp);
+    }
+  else
+    qid = thread_index;
+
+  mq = vec_elt_at_index (mif->tx_queues, qid);
+  ring = mq->ring;
+  ring_size = 1 << mq->log2_ring_size;
+  mask = ring_size - 1;
+retry:
+
+  /* free buffers the master is done with. The tail comes from the master,
+   * never free past the slots posted to it */
+  head = ring->head;
+  tail = ring->tail;
+  if (PREDICT_FALSE ((u16) (tail - mq->last_tail) >
+		     (u16) (head - mq->last_tail)))
+    {
+      vlib_error_count (vm, node->node_index, MEMIF_TX_ERROR_BAD_TAIL, 1);
+      tail = mq->last_tail;
+    }
+  else
+    {
+      memif_free_ring_buffers (vm, mq, mq->last_tail, tail - mq->last_tail);
+      mq->last_tail = tail;
+    }
+
+  free_slots = ring_size - head + tail;
+
+  while (n_left > 2 && free_slots)
+    {
+      vlib_prefetch_buffer_with_index (vm, buffers[2], LOAD);
+      n_slots = memif_zc_buffer_to_tx_ring (vm, mif, mq, buffers[0], head,
+					    mask, free_slots);
+      if (PREDICT_FALSE (n_slots == 0))
+	break;
+      head += n_slots;
+      free_slots -= n_slots;
+      buffers++;
+      n_left--;
+    }
+
+  while (n_left && free_slots)
+    {
+      n_slots = memif_zc_buffer_to_tx_ring (vm, mif, mq, buffers[0], head,
+					    mask, free_slots);
+      if (PREDICT_FALSE (n_slots == 0))
+	break;
+      head += n_slots;
+      free_slots -= n_slots;
+      buffers++;
+      n_left--;
+    }
+
+  CLIB_MEMORY_STORE_BARRIER ();
+  ring->head = head;
+
+  if (n_left && n_retries--)
+    goto retry;
+
+  clib_spinlock_unlock_if_init (&mif->lockp);
+
+  if (n_left)
+    {
+      vlib_error_count (vm, node->node_index, MEMIF_TX_ERROR_NO_FREE_SLOTS,
+			n_left);
+      vlib_buffer_free (vm, buffers, n_left);
+    }
+
+  if ((ring->flags & MEMIF_RING_FLAG_MASK_INT) == 0 && mq->int_fd > -1)
+    {
+      u64 b = 1;
+      CLIB_UNUSED (int r) = write (mq->int_fd, &b, sizeof (b));
+      mq->int_count++;
+    }
+
+  return frame->n_vectors;
+}
+
 uword
 CLIB_MULTIARCH_FN (memif_interface_tx) (vlib_main_t * vm,
 					vlib_node_runtime_t * node,
@@ -262,7 +415,9 @@ CLIB_MULTIARCH_FN (memif_interface_tx) (vlib_main_t * vm,
   vnet_interface_output_runtime_t *rund = (void *) node->runtime_data;
   memif_if_t *mif = pool_elt_at_index (nm->interfaces, rund->dev_instance);
 
-  if (mif->flags & MEMIF_IF_FLAG_IS_SLAVE)
+  if (mif->flags & MEMIF_IF_FLAG_ZERO_COPY)
+    return memif_interface_tx_zc_inline (vm, node, frame, mif);
+  else if (mif->flags & MEMIF_IF_FLAG_IS_SLAVE)
     return memif_interface_tx_inline (vm, node, frame, mif, MEMIF_RING_S2M);
   else
     return memif_interface_tx_inline (vm, node, frame, mif, MEMIF_RING_M2S);
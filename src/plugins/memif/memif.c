@@ -69,6 +69,7 @@ void
 memif_disconnect (memif_if_t * mif, clib_error_t * err)
 {
   memif_main_t *mm = &memif_main;
+  vlib_main_t *vm = vlib_get_main ();
   vnet_main_t *vnm = vnet_get_main ();
   memif_region_t *mr;
   memif_queue_t *mq;
@@ -110,6 +111,21 @@ memif_disconnect (memif_if_t * mif, clib_error_t * err)
       clib_mem_free (mif->sock);
     }
 
+  /* return zero-copy buffers still posted in the rings */
+  vec_foreach (mq, mif->rx_queues)
+  {
+    if (mq->buffers && mq->ring)
+      memif_free_ring_buffers (vm, mq, mq->last_head,
+			       mq->ring->tail + (1 << mq->log2_ring_size) -
+			       mq->last_head);
+  }
+  vec_foreach (mq, mif->tx_queues)
+  {
+    if (mq->buffers && mq->ring)
+      memif_free_ring_buffers (vm, mq, mq->last_tail,
+			       mq->ring->head - mq->last_tail);
+  }
+
   vec_foreach_index (i, mif->rx_queues)
   {
     mq = vec_elt_at_index (mif->rx_queues, i);
@@ -125,16 +141,26 @@ memif_disconnect (memif_if_t * mif, clib_error_t * err)
   }
 
   /* free tx and rx queues */
-  vec_foreach (mq, mif->rx_queues) memif_queue_intfd_close (mq);
+  vec_foreach (mq, mif->rx_queues)
+  {
+    memif_queue_intfd_close (mq);
+    vec_free (mq->buffers);
+  }
   vec_free (mif->rx_queues);
 
-  vec_foreach (mq, mif->tx_queues) memif_queue_intfd_close (mq);
+  vec_foreach (mq, mif->tx_queues)
+  {
+    memif_queue_intfd_close (mq);
+    vec_free (mq->buffers);
+  }
   vec_free (mif->tx_queues);
 
   /* free memory regions */
   vec_foreach (mr, mif->regions)
   {
     int rv;
+    if (mr->is_external)
+      continue;
     if ((rv = munmap (mr->shm, mr->region_size)))
       clib_warning ("munmap failed, rv = %d", rv);
     if (mr->fd > -1)
@@ -262,15 +288,42 @@ memif_get_ring (memif_if_t * mif, memif_ring_type_t type, u16 ring_num)
   return (memif_ring_t *) p;
 }
 
+/*
+ * In zero-copy mode region 0 only holds the rings and the descriptors
+ * point at vlib buffers, which live in the buffer pools' physmem regions.
+ * Those are shared memory already, so they are handed to the master as
+ * regions 1 to n.
+ */
+static void
+memif_add_buffer_pool_regions (vlib_main_t * vm, memif_if_t * mif)
+{
+  vlib_buffer_main_t *bm = vm->buffer_main;
+  vlib_buffer_pool_t *bp;
+  vlib_physmem_region_t *pr;
+  memif_region_t *r;
+
+  vec_foreach (bp, bm->buffer_pools)
+  {
+    pr = vlib_physmem_get_region (vm, bp->physmem_region);
+    vec_add2_aligned (mif->regions, r, 1, CLIB_CACHE_LINE_BYTES);
+    r->shm = pr->mem;
+    r->region_size = pr->size;
+    r->fd = pr->fd;
+    r->is_external = 1;
+  }
+}
+
 clib_error_t *
 memif_init_regions_and_queues (memif_if_t * mif)
 {
+  vlib_main_t *vm = vlib_get_main ();
   memif_ring_t *ring = NULL;
   int i, j;
   u64 buffer_offset;
   memif_region_t *r;
   clib_mem_vm_alloc_t alloc = { 0 };
   clib_error_t *err;
+  int zero_copy = (mif->flags & MEMIF_IF_FLAG_ZERO_COPY) != 0;
 
   vec_validate_aligned (mif->regions, 0, CLIB_CACHE_LINE_BYTES);
   r = vec_elt_at_index (mif->regions, 0);
@@ -279,9 +332,10 @@ memif_init_regions_and_queues (memif_if_t * mif)
     (sizeof (memif_ring_t) +
      sizeof (memif_desc_t) * (1 << mif->run.log2_ring_size));
 
-  r->region_size = buffer_offset +
-    mif->run.buffer_size * (1 << mif->run.log2_ring_size) *
-    (mif->run.num_s2m_rings + mif->run.num_m2s_rings);
+  r->region_size = buffer_offset;
+  if (!zero_copy)
+    r->region_size += mif->run.buffer_size * (1 << mif->run.log2_ring_size) *
+      (mif->run.num_s2m_rings + mif->run.num_m2s_rings);
 
   alloc.name = "memif region";
   alloc.size = r->region_size;
@@ -294,11 +348,17 @@ memif_init_regions_and_queues (memif_if_t * mif)
   r->fd = alloc.fd;
   r->shm = alloc.addr;
 
+  if (zero_copy)
+    memif_add_buffer_pool_regions (vm, mif);
+
   for (i = 0; i < mif->run.num_s2m_rings; i++)
     {
       ring = memif_get_ring (mif, MEMIF_RING_S2M, i);
       ring->head = ring->tail = 0;
       ring->cookie = MEMIF_COOKIE;
+      /* zero-copy descriptors are filled in on tx */
+      if (zero_copy)
+	continue;
       for (j = 0; j < (1 << mif->run.log2_ring_size); j++)
 	{
 	  u16 slot = i * (1 << mif->run.log2_ring_size) + j;
@@ -313,6 +373,9 @@ memif_init_regions_and_queues (memif_if_t * mif)
       ring = memif_get_ring (mif, MEMIF_RING_M2S, i);
       ring->head = ring->tail = 0;
       ring->cookie = MEMIF_COOKIE;
+      /* zero-copy descriptors are posted by memif_refill_rx_ring */
+      if (zero_copy)
+	continue;
       for (j = 0; j < (1 << mif->run.log2_ring_size); j++)
 	{
 	  u16 slot =
@@ -338,6 +401,10 @@ memif_init_regions_and_queues (memif_if_t * mif)
     mq->region = 0;
     mq->offset = (void *) mq->ring - (void *) mif->regions[mq->region].shm;
     mq->last_head = 0;
+    mq->last_tail = 0;
+    if (zero_copy)
+      vec_validate_aligned (mq->buffers, (1 << mq->log2_ring_size) - 1,
+			    CLIB_CACHE_LINE_BYTES);
   }
 
   ASSERT (mif->rx_queues == 0);
@@ -354,6 +421,14 @@ memif_init_regions_and_queues (memif_if_t * mif)
     mq->region = 0;
     mq->offset = (void *) mq->ring - (void *) mif->regions[mq->region].shm;
     mq->last_head = 0;
+    if (zero_copy)
+      {
+	vec_validate_aligned (mq->buffers, (1 << mq->log2_ring_size) - 1,
+			      CLIB_CACHE_LINE_BYTES);
+	/* no slot is writable by the master until a buffer is posted */
+	mq->ring->tail = -(1 << mq->log2_ring_size);
+	memif_refill_rx_ring (vm, mif, mq);
+      }
   }
 
   return 0;
@@ -733,7 +808,11 @@ memif_create_if (vlib_main_t * vm, memif_create_if_args_t * args)
   msf->ref_cnt++;
 
   if (args->is_master == 0)
-    mif->flags |= MEMIF_IF_FLAG_IS_SLAVE;
+    {
+      mif->flags |= MEMIF_IF_FLAG_IS_SLAVE;
+      if (args->is_zero_copy)
+	mif->flags |= MEMIF_IF_FLAG_ZERO_COPY;
+    }
 
   hw = vnet_get_hw_interface (vnm, mif->hw_if_index);
   hw->flags |= VNET_HW_INTERFACE_FLAG_SUPPORTS_INT_MODE;
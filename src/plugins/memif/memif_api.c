@@ -136,6 +136,9 @@ vl_api_memif_create_t_handler (vl_api_memif_create_t * mp)
   /* mode */
   args.mode = mp->mode;
 
+  /* zero-copy, slave only */
+  args.is_zero_copy = !mp->no_zero_copy;
+
   /* rx/tx queues */
   if (args.is_master == 0)
     {
@@ -130,6 +130,7 @@ api_memif_create (vat_main_t * vam)
   u32 tx_queues = MEMIF_DEFAULT_TX_QUEUES;
   int ret;
   u8 mode = MEMIF_INTERFACE_MODE_ETHERNET;
+  u8 no_zero_copy = 0;
 
   while (unformat_check_input (i) != UNFORMAT_END_OF_INPUT)
     {
@@ -150,6 +151,8 @@ api_memif_create (vat_main_t * vam)
 	role = 1;
       else if (unformat (i, "mode ip"))
 	mode = MEMIF_INTERFACE_MODE_IP;
+      else if (unformat (i, "no_zero_copy"))
+	no_zero_copy = 1;
       else if (unformat (i, "hw_addr %U", unformat_ethernet_address, hw_addr))
 	;
       else
@@ -184,6 +187,7 @@ api_memif_create (vat_main_t * vam)
   mp->role = role;
   mp->ring_size = clib_host_to_net_u32 (ring_size);
   mp->buffer_size = clib_host_to_net_u16 (buffer_size & 0xffff);
+  mp->no_zero_copy = no_zero_copy;
   if (socket_filename != 0)
     {
       strncpy ((char *) mp->socket_filename, (char *) socket_filename, 127);
@@ -312,7 +316,7 @@ static void vl_api_memif_details_t_handler (vl_api_memif_details_t * mp)
 #define foreach_vpe_api_msg					  \
 _(memif_create, "[id <id>] [socket <path>] [ring_size <size>] " \
 		"[buffer_size <size>] [hw_addr <mac_address>] "   \
-		"[secret <string>] [mode ip] <master|slave>")	  \
+		"[secret <string>] [mode ip] [no_zero_copy] <master|slave>")	  \
 _(memif_delete, "<sw_if_index>")                                  \
 _(memif_dump, "")
 
@@ -31,7 +31,8 @@
 #include <memif/private.h>
 
 #define foreach_memif_input_error \
-  _(NOT_IP, "not ip packet")
+  _(NOT_IP, "not ip packet") \
+  _(BUFFER_OVERFLOW, "descriptor longer than buffer")
 
 typedef enum
 {
@@ -201,6 +202,80 @@ memif_copy_buffer_from_rx_ring (vlib_main_t * vm, memif_if_t * mif,
   return (total_bytes);
 }
 
+/**
+ * @brief Take the vlib buffers posted in the rx ring (zero-copy)
+ *
+ * @param * vm (in)
+ * @param * mif (in) pointer to memif interface
+ * @param * ring (in) pointer to memif ring
+ * @param * mq (in) pointer to memif queue
+ * @param mask (in) ring size - 1
+ * @param n_buffer_bytes (in) vlib buffer data size
+ * @param ** first_b (out) the first vlib buffer pointer
+ * @param * first_bi (out) the first vlib buffer index
+ * @param * num_slots (in/out) the number of descriptors available to read
+ * @param * oversized (out) set if a descriptor is longer than its buffer
+ *
+ * @return total bytes written by the master to the vlib buffers
+ */
+static_always_inline uword
+memif_zc_buffer_from_rx_ring (vlib_main_t * vm, memif_if_t * mif,
+			      memif_ring_t * ring, memif_queue_t * mq,
+			      u16 mask, u32 n_buffer_bytes,
+			      vlib_buffer_t ** first_b, u32 * first_bi,
+			      u16 * num_slots, u8 * oversized)
+{
+  u32 total_bytes = 0;
+  u32 bi, prev_bi = ~0;
+  vlib_buffer_t *b;
+  memif_desc_t *d;
+  u32 length;
+  u16 slot;
+
+  *oversized = 0;
+  while (*num_slots)
+    {
+      slot = mq->last_head & mask;
+      d = &ring->desc[slot];
+      bi = mq->buffers[slot];
+      b = vlib_get_buffer (vm, bi);
+      b->current_data = 0;
+      /* the length comes from the master, never trust it */
+      length = d->length;
+      if (PREDICT_FALSE (length > n_buffer_bytes))
+	{
+	  length = n_buffer_bytes;
+	  *oversized = 1;
+	}
+      b->current_length = length;
+
+      if (prev_bi == ~0)
+	{
+	  /* fill buffer metadata */
+	  b->total_length_not_including_first_buffer = 0;
+	  b->flags = VLIB_BUFFER_TOTAL_LENGTH_VALID;
+	  vnet_buffer (b)->sw_if_index[VLIB_RX] = mif->sw_if_index;
+	  vnet_buffer (b)->sw_if_index[VLIB_TX] = (u32) ~ 0;
+	  *first_bi = bi;
+	  *first_b = b;
+	}
+      else
+	{
+	  b->flags = 0;
+	  memif_buffer_add_to_chain (vm, bi, *first_bi, prev_bi);
+	}
+
+      total_bytes += length;
+      prev_bi = bi;
+      /* Advance to next descriptor */
+      mq->last_head++;
+      (*num_slots)--;
+      if ((d->flags & MEMIF_DESC_FLAG_NEXT) == 0)
+	break;
+    }
+
+  return (total_bytes);
+}
 
 static_always_inline u32
 memif_next_from_ip_hdr (vlib_node_runtime_t * node, vlib_buffer_t * b)
@@ -221,7 +296,7 @@ static_always_inline uword
 memif_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 			   vlib_frame_t * frame, memif_if_t * mif,
 			   memif_ring_type_t type, u16 qid,
-			   memif_interface_mode_t mode)
+			   memif_interface_mode_t mode, int zero_copy)
 {
   vnet_main_t *vnm = vnet_get_main ();
   memif_ring_t *ring;
@@ -255,7 +330,7 @@ memif_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
     }
 
   n_free_bufs = vec_len (nm->rx_buffers[thread_index]);
-  if (PREDICT_FALSE (n_free_bufs < ring_size))
+  if (PREDICT_FALSE (!zero_copy && n_free_bufs < ring_size))
     {
       vec_validate (nm->rx_buffers[thread_index],
 		    ring_size + n_free_bufs - 1);
@@ -267,9 +342,22 @@ memif_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 
   head = ring->head;
   if (head == mq->last_head)
-    return 0;
+    {
+      /* retry a refill that ran out of buffers */
+      if (zero_copy)
+	memif_refill_rx_ring (vm, mif, mq);
+      return 0;
+    }
 
   num_slots = head - mq->last_head;
+  /*
+   * In zero-copy mode, the slots past the posted ones hold buffers
+   * already handed to the graph: never take more than was posted,
+   * whatever head the master wrote.
+   */
+  if (zero_copy)
+    num_slots = clib_min (num_slots,
+			  (u16) (ring->tail + ring_size - mq->last_head));
 
   while (num_slots)
     {
@@ -293,21 +381,39 @@ memif_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 
 	  vlib_buffer_t *first_b0 = 0;
 	  u32 bi0 = 0, first_bi0 = 0;
-	  b0_total = memif_copy_buffer_from_rx_ring (vm, mif, ring, mq,
-						     ring_size,
-						     n_buffer_bytes,
-						     &n_free_bufs, &first_b0,
-						     &first_bi0, &bi0,
-						     &num_slots);
-
 	  vlib_buffer_t *first_b1 = 0;
 	  u32 bi1 = 0, first_bi1 = 0;
-	  b1_total = memif_copy_buffer_from_rx_ring (vm, mif, ring, mq,
-						     ring_size,
-						     n_buffer_bytes,
-						     &n_free_bufs, &first_b1,
-						     &first_bi1, &bi1,
-						     &num_slots);
+	  u8 oversized0 = 0, oversized1 = 0;
+	  if (zero_copy)
+	    {
+	      b0_total = memif_zc_buffer_from_rx_ring (vm, mif, ring, mq,
+						       mask, n_buffer_bytes,
+						       &first_b0, &first_bi0,
+						       &num_slots,
+						       &oversized0);
+	      b1_total = memif_zc_buffer_from_rx_ring (vm, mif, ring, mq,
+						       mask, n_buffer_bytes,
+						       &first_b1, &first_bi1,
+						       &num_slots,
+						       &oversized1);
+	    }
+	  else
+	    {
+	      b0_total = memif_copy_buffer_from_rx_ring (vm, mif, ring, mq,
+							 ring_size,
+							 n_buffer_bytes,
+							 &n_free_bufs,
+							 &first_b0,
+							 &first_bi0, &bi0,
+							 &num_slots);
+	      b1_total = memif_copy_buffer_from_rx_ring (vm, mif, ring, mq,
+							 ring_size,
+							 n_buffer_bytes,
+							 &n_free_bufs,
+							 &first_b1,
+							 &first_bi1, &bi1,
+							 &num_slots);
+	    }
 
 	  /* enqueue buffer */
 	  to_next[0] = first_bi0;
@@ -333,6 +439,17 @@ memif_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 						    first_b0, first_b1);
 	    }
 
+	  if (PREDICT_FALSE (oversized0))
+	    {
+	      next0 = VNET_DEVICE_INPUT_NEXT_DROP;
+	      first_b0->error = node->errors[MEMIF_INPUT_ERROR_BUFFER_OVERFLOW];
+	    }
+	  if (PREDICT_FALSE (oversized1))
+	    {
+	      next1 = VNET_DEVICE_INPUT_NEXT_DROP;
+	      first_b1->error = node->errors[MEMIF_INPUT_ERROR_BUFFER_OVERFLOW];
+	    }
+
 	  /* trace */
 	  VLIB_BUFFER_TRACE_TRAJECTORY_INIT (first_b0);
 	  VLIB_BUFFER_TRACE_TRAJECTORY_INIT (first_b1);
@@ -381,12 +498,19 @@ memif_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 	{
 	  vlib_buffer_t *first_b0 = 0;
 	  u32 bi0 = 0, first_bi0 = 0;
-	  b0_total = memif_copy_buffer_from_rx_ring (vm, mif, ring, mq,
-						     ring_size,
+	  u8 oversized0 = 0;
+	  if (zero_copy)
+	    b0_total = memif_zc_buffer_from_rx_ring (vm, mif, ring, mq, mask,
 						     n_buffer_bytes,
-						     &n_free_bufs, &first_b0,
-						     &first_bi0, &bi0,
-						     &num_slots);
+						     &first_b0, &first_bi0,
+						     &num_slots, &oversized0);
+	  else
+	    b0_total = memif_copy_buffer_from_rx_ring (vm, mif, ring, mq,
+						       ring_size,
+						       n_buffer_bytes,
+						       &n_free_bufs, &first_b0,
+						       &first_bi0, &bi0,
+						       &num_slots);
 
 	  if (mode == MEMIF_INTERFACE_MODE_IP)
 	    {
@@ -403,6 +527,12 @@ memif_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 						    &next0, first_b0);
 	    }
 
+	  if (PREDICT_FALSE (oversized0))
+	    {
+	      next0 = VNET_DEVICE_INPUT_NEXT_DROP;
+	      first_b0->error = node->errors[MEMIF_INPUT_ERROR_BUFFER_OVERFLOW];
+	    }
+
 	  /* trace */
 	  VLIB_BUFFER_TRACE_TRAJECTORY_INIT (first_b0);
 
@@ -436,8 +566,13 @@ memif_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 	}
       vlib_put_next_frame (vm, node, next_index, n_left_to_next);
     }
-  CLIB_MEMORY_STORE_BARRIER ();
-  ring->tail = head;
+  if (zero_copy)
+    memif_refill_rx_ring (vm, mif, mq);
+  else
+    {
+      CLIB_MEMORY_STORE_BARRIER ();
+      ring->tail = head;
+    }
 
   vlib_increment_combined_counter (vnm->interface_main.combined_sw_if_counters
 				   + VNET_INTERFACE_COUNTER_RX, thread_index,
@@ -447,6 +582,29 @@ memif_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   return n_rx_packets;
 }
 
+/*
+ * In adaptive mode, stop the peer from interrupting us while vlib polls
+ * the queue. Interrupts are unmasked before the last poll which precedes
+ * the switch back to interrupt mode, so that no packet is left behind.
+ */
+static_always_inline void
+memif_adaptive_update_int_mask (memif_if_t * mif, u16 qid,
+				vlib_node_runtime_t * node)
+{
+  memif_queue_t *mq = vec_elt_at_index (mif->rx_queues, qid);
+  u16 flags = mq->ring->flags;
+
+  if ((node->flags & VLIB_NODE_FLAG_SWITCH_FROM_POLLING_TO_INTERRUPT_MODE)
+      || !(node->flags &
+	   VLIB_NODE_FLAG_SWITCH_FROM_INTERRUPT_TO_POLLING_MODE))
+    flags &= ~MEMIF_RING_FLAG_MASK_INT;
+  else
+    flags |= MEMIF_RING_FLAG_MASK_INT;
+
+  if (flags != mq->ring->flags)
+    mq->ring->flags = flags;
+}
+
 uword
 CLIB_MULTIARCH_FN (memif_input_fn) (vlib_main_t * vm,
 				    vlib_node_runtime_t * node,
@@ -457,34 +615,50 @@ CLIB_MULTIARCH_FN (memif_input_fn) (vlib_main_t * vm,
   vnet_device_input_runtime_t *rt = (void *) node->runtime_data;
   vnet_device_and_queue_t *dq;
 
-  foreach_device_and_queue (dq, rt->devices_and_queues)
+  foreach_device_and_queue_adaptive (dq, rt->devices_and_queues, node)
   {
     memif_if_t *mif;
     mif = vec_elt_at_index (nm->interfaces, dq->dev_instance);
     if ((mif->flags & MEMIF_IF_FLAG_ADMIN_UP) &&
 	(mif->flags & MEMIF_IF_FLAG_CONNECTED))
       {
-	if (mif->flags & MEMIF_IF_FLAG_IS_SLAVE)
+	if (PREDICT_FALSE (dq->mode == VNET_HW_INTERFACE_RX_MODE_ADAPTIVE))
+	  memif_adaptive_update_int_mask (mif, dq->queue_id, node);
+	if (mif->flags & MEMIF_IF_FLAG_ZERO_COPY)
+	  {
+	    if (mif->mode == MEMIF_INTERFACE_MODE_IP)
+	      n_rx += memif_device_input_inline (vm, node, frame, mif,
+						 MEMIF_RING_M2S, dq->queue_id,
+						 MEMIF_INTERFACE_MODE_IP, 1);
+	    else
+	      n_rx += memif_device_input_inline (vm, node, frame, mif,
+						 MEMIF_RING_M2S, dq->queue_id,
+						 MEMIF_INTERFACE_MODE_ETHERNET,
+						 1);
+	  }
+	else if (mif->flags & MEMIF_IF_FLAG_IS_SLAVE)
 	  {
 	    if (mif->mode == MEMIF_INTERFACE_MODE_IP)
 	      n_rx += memif_device_input_inline (vm, node, frame, mif,
 						 MEMIF_RING_M2S, dq->queue_id,
-						 MEMIF_INTERFACE_MODE_IP);
+						 MEMIF_INTERFACE_MODE_IP, 0);
 	    else
 	      n_rx += memif_device_input_inline (vm, node, frame, mif,
 						 MEMIF_RING_M2S, dq->queue_id,
-						 MEMIF_INTERFACE_MODE_ETHERNET);
+						 MEMIF_INTERFACE_MODE_ETHERNET,
+						 0);
 	  }
 	else
 	  {
 	    if (mif->mode == MEMIF_INTERFACE_MODE_IP)
 	      n_rx += memif_device_input_inline (vm, node, frame, mif,
 						 MEMIF_RING_S2M, dq->queue_id,
-						 MEMIF_INTERFACE_MODE_IP);
+						 MEMIF_INTERFACE_MODE_IP, 0);
 	    else
 	      n_rx += memif_device_input_inline (vm, node, frame, mif,
 						 MEMIF_RING_S2M, dq->queue_id,
-						 MEMIF_INTERFACE_MODE_ETHERNET);
+						 MEMIF_INTERFACE_MODE_ETHERNET,
+						 0);
 	  }
       }
   }
@@ -82,6 +82,7 @@ typedef struct
   void *shm;
   memif_region_size_t region_size;
   int fd;
+  u8 is_external;		/* vlib buffer memory, not ours to unmap */
 } memif_region_t;
 
 typedef struct
@@ -101,6 +102,9 @@ typedef struct
   u16 last_head;
   u16 last_tail;
 
+  /* zero-copy: vlib buffer behind each descriptor */
+  u32 *buffers;
+
   /* interrupts */
   int int_fd;
   uword int_clib_file_index;
@@ -112,7 +116,8 @@ typedef struct
   _(1, IS_SLAVE, "slave")		\
   _(2, CONNECTING, "connecting")	\
   _(3, CONNECTED, "connected")		\
-  _(4, DELETING, "deleting")
+  _(4, DELETING, "deleting")		\
+  _(5, ZERO_COPY, "zero-copy")
 
 typedef enum
 {
@@ -212,6 +217,7 @@ typedef struct
   u8 hw_addr[6];
   u8 rx_queues;
   u8 tx_queues;
+  u8 is_zero_copy;
 
   /* return */
   u32 sw_if_index;
@@ -228,6 +234,90 @@ memif_get_buffer (memif_if_t * mif, memif_ring_t * ring, u16 slot)
   return mif->regions[region].shm + ring->desc[slot].offset;
 }
 
+/* zero-copy: buffer pool n is shared with the master as region n + 1 */
+static_always_inline memif_region_index_t
+memif_buffer_region (vlib_buffer_t * b)
+{
+  return b->buffer_pool_index + 1;
+}
+
+static_always_inline memif_region_offset_t
+memif_buffer_offset (memif_if_t * mif, memif_region_index_t region, void *p)
+{
+  ASSERT (region < vec_len (mif->regions));
+  return p - mif->regions[region].shm;
+}
+
+/**
+ * @brief Free the zero-copy buffers held by @a n_slots ring slots
+ * starting at @a first
+ */
+static_always_inline void
+memif_free_ring_buffers (vlib_main_t * vm, memif_queue_t * mq, u16 first,
+			 u16 n_slots)
+{
+  u16 mask = (1 << mq->log2_ring_size) - 1;
+  u16 slot, n;
+
+  while (n_slots)
+    {
+      slot = first & mask;
+      n = clib_min (n_slots, mask + 1 - slot);
+      vlib_buffer_free_no_next (vm, mq->buffers + slot, n);
+      first += n;
+      n_slots -= n;
+    }
+}
+
+/**
+ * @brief Post fresh vlib buffers in the zero-copy rx ring
+ *
+ * The master may write any slot below tail + ring size, so every slot the
+ * slave consumed since the last refill, i.e. from tail to last_head, gets a
+ * new buffer before tail is advanced past it.
+ */
+static_always_inline void
+memif_refill_rx_ring (vlib_main_t * vm, memif_if_t * mif, memif_queue_t * mq)
+{
+  memif_ring_t *ring = mq->ring;
+  u16 mask = (1 << mq->log2_ring_size) - 1;
+  u16 tail = ring->tail, n_slots = mq->last_head - tail;
+  u32 n_alloc = 0, n, i, buffer_size;
+  vlib_buffer_t *b;
+  memif_desc_t *d;
+  u16 slot;
+
+  if (n_slots == 0)
+    return;
+
+  while (n_alloc < n_slots)
+    {
+      slot = (tail + n_alloc) & mask;
+      n = clib_min (n_slots - n_alloc, mask + 1 - slot);
+      n = vlib_buffer_alloc (vm, mq->buffers + slot, n);
+      n_alloc += n;
+      if (slot + n <= mask)
+	break;
+    }
+
+  buffer_size = vlib_buffer_free_list_buffer_size (vm,
+						   VLIB_BUFFER_DEFAULT_FREE_LIST_INDEX);
+  for (i = 0; i < n_alloc; i++)
+    {
+      slot = (tail + i) & mask;
+      b = vlib_get_buffer (vm, mq->buffers[slot]);
+      d = &ring->desc[slot];
+      d->flags = 0;
+      d->region = memif_buffer_region (b);
+      d->offset = memif_buffer_offset (mif, d->region, b->data);
+      d->buffer_length = buffer_size;
+      d->length = 0;
+    }
+
+  CLIB_MEMORY_STORE_BARRIER ();
+  ring->tail = tail + n_alloc;
+}
+
 /* memif.c */
 clib_error_t *memif_init_regions_and_queues (memif_if_t * mif);
 clib_error_t *memif_connect (memif_if_t * mif);
@@ -215,6 +215,16 @@ memif_msg_receive_hello (memif_if_t * mif, memif_msg_t * msg)
 				      mif->cfg.log2_ring_size);
   mif->run.buffer_size = mif->cfg.buffer_size;
 
+  /* zero-copy needs one region per buffer pool on top of the rings' one */
+  if ((mif->flags & MEMIF_IF_FLAG_ZERO_COPY) &&
+      h->max_region < vec_len (vlib_get_main ()->buffer_main->buffer_pools))
+    {
+      clib_warning ("%U: peer supports too few regions, disabling "
+		    "zero-copy", format_vnet_sw_if_index_name,
+		    vnet_get_main (), mif->sw_if_index);
+      mif->flags &= ~MEMIF_IF_FLAG_ZERO_COPY;
+    }
+
   mif->remote_name = memif_str2vec (h->name, sizeof (h->name));
 
   return 0;
@@ -428,7 +438,8 @@ memif_msg_receive (memif_if_t ** mifp, clib_socket_t * sock, clib_file_t * uf)
       if ((err = memif_init_regions_and_queues (mif)))
 	return err;
       memif_msg_enq_init (mif);
-      memif_msg_enq_add_region (mif, 0);
+      vec_foreach_index (i, mif->regions)
+	memif_msg_enq_add_region (mif, i);
       vec_foreach_index (i, mif->tx_queues)
 	memif_msg_enq_add_ring (mif, i, MEMIF_RING_S2M);
       vec_foreach_index (i, mif->rx_queues)
@@ -42,6 +42,7 @@ slow_path (dslite_main_t * dm, dslite_session_key_t * in2out_key,
   clib_bihash_kv_8_8_t out2in_kv;
   dlist_elt_t *head_elt, *oldest_elt, *elt;
   u32 oldest_index;
+  ip4_address_t no_addr = {.as_u32 = 0 };
   dslite_session_t *s;
   snat_session_key_t out2in_key;
   u32 address_index;
@@ -108,14 +109,15 @@ slow_path (dslite_main_t * dm, dslite_session_key_t * in2out_key,
 
       if (snat_alloc_outside_address_and_port
 	  (dm->addr_pool, 0, thread_index, &out2in_key,
-	   &s->outside_address_index, 0, dm->port_per_thread, thread_index))
+	   &s->outside_address_index, 0, dm->port_per_thread, thread_index,
+	   no_addr, 0))
 	ASSERT (0);
     }
   else
     {
       if (snat_alloc_outside_address_and_port
 	  (dm->addr_pool, 0, thread_index, &out2in_key, &address_index, 0,
-	   dm->port_per_thread, thread_index))
+	   dm->port_per_thread, thread_index, no_addr, 0))
 	{
 	  *error = DSLITE_ERROR_OUT_OF_PORTS;
 	  return DSLITE_IN2OUT_NEXT_DROP;
@@ -269,6 +269,7 @@ static u32 slow_path (snat_main_t *sm, vlib_buffer_t *b0,
   u32 outside_fib_index;
   uword * p;
   udp_header_t * udp0 = ip4_next_header (ip0);
+  u16 r_port;
 
   if (PREDICT_FALSE (maximum_sessions_exceeded(sm, thread_index)))
     {
@@ -285,6 +286,8 @@ static u32 slow_path (snat_main_t *sm, vlib_buffer_t *b0,
   outside_fib_index = p[0];
 
   key1.protocol = key0->protocol;
+  /* remote port of the return traffic, for the port allocation */
+  r_port = key0->protocol == SNAT_PROTOCOL_ICMP ? 0 : udp0->dst_port;
   user_key.addr = ip0->src_address;
   user_key.fib_index = rx_fib_index0;
   kv0.key = user_key.as_u64;
@@ -347,6 +350,10 @@ static u32 slow_path (snat_main_t *sm, vlib_buffer_t *b0,
                                  session_index);
       } while (snat_is_session_static (s));
 
+      nat44_session_timer_stop (&sm->per_thread_data[thread_index], s);
+      s->flags &= ~(SNAT_SESSION_FLAG_TCP_ESTABLISHED |
+                    SNAT_SESSION_FLAG_TCP_CLOSING);
+
       if (snat_is_unk_proto_session (s))
         {
           clib_bihash_kv_16_8_t up_kv;
@@ -400,7 +407,8 @@ static u32 slow_path (snat_main_t *sm, vlib_buffer_t *b0,
                                                thread_index, &key1,
                                                &address_index, sm->vrf_mode,
                                                sm->port_per_thread,
-                                               sm->per_thread_data[thread_index].snat_thread_index))
+                                               sm->per_thread_data[thread_index].snat_thread_index,
+                                               ip0->dst_address, r_port))
         {
           ASSERT(0);
 
@@ -422,7 +430,8 @@ static u32 slow_path (snat_main_t *sm, vlib_buffer_t *b0,
                                                    thread_index, &key1,
                                                    &address_index, sm->vrf_mode,
                                                    sm->port_per_thread,
-                                                   sm->per_thread_data[thread_index].snat_thread_index))
+                                                   sm->per_thread_data[thread_index].snat_thread_index,
+                                                   ip0->dst_address, r_port))
             {
               b0->error = node->errors[SNAT_IN2OUT_ERROR_OUT_OF_PORTS];
               return SNAT_IN2OUT_NEXT_DROP;
@@ -471,6 +480,7 @@ static u32 slow_path (snat_main_t *sm, vlib_buffer_t *b0,
   s->ext_host_addr.as_u32 = ip0->dst_address.as_u32;
   s->ext_host_port = udp0->dst_port;
   *sessionp = s;
+  nat44_session_timer_start (sm, &sm->per_thread_data[thread_index], s);
 
   /* Add to translation hashes */
   kv0.key = s->in2out.as_u64;
@@ -1268,6 +1278,8 @@ create_ses:
               s = pool_elt_at_index (tsm->sessions, ses_index);
           } while (snat_is_session_static (s));
 
+          nat44_session_timer_stop (tsm, s);
+
           if (snat_is_unk_proto_session (s))
             {
               /* Remove from lookup tables */
@@ -1345,6 +1357,7 @@ create_ses:
         {
           u->nsessions++;
         }
+      nat44_session_timer_start (sm, tsm, s);
 
       /* Add to lookup tables */
       key.l_addr.as_u32 = old_addr;
@@ -1486,6 +1499,7 @@ snat_in2out_lb (snat_main_t *sm,
       s->in2out = l_key;
       s->out2in = e_key;
       u->nstaticsessions++;
+      nat44_session_timer_start (sm, tsm, s);
 
       /* Create list elts */
       pool_get (tsm->list_pool, elt);
@@ -1590,6 +1604,8 @@ snat_in2out_node_fn_inline (vlib_main_t * vm,
           u32 proto0, proto1;
           snat_session_t * s0 = 0, * s1 = 0;
           clib_bihash_kv_8_8_t kv0, value0, kv1, value1;
+          clib_bihash_kv_8_8_t kvs[2], values[2];
+          int rv0 = 0, rv1 = 0, rvs[2];
           u32 iph_offset0 = 0, iph_offset1 = 0;
 
 	  /* Prefetch next iteration. */
@@ -1618,18 +1634,63 @@ snat_in2out_node_fn_inline (vlib_main_t * vm,
 	  b1 = vlib_get_buffer (vm, bi1);
 
           if (is_output_feature)
-            iph_offset0 = vnet_buffer (b0)->ip.save_rewrite_length;
+            {
+              iph_offset0 = vnet_buffer (b0)->ip.save_rewrite_length;
+              iph_offset1 = vnet_buffer (b1)->ip.save_rewrite_length;
+            }
 
           ip0 = (ip4_header_t *) ((u8 *) vlib_buffer_get_current (b0) +
                  iph_offset0);
+          ip1 = (ip4_header_t *) ((u8 *) vlib_buffer_get_current (b1) +
+                 iph_offset1);
 
           udp0 = ip4_next_header (ip0);
           tcp0 = (tcp_header_t *) udp0;
           icmp0 = (icmp46_header_t *) udp0;
+          udp1 = ip4_next_header (ip1);
+          tcp1 = (tcp_header_t *) udp1;
+          icmp1 = (icmp46_header_t *) udp1;
 
           sw_if_index0 = vnet_buffer(b0)->sw_if_index[VLIB_RX];
 	  rx_fib_index0 = vec_elt (sm->ip4_main->fib_index_by_sw_if_index,
                                    sw_if_index0);
+          sw_if_index1 = vnet_buffer(b1)->sw_if_index[VLIB_RX];
+	  rx_fib_index1 = vec_elt (sm->ip4_main->fib_index_by_sw_if_index,
+                                   sw_if_index1);
+
+          proto0 = ip_proto_to_snat_proto (ip0->protocol);
+          proto1 = ip_proto_to_snat_proto (ip1->protocol);
+
+          key0.addr = ip0->src_address;
+          key0.port = udp0->src_port;
+          key0.protocol = proto0;
+          key0.fib_index = rx_fib_index0;
+          key1.addr = ip1->src_address;
+          key1.port = udp1->src_port;
+          key1.protocol = proto1;
+          key1.fib_index = rx_fib_index1;
+
+          kv0.key = key0.as_u64;
+          kv1.key = key1.as_u64;
+
+          /*
+           * The fast path neither creates nor frees sessions, so the
+           * session lookups for both packets are made together; those
+           * of the slow path are made in turn, since the first packet
+           * can add or recycle the session the second finds.
+           */
+          if (!is_slow_path)
+            {
+              kvs[0] = kv0;
+              kvs[1] = kv1;
+              clib_bihash_search_batch_8_8 (
+                &sm->per_thread_data[thread_index].in2out, kvs, values,
+                rvs, 2);
+              rv0 = rvs[0];
+              rv1 = rvs[1];
+              value0 = values[0];
+              value1 = values[1];
+            }
 
           next0 = next1 = SNAT_IN2OUT_NEXT_LOOKUP;
 
@@ -1643,8 +1704,6 @@ snat_in2out_node_fn_inline (vlib_main_t * vm,
               goto trace00;
             }
 
-          proto0 = ip_proto_to_snat_proto (ip0->protocol);
-
           /* Next configured feature, probably ip4-lookup */
           if (is_slow_path)
             {
@@ -1680,15 +1739,11 @@ snat_in2out_node_fn_inline (vlib_main_t * vm,
                 }
             }
 
-          key0.addr = ip0->src_address;
-          key0.port = udp0->src_port;
-          key0.protocol = proto0;
-          key0.fib_index = rx_fib_index0;
-
-          kv0.key = key0.as_u64;
+          if (is_slow_path)
+            rv0 = clib_bihash_search_8_8 (
+              &sm->per_thread_data[thread_index].in2out, &kv0, &value0);
 
-          if (PREDICT_FALSE (clib_bihash_search_8_8 (
-              &sm->per_thread_data[thread_index].in2out, &kv0, &value0) != 0))
+          if (PREDICT_FALSE (rv0 != 0))
             {
               if (is_slow_path)
                 {
@@ -1749,6 +1804,7 @@ snat_in2out_node_fn_inline (vlib_main_t * vm,
 
           if (PREDICT_TRUE(proto0 == SNAT_PROTOCOL_TCP))
             {
+              nat44_session_update_tcp_state (s0, tcp0);
               old_port0 = tcp0->src_port;
               tcp0->src_port = s0->out2in.port;
               new_port0 = tcp0->src_port;
@@ -1799,20 +1855,6 @@ snat_in2out_node_fn_inline (vlib_main_t * vm,
 
           pkts_processed += next0 != SNAT_IN2OUT_NEXT_DROP;
 
-          if (is_output_feature)
-            iph_offset1 = vnet_buffer (b1)->ip.save_rewrite_length;
-
-          ip1 = (ip4_header_t *) ((u8 *) vlib_buffer_get_current (b1) +
-                 iph_offset1);
-
-          udp1 = ip4_next_header (ip1);
-          tcp1 = (tcp_header_t *) udp1;
-          icmp1 = (icmp46_header_t *) udp1;
-
-          sw_if_index1 = vnet_buffer(b1)->sw_if_index[VLIB_RX];
-	  rx_fib_index1 = vec_elt (sm->ip4_main->fib_index_by_sw_if_index,
-                                   sw_if_index1);
-
           if (PREDICT_FALSE(ip1->ttl == 1))
             {
               vnet_buffer (b1)->sw_if_index[VLIB_TX] = (u32) ~ 0;
@@ -1823,8 +1865,6 @@ snat_in2out_node_fn_inline (vlib_main_t * vm,
               goto trace01;
             }
 
-          proto1 = ip_proto_to_snat_proto (ip1->protocol);
-
           /* Next configured feature, probably ip4-lookup */
           if (is_slow_path)
             {
@@ -1862,15 +1902,11 @@ snat_in2out_node_fn_inline (vlib_main_t * vm,
 
           b1->flags |= VNET_BUFFER_F_IS_NATED;
 
-          key1.addr = ip1->src_address;
-          key1.port = udp1->src_port;
-          key1.protocol = proto1;
-          key1.fib_index = rx_fib_index1;
-
-          kv1.key = key1.as_u64;
+          if (is_slow_path)
+            rv1 = clib_bihash_search_8_8 (
+              &sm->per_thread_data[thread_index].in2out, &kv1, &value1);
 
-            if (PREDICT_FALSE(clib_bihash_search_8_8 (
-                &sm->per_thread_data[thread_index].in2out, &kv1, &value1) != 0))
+          if (PREDICT_FALSE (rv1 != 0))
             {
               if (is_slow_path)
                 {
@@ -1929,6 +1965,7 @@ snat_in2out_node_fn_inline (vlib_main_t * vm,
 
           if (PREDICT_TRUE(proto1 == SNAT_PROTOCOL_TCP))
             {
+              nat44_session_update_tcp_state (s1, tcp1);
               old_port1 = tcp1->src_port;
               tcp1->src_port = s1->out2in.port;
               new_port1 = tcp1->src_port;
@@ -2146,6 +2183,7 @@ snat_in2out_node_fn_inline (vlib_main_t * vm,
 
           if (PREDICT_TRUE(proto0 == SNAT_PROTOCOL_TCP))
             {
+              nat44_session_update_tcp_state (s0, tcp0);
               old_port0 = tcp0->src_port;
               tcp0->src_port = s0->out2in.port;
               new_port0 = tcp0->src_port;
@@ -3661,6 +3699,7 @@ snat_in2out_worker_handoff_fn_inline (vlib_main_t * vm,
             {
               hf->n_vectors = VLIB_FRAME_SIZE;
               vlib_put_frame_queue_elt (hf);
+              vlib_main_wakeup (vlib_mains[next_worker_index]);
               current_worker_index = ~0;
               handoff_queue_elt_by_worker_index[next_worker_index] = 0;
               hf = 0;
@@ -3710,6 +3749,7 @@ snat_in2out_worker_handoff_fn_inline (vlib_main_t * vm,
 	  if (1 || hf->n_vectors == hf->last_n_vectors)
 	    {
 	      vlib_put_frame_queue_elt (hf);
+	      vlib_main_wakeup (vlib_mains[i]);
 	      handoff_queue_elt_by_worker_index[i] = 0;
 	    }
 	  else
@@ -711,6 +711,7 @@ int snat_add_static_mapping(ip4_address_t l_addr, ip4_address_t e_addr,
                       if (clib_bihash_add_del_8_8 (&tsm->out2in, &value, 0))
                         clib_warning ("out2in key del failed");
 delete:
+                      nat44_session_timer_stop (tsm, s);
                       pool_put (tsm->sessions, s);
 
                       clib_dlist_remove (tsm->list_pool, del_elt_index);
@@ -1075,6 +1076,7 @@ int snat_del_address (snat_main_t *sm, ip4_address_t addr, u8 delete_sm)
                     kv.key = ses->out2in.as_u64;
                     clib_bihash_add_del_8_8 (&tsm->out2in, &kv, 0);
                   }
+                nat44_session_timer_stop (tsm, ses);
                 vec_add1 (ses_to_be_removed, ses - tsm->sessions);
                 clib_dlist_remove (tsm->list_pool, ses->per_user_index);
                 user_key.addr = ses->in2out.addr;
@@ -1118,6 +1120,8 @@ int snat_del_address (snat_main_t *sm, ip4_address_t addr, u8 delete_sm)
   return 0;
 }
 
+static void nat44_session_aging_enable (snat_main_t * sm);
+
 int snat_interface_add_del (u32 sw_if_index, u8 is_inside, int is_del)
 {
   snat_main_t *sm = &snat_main;
@@ -1142,6 +1146,9 @@ int snat_interface_add_del (u32 sw_if_index, u8 is_inside, int is_del)
   if (sm->fq_in2out_index == ~0 && !sm->deterministic && sm->num_workers > 1)
     sm->fq_in2out_index = vlib_frame_queue_main_init (sm->in2out_node_index, 0);
 
+  if (!is_del)
+    nat44_session_aging_enable (sm);
+
   if (sm->fq_out2in_index == ~0 && !sm->deterministic && sm->num_workers > 1)
     sm->fq_out2in_index = vlib_frame_queue_main_init (sm->out2in_node_index, 0);
 
@@ -1267,6 +1274,9 @@ int snat_interface_add_del_output_feature (u32 sw_if_index,
       (sm->static_mapping_only && !(sm->static_mapping_connection_tracking)))
     return VNET_API_ERROR_UNSUPPORTED;
 
+  if (!is_del)
+    nat44_session_aging_enable (sm);
+
   if (is_inside)
     {
       vnet_feature_enable_disable ("ip4-unicast", "nat44-hairpin-dst",
@@ -1386,7 +1396,9 @@ nat_alloc_addr_and_port_default (snat_address_t * addresses,
                                  u32 * address_indexp,
                                  u8 vrf_mode,
                                  u16 port_per_thread,
-                                 u32 snat_thread_index);
+                                 u32 snat_thread_index,
+                                 ip4_address_t r_addr,
+                                 u16 r_port);
 
 static clib_error_t * snat_init (vlib_main_t * vm)
 {
@@ -1419,6 +1431,8 @@ static clib_error_t * snat_init (vlib_main_t * vm)
   sm->tcp_transitory_timeout = SNAT_TCP_TRANSITORY_TIMEOUT;
   sm->icmp_timeout = SNAT_ICMP_TIMEOUT;
   sm->alloc_addr_and_port = nat_alloc_addr_and_port_default;
+  sm->rss_reta_size = 128;
+  clib_toeplitz_symmetric_key (sm->rss_key, sizeof (sm->rss_key));
 
   p = hash_get_mem (tm->thread_registrations_by_name, "workers");
   if (p)
@@ -1606,13 +1620,15 @@ snat_alloc_outside_address_and_port (snat_address_t * addresses,
                                      u32 * address_indexp,
                                      u8 vrf_mode,
                                      u16 port_per_thread,
-                                     u32 snat_thread_index)
+                                     u32 snat_thread_index,
+                                     ip4_address_t r_addr,
+                                     u16 r_port)
 {
   snat_main_t *sm = &snat_main;
 
   return sm->alloc_addr_and_port(addresses, fib_index, thread_index, k,
                                  address_indexp, vrf_mode, port_per_thread,
-                                 snat_thread_index);
+                                 snat_thread_index, r_addr, r_port);
 }
 
 static int
@@ -1623,7 +1639,9 @@ nat_alloc_addr_and_port_default (snat_address_t * addresses,
                                  u32 * address_indexp,
                                  u8 vrf_mode,
                                  u16 port_per_thread,
-                                 u32 snat_thread_index)
+                                 u32 snat_thread_index,
+                                 ip4_address_t r_addr,
+                                 u16 r_port)
 {
   int i;
   snat_address_t *a;
@@ -1678,7 +1696,9 @@ nat_alloc_addr_and_port_mape (snat_address_t * addresses,
                               u32 * address_indexp,
                               u8 vrf_mode,
                               u16 port_per_thread,
-                              u32 snat_thread_index)
+                              u32 snat_thread_index,
+                              ip4_address_t r_addr,
+                              u16 r_port)
 {
   snat_main_t *sm = &snat_main;
   snat_address_t *a = addresses;
@@ -1724,6 +1744,158 @@ exhausted:
   return 1;
 }
 
+static vnet_hw_interface_t *
+nat_rss_outside_hw_interface (snat_main_t * sm)
+{
+  snat_interface_t *i;
+
+  pool_foreach (i, sm->interfaces,
+  ({
+    if (nat_interface_is_outside(i))
+      return vnet_get_sup_hw_interface (sm->vnet_main, i->sw_if_index);
+  }));
+  pool_foreach (i, sm->output_feature_interfaces,
+  ({
+    if (nat_interface_is_outside(i))
+      return vnet_get_sup_hw_interface (sm->vnet_main, i->sw_if_index);
+  }));
+
+  return 0;
+}
+
+/**
+ * RSS aware port allocation.
+ *
+ * The outside NIC hashes the return traffic of a session with the
+ * Toeplitz function over (remote address, outside address, remote port,
+ * outside port) and the default redirection table maps the hash to queue
+ * (hash % reta-size) % n-queues. Pick, from this thread's port range, an
+ * outside port for which that queue is polled by this thread, so that the
+ * return traffic is received on the worker owning the session and the
+ * out2in handoff keeps it there instead of queueing it to another worker.
+ *
+ * The outside NIC has to be configured with "rss-symmetric" so that its
+ * key is known. Ports stay partitioned per thread, so a mapping reused for
+ * another remote endpoint, which hashes elsewhere, is still handed off to
+ * the right worker.
+ */
+static int
+nat_alloc_addr_and_port_rss (snat_address_t * addresses,
+                             u32 fib_index,
+                             u32 thread_index,
+                             snat_session_key_t * k,
+                             u32 * address_indexp,
+                             u8 vrf_mode,
+                             u16 port_per_thread,
+                             u32 snat_thread_index,
+                             ip4_address_t r_addr,
+                             u16 r_port)
+{
+  snat_main_t *sm = &snat_main;
+  vnet_hw_interface_t *hw;
+  snat_address_t *a;
+  u16 *busy_ports = 0, *busy_ports_per_thread = 0;
+  uword *busy_port_bitmap = 0;
+  u8 tuple[12], port_tuple[12];
+  u32 n_queues, base, hash, queue;
+  u32 portnum, fallback;
+  int i, try;
+
+  hw = nat_rss_outside_hw_interface (sm);
+
+  /* ICMP is hashed on the addresses only, nothing to steer with the port */
+  if (!hw || !r_port || k->protocol == SNAT_PROTOCOL_ICMP ||
+      vec_len (hw->input_node_thread_index_by_queue) < 2)
+    return nat_alloc_addr_and_port_default (addresses, fib_index,
+                                            thread_index, k, address_indexp,
+                                            vrf_mode, port_per_thread,
+                                            snat_thread_index, r_addr,
+                                            r_port);
+
+  n_queues = vec_len (hw->input_node_thread_index_by_queue);
+
+  /* the return traffic: remote -> outside address */
+  clib_memcpy (tuple, &r_addr, 4);
+  clib_memcpy (tuple + 8, &r_port, 2);
+  tuple[10] = tuple[11] = 0;
+  memset (port_tuple, 0, sizeof (port_tuple));
+
+  for (i = 0; i < vec_len (addresses); i++)
+    {
+      a = addresses + i;
+      if (vrf_mode && a->fib_index != ~0 && a->fib_index != fib_index)
+        continue;
+      switch (k->protocol)
+        {
+#define _(N, j, n, s) \
+        case SNAT_PROTOCOL_##N: \
+          busy_ports = &a->busy_##n##_ports; \
+          busy_ports_per_thread = a->busy_##n##_ports_per_thread; \
+          busy_port_bitmap = a->busy_##n##_port_bitmap; \
+          break;
+          foreach_snat_protocol
+#undef _
+        default:
+          clib_warning("unknown protocol");
+          return 1;
+        }
+
+      if (busy_ports_per_thread[thread_index] >= port_per_thread)
+        continue;
+
+      clib_memcpy (tuple + 4, &a->addr, 4);
+      base = clib_toeplitz_hash (sm->rss_key, sizeof (sm->rss_key),
+                                 tuple, sizeof (tuple));
+
+      /*
+       * Each try lands on this thread's queues with probability of about
+       * 1 / n-workers; if the ports which do are all taken settle for
+       * a free one and let the handoff deal with it.
+       */
+      fallback = ~0;
+      for (try = 0; try < 16 * n_queues; try++)
+        {
+          portnum = (port_per_thread * snat_thread_index) +
+            snat_random_port (1, port_per_thread) + 1024;
+          if (clib_bitmap_get_no_check (busy_port_bitmap, portnum))
+            continue;
+          if (fallback == ~0)
+            fallback = portnum;
+
+          port_tuple[10] = portnum >> 8;
+          port_tuple[11] = portnum;
+          hash = base ^ clib_toeplitz_hash (sm->rss_key, sizeof (sm->rss_key),
+                                            port_tuple, sizeof (port_tuple));
+          queue = (hash & (sm->rss_reta_size - 1)) % n_queues;
+          if (hw->input_node_thread_index_by_queue[queue] == thread_index)
+            goto found;
+        }
+
+      portnum = fallback;
+      /* unlucky, but there is a free port somewhere in the range */
+      while (portnum == ~0)
+        {
+          portnum = (port_per_thread * snat_thread_index) +
+            snat_random_port (1, port_per_thread) + 1024;
+          if (clib_bitmap_get_no_check (busy_port_bitmap, portnum))
+            portnum = ~0;
+        }
+
+    found:
+      clib_bitmap_set_no_check (busy_port_bitmap, portnum, 1);
+      busy_ports_per_thread[thread_index]++;
+      (*busy_ports)++;
+      k->addr = a->addr;
+      k->port = clib_host_to_net_u16 (portnum);
+      *address_indexp = i;
+      return 0;
+    }
+
+  /* Totally out of translations to use... */
+  snat_ipfix_logging_addresses_exhausted(0);
+  return 1;
+}
+
 static clib_error_t *
 add_address_command_fn (vlib_main_t * vm,
                         unformat_input_t * input,
@@ -2549,6 +2721,11 @@ snat_config (vlib_main_t * vm, unformat_input_t * input)
 
               clib_bihash_init_8_8 (&tsm->user_hash, "users", user_buckets,
                                     user_memory_size);
+
+              tw_timer_wheel_init_16t_2w_512sl (&tsm->session_timer_wheel,
+                                                0 /* no callback */,
+                                                NAT44_SESSION_TIMER_TICK,
+                                                NAT44_SESSION_EXPIRE_BATCH);
             }
 
           clib_bihash_init_16_8 (&sm->in2out_ed, "in2out-ed",
@@ -2627,6 +2804,8 @@ u8 * format_snat_session (u8 * s, va_list * args)
       s = format (s, "       external host %U\n",
                   format_ip4_address, &sess->ext_host_addr);
   s = format (s, "       last heard %.2f\n", sess->last_heard);
+  s = format (s, "       idle timeout %us\n",
+              nat44_session_get_timeout (&snat_main, sess));
   s = format (s, "       total pkts %d, total bytes %lld\n",
               sess->total_pkts, sess->total_bytes);
   if (snat_is_session_static (sess))
@@ -3214,6 +3393,7 @@ nat44_del_session (snat_main_t *sm, ip4_address_t *addr, u16 port,
           u->nsessions--;
         }
       clib_dlist_remove (tsm->list_pool, s->per_user_index);
+      nat44_session_timer_stop (tsm, s);
       pool_put (tsm->sessions, s);
       return 0;
     }
@@ -3221,6 +3401,290 @@ nat44_del_session (snat_main_t *sm, ip4_address_t *addr, u16 port,
   return VNET_API_ERROR_NO_SUCH_ENTRY;
 }
 
+/**
+ * @brief Delete a NAT44 session whose aging timer expired.
+ *
+ * Removes the session from the lookup tables, returns the outside port of a
+ * dynamic session and frees the user once it has no sessions left.
+ */
+static void
+nat44_session_expire (snat_main_t * sm, snat_main_per_thread_data_t * tsm,
+                      snat_session_t * s, u32 thread_index)
+{
+  clib_bihash_kv_8_8_t kv, value;
+  clib_bihash_kv_16_8_t ed_kv;
+  nat_ed_ses_key_t ed_key;
+  snat_user_key_t u_key;
+  snat_user_t *u;
+
+  if (snat_is_unk_proto_session (s) ||
+      (s->flags & SNAT_SESSION_FLAG_LOAD_BALANCING))
+    {
+      ed_key.l_addr = s->in2out.addr;
+      ed_key.r_addr = s->ext_host_addr;
+      ed_key.fib_index = s->in2out.fib_index;
+      ed_key.rsvd = 0;
+      if (snat_is_unk_proto_session (s))
+        {
+          ed_key.proto = s->in2out.port;
+          ed_key.l_port = 0;
+        }
+      else
+        {
+          ed_key.proto = snat_proto_to_ip_proto (s->in2out.protocol);
+          ed_key.l_port = s->in2out.port;
+        }
+      ed_kv.key[0] = ed_key.as_u64[0];
+      ed_kv.key[1] = ed_key.as_u64[1];
+      if (clib_bihash_add_del_16_8 (&sm->in2out_ed, &ed_kv, 0))
+        clib_warning ("in2out-ed key del failed");
+
+      ed_key.l_addr = s->out2in.addr;
+      ed_key.fib_index = s->out2in.fib_index;
+      if (!snat_is_unk_proto_session (s))
+        ed_key.l_port = s->out2in.port;
+      ed_kv.key[0] = ed_key.as_u64[0];
+      ed_kv.key[1] = ed_key.as_u64[1];
+      if (clib_bihash_add_del_16_8 (&sm->out2in_ed, &ed_kv, 0))
+        clib_warning ("out2in-ed key del failed");
+    }
+  else
+    {
+      /* log NAT event */
+      snat_ipfix_logging_nat44_ses_delete(s->in2out.addr.as_u32,
+                                          s->out2in.addr.as_u32,
+                                          s->in2out.protocol,
+                                          s->in2out.port,
+                                          s->out2in.port,
+                                          s->in2out.fib_index);
+
+      kv.key = s->in2out.as_u64;
+      if (clib_bihash_add_del_8_8 (&tsm->in2out, &kv, 0))
+        clib_warning ("in2out key del failed");
+      kv.key = s->out2in.as_u64;
+      if (clib_bihash_add_del_8_8 (&tsm->out2in, &kv, 0))
+        clib_warning ("out2in key del failed");
+
+      if (!snat_is_session_static (s) && s->outside_address_index != ~0)
+        snat_free_outside_address_and_port (sm->addresses, thread_index,
+                                            &s->out2in,
+                                            s->outside_address_index);
+    }
+
+  u_key.addr = s->in2out.addr;
+  u_key.fib_index = s->in2out.fib_index;
+  kv.key = u_key.as_u64;
+  if (!clib_bihash_search_8_8 (&tsm->user_hash, &kv, &value))
+    {
+      u = pool_elt_at_index (tsm->users, value.value);
+      if (snat_is_session_static (s))
+        u->nstaticsessions--;
+      else
+        u->nsessions--;
+
+      if (!u->nsessions && !u->nstaticsessions)
+        {
+          pool_put_index (tsm->list_pool,
+                          u->sessions_per_user_list_head_index);
+          pool_put (tsm->users, u);
+          clib_bihash_add_del_8_8 (&tsm->user_hash, &kv, 0);
+        }
+    }
+
+  clib_dlist_remove (tsm->list_pool, s->per_user_index);
+  pool_put_index (tsm->list_pool, s->per_user_index);
+  pool_put (tsm->sessions, s);
+}
+
+#define foreach_nat44_session_expire_error                      \
+_(EXPIRED, "sessions expired")                                  \
+_(REARMED, "session timers re-armed")
+
+typedef enum {
+#define _(sym,str) NAT44_SESSION_EXPIRE_ERROR_##sym,
+  foreach_nat44_session_expire_error
+#undef _
+  NAT44_SESSION_EXPIRE_N_ERROR,
+} nat44_session_expire_error_t;
+
+static char * nat44_session_expire_error_strings[] = {
+#define _(sym,string) string,
+  foreach_nat44_session_expire_error
+#undef _
+};
+
+/**
+ * @brief Age out idle NAT44 sessions of this thread.
+ *
+ * The timer of a session is started once with its idle timeout and is not
+ * touched by the data plane. When it fires the session is deleted only if it
+ * has really been idle for the whole timeout, otherwise the timer is started
+ * again for the remaining time.
+ *
+ * The wheel only stops between ticks, so the timers which expire in one tick
+ * go to a backlog first, and at most NAT44_SESSION_EXPIRE_BATCH of them are
+ * looked at per dispatch. The node is an interrupt node, raised every tick by
+ * nat44-session-aging-process, and raises itself again while the backlog is
+ * not empty.
+ */
+static uword
+nat44_session_expire_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
+                         vlib_frame_t * frame)
+{
+  snat_main_t *sm = &snat_main;
+  u32 thread_index = vlib_get_thread_index ();
+  snat_main_per_thread_data_t *tsm = &sm->per_thread_data[thread_index];
+  tw_timer_wheel_16t_2w_512sl_t *tw = &tsm->session_timer_wheel;
+  f64 now = vlib_time_now (vm);
+  u32 n_expired = 0, n_rearmed = 0;
+  snat_session_t *s;
+  f64 remaining;
+  u32 i, end, session_index, ticks;
+
+  /* Count the ticks from the first run on this thread, not from time 0 */
+  if (PREDICT_FALSE (tw->last_run_time == 0))
+    {
+      tw->last_run_time = now;
+      tw->next_run_time = now + tw->timer_interval;
+      return 0;
+    }
+
+  if (vec_len (tsm->expired_sessions) == 0)
+    {
+      if (now < tw->next_run_time)
+        return 0;
+
+      tsm->expired_sessions =
+        tw_timer_expire_timers_vec_16t_2w_512sl (tw, now,
+                                                 tsm->expired_sessions);
+      tsm->expired_cursor = 0;
+      /* The timers are gone from the wheel */
+      for (i = 0; i < vec_len (tsm->expired_sessions); i++)
+        {
+          session_index = tsm->expired_sessions[i] & 0x0FFFFFFF;
+          if (!pool_is_free_index (tsm->sessions, session_index))
+            pool_elt_at_index (tsm->sessions, session_index)->timer_handle =
+              ~0;
+        }
+    }
+
+  end = clib_min (vec_len (tsm->expired_sessions),
+                  tsm->expired_cursor + NAT44_SESSION_EXPIRE_BATCH);
+
+  for (i = tsm->expired_cursor; i < end; i++)
+    {
+      session_index = tsm->expired_sessions[i] & 0x0FFFFFFF;
+      if (pool_is_free_index (tsm->sessions, session_index))
+        continue;
+
+      s = pool_elt_at_index (tsm->sessions, session_index);
+      /* A new session took the pool entry while this one was queued */
+      if (s->timer_handle != ~0)
+        continue;
+
+      remaining = s->last_heard + (f64) nat44_session_get_timeout (sm, s) - now;
+      if (remaining > 0)
+        {
+          ticks = clib_min ((u32) remaining + 1, NAT44_SESSION_TIMER_MAX_TICKS);
+          s->timer_handle =
+            tw_timer_start_16t_2w_512sl (tw, session_index, 0, ticks);
+          n_rearmed++;
+          continue;
+        }
+
+      nat44_session_expire (sm, tsm, s, thread_index);
+      n_expired++;
+    }
+  tsm->expired_cursor = end;
+
+  /* Backlog left, come back in the next loop */
+  if (end < vec_len (tsm->expired_sessions))
+    vlib_node_set_interrupt_pending (vm, node->node_index);
+  else
+    _vec_len (tsm->expired_sessions) = 0;
+
+  if (n_expired)
+    vlib_node_increment_counter (vm, node->node_index,
+                                 NAT44_SESSION_EXPIRE_ERROR_EXPIRED,
+                                 n_expired);
+  if (n_rearmed)
+    vlib_node_increment_counter (vm, node->node_index,
+                                 NAT44_SESSION_EXPIRE_ERROR_REARMED,
+                                 n_rearmed);
+
+  return 0;
+}
+
+VLIB_REGISTER_NODE (nat44_session_expire_node) = {
+  .function = nat44_session_expire_fn,
+  .name = "nat44-session-expire",
+  .type = VLIB_NODE_TYPE_INPUT,
+  .state = VLIB_NODE_STATE_DISABLED,
+  .n_errors = ARRAY_LEN(nat44_session_expire_error_strings),
+  .error_strings = nat44_session_expire_error_strings,
+};
+
+/**
+ * @brief The 'nat44-session-aging-process' main loop.
+ *
+ * Raise nat44-session-expire on the threads which own NAT44 sessions once
+ * per timer tick, so that idle workers sleep in between.
+ */
+static uword
+nat44_session_aging_process_fn (vlib_main_t * vm, vlib_node_runtime_t * rt,
+                                vlib_frame_t * f)
+{
+  snat_main_t *sm = &snat_main;
+  u32 ii;
+
+  /* Wait for nat44_session_aging_enable */
+  vlib_process_wait_for_event (vm);
+  vlib_process_get_events (vm, NULL);
+
+  while (1)
+    {
+      vlib_process_suspend (vm, NAT44_SESSION_TIMER_TICK);
+      for (ii = 0; ii < vec_len (vlib_mains); ii++)
+        if (!sm->num_workers || ii > 0)
+          vlib_node_set_interrupt_pending (vlib_mains[ii],
+                                           nat44_session_expire_node.index);
+    }
+
+  return 0;
+}
+
+static vlib_node_registration_t nat44_session_aging_process_node;
+
+VLIB_REGISTER_NODE (nat44_session_aging_process_node, static) = {
+  .function = nat44_session_aging_process_fn,
+  .type = VLIB_NODE_TYPE_PROCESS,
+  .name = "nat44-session-aging-process",
+};
+
+/**
+ * @brief Enable session aging on the threads which own NAT44 sessions.
+ */
+static void
+nat44_session_aging_enable (snat_main_t * sm)
+{
+  if (sm->session_aging_enabled || sm->deterministic ||
+      (sm->static_mapping_only && !(sm->static_mapping_connection_tracking)))
+    return;
+
+  sm->session_aging_enabled = 1;
+
+  /* *INDENT-OFF* */
+  foreach_vlib_main (({
+    if (!sm->num_workers || ii > 0)
+      vlib_node_set_state (this_vlib_main, nat44_session_expire_node.index,
+                           VLIB_NODE_STATE_INTERRUPT);
+  }));
+  /* *INDENT-ON* */
+
+  vlib_process_signal_event (sm->vlib_main,
+                             nat44_session_aging_process_node.index, 0, 0);
+}
+
 static clib_error_t *
 nat44_del_session_command_fn (vlib_main_t * vm,
                               unformat_input_t * input,
@@ -3292,6 +3756,7 @@ nat44_set_alloc_addr_and_port_alg_command_fn (vlib_main_t * vm,
   unformat_input_t _line_input, *line_input = &_line_input;
   clib_error_t *error = 0;
   u32 psid, psid_offset, psid_length;
+  u32 reta_size;
 
   /* Get a line of input. */
   if (!unformat_user (input, unformat_line_input, line_input))
@@ -3309,6 +3774,18 @@ nat44_set_alloc_addr_and_port_alg_command_fn (vlib_main_t * vm,
           sm->psid_offset = (u16) psid_offset;
           sm->psid_length = (u16) psid_length;
         }
+      else if (unformat (line_input, "rss reta-size %u", &reta_size))
+        {
+          if (!is_pow2 (reta_size))
+            {
+              error = clib_error_return (0, "reta-size must be a power of 2");
+              goto done;
+            }
+          sm->alloc_addr_and_port = nat_alloc_addr_and_port_rss;
+          sm->rss_reta_size = reta_size;
+        }
+      else if (unformat (line_input, "rss"))
+        sm->alloc_addr_and_port = nat_alloc_addr_and_port_rss;
       else
         {
           error = clib_error_return (0, "unknown input '%U'",
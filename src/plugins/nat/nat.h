@@ -27,6 +27,8 @@
 #include <vppinfra/bihash_16_8.h>
 #include <vppinfra/dlist.h>
 #include <vppinfra/error.h>
+#include <vppinfra/toeplitz.h>
+#include <vppinfra/tw_timer_16t_2w_512sl.h>
 #include <vlibapi/api.h>
 
 
@@ -128,6 +130,8 @@ typedef enum {
 #define SNAT_SESSION_FLAG_STATIC_MAPPING 1
 #define SNAT_SESSION_FLAG_UNKNOWN_PROTO  2
 #define SNAT_SESSION_FLAG_LOAD_BALANCING 4
+#define SNAT_SESSION_FLAG_TCP_ESTABLISHED 8
+#define SNAT_SESSION_FLAG_TCP_CLOSING 16
 
 #define NAT_INTERFACE_FLAG_IS_INSIDE 1
 #define NAT_INTERFACE_FLAG_IS_OUTSIDE 2
@@ -157,6 +161,9 @@ typedef CLIB_PACKED(struct {
   /* External host address and port */
   ip4_address_t ext_host_addr;  /* 68-71 */
   u16 ext_host_port;            /* 72-73 */
+
+  /* Session aging timer */
+  u32 timer_handle;             /* 74-77 */
 }) snat_session_t;
 
 
@@ -251,6 +258,12 @@ typedef struct {
   /* Pool of doubly-linked list elements */
   dlist_elt_t * list_pool;
 
+  /* Session aging, 1 second ticks */
+  tw_timer_wheel_16t_2w_512sl_t session_timer_wheel;
+  /* Sessions whose timers expired, and the next one of them to look at */
+  u32 *expired_sessions;
+  u32 expired_cursor;
+
   u32 snat_thread_index;
 } snat_main_per_thread_data_t;
 
@@ -276,7 +289,9 @@ typedef int nat_alloc_out_addr_and_port_function_t (snat_address_t * addresses,
                                                     u32 * address_indexp,
                                                     u8 vrf_mode,
                                                     u16 port_per_thread,
-                                                    u32 snat_thread_index);
+                                                    u32 snat_thread_index,
+                                                    ip4_address_t r_addr,
+                                                    u16 r_port);
 
 typedef struct snat_main_s {
   /* Endpoint address dependent sessions lookup tables */
@@ -317,6 +332,9 @@ typedef struct snat_main_s {
   u8 psid_offset;
   u8 psid_length;
   u16 psid;
+  /* RSS aware port allocation, see nat_alloc_addr_and_port_rss */
+  u32 rss_reta_size;
+  u8 rss_key[CLIB_TOEPLITZ_SYMMETRIC_KEY_SIZE];
 
   /* sw_if_indices whose intfc addresses should be auto-added */
   u32 * auto_add_sw_if_indices;
@@ -363,6 +381,7 @@ typedef struct snat_main_s {
   u32 tcp_established_timeout;
   u32 tcp_transitory_timeout;
   u32 icmp_timeout;
+  u8 session_aging_enabled;
 
   /* API message ID base */
   u16 msg_id_base;
@@ -388,6 +407,7 @@ extern vlib_node_registration_t snat_det_in2out_node;
 extern vlib_node_registration_t snat_det_out2in_node;
 extern vlib_node_registration_t snat_hairpin_dst_node;
 extern vlib_node_registration_t snat_hairpin_src_node;
+extern vlib_node_registration_t nat44_session_expire_node;
 
 void snat_free_outside_address_and_port (snat_address_t * addresses,
                                          u32 thread_index,
@@ -401,7 +421,9 @@ int snat_alloc_outside_address_and_port (snat_address_t * addresses,
                                          u32 * address_indexp,
                                          u8 vrf_mode,
                                          u16 port_per_thread,
-                                         u32 snat_thread_index);
+                                         u32 snat_thread_index,
+                                         ip4_address_t r_addr,
+                                         u16 r_port);
 
 int snat_static_mapping_match (snat_main_t * sm,
                                snat_session_key_t match,
@@ -431,11 +453,98 @@ typedef struct {
     @param s SNAT session
     @return 1 if SNAT session for unknown protocol otherwise 0
 */
-#define snat_is_unk_proto_session(s) s->flags & SNAT_SESSION_FLAG_UNKNOWN_PROTO
+#define snat_is_unk_proto_session(s) \
+  ((s)->flags & SNAT_SESSION_FLAG_UNKNOWN_PROTO)
 
 #define nat_interface_is_inside(i) i->flags & NAT_INTERFACE_FLAG_IS_INSIDE
 #define nat_interface_is_outside(i) i->flags & NAT_INTERFACE_FLAG_IS_OUTSIDE
 
+/* Sessions looked at per dispatch of nat44-session-expire */
+#define NAT44_SESSION_EXPIRE_BATCH 256
+/* Session timer wheel tick, in seconds */
+#define NAT44_SESSION_TIMER_TICK 1.0
+/* Longest interval the session timer wheel can hold, in ticks */
+#define NAT44_SESSION_TIMER_MAX_TICKS ((512 * 512) - 1)
+
+/** \brief Idle timeout of a NAT44 session.
+    @param sm SNAT main
+    @param s SNAT session
+    @return timeout in seconds
+*/
+always_inline u32
+nat44_session_get_timeout (snat_main_t * sm, snat_session_t * s)
+{
+  if (snat_is_unk_proto_session (s))
+    return sm->udp_timeout;
+
+  switch (s->in2out.protocol)
+    {
+    case SNAT_PROTOCOL_ICMP:
+      return sm->icmp_timeout;
+    case SNAT_PROTOCOL_TCP:
+      if ((s->flags & (SNAT_SESSION_FLAG_TCP_ESTABLISHED |
+                       SNAT_SESSION_FLAG_TCP_CLOSING)) ==
+          SNAT_SESSION_FLAG_TCP_ESTABLISHED)
+        return sm->tcp_established_timeout;
+      return sm->tcp_transitory_timeout;
+    default:
+      return sm->udp_timeout;
+    }
+}
+
+/** \brief Track TCP session state for the idle timeout.
+    A session is established once a segment without SYN is seen and
+    goes back to the transitory timeout after FIN or RST.
+    @param s SNAT session
+    @param tcp TCP header of a packet of the session
+*/
+always_inline void
+nat44_session_update_tcp_state (snat_session_t * s, tcp_header_t * tcp)
+{
+  if (PREDICT_FALSE (tcp->flags & (TCP_FLAG_FIN | TCP_FLAG_RST)))
+    s->flags |= SNAT_SESSION_FLAG_TCP_CLOSING;
+  else if (PREDICT_FALSE (!(s->flags & SNAT_SESSION_FLAG_TCP_ESTABLISHED) &&
+                          !(tcp->flags & TCP_FLAG_SYN)))
+    s->flags |= SNAT_SESSION_FLAG_TCP_ESTABLISHED;
+}
+
+/** \brief Start the aging timer of a new session.
+    The timer is not restarted when the session is used, the expiry
+    checks last heard and re-arms it for the remaining time instead.
+    @param sm SNAT main
+    @param tsm per thread data of the thread owning the session
+    @param s SNAT session
+*/
+always_inline void
+nat44_session_timer_start (snat_main_t * sm,
+                           snat_main_per_thread_data_t * tsm,
+                           snat_session_t * s)
+{
+  u32 ticks = nat44_session_get_timeout (sm, s);
+
+  ticks = clib_max (ticks, 1);
+  ticks = clib_min (ticks, NAT44_SESSION_TIMER_MAX_TICKS);
+  s->timer_handle =
+    tw_timer_start_16t_2w_512sl (&tsm->session_timer_wheel,
+                                 s - tsm->sessions, 0, ticks);
+}
+
+/** \brief Stop the aging timer of a session which is being deleted.
+    @param tsm per thread data of the thread owning the session
+    @param s SNAT session
+*/
+always_inline void
+nat44_session_timer_stop (snat_main_per_thread_data_t * tsm,
+                          snat_session_t * s)
+{
+  if (s->timer_handle != ~0)
+    {
+      tw_timer_stop_16t_2w_512sl (&tsm->session_timer_wheel,
+                                  s->timer_handle);
+      s->timer_handle = ~0;
+    }
+}
+
 /*
  * Why is this here? Because we don't need to touch this layer to
  * simply reply to an icmp. We need to change id to a unique
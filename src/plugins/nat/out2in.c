@@ -240,6 +240,7 @@ create_session_for_static_mapping (snat_main_t *sm,
   s->in2out = in2out;
   s->out2in = out2in;
   s->in2out.protocol = out2in.protocol;
+  nat44_session_timer_start (sm, &sm->per_thread_data[thread_index], s);
 
   /* Add to translation hashes */
   kv0.key = s->in2out.as_u64;
@@ -754,6 +755,7 @@ snat_out2in_unknown_proto (snat_main_t *sm,
       s->in2out.fib_index = m->fib_index;
       s->in2out.port = s->out2in.port = ip->protocol;
       u->nstaticsessions++;
+      nat44_session_timer_start (sm, tsm, s);
 
       /* Create list elts */
       pool_get (tsm->list_pool, elt);
@@ -893,6 +895,7 @@ snat_out2in_lb (snat_main_t *sm,
       s->out2in = e_key;
       s->in2out = l_key;
       u->nstaticsessions++;
+      nat44_session_timer_start (sm, tsm, s);
 
       /* Create list elts */
       pool_get (tsm->list_pool, elt);
@@ -994,6 +997,8 @@ snat_out2in_node_fn (vlib_main_t * vm,
           u32 proto0, proto1;
           snat_session_t * s0 = 0, * s1 = 0;
           clib_bihash_kv_8_8_t kv0, kv1, value0, value1;
+          clib_bihash_kv_8_8_t kvs[2], values[2];
+          int rv0, rv1, rvs[2], reuse1 = 0;
 
 	  /* Prefetch next iteration. */
 	  {
@@ -1027,10 +1032,42 @@ snat_out2in_node_fn (vlib_main_t * vm,
           udp0 = ip4_next_header (ip0);
           tcp0 = (tcp_header_t *) udp0;
           icmp0 = (icmp46_header_t *) udp0;
+          ip1 = vlib_buffer_get_current (b1);
+          udp1 = ip4_next_header (ip1);
+          tcp1 = (tcp_header_t *) udp1;
+          icmp1 = (icmp46_header_t *) udp1;
 
           sw_if_index0 = vnet_buffer(b0)->sw_if_index[VLIB_RX];
 	  rx_fib_index0 = vec_elt (sm->ip4_main->fib_index_by_sw_if_index,
                                    sw_if_index0);
+          sw_if_index1 = vnet_buffer(b1)->sw_if_index[VLIB_RX];
+	  rx_fib_index1 = vec_elt (sm->ip4_main->fib_index_by_sw_if_index,
+                                   sw_if_index1);
+
+          proto0 = ip_proto_to_snat_proto (ip0->protocol);
+          proto1 = ip_proto_to_snat_proto (ip1->protocol);
+
+          key0.addr = ip0->dst_address;
+          key0.port = udp0->dst_port;
+          key0.protocol = proto0;
+          key0.fib_index = rx_fib_index0;
+          key1.addr = ip1->dst_address;
+          key1.port = udp1->dst_port;
+          key1.protocol = proto1;
+          key1.fib_index = rx_fib_index1;
+
+          kv0.key = key0.as_u64;
+          kv1.key = key1.as_u64;
+
+          /* Lookup the sessions of both packets together */
+          kvs[0] = kv0;
+          kvs[1] = kv1;
+          clib_bihash_search_batch_8_8 (
+            &sm->per_thread_data[thread_index].out2in, kvs, values, rvs, 2);
+          rv0 = rvs[0];
+          rv1 = rvs[1];
+          value0 = values[0];
+          value1 = values[1];
 
           if (PREDICT_FALSE(ip0->ttl == 1))
             {
@@ -1042,8 +1079,6 @@ snat_out2in_node_fn (vlib_main_t * vm,
               goto trace0;
             }
 
-          proto0 = ip_proto_to_snat_proto (ip0->protocol);
-
           if (PREDICT_FALSE (proto0 == ~0))
             {
               s0 = snat_out2in_unknown_proto(sm, b0, ip0, rx_fib_index0,
@@ -1067,15 +1102,7 @@ snat_out2in_node_fn (vlib_main_t * vm,
               goto trace0;
             }
 
-          key0.addr = ip0->dst_address;
-          key0.port = udp0->dst_port;
-          key0.protocol = proto0;
-          key0.fib_index = rx_fib_index0;
-
-          kv0.key = key0.as_u64;
-
-          if (clib_bihash_search_8_8 (&sm->per_thread_data[thread_index].out2in,
-                                      &kv0, &value0))
+          if (rv0)
             {
               /* Try to match static mapping by external address and port,
                  destination address and port in packet */
@@ -1117,6 +1144,11 @@ snat_out2in_node_fn (vlib_main_t * vm,
                   s0 = pool_elt_at_index (
                     sm->per_thread_data[thread_index].sessions,
                     value0.value);
+                  /*
+                   * Packet 0 neither created nor recycled a session, so
+                   * the lookup made for packet 1 still holds.
+                   */
+                  reuse1 = 1;
                 }
             }
 
@@ -1133,6 +1165,7 @@ snat_out2in_node_fn (vlib_main_t * vm,
 
           if (PREDICT_TRUE(proto0 == SNAT_PROTOCOL_TCP))
             {
+              nat44_session_update_tcp_state (s0, tcp0);
               old_port0 = tcp0->dst_port;
               tcp0->dst_port = s0->in2out.port;
               new_port0 = tcp0->dst_port;
@@ -1184,15 +1217,6 @@ snat_out2in_node_fn (vlib_main_t * vm,
           pkts_processed += next0 != SNAT_OUT2IN_NEXT_DROP;
 
 
-          ip1 = vlib_buffer_get_current (b1);
-          udp1 = ip4_next_header (ip1);
-          tcp1 = (tcp_header_t *) udp1;
-          icmp1 = (icmp46_header_t *) udp1;
-
-          sw_if_index1 = vnet_buffer(b1)->sw_if_index[VLIB_RX];
-	  rx_fib_index1 = vec_elt (sm->ip4_main->fib_index_by_sw_if_index,
-                                   sw_if_index1);
-
           if (PREDICT_FALSE(ip1->ttl == 1))
             {
               vnet_buffer (b1)->sw_if_index[VLIB_TX] = (u32) ~ 0;
@@ -1203,8 +1227,6 @@ snat_out2in_node_fn (vlib_main_t * vm,
               goto trace1;
             }
 
-          proto1 = ip_proto_to_snat_proto (ip1->protocol);
-
           if (PREDICT_FALSE (proto1 == ~0))
             {
               s1 = snat_out2in_unknown_proto(sm, b1, ip1, rx_fib_index1,
@@ -1228,15 +1250,11 @@ snat_out2in_node_fn (vlib_main_t * vm,
               goto trace1;
             }
 
-          key1.addr = ip1->dst_address;
-          key1.port = udp1->dst_port;
-          key1.protocol = proto1;
-          key1.fib_index = rx_fib_index1;
+          if (!reuse1)
+            rv1 = clib_bihash_search_8_8 (
+              &sm->per_thread_data[thread_index].out2in, &kv1, &value1);
 
-          kv1.key = key1.as_u64;
-
-          if (clib_bihash_search_8_8 (&sm->per_thread_data[thread_index].out2in,
-                                      &kv1, &value1))
+          if (rv1)
             {
               /* Try to match static mapping by external address and port,
                  destination address and port in packet */
@@ -1294,6 +1312,7 @@ snat_out2in_node_fn (vlib_main_t * vm,
 
           if (PREDICT_TRUE(proto1 == SNAT_PROTOCOL_TCP))
             {
+              nat44_session_update_tcp_state (s1, tcp1);
               old_port1 = tcp1->dst_port;
               tcp1->dst_port = s1->in2out.port;
               new_port1 = tcp1->dst_port;
@@ -1492,6 +1511,7 @@ snat_out2in_node_fn (vlib_main_t * vm,
 
           if (PREDICT_TRUE(proto0 == SNAT_PROTOCOL_TCP))
             {
+              nat44_session_update_tcp_state (s0, tcp0);
               old_port0 = tcp0->dst_port;
               tcp0->dst_port = s0->in2out.port;
               new_port0 = tcp0->dst_port;
@@ -2576,6 +2596,7 @@ snat_out2in_worker_handoff_fn (vlib_main_t * vm,
             {
               hf->n_vectors = VLIB_FRAME_SIZE;
               vlib_put_frame_queue_elt (hf);
+              vlib_main_wakeup (vlib_mains[next_worker_index]);
               current_worker_index = ~0;
               handoff_queue_elt_by_worker_index[next_worker_index] = 0;
               hf = 0;
@@ -2625,6 +2646,7 @@ snat_out2in_worker_handoff_fn (vlib_main_t * vm,
 	  if (1 || hf->n_vectors == hf->last_n_vectors)
 	    {
 	      vlib_put_frame_queue_elt (hf);
+	      vlib_main_wakeup (vlib_mains[i]);
 	      handoff_queue_elt_by_worker_index[i] = 0;
 	    }
 	  else
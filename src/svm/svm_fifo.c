@@ -107,7 +107,8 @@ svm_fifo_replay (u8 * s, svm_fifo_t * f, u8 no_read, u8 verbose)
 #endif
 
   dummy_fifo = svm_fifo_create (f->nitems);
-  memset (f->data, 0xFF, f->nitems);
+  if (!svm_fifo_is_elastic (f))
+    memset (f->data, 0xFF, f->nitems);
 
   vec_validate (data, f->nitems);
   for (i = 0; i < vec_len (data); i++)
@@ -172,6 +173,10 @@ format_svm_fifo (u8 * s, va_list * args)
   s = format (s, "cursize %u nitems %u has_event %d\n",
 	      f->cursize, f->nitems, f->has_event);
   s = format (s, " head %d tail %d\n", f->head, f->tail);
+  if (svm_fifo_is_elastic (f))
+    s = format (s, " elastic, %u of %u chunks of %u bytes\n",
+		svm_fifo_n_chunks (f), f->nitems / f->chunk_size,
+		f->chunk_size);
 
   if (verbose > 1)
     s = format
@@ -217,11 +222,272 @@ svm_fifo_free (svm_fifo_t * f)
 
   if (--f->refcnt == 0)
     {
+      svm_fifo_free_chunks (f);
       pool_free (f->ooo_segments);
       clib_mem_free (f);
     }
 }
 
+/*
+ * Elastic fifos
+ *
+ * Instead of nitems bytes of data, elastic fifos carry a table of pointers
+ * to fixed size chunks, one per chunk_size bytes of ring. Chunks are only
+ * allocated when the producer writes to that part of the ring and are
+ * returned by the consumer as soon as head moves past them, so a fifo
+ * costs memory in proportion to the data it holds. Head and tail keep
+ * their meaning, and so do ooo segments.
+ *
+ * The table is the only state both ends write. The producer only fills in
+ * entries that are outside [head, head + cursize), the consumer only clears
+ * entries it is done with and does so before publishing the new head.
+ */
+
+void
+svm_fifo_chunk_pool_init (svm_fifo_chunk_pool_t * cp, void *heap,
+			  volatile u32 * lock, u32 chunk_size)
+{
+  ASSERT (is_pow2 (chunk_size));
+  memset (cp, 0, sizeof (*cp));
+  cp->heap = heap;
+  cp->lock = lock;
+  cp->chunk_size = chunk_size;
+}
+
+static u8 *
+svm_fifo_chunk_alloc (svm_fifo_chunk_pool_t * cp)
+{
+  void *oldheap;
+  u8 *c;
+
+  while (__sync_lock_test_and_set (cp->lock, 1))
+    ;
+
+  c = cp->free_chunks;
+  if (c)
+    {
+      cp->free_chunks = *(u8 **) c;
+      cp->n_free_chunks--;
+    }
+  else
+    {
+      oldheap = clib_mem_set_heap (cp->heap);
+      c = clib_mem_alloc_aligned_at_offset (cp->chunk_size,
+					    CLIB_CACHE_LINE_BYTES,
+					    0 /* align_offset */ ,
+					    0 /* os_out_of_memory */ );
+      clib_mem_set_heap (oldheap);
+      if (c)
+	cp->n_chunks++;
+    }
+
+  __sync_lock_release (cp->lock);
+  return c;
+}
+
+static void
+svm_fifo_chunk_free (svm_fifo_chunk_pool_t * cp, u8 * c)
+{
+  while (__sync_lock_test_and_set (cp->lock, 1))
+    ;
+
+  *(u8 **) c = cp->free_chunks;
+  cp->free_chunks = c;
+  cp->n_free_chunks++;
+
+  __sync_lock_release (cp->lock);
+}
+
+static inline u8 **
+svm_fifo_chunks (svm_fifo_t * f)
+{
+  return (u8 **) f->data;
+}
+
+static inline u32
+svm_fifo_n_table_chunks (svm_fifo_t * f)
+{
+  return f->nitems / f->chunk_size;
+}
+
+/**
+ * Create an elastic fifo, in the current heap. Only the fifo header and
+ * the chunk table are allocated, chunks come from @a cp as data arrives.
+ *
+ * @return 0 on failure or if size is not a multiple of the chunk size
+ */
+svm_fifo_t *
+svm_fifo_create_elastic (u32 data_size_in_bytes, svm_fifo_chunk_pool_t * cp)
+{
+  svm_fifo_t *f;
+  u32 rounded_data_size, table_size;
+
+  if (data_size_in_bytes < cp->chunk_size
+      || (data_size_in_bytes & (cp->chunk_size - 1)))
+    return 0;
+
+  /* size table as if data was rounded to a power-of-two, like regular
+   * fifos, so the fifo can be reused for any size in its class */
+  rounded_data_size = (1 << (max_log2 (data_size_in_bytes)));
+  table_size = (rounded_data_size / cp->chunk_size) * sizeof (u8 *);
+  f = clib_mem_alloc_aligned_or_null (sizeof (*f) + table_size,
+				      CLIB_CACHE_LINE_BYTES);
+  if (f == 0)
+    return 0;
+
+  memset (f, 0, sizeof (*f) + table_size);
+  f->nitems = data_size_in_bytes;
+  f->ooos_list_head = OOO_SEGMENT_INVALID_INDEX;
+  f->refcnt = 1;
+  f->chunk_size = cp->chunk_size;
+  f->chunk_pool = cp;
+  return (f);
+}
+
+/**
+ * Return all chunks of an elastic fifo to its pool. Neither end may be
+ * using the fifo.
+ */
+void
+svm_fifo_free_chunks (svm_fifo_t * f)
+{
+  u8 **chunks;
+  int i;
+
+  if (!svm_fifo_is_elastic (f))
+    return;
+
+  chunks = svm_fifo_chunks (f);
+  for (i = 0; i < svm_fifo_n_table_chunks (f); i++)
+    {
+      if (chunks[i])
+	svm_fifo_chunk_free (f->chunk_pool, chunks[i]);
+      chunks[i] = 0;
+    }
+  if (f->spare_chunk)
+    svm_fifo_chunk_free (f->chunk_pool, f->spare_chunk);
+  f->spare_chunk = 0;
+}
+
+/**
+ * Number of chunks backing an elastic fifo's data
+ */
+u32
+svm_fifo_n_chunks (svm_fifo_t * f)
+{
+  u8 **chunks;
+  u32 i, n_chunks = 0;
+
+  if (!svm_fifo_is_elastic (f))
+    return 0;
+
+  chunks = svm_fifo_chunks (f);
+  for (i = 0; i < svm_fifo_n_table_chunks (f); i++)
+    n_chunks += chunks[i] != 0;
+  return n_chunks;
+}
+
+/**
+ * Producer side. Allocate the chunks that back @a n_bytes of ring starting
+ * at @a pos, if not already there.
+ *
+ * @return number of bytes, starting at pos, that are backed by chunks
+ */
+static u32
+svm_fifo_chunks_grow (svm_fifo_t * f, u32 pos, u32 n_bytes)
+{
+  u8 **chunks = svm_fifo_chunks (f), *c;
+  u32 chunk_size = f->chunk_size, backed = 0, ci;
+
+  ci = pos / chunk_size;
+  while (backed < n_bytes)
+    {
+      if (PREDICT_FALSE (chunks[ci] == 0))
+	{
+	  c = __sync_lock_test_and_set (&f->spare_chunk, 0);
+	  if (!c && !(c = svm_fifo_chunk_alloc (f->chunk_pool)))
+	    break;
+	  chunks[ci] = c;
+	}
+      backed += chunk_size - ((pos + backed) & (chunk_size - 1));
+      ci = (ci + 1 == svm_fifo_n_table_chunks (f)) ? 0 : ci + 1;
+    }
+  return clib_min (backed, n_bytes);
+}
+
+/**
+ * Consumer side. Free the chunks head moves past when @a n_bytes are
+ * consumed. Must be called before head and cursize are updated.
+ *
+ * While the fifo is not drained, one chunk is kept for the producer to
+ * reuse without going to the pool.
+ */
+static void
+svm_fifo_chunks_release (svm_fifo_t * f, u32 n_bytes, u32 cursize)
+{
+  u8 **chunks = svm_fifo_chunks (f), *c;
+  u32 chunk_size = f->chunk_size, n_done, ci;
+
+  n_done = ((f->head & (chunk_size - 1)) + n_bytes) / chunk_size;
+  ci = f->head / chunk_size;
+  while (n_done--)
+    {
+      c = chunks[ci];
+      chunks[ci] = 0;
+      ci = (ci + 1 == svm_fifo_n_table_chunks (f)) ? 0 : ci + 1;
+      if (cursize > n_bytes && f->spare_chunk == 0
+	  && __sync_bool_compare_and_swap (&f->spare_chunk, 0, c))
+	continue;
+      svm_fifo_chunk_free (f->chunk_pool, c);
+    }
+
+  if (cursize == n_bytes && f->spare_chunk)
+    {
+      c = __sync_lock_test_and_set (&f->spare_chunk, 0);
+      if (c)
+	svm_fifo_chunk_free (f->chunk_pool, c);
+    }
+
+  /* Chunks must be gone before the producer sees the space */
+  CLIB_MEMORY_BARRIER ();
+}
+
+static void
+svm_fifo_chunks_copy_to (svm_fifo_t * f, u32 pos, u32 n_bytes, u8 * src)
+{
+  u8 **chunks = svm_fifo_chunks (f);
+  u32 chunk_size = f->chunk_size, offset, n;
+
+  while (n_bytes)
+    {
+      offset = pos & (chunk_size - 1);
+      n = clib_min (chunk_size - offset, n_bytes);
+      clib_memcpy (chunks[pos / chunk_size] + offset, src, n);
+      src += n;
+      n_bytes -= n;
+      pos += n;
+      pos = (pos == f->nitems) ? 0 : pos;
+    }
+}
+
+static void
+svm_fifo_chunks_copy_from (svm_fifo_t * f, u32 pos, u32 n_bytes, u8 * dst)
+{
+  u8 **chunks = svm_fifo_chunks (f);
+  u32 chunk_size = f->chunk_size, offset, n;
+
+  while (n_bytes)
+    {
+      offset = pos & (chunk_size - 1);
+      n = clib_min (chunk_size - offset, n_bytes);
+      clib_memcpy (dst, chunks[pos / chunk_size] + offset, n);
+      dst += n;
+      n_bytes -= n;
+      pos += n;
+      pos = (pos == f->nitems) ? 0 : pos;
+    }
+}
+
 always_inline ooo_segment_t *
 ooo_segment_new (svm_fifo_t * f, u32 start, u32 length)
 {
@@ -466,7 +732,17 @@ svm_fifo_enqueue_internal (svm_fifo_t * f, u32 max_bytes, u8 * copy_from_here)
   total_copy_bytes = (nitems - cursize) < max_bytes ?
     (nitems - cursize) : max_bytes;
 
-  if (PREDICT_TRUE (copy_from_here != 0))
+  if (PREDICT_FALSE (svm_fifo_is_elastic (f)))
+    {
+      total_copy_bytes = clib_min (svm_fifo_max_enqueue (f), max_bytes);
+      total_copy_bytes = svm_fifo_chunks_grow (f, f->tail, total_copy_bytes);
+      if (total_copy_bytes == 0)
+	return -2;		/* fifo stuffed or out of chunks */
+
+      svm_fifo_chunks_copy_to (f, f->tail, total_copy_bytes, copy_from_here);
+      f->tail = (f->tail + total_copy_bytes) % nitems;
+    }
+  else if (PREDICT_TRUE (copy_from_here != 0))
     {
       /* Number of bytes in first copy segment */
       first_copy_bytes = ((nitems - f->tail) < total_copy_bytes)
@@ -574,6 +850,20 @@ svm_fifo_enqueue_with_offset_internal (svm_fifo_t * f,
   if ((required_bytes + offset) > (nitems - cursize))
     return -1;
 
+  if (PREDICT_FALSE (svm_fifo_is_elastic (f)))
+    {
+      if ((required_bytes + offset) > svm_fifo_max_enqueue (f)
+	  || svm_fifo_chunks_grow (f, normalized_offset, required_bytes)
+	  < required_bytes)
+	return -1;
+
+      svm_fifo_trace_add (f, offset, required_bytes, 1);
+      ooo_segment_add (f, offset, required_bytes);
+      svm_fifo_chunks_copy_to (f, normalized_offset, required_bytes,
+			       copy_from_here);
+      return (0);
+    }
+
   svm_fifo_trace_add (f, offset, required_bytes, 1);
 
   ooo_segment_add (f, offset, required_bytes);
@@ -630,7 +920,13 @@ svm_fifo_dequeue_internal (svm_fifo_t * f, u32 max_bytes, u8 * copy_here)
   /* Number of bytes we're going to copy */
   total_copy_bytes = (cursize < max_bytes) ? cursize : max_bytes;
 
-  if (PREDICT_TRUE (copy_here != 0))
+  if (PREDICT_FALSE (svm_fifo_is_elastic (f)))
+    {
+      svm_fifo_chunks_copy_from (f, f->head, total_copy_bytes, copy_here);
+      svm_fifo_chunks_release (f, total_copy_bytes, cursize);
+      f->head = (f->head + total_copy_bytes) % nitems;
+    }
+  else if (PREDICT_TRUE (copy_here != 0))
     {
       /* Number of bytes in first copy segment */
       first_copy_bytes = ((nitems - f->head) < total_copy_bytes)
@@ -721,7 +1017,9 @@ svm_fifo_peek_ma (svm_fifo_t * f, u32 relative_offset, u32 max_bytes,
   total_copy_bytes = (cursize - relative_offset < max_bytes) ?
     cursize - relative_offset : max_bytes;
 
-  if (PREDICT_TRUE (copy_here != 0))
+  if (PREDICT_FALSE (svm_fifo_is_elastic (f)))
+    svm_fifo_chunks_copy_from (f, real_head, total_copy_bytes, copy_here);
+  else if (PREDICT_TRUE (copy_here != 0))
     {
       /* Number of bytes in first copy segment */
       first_copy_bytes =
@@ -786,6 +1084,9 @@ svm_fifo_dequeue_drop (svm_fifo_t * f, u32 max_bytes)
 
   svm_fifo_trace_add (f, f->tail, total_drop_bytes, 3);
 
+  if (PREDICT_FALSE (svm_fifo_is_elastic (f)))
+    svm_fifo_chunks_release (f, total_drop_bytes, cursize);
+
   /* Number of bytes in first copy segment */
   first_drop_bytes =
     ((nitems - f->head) < total_drop_bytes) ?
@@ -808,6 +1109,56 @@ svm_fifo_dequeue_drop (svm_fifo_t * f, u32 max_bytes)
   return total_drop_bytes;
 }
 
+/**
+ * Reference, instead of copy, up to @a max_bytes of data starting at
+ * @a relative_offset from head. Lets the consumer read data in place, out
+ * of the shared memory segment. Data that wraps around the end of the fifo
+ * is returned as two pieces, otherwise iov[1].len is 0. Elastic fifos
+ * return at most what is left of the chunk at head, plus the next chunk.
+ *
+ * The producer only writes past tail, so the data stays valid until the
+ * consumer moves head, typically with svm_fifo_dequeue_drop, once done.
+ *
+ * @return number of bytes referenced or -2 if nothing to read
+ */
+int
+svm_fifo_peek_in_place (svm_fifo_t * f, u32 relative_offset, u32 max_bytes,
+			svm_fifo_iovec_t * iov)
+{
+  u32 cursize, nitems, real_head, n_bytes;
+
+  /* read cursize, which can only increase while we're working */
+  cursize = svm_fifo_max_dequeue (f);
+  if (PREDICT_FALSE (cursize <= relative_offset))
+    return -2;			/* nothing in the fifo */
+
+  nitems = f->nitems;
+  real_head = f->head + relative_offset;
+  real_head = real_head >= nitems ? real_head - nitems : real_head;
+  n_bytes = clib_min (cursize - relative_offset, max_bytes);
+
+  if (PREDICT_FALSE (svm_fifo_is_elastic (f)))
+    {
+      u8 **chunks = svm_fifo_chunks (f);
+      u32 chunk_size = f->chunk_size, ci = real_head / chunk_size;
+
+      iov[0].data = chunks[ci] + (real_head & (chunk_size - 1));
+      iov[0].len = clib_min (chunk_size - (real_head & (chunk_size - 1)),
+			     n_bytes);
+      ci = (ci + 1 == svm_fifo_n_table_chunks (f)) ? 0 : ci + 1;
+      iov[1].data = chunks[ci];
+      iov[1].len = clib_min (chunk_size, n_bytes - iov[0].len);
+      return iov[0].len + iov[1].len;
+    }
+
+  iov[0].data = &f->data[real_head];
+  iov[0].len = clib_min (nitems - real_head, n_bytes);
+  iov[1].data = &f->data[0];
+  iov[1].len = n_bytes - iov[0].len;
+
+  return n_bytes;
+}
+
 u32
 svm_fifo_number_ooo_segments (svm_fifo_t * f)
 {
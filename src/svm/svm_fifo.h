@@ -36,9 +36,34 @@ typedef struct
 format_function_t format_ooo_segment;
 format_function_t format_ooo_list;
 
+/** Fifo data referenced in place. Data that wraps takes two of these */
+typedef struct
+{
+  u8 *data;	/**< Start of data, within the fifo */
+  u32 len;	/**< Number of bytes */
+} svm_fifo_iovec_t;
+
 #define SVM_FIFO_TRACE (0)
 #define OOO_SEGMENT_INVALID_INDEX ((u32)~0)
 
+/** Size of the chunks elastic fifos are made of */
+#define SVM_FIFO_CHUNK_SIZE (4 << 10)
+
+/**
+ * Pool of fixed size chunks elastic fifos grow from and return memory to.
+ * Chunks are carved out of @a heap, so the pool must be protected by the
+ * lock that serializes all other users of that heap.
+ */
+typedef struct
+{
+  volatile u32 *lock;		/**< Lock shared with other heap users */
+  void *heap;			/**< Heap chunks are carved from */
+  u8 *free_chunks;		/**< Freelist, linked through first word */
+  u32 chunk_size;		/**< Chunk size, power of 2 */
+  u32 n_chunks;			/**< Number of chunks carved from heap */
+  u32 n_free_chunks;		/**< Number of chunks on freelist */
+} svm_fifo_chunk_pool_t;
+
 typedef struct
 {
   u32 offset;
@@ -60,6 +85,11 @@ typedef struct _svm_fifo
   u8 master_thread_index;
   u8 client_thread_index;
   u32 segment_manager;
+
+  /* Elastic fifos. Data lives in chunks, pointed to by a table in data[] */
+  u32 chunk_size;		/**< Non-zero if fifo is elastic */
+  svm_fifo_chunk_pool_t *chunk_pool;	/**< Pool chunks come from */
+  u8 *volatile spare_chunk;	/**< Chunk consumer handed back */
     CLIB_CACHE_LINE_ALIGN_MARK (end_shared);
   u32 head;
     CLIB_CACHE_LINE_ALIGN_MARK (end_consumer);
@@ -102,10 +132,31 @@ svm_fifo_max_dequeue (svm_fifo_t * f)
   return f->cursize;
 }
 
+static inline u8
+svm_fifo_is_elastic (svm_fifo_t * f)
+{
+  return f->chunk_size != 0;
+}
+
 static inline u32
 svm_fifo_max_enqueue (svm_fifo_t * f)
 {
-  return f->nitems - svm_fifo_max_dequeue (f);
+  u32 head, head_chunk, cursize, used;
+
+  if (PREDICT_TRUE (!svm_fifo_is_elastic (f)))
+    return f->nitems - svm_fifo_max_dequeue (f);
+
+  /* The consumer frees chunks once done with them, so the producer must
+   * not wrap around into the chunk the consumer is reading from. Head is
+   * read before cursize, as the consumer updates them in reverse order. */
+  head = f->head;
+  head_chunk = head & ~(f->chunk_size - 1);
+  CLIB_MEMORY_BARRIER ();
+  cursize = svm_fifo_max_dequeue (f);
+  if (PREDICT_FALSE (f->tail == head_chunk && f->tail != head))
+    return 0;
+  used = (f->tail + f->nitems - head_chunk) % f->nitems;
+  return clib_min (f->nitems - cursize, f->nitems - used);
 }
 
 static inline u8
@@ -137,7 +188,13 @@ svm_fifo_unset_event (svm_fifo_t * f)
 }
 
 svm_fifo_t *svm_fifo_create (u32 data_size_in_bytes);
+svm_fifo_t *svm_fifo_create_elastic (u32 data_size_in_bytes,
+				     svm_fifo_chunk_pool_t * cp);
 void svm_fifo_free (svm_fifo_t * f);
+void svm_fifo_free_chunks (svm_fifo_t * f);
+u32 svm_fifo_n_chunks (svm_fifo_t * f);
+void svm_fifo_chunk_pool_init (svm_fifo_chunk_pool_t * cp, void *heap,
+			       volatile u32 * lock, u32 chunk_size);
 
 int svm_fifo_enqueue_nowait (svm_fifo_t * f, u32 max_bytes,
 			     u8 * copy_from_here);
@@ -147,6 +204,8 @@ int svm_fifo_dequeue_nowait (svm_fifo_t * f, u32 max_bytes, u8 * copy_here);
 
 int svm_fifo_peek (svm_fifo_t * f, u32 offset, u32 max_bytes, u8 * copy_here);
 int svm_fifo_dequeue_drop (svm_fifo_t * f, u32 max_bytes);
+int svm_fifo_peek_in_place (svm_fifo_t * f, u32 relative_offset,
+			    u32 max_bytes, svm_fifo_iovec_t * iov);
 u32 svm_fifo_number_ooo_segments (svm_fifo_t * f);
 ooo_segment_t *svm_fifo_first_ooo_segment (svm_fifo_t * f);
 void svm_fifo_init_pointers (svm_fifo_t * f, u32 pointer);
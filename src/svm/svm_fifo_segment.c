@@ -205,6 +205,8 @@ svm_fifo_segment_create (svm_fifo_segment_create_args_t * a)
   sh->opaque[0] = fsh;
   s->h = fsh;
   fsh->segment_name = format (0, "%s%c", a->segment_name, 0);
+  svm_fifo_chunk_pool_init (&fsh->chunk_pool, sh->heap, &sh->lock,
+			    SVM_FIFO_CHUNK_SIZE);
   preallocate_fifo_pairs (s, a);
 
   ssvm_pop_heap (oldheap);
@@ -278,6 +280,8 @@ svm_fifo_segment_create_process_private (svm_fifo_segment_create_args_t * a)
       if (!a->private_segment_count)
 	fsh->flags |= FIFO_SEGMENT_F_IS_MAIN_HEAP;
       fsh->segment_name = format (0, "%s%c", a->segment_name, 0);
+      svm_fifo_chunk_pool_init (&fsh->chunk_pool, sh->heap, &sh->lock,
+				SVM_FIFO_CHUNK_SIZE);
 
       if (a->private_segment_count)
 	{
@@ -351,6 +355,38 @@ svm_fifo_segment_delete (svm_fifo_segment_private_t * s)
     }
 }
 
+/** Memory a fifo holds in the segment, not counting elastic fifo chunks */
+static inline uword
+fifo_segment_fifo_bytes (svm_fifo_t * f)
+{
+  u32 rounded_data_size = 1 << max_log2 (f->nitems);
+
+  if (svm_fifo_is_elastic (f))
+    return sizeof (*f) + (rounded_data_size / f->chunk_size) * sizeof (u8 *);
+  return sizeof (*f) + rounded_data_size;
+}
+
+static void
+fifo_segment_add_active (svm_fifo_segment_header_t * fsh, svm_fifo_t * f,
+			 svm_fifo_segment_freelist_t list_index)
+{
+  /* If rx_freelist add to active fifos list. When cleaning up segment,
+   * we need a list of active sessions that should be disconnected. Since
+   * both rx and tx fifos keep pointers to the session, it's enough to track
+   * only one. */
+  if (list_index == FIFO_SEGMENT_RX_FREELIST)
+    {
+      if (fsh->fifos)
+	{
+	  fsh->fifos->prev = f;
+	  f->next = fsh->fifos;
+	}
+      fsh->fifos = f;
+    }
+  fsh->n_active_fifos++;
+  fsh->n_fifo_bytes += fifo_segment_fifo_bytes (f);
+}
+
 svm_fifo_t *
 svm_fifo_segment_alloc_fifo (svm_fifo_segment_private_t * s,
 			     u32 data_size_in_bytes,
@@ -426,20 +462,73 @@ svm_fifo_segment_alloc_fifo (svm_fifo_segment_private_t * s,
   f->freelist_index = freelist_index;
 
 found:
-  /* If rx_freelist add to active fifos list. When cleaning up segment,
-   * we need a list of active sessions that should be disconnected. Since
-   * both rx and tx fifos keep pointers to the session, it's enough to track
-   * only one. */
-  if (list_index == FIFO_SEGMENT_RX_FREELIST)
+  fifo_segment_add_active (fsh, f, list_index);
+
+  ssvm_pop_heap (oldheap);
+  ssvm_unlock_non_recursive (sh);
+  return (f);
+}
+
+/**
+ * Allocate an elastic fifo, i.e., one whose data is allocated in chunks
+ * as it arrives and freed as it is consumed. Falls back to a regular fifo
+ * if the size is not a multiple of the chunk size.
+ *
+ * Chunks are allocated by the producer, in the segment's heap, so only
+ * fifos whose producer is the segment's owner should be elastic.
+ */
+svm_fifo_t *
+svm_fifo_segment_alloc_elastic_fifo (svm_fifo_segment_private_t * s,
+				     u32 data_size_in_bytes,
+				     svm_fifo_segment_freelist_t list_index)
+{
+  ssvm_shared_header_t *sh;
+  svm_fifo_segment_header_t *fsh;
+  svm_fifo_t *f;
+  void *oldheap;
+  int freelist_index;
+
+  sh = s->ssvm.sh;
+  fsh = (svm_fifo_segment_header_t *) sh->opaque[0];
+
+  if (data_size_in_bytes < FIFO_SEGMENT_MIN_FIFO_SIZE ||
+      data_size_in_bytes > FIFO_SEGMENT_MAX_FIFO_SIZE ||
+      (data_size_in_bytes & (fsh->chunk_pool.chunk_size - 1)))
+    return svm_fifo_segment_alloc_fifo (s, data_size_in_bytes, list_index);
+
+  freelist_index = max_log2 (data_size_in_bytes)
+    - max_log2 (FIFO_SEGMENT_MIN_FIFO_SIZE);
+
+  ssvm_lock_non_recursive (sh, 1);
+  oldheap = ssvm_push_heap (sh);
+
+  vec_validate_init_empty (fsh->free_elastic_fifos, freelist_index, 0);
+  f = fsh->free_elastic_fifos[freelist_index];
+  if (f)
     {
-      if (fsh->fifos)
+      fsh->free_elastic_fifos[freelist_index] = f->next;
+      /* (re)initialize the fifo, as in svm_fifo_create_elastic. The chunk
+       * table was cleared when the fifo was freed */
+      memset (f, 0, sizeof (*f));
+      f->nitems = data_size_in_bytes;
+      f->ooos_list_head = OOO_SEGMENT_INVALID_INDEX;
+      f->refcnt = 1;
+      f->chunk_size = fsh->chunk_pool.chunk_size;
+      f->chunk_pool = &fsh->chunk_pool;
+    }
+  else
+    {
+      f = svm_fifo_create_elastic (data_size_in_bytes, &fsh->chunk_pool);
+      if (PREDICT_FALSE (f == 0))
 	{
-	  fsh->fifos->prev = f;
-	  f->next = fsh->fifos;
+	  ssvm_pop_heap (oldheap);
+	  ssvm_unlock_non_recursive (sh);
+	  return (0);
 	}
-      fsh->fifos = f;
     }
-  fsh->n_active_fifos++;
+  f->freelist_index = freelist_index;
+  fsh->n_elastic_fifos++;
+  fifo_segment_add_active (fsh, f, list_index);
 
   ssvm_pop_heap (oldheap);
   ssvm_unlock_non_recursive (sh);
@@ -465,7 +554,11 @@ svm_fifo_segment_free_fifo (svm_fifo_segment_private_t * s, svm_fifo_t * f,
 
   freelist_index = f->freelist_index;
 
-  ASSERT (freelist_index < vec_len (fsh->free_fifos));
+  /* Chunks go back to the pool, which takes the segment lock itself */
+  if (svm_fifo_is_elastic (f))
+    svm_fifo_free_chunks (f);
+  else
+    ASSERT (freelist_index < vec_len (fsh->free_fifos));
 
   ssvm_lock_non_recursive (sh, 2);
   oldheap = ssvm_push_heap (sh);
@@ -483,8 +576,15 @@ svm_fifo_segment_free_fifo (svm_fifo_segment_private_t * s, svm_fifo_t * f,
       /* Fall through: we add only rx fifos to active pool */
     case FIFO_SEGMENT_TX_FREELIST:
       /* Add to free list */
-      f->next = fsh->free_fifos[freelist_index];
       f->prev = 0;
+      if (svm_fifo_is_elastic (f))
+	{
+	  f->next = fsh->free_elastic_fifos[freelist_index];
+	  fsh->free_elastic_fifos[freelist_index] = f;
+	  fsh->n_elastic_fifos--;
+	  break;
+	}
+      f->next = fsh->free_fifos[freelist_index];
       fsh->free_fifos[freelist_index] = f;
       break;
     case FIFO_SEGMENT_FREELIST_NONE:
@@ -502,6 +602,7 @@ svm_fifo_segment_free_fifo (svm_fifo_segment_private_t * s, svm_fifo_t * f,
     }
 
   fsh->n_active_fifos--;
+  fsh->n_fifo_bytes -= fifo_segment_fifo_bytes (f);
   ssvm_pop_heap (oldheap);
   ssvm_unlock_non_recursive (sh);
 }
@@ -634,6 +735,35 @@ format_svm_fifo_segment (u8 * s, va_list * args)
   return s;
 }
 
+/**
+ * Segment memory usage, on one line. Fifo memory counts headers and data,
+ * or chunk tables for elastic fifos, whose data is in chunks.
+ */
+u8 *
+format_svm_fifo_segment_usage (u8 * s, va_list * args)
+{
+  svm_fifo_segment_private_t *sp
+    = va_arg (*args, svm_fifo_segment_private_t *);
+  svm_fifo_segment_header_t *fsh;
+  svm_fifo_chunk_pool_t *cp;
+  clib_mem_usage_t usage;
+  u32 n_used_chunks;
+
+  fsh = (svm_fifo_segment_header_t *) sp->ssvm.sh->opaque[0];
+  cp = &fsh->chunk_pool;
+  n_used_chunks = cp->n_chunks - cp->n_free_chunks;
+  mheap_usage (sp->ssvm.sh->heap, &usage);
+
+  s = format (s, "%-10u%-10u%-12U%-12U%-12U%U/%U",
+	      fsh->n_active_fifos, fsh->n_elastic_fifos,
+	      format_memory_size, fsh->n_fifo_bytes,
+	      format_memory_size, (uword) n_used_chunks * cp->chunk_size,
+	      format_memory_size, (uword) cp->n_free_chunks * cp->chunk_size,
+	      format_memory_size, usage.bytes_used,
+	      format_memory_size, usage.bytes_total);
+  return s;
+}
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
@@ -40,7 +40,11 @@ typedef struct
   svm_fifo_t *fifos;		/**< Linked list of active RX fifos */
   u8 *segment_name;		/**< Segment name */
   svm_fifo_t **free_fifos;	/**< Freelists, by fifo size  */
+  svm_fifo_t **free_elastic_fifos;	/**< Elastic fifo freelists */
+  svm_fifo_chunk_pool_t chunk_pool;	/**< Chunks elastic fifos use */
   u32 n_active_fifos;		/**< Number of active fifos */
+  u32 n_elastic_fifos;		/**< Number of active elastic fifos */
+  uword n_fifo_bytes;		/**< Memory held by active fifos */
   u8 flags;			/**< Segment flags */
 } svm_fifo_segment_header_t;
 
@@ -113,6 +117,10 @@ void svm_fifo_segment_delete (svm_fifo_segment_private_t * s);
 svm_fifo_t *svm_fifo_segment_alloc_fifo (svm_fifo_segment_private_t * s,
 					 u32 data_size_in_bytes,
 					 svm_fifo_segment_freelist_t index);
+svm_fifo_t *svm_fifo_segment_alloc_elastic_fifo (svm_fifo_segment_private_t
+						 * s, u32 data_size_in_bytes,
+						 svm_fifo_segment_freelist_t
+						 index);
 void svm_fifo_segment_free_fifo (svm_fifo_segment_private_t * s,
 				 svm_fifo_t * f,
 				 svm_fifo_segment_freelist_t index);
@@ -124,6 +132,7 @@ u32 svm_fifo_segment_num_free_fifos (svm_fifo_segment_private_t *
 
 svm_fifo_segment_private_t *svm_fifo_segment_segments_pool (void);
 format_function_t format_svm_fifo_segment;
+format_function_t format_svm_fifo_segment_usage;
 
 #endif /* __included_ssvm_fifo_segment_h__ */
 
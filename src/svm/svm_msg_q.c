@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <svm/svm_msg_q.h>
+#include <vppinfra/error.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <limits.h>
+
+/**
+ * Allocate queue in the current heap, usually a shared memory segment's
+ */
+svm_msg_q_t *
+svm_msg_q_alloc (u32 n_elts, u32 elt_size, svm_msg_q_notify_t * notify)
+{
+  svm_msg_q_t *mq;
+
+  n_elts = max_pow2 (n_elts);
+  mq = clib_mem_alloc_aligned (sizeof (*mq) + n_elts * elt_size,
+			       CLIB_CACHE_LINE_BYTES);
+  memset (mq, 0, sizeof (*mq));
+  mq->n_elts = n_elts;
+  mq->elt_size = elt_size;
+  mq->notify = notify;
+  return mq;
+}
+
+void
+svm_msg_q_free (svm_msg_q_t * mq)
+{
+  clib_mem_free (mq);
+}
+
+svm_msg_q_notify_t *
+svm_msg_q_notify_alloc (void)
+{
+  svm_msg_q_notify_t *notify;
+
+  notify = clib_mem_alloc_aligned (sizeof (*notify), CLIB_CACHE_LINE_BYTES);
+  memset (notify, 0, sizeof (*notify));
+  return notify;
+}
+
+void
+svm_msg_q_notify_free (svm_msg_q_notify_t * notify)
+{
+  clib_mem_free (notify);
+}
+
+/*
+ * The word lives in memory mapped by both vpp and the app, so the futex
+ * ops must not be process private.
+ */
+static inline long
+svm_msg_q_futex (volatile u32 * uaddr, int op, u32 val,
+		 struct timespec *timeout)
+{
+  return syscall (SYS_futex, uaddr, op, val, timeout, 0, 0);
+}
+
+/**
+ * Wake up the consumer. Can be called by any producer, or by the consumer
+ * process itself, e.g., from another thread. If the consumer has several
+ * threads waiting, all are woken.
+ */
+void
+svm_msg_q_notify_signal (svm_msg_q_notify_t * notify)
+{
+  __sync_fetch_and_add (&notify->seq, 1);
+  svm_msg_q_futex (&notify->seq, FUTEX_WAKE, INT_MAX, 0);
+}
+
+/**
+ * Sleep until signaled or until @a timeout seconds have elapsed
+ *
+ * Must follow svm_msg_q_notify_prepare.
+ *
+ * @param seq	sequence number read with svm_msg_q_notify_seq
+ * @param timeout negative to wait forever
+ * @return 0 if signaled or timed out, -1 on error
+ */
+int
+svm_msg_q_notify_wait (svm_msg_q_notify_t * notify, u32 seq, f64 timeout)
+{
+  struct timespec ts, *tsp = 0;
+  long rv;
+
+  if (timeout >= 0)
+    {
+      ts.tv_sec = (time_t) timeout;
+      ts.tv_nsec = (long) ((timeout - ts.tv_sec) * 1e9);
+      tsp = &ts;
+    }
+
+  rv = svm_msg_q_futex (&notify->seq, FUTEX_WAIT, seq, tsp);
+  __sync_fetch_and_sub (&notify->n_waiters, 1);
+
+  /* Already signaled, timed out or interrupted are all fine */
+  if (rv < 0 && errno != EAGAIN && errno != ETIMEDOUT && errno != EINTR)
+    {
+      clib_unix_warning ("futex wait");
+      return -1;
+    }
+  return 0;
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
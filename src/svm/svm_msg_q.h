@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef __included_svm_msg_q_h__
+#define __included_svm_msg_q_h__
+
+#include <vppinfra/clib.h>
+#include <vppinfra/mem.h>
+
+/**
+ * Wakeup notification shared by all the message queues of one consumer.
+ *
+ * Consumer threads announce they are about to sleep by counting
+ * themselves in @a n_waiters and then wait, with a process-shared futex,
+ * for @a seq to change. Producers only issue a syscall if they find some
+ * consumer thread waiting, and then wake them all.
+ */
+typedef struct svm_msg_q_notify_
+{
+  volatile u32 seq;		/**< futex word, bumped on every wakeup */
+  volatile u32 n_waiters;	/**< consumer threads asleep, or about to be */
+} svm_msg_q_notify_t;
+
+/**
+ * Single producer single consumer message queue
+ *
+ * Lock-free ring of fixed size elements meant to live in a shared memory
+ * segment. Head and tail are free running and sit on separate cache lines,
+ * so producer and consumer never write the same line.
+ */
+typedef struct svm_msg_q_
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  volatile u32 tail;		/**< next slot to write, producer owned */
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline1);
+  volatile u32 head;		/**< next slot to read, consumer owned */
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline2);
+  u32 n_elts;			/**< ring size, power of 2 */
+  u32 elt_size;			/**< bytes per element */
+  svm_msg_q_notify_t *notify;	/**< consumer wakeup, optional */
+  CLIB_CACHE_LINE_ALIGN_MARK (data);	/**< elements */
+} svm_msg_q_t;
+
+svm_msg_q_t *svm_msg_q_alloc (u32 n_elts, u32 elt_size,
+			      svm_msg_q_notify_t * notify);
+void svm_msg_q_free (svm_msg_q_t * mq);
+svm_msg_q_notify_t *svm_msg_q_notify_alloc (void);
+void svm_msg_q_notify_free (svm_msg_q_notify_t * notify);
+void svm_msg_q_notify_signal (svm_msg_q_notify_t * notify);
+int svm_msg_q_notify_wait (svm_msg_q_notify_t * notify, u32 seq,
+			   f64 timeout);
+
+static inline u8 *
+svm_msg_q_elt (svm_msg_q_t * mq, u32 i)
+{
+  return mq->data + (i & (mq->n_elts - 1)) * mq->elt_size;
+}
+
+static inline u32
+svm_msg_q_n_msgs (svm_msg_q_t * mq)
+{
+  return mq->tail - mq->head;
+}
+
+static inline u8
+svm_msg_q_is_empty (svm_msg_q_t * mq)
+{
+  return mq->tail == mq->head;
+}
+
+/**
+ * Wake the consumer if it sleeps. Must follow a full barrier
+ */
+static inline void
+svm_msg_q_notify (svm_msg_q_t * mq)
+{
+  svm_msg_q_notify_t *notify = mq->notify;
+
+  if (notify && notify->n_waiters)
+    svm_msg_q_notify_signal (notify);
+}
+
+/**
+ * Enqueue one message. Producer only
+ *
+ * @return 0 on success, -1 if the queue is full. The consumer is poked
+ * in both cases, so that a full queue is always drained.
+ */
+static inline int
+svm_msg_q_add (svm_msg_q_t * mq, void *elt)
+{
+  u32 tail = mq->tail;
+  int rv = -1;
+
+  if (tail - mq->head < mq->n_elts)
+    {
+      clib_memcpy (svm_msg_q_elt (mq, tail), elt, mq->elt_size);
+      CLIB_MEMORY_STORE_BARRIER ();
+      mq->tail = tail + 1;
+      rv = 0;
+    }
+
+  /* Publish tail before checking if the consumer went to sleep */
+  CLIB_MEMORY_BARRIER ();
+  svm_msg_q_notify (mq);
+  return rv;
+}
+
+/**
+ * Dequeue up to @a n_max messages into @a elts. Consumer only
+ *
+ * @return number of messages dequeued
+ */
+static inline u32
+svm_msg_q_sub_batch (svm_msg_q_t * mq, void *elts, u32 n_max)
+{
+  u32 head = mq->head, n_msgs, first, mask = mq->n_elts - 1;
+
+  n_msgs = clib_min (mq->tail - head, n_max);
+  if (!n_msgs)
+    return 0;
+
+  /* Read the messages only after having seen the tail */
+  CLIB_MEMORY_BARRIER ();
+
+  first = clib_min (n_msgs, mq->n_elts - (head & mask));
+  clib_memcpy (elts, svm_msg_q_elt (mq, head), first * mq->elt_size);
+  if (first < n_msgs)
+    clib_memcpy ((u8 *) elts + first * mq->elt_size, mq->data,
+		 (n_msgs - first) * mq->elt_size);
+
+  CLIB_MEMORY_BARRIER ();
+  mq->head = head + n_msgs;
+  return n_msgs;
+}
+
+/**
+ * Sequence number to sleep on. Consumer only
+ *
+ * Read it before checking whatever state the wakeups cover, so that a
+ * signal that comes after the check, but before svm_msg_q_notify_wait,
+ * is not lost.
+ */
+static inline u32
+svm_msg_q_notify_seq (svm_msg_q_notify_t * notify)
+{
+  return notify->seq;
+}
+
+/**
+ * Announce that a consumer thread is about to sleep. Consumer only
+ *
+ * Must be followed by a last check of all the queues that share the
+ * notification and, if they are all empty, by svm_msg_q_notify_wait.
+ * Otherwise, cancel with svm_msg_q_notify_cancel.
+ */
+static inline void
+svm_msg_q_notify_prepare (svm_msg_q_notify_t * notify)
+{
+  /* Full barrier, the queues are checked after */
+  __sync_fetch_and_add (&notify->n_waiters, 1);
+}
+
+static inline void
+svm_msg_q_notify_cancel (svm_msg_q_notify_t * notify)
+{
+  __sync_fetch_and_sub (&notify->n_waiters, 1);
+}
+
+#endif /* __included_svm_msg_q_h__ */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -18870,6 +18870,7 @@ api_af_packet_create (vat_main_t * vam)
   u8 *host_if_name = 0;
   u8 hw_addr[6];
   u8 random_hw_addr = 1;
+  u32 num_rx_queues = 0;
   int ret;
 
   memset (hw_addr, 0, sizeof (hw_addr));
@@ -18880,6 +18881,8 @@ api_af_packet_create (vat_main_t * vam)
 	vec_add1 (host_if_name, 0);
       else if (unformat (i, "hw_addr %U", unformat_ethernet_address, hw_addr))
 	random_hw_addr = 0;
+      else if (unformat (i, "num_rx_queues %u", &num_rx_queues))
+	;
       else
 	break;
     }
@@ -18901,6 +18904,7 @@ api_af_packet_create (vat_main_t * vam)
   clib_memcpy (mp->host_if_name, host_if_name, vec_len (host_if_name));
   clib_memcpy (mp->hw_addr, hw_addr, 6);
   mp->use_random_hw_addr = random_hw_addr;
+  mp->num_rx_queues = num_rx_queues;
   vec_free (host_if_name);
 
   S (mp);
@@ -22704,7 +22708,8 @@ _(lisp_get_map_request_itr_rlocs, "")                                   \
 _(show_lisp_pitr, "")                                                   \
 _(show_lisp_use_petr, "")                                               \
 _(show_lisp_map_request_mode, "")                                       \
-_(af_packet_create, "name <host interface name> [hw_addr <mac>]")       \
+_(af_packet_create, "name <host interface name> [hw_addr <mac>] "      \
+  "[num_rx_queues <n>]")                                                \
 _(af_packet_delete, "name <host interface name>")                       \
 _(policer_add_del, "name <policer name> <params> [del]")                \
 _(policer_dump, "[name <policer name>]")                                \
@@ -31,6 +31,7 @@
 #define SOCK_TEST_TOKEN_SHOW_CFG       "#C"
 #define SOCK_TEST_TOKEN_RUN_UNI        "#U"
 #define SOCK_TEST_TOKEN_RUN_BI         "#B"
+#define SOCK_TEST_TOKEN_RUN_LATENCY    "#L"
 
 #define SOCK_TEST_BANNER_STRING \
   "============================================\n"
@@ -55,6 +56,7 @@ typedef enum
   SOCK_TEST_TYPE_UNI,
   SOCK_TEST_TYPE_BI,
   SOCK_TEST_TYPE_EXIT,
+  SOCK_TEST_TYPE_LATENCY,
 } sock_test_t;
 
 typedef struct  __attribute__ ((packed))
@@ -194,6 +196,9 @@ sock_test_type_str (sock_test_t t)
     case SOCK_TEST_TYPE_EXIT:
       return "EXIT";
 
+    case SOCK_TEST_TYPE_LATENCY:
+      return "LATENCY";
+
     default:
       return "Unknown";
     }
@@ -220,7 +225,9 @@ sock_test_cfg_dump (sock_test_cfg_t * cfg, uint8_t is_client)
           is_client && (cfg->test == SOCK_TEST_TYPE_UNI) ?
           "'"SOCK_TEST_TOKEN_RUN_UNI"'" :
           is_client && (cfg->test == SOCK_TEST_TYPE_BI) ?
-           "'"SOCK_TEST_TOKEN_RUN_BI"'" : spc,
+           "'"SOCK_TEST_TOKEN_RUN_BI"'" :
+          is_client && (cfg->test == SOCK_TEST_TYPE_LATENCY) ?
+           "'"SOCK_TEST_TOKEN_RUN_LATENCY"'" : spc,
           sock_test_type_str (cfg->test), cfg->test,
           cfg->ctrl_handle, cfg->ctrl_handle,
           is_client ? "'"SOCK_TEST_TOKEN_NUM_TEST_SCKTS"'" : spc,
@@ -416,6 +416,147 @@ stream_test_client (sock_test_t test)
 	  test == SOCK_TEST_TYPE_BI ? "Bi" : "Uni");
 }
 
+static int
+latency_sample_cmp (const void *a, const void *b)
+{
+  uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+  return (x > y) - (x < y);
+}
+
+static inline double
+latency_usec (uint64_t * rtt, uint64_t n, uint32_t pct)
+{
+  return rtt[(n - 1) * pct / 100] / 1e3;
+}
+
+/*
+ * Request/response round trips of txbuf size on the first test socket.
+ * The server echoes each request back, one outstanding at a time, so the
+ * distribution of the round trip times shows the per event overhead of
+ * the stack, e.g., of the app's event delivery and wakeups.
+ */
+static void
+latency_test_client (void)
+{
+  sock_client_main_t *scm = &sock_client_main;
+  sock_test_socket_t *ctrl = &scm->ctrl_socket;
+  sock_test_socket_t *tsock = &scm->test_socket[0];
+  struct timespec t0, t1;
+  uint64_t *rtt, i, n, sum = 0;
+  uint32_t n_rx;
+  int rv;
+
+  ctrl->cfg.total_bytes = ctrl->cfg.num_writes * ctrl->cfg.txbuf_size;
+  ctrl->cfg.ctrl_handle = ~0;
+
+  printf ("\n" SOCK_TEST_BANNER_STRING
+	  "CLIENT (fd %d): Latency Test!\n\n"
+	  "CLIENT (fd %d): Sending config to server on ctrl socket...\n",
+	  ctrl->fd, ctrl->fd);
+
+  if (sock_test_cfg_sync (ctrl))
+    {
+      fprintf (stderr, "ERROR: test cfg sync failed -- aborting!");
+      return;
+    }
+
+  rtt = malloc (ctrl->cfg.num_writes * sizeof (*rtt));
+  if (!rtt)
+    {
+      fprintf (stderr, "ERROR: sample allocation failed -- aborting!");
+      return;
+    }
+
+  tsock->cfg = ctrl->cfg;
+  sock_test_socket_buf_alloc (tsock);
+  printf ("CLIENT (fd %d): Sending config to server on test socket 0...\n",
+	  tsock->fd);
+  sock_test_cfg_sync (tsock);
+
+  for (i = 0; i < tsock->txbuf_size; i++)
+    tsock->txbuf[i] = i & 0xff;
+
+  memset (&tsock->stats, 0, sizeof (tsock->stats));
+  clock_gettime (CLOCK_REALTIME, &tsock->stats.start);
+  for (n = 0; n < ctrl->cfg.num_writes; n++)
+    {
+      clock_gettime (CLOCK_MONOTONIC, &t0);
+      rv = sock_test_write (tsock->fd, (uint8_t *) tsock->txbuf,
+			    ctrl->cfg.txbuf_size, &tsock->stats,
+			    ctrl->cfg.verbose);
+      if (rv < 0)
+	{
+	  fprintf (stderr, "\nERROR: sock_test_write(%d) failed "
+		   "-- aborting test!\n", tsock->fd);
+	  goto done;
+	}
+
+      for (n_rx = 0; n_rx < ctrl->cfg.txbuf_size; n_rx += rv)
+	{
+	  uint32_t n_left = ctrl->cfg.txbuf_size - n_rx;
+
+	  rv = sock_test_read (tsock->fd, (uint8_t *) tsock->rxbuf,
+			       (n_left < tsock->rxbuf_size) ? n_left :
+			       tsock->rxbuf_size, &tsock->stats);
+	  if (rv < 0)
+	    {
+	      fprintf (stderr, "\nERROR: sock_test_read(%d) failed "
+		       "-- aborting test!\n", tsock->fd);
+	      goto done;
+	    }
+	}
+      clock_gettime (CLOCK_MONOTONIC, &t1);
+
+      rtt[n] = (t1.tv_sec - t0.tv_sec) * 1000000000ULL
+	+ t1.tv_nsec - t0.tv_nsec;
+      sum += rtt[n];
+    }
+  clock_gettime (CLOCK_REALTIME, &tsock->stats.stop);
+
+  printf ("CLIENT (fd %d): Sending config to server on ctrl socket...\n",
+	  ctrl->fd);
+
+  if (sock_test_cfg_sync (ctrl))
+    {
+      fprintf (stderr, "ERROR: test cfg sync failed -- aborting!");
+      goto done;
+    }
+
+  memset (&ctrl->stats, 0, sizeof (ctrl->stats));
+  sock_test_stats_accumulate (&ctrl->stats, &tsock->stats);
+  ctrl->stats.start = tsock->stats.start;
+  ctrl->stats.stop = tsock->stats.stop;
+  sock_test_stats_dump ("CLIENT RESULTS", &ctrl->stats, 1 /* show_rx */ ,
+			1 /* show tx */ , ctrl->cfg.verbose);
+
+  qsort (rtt, n, sizeof (*rtt), latency_sample_cmp);
+  printf ("  round trip latency (usec):\n"
+	  SOCK_TEST_SEPARATOR_STRING
+	  "        samples:  %lu\n"
+	  "   request size:  %lu\n"
+	  "            min:  %.3lf\n"
+	  "            avg:  %.3lf\n"
+	  "            p50:  %.3lf\n"
+	  "            p90:  %.3lf\n"
+	  "            p99:  %.3lf\n"
+	  "            max:  %.3lf\n"
+	  SOCK_TEST_SEPARATOR_STRING,
+	  n, ctrl->cfg.txbuf_size, rtt[0] / 1e3, (double) sum / n / 1e3,
+	  latency_usec (rtt, n, 50), latency_usec (rtt, n, 90),
+	  latency_usec (rtt, n, 99), rtt[n - 1] / 1e3);
+  sock_test_cfg_dump (&ctrl->cfg, 1 /* is_client */ );
+
+  ctrl->cfg.test = SOCK_TEST_TYPE_ECHO;
+  if (sock_test_cfg_sync (ctrl))
+    fprintf (stderr, "ERROR: post-test cfg sync failed!");
+
+  printf ("CLIENT (fd %d): Latency Test Complete!\n"
+	  SOCK_TEST_BANNER_STRING "\n", ctrl->fd);
+
+done:
+  free (rtt);
+}
+
 static void
 exit_client (void)
 {
@@ -573,6 +714,8 @@ dump_help (void)
 	  "\t\t\tRun the Uni-directional test."
 	  INDENT SOCK_TEST_TOKEN_RUN_BI
 	  "\t\t\tRun the Bi-directional test."
+	  INDENT SOCK_TEST_TOKEN_RUN_LATENCY
+	  "\t\t\tRun the request/response latency test."
 	  INDENT SOCK_TEST_TOKEN_VERBOSE
 	  "\t\t\tToggle verbose setting."
 	  INDENT SOCK_TEST_TOKEN_RXBUF_SIZE
@@ -723,6 +866,10 @@ parse_input ()
 		     strlen (SOCK_TEST_TOKEN_RUN_BI)))
     rv = ctrl->cfg.test = SOCK_TEST_TYPE_BI;
 
+  else if (!strncmp (SOCK_TEST_TOKEN_RUN_LATENCY, ctrl->txbuf,
+		     strlen (SOCK_TEST_TOKEN_RUN_LATENCY)))
+    rv = ctrl->cfg.test = SOCK_TEST_TYPE_LATENCY;
+
   else
     rv = SOCK_TEST_TYPE_ECHO;
 
@@ -745,6 +892,7 @@ print_usage_and_exit (void)
 	   "  -T <txbuf-size>  Test Cfg: tx buffer size.\n"
 	   "  -U               Run Uni-directional test.\n"
 	   "  -B               Run Bi-directional test.\n"
+	   "  -L               Run request/response latency test.\n"
 	   "  -V               Verbose mode.\n");
   exit (1);
 }
@@ -761,7 +909,7 @@ main (int argc, char **argv)
   sock_test_socket_buf_alloc (ctrl);
 
   opterr = 0;
-  while ((c = getopt (argc, argv, "chn:w:XE:I:N:R:T:UBV")) != -1)
+  while ((c = getopt (argc, argv, "chn:w:XE:I:N:R:T:UBLV")) != -1)
     switch (c)
       {
       case 'c':
@@ -888,6 +1036,10 @@ main (int argc, char **argv)
 	ctrl->cfg.test = SOCK_TEST_TYPE_BI;
 	break;
 
+      case 'L':
+	ctrl->cfg.test = SOCK_TEST_TYPE_LATENCY;
+	break;
+
       case 'V':
 	ctrl->cfg.verbose = 1;
 	break;
@@ -1017,6 +1169,10 @@ main (int argc, char **argv)
 	  stream_test_client (ctrl->cfg.test);
 	  break;
 
+	case SOCK_TEST_TYPE_LATENCY:
+	  latency_test_client ();
+	  break;
+
 	case SOCK_TEST_TYPE_EXIT:
 	  continue;
 
@@ -1032,6 +1188,7 @@ main (int argc, char **argv)
 	    case SOCK_TEST_TYPE_EXIT:
 	    case SOCK_TEST_TYPE_UNI:
 	    case SOCK_TEST_TYPE_BI:
+	    case SOCK_TEST_TYPE_LATENCY:
 	    case SOCK_TEST_TYPE_ECHO:
 	      ctrl->cfg.test = SOCK_TEST_TYPE_EXIT;
 	      continue;
@@ -1046,6 +1203,7 @@ main (int argc, char **argv)
 	case SOCK_TEST_TYPE_ECHO:
 	case SOCK_TEST_TYPE_UNI:
 	case SOCK_TEST_TYPE_BI:
+	case SOCK_TEST_TYPE_LATENCY:
 	default:
 	  break;
 	}
@@ -221,7 +221,7 @@ stream_test_server_start_stop (sock_server_conn_t * conn,
 
 		  sprintf (buf, "SERVER (fd %d) RESULTS", tc->fd);
 		  sock_test_stats_dump (buf, &tc->stats, 1 /* show_rx */ ,
-					test == SOCK_TEST_TYPE_BI
+					test != SOCK_TEST_TYPE_UNI
 					/* show tx */ ,
 					conn->cfg.verbose);
 		}
@@ -229,7 +229,7 @@ stream_test_server_start_stop (sock_server_conn_t * conn,
 	}
 
       sock_test_stats_dump ("SERVER RESULTS", &conn->stats, 1 /* show_rx */ ,
-			    (test == SOCK_TEST_TYPE_BI) /* show_tx */ ,
+			    (test != SOCK_TEST_TYPE_UNI) /* show_tx */ ,
 			    conn->cfg.verbose);
       sock_test_cfg_dump (&conn->cfg, 0 /* is_client */ );
       if (conn->cfg.verbose)
@@ -245,14 +245,14 @@ stream_test_server_start_stop (sock_server_conn_t * conn,
       sync_config_and_reply (conn, rx_cfg);
       printf ("\nSERVER (fd %d): %s-directional Stream Test Complete!\n"
 	      SOCK_TEST_BANNER_STRING "\n", conn->fd,
-	      test == SOCK_TEST_TYPE_BI ? "Bi" : "Uni");
+	      test == SOCK_TEST_TYPE_UNI ? "Uni" : "Bi");
     }
   else
     {
       printf ("\n" SOCK_TEST_BANNER_STRING
 	      "SERVER (fd %d): %s-directional Stream Test!\n"
 	      "  Sending client the test cfg to start streaming data...\n",
-	      client_fd, test == SOCK_TEST_TYPE_BI ? "Bi" : "Uni");
+	      client_fd, test == SOCK_TEST_TYPE_UNI ? "Uni" : "Bi");
 
       rx_cfg->ctrl_handle = (rx_cfg->ctrl_handle == ~0) ? conn->fd :
 	rx_cfg->ctrl_handle;
@@ -272,7 +272,8 @@ stream_test_server (sock_server_conn_t * conn, int rx_bytes)
   int client_fd = conn->fd;
   sock_test_t test = conn->cfg.test;
 
-  if (test == SOCK_TEST_TYPE_BI)
+  /* Latency test requests are echoed back like bi-directional data */
+  if (test != SOCK_TEST_TYPE_UNI)
     (void) sock_test_write (client_fd, conn->buf, rx_bytes, &conn->stats,
 			    conn->cfg.verbose);
 
@@ -670,6 +671,7 @@ main (int argc, char **argv)
 
 			case SOCK_TEST_TYPE_BI:
 			case SOCK_TEST_TYPE_UNI:
+			case SOCK_TEST_TYPE_LATENCY:
 			  stream_test_server_start_stop (conn, rx_cfg);
 			  break;
 
@@ -706,7 +708,8 @@ main (int argc, char **argv)
 		    }
 
 		  else if ((conn->cfg.test == SOCK_TEST_TYPE_UNI) ||
-			   (conn->cfg.test == SOCK_TEST_TYPE_BI))
+			   (conn->cfg.test == SOCK_TEST_TYPE_BI) ||
+			   (conn->cfg.test == SOCK_TEST_TYPE_LATENCY))
 		    {
 		      stream_test_server (conn, rx_bytes);
 		      continue;
@@ -17,6 +17,7 @@
 #include <stdlib.h>
 #include <signal.h>
 #include <svm/svm_fifo_segment.h>
+#include <svm/svm_msg_q.h>
 #include <vlibmemory/api.h>
 #include <vpp/api/vpe_msg_enum.h>
 #include <vnet/session/application_interface.h>
@@ -144,6 +145,8 @@ typedef struct vppcom_cfg_t_
   u8 app_proxy_transport_udp;
   u8 app_scope_local;
   u8 app_scope_global;
+  u8 use_mq;
+  u8 mq_sleep;
   u8 *namespace_id;
   u64 namespace_secret;
   f64 app_timeout;
@@ -179,6 +182,9 @@ typedef struct vppcom_main_t_
   /* Our event queue */
   unix_shared_memory_queue_t *app_event_queue;
 
+  /* Per vpp thread event message queues, if configured */
+  svm_msg_q_t **app_mqs;
+
   /* unique segment name counter */
   u32 unique_segment_index;
 
@@ -218,6 +224,71 @@ do {                                                    \
     }                                                   \
 } while (0)
 
+#define VCL_MQ_BATCH_SIZE 64
+
+/**
+ * Wake up threads sleeping in vppcom_epoll_wait. Needed after session
+ * state changes that vpp does not signal with fifo events.
+ */
+static inline void
+vppcom_mq_wake (void)
+{
+  if (vcm->app_mqs && vcm->cfg.mq_sleep)
+    svm_msg_q_notify_signal (vcm->app_mqs[0]->notify);
+}
+
+/**
+ * Drain the event message queues in batches. Clearing the fifo event
+ * flags lets vpp signal new data. Readiness is then found by scanning the
+ * sessions, so the events themselves are dropped.
+ */
+static u32
+vppcom_mq_drain (void)
+{
+  session_fifo_event_t evts[VCL_MQ_BATCH_SIZE];
+  u32 n_evts, n_drained = 0;
+  int i, j;
+
+  /* Queues are single consumer */
+  clib_spinlock_lock (&vcm->sessions_lockp);
+  for (i = 0; i < vec_len (vcm->app_mqs); i++)
+    {
+      do
+	{
+	  n_evts = svm_msg_q_sub_batch (vcm->app_mqs[i], evts,
+					VCL_MQ_BATCH_SIZE);
+	  for (j = 0; j < n_evts; j++)
+	    svm_fifo_unset_event (evts[j].fifo);
+	  n_drained += n_evts;
+	}
+      while (n_evts == VCL_MQ_BATCH_SIZE);
+    }
+  clib_spinlock_unlock (&vcm->sessions_lockp);
+  return n_drained;
+}
+
+/**
+ * Sleep until signaled or @a wait_for_time expires, unless events
+ * arrived since the last drain
+ *
+ * @param seq notification sequence number read before the last drain
+ */
+static void
+vppcom_mq_wait (u32 seq, f64 wait_for_time)
+{
+  svm_msg_q_notify_t *notify = vcm->app_mqs[0]->notify;
+  int i;
+
+  svm_msg_q_notify_prepare (notify);
+  for (i = 0; i < vec_len (vcm->app_mqs); i++)
+    if (!svm_msg_q_is_empty (vcm->app_mqs[i]))
+      {
+	svm_msg_q_notify_cancel (notify);
+	return;
+      }
+  svm_msg_q_notify_wait (notify, seq, wait_for_time);
+}
+
 static const char *
 vppcom_app_state_str (app_state_t state)
 {
@@ -547,7 +618,8 @@ vppcom_app_send_attach (void)
     APP_OPTIONS_FLAGS_ACCEPT_REDIRECT | APP_OPTIONS_FLAGS_ADD_SEGMENT |
     (vcm->cfg.app_scope_local ? APP_OPTIONS_FLAGS_USE_LOCAL_SCOPE : 0) |
     (vcm->cfg.app_scope_global ? APP_OPTIONS_FLAGS_USE_GLOBAL_SCOPE : 0) |
-    (app_is_proxy ? APP_OPTIONS_FLAGS_IS_PROXY : 0);
+    (app_is_proxy ? APP_OPTIONS_FLAGS_IS_PROXY : 0) |
+    (vcm->cfg.use_mq ? APP_OPTIONS_FLAGS_EVT_MQ : 0);
   bmp->options[APP_OPTIONS_PROXY_TRANSPORT] =
     (vcm->cfg.app_proxy_transport_tcp ? 1 << TRANSPORT_PROTO_TCP : 0) |
     (vcm->cfg.app_proxy_transport_udp ? 1 << TRANSPORT_PROTO_UDP : 0);
@@ -555,6 +627,7 @@ vppcom_app_send_attach (void)
   bmp->options[SESSION_OPTIONS_ADD_SEGMENT_SIZE] = vcm->cfg.add_segment_size;
   bmp->options[SESSION_OPTIONS_RX_FIFO_SIZE] = vcm->cfg.rx_fifo_size;
   bmp->options[SESSION_OPTIONS_TX_FIFO_SIZE] = vcm->cfg.tx_fifo_size;
+  bmp->options[APP_EVT_QUEUE_SIZE] = vcm->cfg.event_queue_size;
   if (nsid_len)
     {
       bmp->namespace_id_len = nsid_len;
@@ -634,6 +707,7 @@ vl_api_application_attach_reply_t_handler (vl_api_application_attach_reply_t *
   vcm->app_event_queue =
     uword_to_pointer (mp->app_event_queue_address,
 		      unix_shared_memory_queue_t *);
+  vcm->app_mqs = uword_to_pointer (mp->app_mqs_address, svm_msg_q_t **);
 
   vcm->app_state = STATE_APP_ATTACHED;
 }
@@ -704,6 +778,7 @@ vl_api_disconnect_session_t_handler (vl_api_disconnect_session_t * mp)
 		      getpid (), mp->handle, session_index, session->state,
 		      vppcom_session_state_str (session->state));
       clib_spinlock_unlock (&vcm->sessions_lockp);
+      vppcom_mq_wake ();
       return;
 
     done:
@@ -753,6 +828,7 @@ vl_api_reset_session_t_handler (vl_api_reset_session_t * mp)
 			  vppcom_session_state_str (session->state));
 	}
       clib_spinlock_unlock (&vcm->sessions_lockp);
+      vppcom_mq_wake ();
     }
   else
     {
@@ -862,6 +938,7 @@ done:
 		  session->server_tx_fifo, session->server_tx_fifo->refcnt);
 done_unlock:
   clib_spinlock_unlock (&vcm->sessions_lockp);
+  vppcom_mq_wake ();
 }
 
 static void
@@ -1135,6 +1212,7 @@ vl_api_accept_session_t_handler (vl_api_accept_session_t * mp)
   clib_fifo_add1 (vcm->client_session_index_fifo, session_index);
 
   clib_spinlock_unlock (&vcm->sessions_lockp);
+  vppcom_mq_wake ();
 
   if (VPPCOM_DEBUG > 1)
     clib_warning ("[%d] vpp handle 0x%llx, sid %u: client accept "
@@ -1236,6 +1314,7 @@ vl_api_connect_sock_t_handler (vl_api_connect_sock_t * mp)
 		  "clib_fifo_elts %u!\n", getpid (), session_index,
 		  clib_fifo_elts (vcm->client_session_index_fifo));
   clib_spinlock_unlock (&vcm->sessions_lockp);
+  vppcom_mq_wake ();
 }
 
 static void
@@ -1845,6 +1924,20 @@ vppcom_cfg_read (char *conf_fname)
 		clib_warning ("[%d] configured app_scope_global (%d)",
 			      getpid (), vcl_cfg->app_scope_global);
 	    }
+	  else if (unformat (line_input, "use-mq"))
+	    {
+	      vcl_cfg->use_mq = 1;
+	      if (VPPCOM_DEBUG > 0)
+		clib_warning ("[%d] configured use_mq (%d)",
+			      getpid (), vcl_cfg->use_mq);
+	    }
+	  else if (unformat (line_input, "mq-sleep"))
+	    {
+	      vcl_cfg->use_mq = vcl_cfg->mq_sleep = 1;
+	      if (VPPCOM_DEBUG > 0)
+		clib_warning ("[%d] configured mq_sleep (%d)",
+			      getpid (), vcl_cfg->mq_sleep);
+	    }
 	  else if (unformat (line_input, "namespace-secret %lu",
 			     &vcl_cfg->namespace_secret))
 	    {
@@ -2653,7 +2746,7 @@ done:
 
 static inline int
 vppcom_session_read_internal (uint32_t session_index, void *buf, int n,
-			      u8 peek)
+			      u8 peek, vppcom_data_segment_t * ds)
 {
   session_t *session = 0;
   svm_fifo_t *rx_fifo;
@@ -2666,7 +2759,7 @@ vppcom_session_read_internal (uint32_t session_index, void *buf, int n,
   u8 is_nonblocking;
   u64 vpp_handle;
 
-  ASSERT (buf);
+  ASSERT (buf || ds);
 
   VCL_LOCK_AND_GET_SESSION (session_index, &session);
 
@@ -2707,7 +2800,10 @@ vppcom_session_read_internal (uint32_t session_index, void *buf, int n,
 
   do
     {
-      if (peek)
+      if (ds)
+	n_read = svm_fifo_peek_in_place (rx_fifo, 0, n,
+					 (svm_fifo_iovec_t *) ds);
+      else if (peek)
 	n_read = svm_fifo_peek (rx_fifo, 0, n, buf);
       else
 	n_read = svm_fifo_dequeue_nowait (rx_fifo, n, buf);
@@ -2768,13 +2864,49 @@ done:
 int
 vppcom_session_read (uint32_t session_index, void *buf, int n)
 {
-  return (vppcom_session_read_internal (session_index, buf, n, 0));
+  return (vppcom_session_read_internal (session_index, buf, n, 0, 0));
 }
 
 static int
 vppcom_session_peek (uint32_t session_index, void *buf, int n)
 {
-  return (vppcom_session_read_internal (session_index, buf, n, 1));
+  return (vppcom_session_read_internal (session_index, buf, n, 1, 0));
+}
+
+STATIC_ASSERT (sizeof (vppcom_data_segment_t) == sizeof (svm_fifo_iovec_t),
+	       "vppcom data segment and svm fifo iovec must match");
+
+/*
+ * Zero-copy read. Points the segments at the data in the rx fifo, so the
+ * app can consume it in place. The data must be released with
+ * vppcom_session_free_segments once done with.
+ */
+int
+vppcom_session_read_segments (uint32_t session_index,
+			      vppcom_data_segments_t ds)
+{
+  return (vppcom_session_read_internal (session_index, 0, INT32_MAX, 0, ds));
+}
+
+int
+vppcom_session_free_segments (uint32_t session_index,
+			      vppcom_data_segments_t ds)
+{
+  session_t *session = 0;
+  svm_fifo_t *rx_fifo;
+  int rv;
+
+  VCL_LOCK_AND_GET_SESSION (session_index, &session);
+
+  rx_fifo = ((!session->is_cut_thru || session->is_server) ?
+	     session->server_rx_fifo : session->server_tx_fifo);
+  clib_spinlock_unlock (&vcm->sessions_lockp);
+
+  rv = svm_fifo_dequeue_drop (rx_fifo, ds[0].len + ds[1].len);
+  rv = rv < 0 ? VPPCOM_OK : rv;
+
+done:
+  return rv;
 }
 
 static inline int
@@ -3112,6 +3244,10 @@ vppcom_select (unsigned long n_bits, unsigned long *read_map,
 
   do
     {
+      /* Keep event queues flowing. Select does not sleep on them */
+      if (vcm->app_mqs)
+	vppcom_mq_drain ();
+
       /* *INDENT-OFF* */
       if (n_bits)
         {
@@ -3522,10 +3658,11 @@ vppcom_epoll_wait (uint32_t vep_idx, struct epoll_event *events,
   session_t *vep_session;
   int rv;
   f64 timeout = clib_time_now (&vcm->clib_time) + wait_for_time;
+  f64 time_left;
   u32 keep_trying = 1;
   int num_ev = 0;
-  u32 vep_next_sid, wait_cont_idx;
-  u8 is_vep;
+  u32 vep_next_sid, wait_cont_idx, seq = 0;
+  u8 is_vep, can_sleep;
 
   if (PREDICT_FALSE (maxevents <= 0))
     {
@@ -3562,11 +3699,20 @@ vppcom_epoll_wait (uint32_t vep_idx, struct epoll_event *events,
       u32 next_sid = ~0;
       session_t *session;
 
+      /* Sleeping is only possible if vpp signals all that is waited for.
+       * It does not signal tx space or cut-thru peers' activity */
+      can_sleep = vcm->cfg.mq_sleep && vcm->app_mqs;
+      if (vcm->app_mqs)
+	{
+	  seq = svm_msg_q_notify_seq (vcm->app_mqs[0]->notify);
+	  vppcom_mq_drain ();
+	}
+
       for (sid = (wait_cont_idx == ~0) ? vep_next_sid : wait_cont_idx;
 	   sid != ~0; sid = next_sid)
 	{
 	  u32 session_events, et_mask, clear_et_mask, session_vep_idx;
-	  u8 add_event, is_vep_session;
+	  u8 add_event, is_vep_session, is_cut_thru;
 	  int ready;
 	  u64 session_ev_data;
 
@@ -3576,10 +3722,14 @@ vppcom_epoll_wait (uint32_t vep_idx, struct epoll_event *events,
 	  et_mask = session->vep.et_mask;
 	  is_vep = session->is_vep;
 	  is_vep_session = session->is_vep_session;
+	  is_cut_thru = session->is_cut_thru;
 	  session_vep_idx = session->vep.vep_idx;
 	  session_ev_data = session->vep.ev.data.u64;
 	  clib_spinlock_unlock (&vcm->sessions_lockp);
 
+	  if ((EPOLLOUT & session_events) || is_cut_thru)
+	    can_sleep = 0;
+
 	  if (PREDICT_FALSE (is_vep))
 	    {
 	      if (VPPCOM_DEBUG > 0)
@@ -3693,6 +3843,19 @@ vppcom_epoll_wait (uint32_t vep_idx, struct epoll_event *events,
 	}
       if (wait_for_time != -1)
 	keep_trying = (clib_time_now (&vcm->clib_time) <= timeout) ? 1 : 0;
+
+      if (!num_ev && keep_trying && can_sleep)
+	{
+	  /* A negative wait is forever, so do not sleep past the timeout */
+	  if (wait_for_time == -1)
+	    vppcom_mq_wait (seq, -1);
+	  else
+	    {
+	      time_left = timeout - clib_time_now (&vcm->clib_time);
+	      if (time_left > 0)
+		vppcom_mq_wait (seq, time_left);
+	    }
+	}
     }
   while ((num_ev == 0) && keep_trying);
 
@@ -56,6 +56,15 @@ typedef struct vppcom_endpt_t_
   uint16_t port;
 } vppcom_endpt_t;
 
+/* Received data, read in place. Data that wraps takes both segments */
+typedef struct vppcom_data_segment_
+{
+  unsigned char *data;
+  uint32_t len;
+} vppcom_data_segment_t;
+
+typedef vppcom_data_segment_t vppcom_data_segments_t[2];
+
 typedef enum
 {
   VPPCOM_OK = 0,
@@ -167,6 +176,10 @@ extern int vppcom_session_connect (uint32_t session_index,
 				   vppcom_endpt_t * server_ep);
 extern int vppcom_session_read (uint32_t session_index, void *buf, int n);
 extern int vppcom_session_write (uint32_t session_index, void *buf, int n);
+extern int vppcom_session_read_segments (uint32_t session_index,
+					 vppcom_data_segments_t ds);
+extern int vppcom_session_free_segments (uint32_t session_index,
+					 vppcom_data_segments_t ds);
 
 extern int vppcom_select (unsigned long n_bits,
 			  unsigned long *read_map,
@@ -558,27 +558,42 @@ vlib_buffer_copy (vlib_main_t * vm, vlib_buffer_t * b)
   return fd;
 }
 
-/** \brief Create multiple clones of buffer and store them in the supplied array
+/** \brief Buffer flags a copy or a clone does not inherit from its source
+
+    Free list index, trace and recycle state belong to the buffer, not to
+    the packet in it.
+*/
+#define VLIB_BUFFER_CLONE_FLAGS_MASK				\
+  (VLIB_BUFFER_FREE_LIST_INDEX_MASK | VLIB_BUFFER_IS_TRACED |	\
+   VLIB_BUFFER_NEXT_PRESENT | VLIB_BUFFER_TOTAL_LENGTH_VALID |	\
+   VLIB_BUFFER_IS_RECYCLED | VLIB_BUFFER_RECYCLE |		\
+   VLIB_BUFFER_EXT_HDR_VALID)
+
+/** Default amount of packet data a clone gets its own copy of */
+#define VLIB_BUFFER_CLONE_HEAD_SIZE 256
+
+/** \brief Create up to 256 clones of buffer and store them in the supplied array
 
     @param vm - (vlib_main_t *) vlib main data structure pointer
     @param src_buffer - (u32) source buffer index
     @param buffers - (u32 * ) buffer index array
-    @param n_buffers - (u8) number of buffer clones requested
+    @param n_buffers - (u16) number of buffer clones requested (<=256)
     @param head_end_offset - (u16) offset relative to current position
            where packet head ends
-    @return - (u8) number of buffers actually cloned, may be
+    @return - (u16) number of buffers actually cloned, may be
     less than the number requested or zero
 */
 
-always_inline u8
-vlib_buffer_clone (vlib_main_t * vm, u32 src_buffer, u32 * buffers,
-		   u8 n_buffers, u16 head_end_offset)
+always_inline u16
+vlib_buffer_clone_256 (vlib_main_t * vm, u32 src_buffer, u32 * buffers,
+		       u16 n_buffers, u16 head_end_offset)
 {
-  u8 i;
+  u16 i;
   vlib_buffer_t *s = vlib_get_buffer (vm, src_buffer);
 
   ASSERT (s->n_add_refs == 0);
   ASSERT (n_buffers);
+  ASSERT (n_buffers <= 256);
 
   if (s->current_length <= head_end_offset + CLIB_CACHE_LINE_BYTES * 2)
     {
@@ -589,6 +604,7 @@ vlib_buffer_clone (vlib_main_t * vm, u32 src_buffer, u32 * buffers,
 	  d = vlib_buffer_copy (vm, s);
 	  if (d == 0)
 	    return i;
+	  d->flags |= s->flags & ~VLIB_BUFFER_CLONE_FLAGS_MASK;
 	  buffers[i] = vlib_get_buffer_index (vm, d);
 
 	}
@@ -632,6 +648,48 @@ vlib_buffer_clone (vlib_main_t * vm, u32 src_buffer, u32 * buffers,
   return n_buffers;
 }
 
+/** \brief Create multiple clones of buffer and store them in the supplied array
+
+    Clones share the packet data past head_end_offset, each one has its
+    own copy of the head. A buffer holds at most 256 references, so every
+    additional 256 clones are made from a full copy of the packet.
+
+    @param vm - (vlib_main_t *) vlib main data structure pointer
+    @param src_buffer - (u32) source buffer index
+    @param buffers - (u32 * ) buffer index array
+    @param n_buffers - (u16) number of buffer clones requested
+    @param head_end_offset - (u16) offset relative to current position
+           where packet head ends
+    @return - (u16) number of buffers actually cloned, may be
+    less than the number requested but at least one, the source buffer
+*/
+
+always_inline u16
+vlib_buffer_clone (vlib_main_t * vm, u32 src_buffer, u32 * buffers,
+		   u16 n_buffers, u16 head_end_offset)
+{
+  vlib_buffer_t *s = vlib_get_buffer (vm, src_buffer);
+  vlib_buffer_t *copy;
+  u16 n_cloned = 0;
+
+  while (n_buffers > 256)
+    {
+      copy = vlib_buffer_copy (vm, s);
+      if (PREDICT_FALSE (copy == 0))
+	break;
+      copy->flags |= s->flags & ~VLIB_BUFFER_CLONE_FLAGS_MASK;
+      n_cloned += vlib_buffer_clone_256 (vm, vlib_get_buffer_index (vm, copy),
+					 buffers + n_cloned, 256,
+					 head_end_offset);
+      n_buffers -= 256;
+    }
+  n_cloned += vlib_buffer_clone_256 (vm, src_buffer, buffers + n_cloned,
+				     clib_min (n_buffers, 256),
+				     head_end_offset);
+
+  return n_cloned;
+}
+
 /** \brief Attach cloned tail to the buffer
 
     @param vm - (vlib_main_t *) vlib main data structure pointer
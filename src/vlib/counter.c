@@ -96,6 +96,30 @@ vlib_validate_combined_counter (vlib_combined_counter_main_t * cm, u32 index)
     vec_validate_aligned (cm->counters[i], index, CLIB_CACHE_LINE_BYTES);
 }
 
+int
+vlib_validate_combined_counter_will_expand
+  (vlib_combined_counter_main_t * cm, u32 index)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  int i;
+
+  if (PREDICT_FALSE (vec_len (cm->counters) < tm->n_vlib_mains))
+    return 1;
+
+  for (i = 0; i < tm->n_vlib_mains; i++)
+    {
+      if (index < vec_len (cm->counters[i]))
+	continue;
+      if (_vec_resize_will_expand (cm->counters[i],
+				   index + 1 - vec_len (cm->counters[i]),
+				   (index + 1) * sizeof (cm->counters[i][0]),
+				   0 /* header_bytes */ ,
+				   CLIB_CACHE_LINE_BYTES))
+	return 1;
+    }
+  return 0;
+}
+
 u32
 vlib_combined_counter_n_counters (const vlib_combined_counter_main_t * cm)
 {
@@ -304,6 +304,17 @@ void vlib_validate_simple_counter (vlib_simple_counter_main_t * cm,
 void vlib_validate_combined_counter (vlib_combined_counter_main_t * cm,
 				     u32 index);
 
+/** Check whether validating a combined counter would reallocate the
+    per-thread counter vectors, under the workers' feet.
+    @param cm - (vlib_combined_counter_main_t *) pointer to the counter
+    collection
+    @param index - (u32) index of the counter to validate
+    @returns 1 if the counter vectors would move, 0 otherwise
+*/
+
+int vlib_validate_combined_counter_will_expand
+  (vlib_combined_counter_main_t * cm, u32 index);
+
 /** Obtain the number of simple or combined counters allocated.
     A macro which reduces to to vec_len(cm->maxi), the answer in either
     case.
@@ -38,6 +38,9 @@
  */
 
 #include <math.h>
+#include <errno.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
 #include <vppinfra/format.h>
 #include <vlib/vlib.h>
 #include <vlib/threads.h>
@@ -1423,6 +1426,97 @@ dispatch_suspended_process (vlib_main_t * vm,
   return t;
 }
 
+/* Longest sleep of a worker with no input node left in polling state */
+#define VLIB_WORKER_MAX_SLEEP 10e-3
+/* Main loops without any vector after which a polling worker may sleep */
+#define VLIB_WORKER_IDLE_LOOPS 1024
+
+void
+vlib_main_wakeup_signal (vlib_main_t * vm)
+{
+  vm->wakeup_request_time = clib_cpu_time_now ();
+  __sync_fetch_and_add (&vm->wakeup_seq, 1);
+  syscall (SYS_futex, &vm->wakeup_seq, FUTEX_WAKE_PRIVATE, 1, 0, 0, 0);
+}
+
+static int
+vlib_worker_has_work (vlib_main_t * vm)
+{
+  vlib_node_main_t *nm = &vm->node_main;
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_frame_queue_main_t *fqm;
+  vlib_frame_queue_t *fq;
+
+  if (_vec_len (nm->pending_interrupt_node_runtime_indices))
+    return 1;
+  if (*vlib_worker_threads->wait_at_barrier)
+    return 1;
+  vec_foreach (fqm, tm->frame_queue_mains)
+  {
+    fq = fqm->vlib_frame_queues[vm->thread_index];
+    if (fq->head != fq->tail)
+      return 1;
+  }
+  return 0;
+}
+
+/*
+ * Put an idle worker to sleep for at most timeout seconds. Whoever posts
+ * work for it, input node interrupts, handoff frames or barrier requests,
+ * wakes it up with vlib_main_wakeup. The sleep and the wakeup latency
+ * are accounted for in the show runtime output.
+ */
+static u64
+vlib_worker_sleep (vlib_main_t * vm, f64 timeout)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_frame_queue_main_t *fqm;
+  struct timespec ts;
+  u32 seq = vm->wakeup_seq;
+  u64 t0, t1;
+  long rv;
+
+  /* Ship the handoff frames held back, their receivers may sleep too */
+  vec_foreach (fqm, tm->frame_queue_mains)
+    vlib_frame_queue_flush (vm, fqm, 1 /* force */ );
+
+  vlib_rcu_offline (vm->thread_index);
+  vm->wakeup_request_time = 0;
+  vm->sleeping = 1;
+  CLIB_MEMORY_BARRIER ();
+
+  /* Last check, wakers now see us asleep */
+  if (vlib_worker_has_work (vm))
+    {
+      vm->sleeping = 0;
+      goto done;
+    }
+
+  ts.tv_sec = (time_t) timeout;
+  ts.tv_nsec = (long) ((timeout - ts.tv_sec) * 1e9);
+  rv = syscall (SYS_futex, &vm->wakeup_seq, FUTEX_WAIT_PRIVATE, seq, &ts,
+		0, 0);
+  vm->sleeping = 0;
+  vm->n_sleeps++;
+
+  /* Woken up, or signaled before we could even wait */
+  if (rv == 0 || errno == EAGAIN)
+    {
+      t0 = vm->wakeup_request_time;
+      t1 = clib_cpu_time_now ();
+      if (t0 && t1 > t0)
+	{
+	  vm->n_wakeups++;
+	  vm->wakeup_latency_total += t1 - t0;
+	  vm->wakeup_latency_max = clib_max (vm->wakeup_latency_max, t1 - t0);
+	}
+    }
+
+done:
+  vlib_rcu_online (vm->thread_index);
+  return clib_cpu_time_now ();
+}
+
 static_always_inline void
 vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
 {
@@ -1432,6 +1526,7 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
   u64 cpu_time_now;
   vlib_frame_queue_main_t *fqm;
   u32 *last_node_runtime_indices = 0;
+  u32 n_idle_loops = 0;
 
   /* Initialize pending node vector. */
   if (is_main)
@@ -1478,10 +1573,15 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
       if (!is_main)
 	{
 	  vlib_worker_thread_barrier_check ();
+	  vlib_rcu_quiescent (vm->thread_index);
 	  vec_foreach (fqm, tm->frame_queue_mains)
 	    vlib_frame_queue_dequeue (vm, fqm);
 	}
 
+      /* Ship handoff frames which have been held back too long */
+      vec_foreach (fqm, tm->frame_queue_mains)
+	vlib_frame_queue_flush_stale (vm, fqm);
+
       /* Process pre-input nodes. */
       if (is_main)
 	vec_foreach (n, nm->nodes_by_type[VLIB_NODE_TYPE_PRE_INPUT])
@@ -1604,6 +1704,23 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
       if (is_main && _vec_len (nm->data_from_advancing_timing_wheel) > 0)
 	goto processes_timing_wheel_data;
 
+      /*
+       * The main thread sleeps in epoll. A worker sleeps when none of its
+       * input nodes polls, all wait for interrupts, or, if configured,
+       * when it polled for a while without receiving anything.
+       */
+      if (!is_main)
+	{
+	  n_idle_loops = vm->main_loop_vectors_processed ? 0 :
+	    n_idle_loops + 1;
+	  if (nm->input_node_counts_by_state[VLIB_NODE_STATE_POLLING] == 0)
+	    cpu_time_now = vlib_worker_sleep (vm, VLIB_WORKER_MAX_SLEEP);
+	  else if (PREDICT_FALSE (vlib_global_main.worker_idle_sleep > 0.0
+				  && n_idle_loops >= VLIB_WORKER_IDLE_LOOPS))
+	    cpu_time_now =
+	      vlib_worker_sleep (vm, vlib_global_main.worker_idle_sleep);
+	}
+
       vlib_increment_main_loop_counter (vm);
 
       /* Record time stamp in case there are no enabled nodes and above
@@ -1630,6 +1747,7 @@ static clib_error_t *
 vlib_main_configure (vlib_main_t * vm, unformat_input_t * input)
 {
   int turn_on_mem_trace = 0;
+  f64 sleep_usec;
 
   while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
     {
@@ -1641,6 +1759,16 @@ vlib_main_configure (vlib_main_t * vm, unformat_input_t * input)
 	;
       else if (unformat (input, "elog-post-mortem-dump"))
 	vm->elog_post_mortem_dump = 1;
+      else if (unformat (input, "adaptive-input"))
+	vm->adaptive_input = 1;
+      else if (unformat (input, "adaptive-polling-threshold %u",
+			 &vm->node_main.polling_threshold_vector_length))
+	;
+      else if (unformat (input, "adaptive-interrupt-threshold %u",
+			 &vm->node_main.interrupt_threshold_vector_length))
+	;
+      else if (unformat (input, "worker-idle-sleep %f", &sleep_usec))
+	vm->worker_idle_sleep = sleep_usec * 1e-6;
       else
 	return unformat_parse_error (input);
     }
@@ -210,12 +210,50 @@ typedef struct vlib_main_t
   /* Earliest barrier can be closed again */
   f64 barrier_no_close_before;
 
+  /*
+   * Idle worker sleep, see vlib_worker_sleep. The futex word and the
+   * request time are written by the threads waking the worker up.
+   */
+  volatile u32 wakeup_seq;
+  volatile u32 sleeping;
+  volatile u64 wakeup_request_time;
+
+  /* Sleep statistics, latencies in clocks */
+  u64 n_sleeps;
+  u64 n_wakeups;
+  u64 wakeup_latency_total;
+  u64 wakeup_latency_max;
+
+  /*
+   * Longest sleep of a worker which still polls some input node but
+   * found no work for a while, 0 to never sleep then. If adaptive_input
+   * is set, devices which support interrupts default to adaptive rx
+   * mode. Only valid in vlib_global_main.
+   */
+  f64 worker_idle_sleep;
+  u8 adaptive_input;
+
 } vlib_main_t;
 
 /* Global main structure. */
 extern vlib_main_t vlib_global_main;
 
 void vlib_worker_loop (vlib_main_t * vm);
+void vlib_main_wakeup_signal (vlib_main_t * vm);
+
+/*
+ * Wake up the thread running vm if it sleeps. To be called after having
+ * posted work for it, e.g., an input node interrupt.
+ */
+always_inline void
+vlib_main_wakeup (vlib_main_t * vm)
+{
+  /* Publish the work before checking if vm went to sleep */
+  CLIB_MEMORY_BARRIER ();
+  if (PREDICT_FALSE (vm->sleeping)
+      && __sync_bool_compare_and_swap (&vm->sleeping, 1, 0))
+    vlib_main_wakeup_signal (vm);
+}
 
 always_inline f64
 vlib_time_now (vlib_main_t * vm)
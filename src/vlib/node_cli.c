@@ -354,6 +354,17 @@ show_node_runtime (vlib_main_t * vm,
 	     (f64) n_input / dt,
 	     (f64) n_output / dt, (f64) n_drop / dt, (f64) n_punt / dt);
 
+	  if (stat_vm->n_sleeps)
+	    vlib_cli_output
+	      (vm, "  sleeps %llu, wakeups %llu, wakeup latency "
+	       "avg %.2f us, max %.2f us", stat_vm->n_sleeps,
+	       stat_vm->n_wakeups,
+	       stat_vm->n_wakeups ?
+	       (f64) stat_vm->wakeup_latency_total / stat_vm->n_wakeups *
+	       stat_vm->clib_time.seconds_per_clock * 1e6 : 0,
+	       (f64) stat_vm->wakeup_latency_max *
+	       stat_vm->clib_time.seconds_per_clock * 1e6);
+
 	  vlib_cli_output (vm, "%U", format_vlib_node_stats, stat_vm, 0, max);
 	  for (i = 0; i < vec_len (nodes); i++)
 	    {
@@ -424,6 +435,8 @@ clear_node_runtime (vlib_main_t * vm,
 	}
       /* Note: input/output rates computed using vlib_global_main */
       nm->time_last_runtime_stats_clear = vlib_time_now (vm);
+      stat_vm->n_sleeps = stat_vm->n_wakeups = 0;
+      stat_vm->wakeup_latency_total = stat_vm->wakeup_latency_max = 0;
     }
 
   vlib_worker_thread_barrier_release (vm);
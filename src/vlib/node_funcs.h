@@ -176,6 +176,10 @@ vlib_node_set_state (vlib_main_t * vm, u32 node_index,
 
   n->state = new_state;
   r->state = new_state;
+
+  /* A sleeping worker must see a node being switched to polling */
+  if (n->type == VLIB_NODE_TYPE_INPUT)
+    vlib_main_wakeup (vm);
 }
 
 /** \brief Get node dispatch state.
@@ -201,6 +205,7 @@ vlib_node_set_interrupt_pending (vlib_main_t * vm, u32 node_index)
   clib_spinlock_lock_if_init (&nm->pending_interrupt_lock);
   vec_add1 (nm->pending_interrupt_node_runtime_indices, n->runtime_index);
   clib_spinlock_unlock_if_init (&nm->pending_interrupt_lock);
+  vlib_main_wakeup (vm);
 }
 
 always_inline vlib_process_t *
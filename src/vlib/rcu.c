@@ -0,0 +1,312 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * rcu.c: read-copy-update style deferred reclamation, see rcu.h
+ */
+
+#include <vlib/vlib.h>
+
+vlib_rcu_main_t vlib_rcu_main;
+
+static vlib_node_registration_t vlib_rcu_process_node;
+
+/* How often the process checks for a grace period, while one is pending */
+#define VLIB_RCU_POLL_INTERVAL (1e-4)
+
+#if defined (BARRIER_TRACING) && defined (BARRIER_TRACING_ELOG)
+static inline void
+vlib_rcu_trace (u32 n_callbacks, f64 t_grace)
+{
+  /* *INDENT-OFF* */
+  ELOG_TYPE_DECLARE (e) =
+    {
+      .format = "rcu grace period (%dus) %d callbacks",
+      .format_args = "i4i4",
+    };
+  /* *INDENT-ON* */
+  struct
+  {
+    u32 t_grace, n_callbacks;
+  } *ed = 0;
+
+  ed = ELOG_DATA (&vlib_global_main.elog_main, e);
+  ed->t_grace = (int) (1000000.0 * t_grace);
+  ed->n_callbacks = n_callbacks;
+}
+#else
+static inline void
+vlib_rcu_trace (u32 n_callbacks, f64 t_grace)
+{
+}
+#endif
+
+static inline int
+vlib_rcu_have_workers (void)
+{
+  return (vec_len (vlib_mains) > 1);
+}
+
+/* Holding the barrier, the workers are all at a quiescent point */
+static inline int
+vlib_rcu_barrier_held (void)
+{
+  return (vlib_worker_threads[0].recursion_level > 0);
+}
+
+/* The oldest epoch any of the workers may still be in */
+static u64
+vlib_rcu_min_epoch (vlib_rcu_main_t * rm)
+{
+  u64 min = rm->epoch;
+  u32 i;
+
+  if (vlib_rcu_have_workers () && vlib_rcu_barrier_held ())
+    return min;
+
+  for (i = 1; i < vec_len (rm->threads); i++)
+    min = clib_min (min, rm->threads[i].epoch);
+
+  return min;
+}
+
+static void
+vlib_rcu_grace_period_done (vlib_rcu_main_t * rm, u32 n_callbacks,
+			    f64 t_grace)
+{
+  rm->n_grace_periods++;
+  rm->grace_period_total += t_grace;
+  rm->grace_period_max = clib_max (rm->grace_period_max, t_grace);
+  vlib_rcu_trace (n_callbacks, t_grace);
+}
+
+void
+vlib_rcu_call (vlib_main_t * vm, vlib_rcu_callback_fn_t * fn, void *arg)
+{
+  vlib_rcu_main_t *rm = &vlib_rcu_main;
+  vlib_rcu_callback_t *c;
+  void *oldheap;
+
+  ASSERT (vlib_get_thread_index () == 0);
+
+  /* The callback may be queued with a subsystem's private heap current */
+  oldheap = clib_mem_set_heap (vlib_global_main.heap_base);
+  vec_add2 (rm->pending, c, 1);
+  clib_mem_set_heap (oldheap);
+
+  c->fn = fn;
+  c->arg = arg;
+  c->heap = oldheap;
+  c->time = vlib_time_now (vm);
+  c->epoch = ++rm->epoch;
+  CLIB_MEMORY_BARRIER ();
+
+  rm->n_callbacks++;
+
+  /*
+   * Always defer, even without workers, so the callback never runs
+   * in the middle of the update which retired the object.
+   */
+  if (1 == vec_len (rm->pending))
+    vlib_process_signal_event (vm, vlib_rcu_process_node.index, 0, 0);
+}
+
+static void
+vlib_rcu_vec_free_cb (void *v)
+{
+  vec_free (v);
+}
+
+void
+vlib_rcu_vec_free (vlib_main_t * vm, void *v)
+{
+  if (v)
+    vlib_rcu_call (vm, vlib_rcu_vec_free_cb, v);
+}
+
+void
+vlib_rcu_synchronize (vlib_main_t * vm)
+{
+  vlib_rcu_main_t *rm = &vlib_rcu_main;
+  f64 t_entry, now, deadline;
+  u64 epoch;
+
+  ASSERT (vlib_get_thread_index () == 0);
+
+  if (!vlib_rcu_have_workers () || vlib_rcu_barrier_held ())
+    return;
+
+  rm->n_synchronize++;
+  t_entry = vlib_time_now (vm);
+  deadline = t_entry + BARRIER_SYNC_TIMEOUT;
+
+  epoch = ++rm->epoch;
+  CLIB_MEMORY_BARRIER ();
+
+  while (vlib_rcu_min_epoch (rm) < epoch)
+    {
+      if ((now = vlib_time_now (vm)) > deadline)
+	{
+	  fformat (stderr, "%s: worker thread deadlock\n", __FUNCTION__);
+	  os_panic ();
+	}
+    }
+
+  vlib_rcu_grace_period_done (rm, 0, vlib_time_now (vm) - t_entry);
+}
+
+/*
+ * Run the callbacks whose grace period has passed, returns the number
+ * still pending.
+ */
+static uword
+vlib_rcu_run_callbacks (vlib_main_t * vm)
+{
+  vlib_rcu_main_t *rm = &vlib_rcu_main;
+  static vlib_rcu_callback_t *expired;
+  vlib_rcu_callback_t *c;
+  void *oldheap;
+  u64 min_epoch;
+  f64 t_queued;
+  u32 n;
+
+  min_epoch = vlib_rcu_min_epoch (rm);
+
+  for (n = 0; n < vec_len (rm->pending); n++)
+    if (rm->pending[n].epoch > min_epoch)
+      break;
+
+  if (n)
+    {
+      t_queued = rm->pending[0].time;
+
+      /* The callbacks may queue more */
+      vec_add (expired, rm->pending, n);
+      vec_delete (rm->pending, n, 0);
+
+      vec_foreach (c, expired)
+      {
+	oldheap = clib_mem_set_heap (c->heap);
+	c->fn (c->arg);
+	clib_mem_set_heap (oldheap);
+      }
+
+      vlib_rcu_grace_period_done (rm, n, vlib_time_now (vm) - t_queued);
+      vec_reset_length (expired);
+    }
+
+  return (vec_len (rm->pending));
+}
+
+void
+vlib_rcu_barrier (vlib_main_t * vm)
+{
+  ASSERT (vlib_get_thread_index () == 0);
+
+  /* The callbacks may queue more */
+  do
+    vlib_rcu_synchronize (vm);
+  while (vlib_rcu_run_callbacks (vm));
+}
+
+static uword
+vlib_rcu_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
+		  vlib_frame_t * f)
+{
+  vlib_rcu_main_t *rm = &vlib_rcu_main;
+
+  while (1)
+    {
+      if (vec_len (rm->pending))
+	vlib_process_wait_for_event_or_clock (vm, VLIB_RCU_POLL_INTERVAL);
+      else
+	vlib_process_wait_for_event (vm);
+
+      vlib_process_get_events (vm, NULL);
+      vlib_rcu_run_callbacks (vm);
+    }
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (vlib_rcu_process_node, static) = {
+  .function = vlib_rcu_process,
+  .type = VLIB_NODE_TYPE_PROCESS,
+  .name = "rcu-process",
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+show_rcu (vlib_main_t * vm, unformat_input_t * input,
+	  vlib_cli_command_t * cmd)
+{
+  vlib_rcu_main_t *rm = &vlib_rcu_main;
+  u32 i;
+
+  vlib_cli_output (vm, "epoch %llu, %u callbacks pending",
+		   rm->epoch, vec_len (rm->pending));
+  for (i = 1; i < vec_len (rm->threads); i++)
+    if (rm->threads[i].epoch == ~0ULL)
+      vlib_cli_output (vm, "  %-20v sleeping", vlib_worker_threads[i].name);
+    else
+      vlib_cli_output (vm, "  %-20v epoch %llu",
+		       vlib_worker_threads[i].name, rm->threads[i].epoch);
+  vlib_cli_output (vm, "%llu callbacks, %llu synchronize calls",
+		   rm->n_callbacks, rm->n_synchronize);
+  if (rm->n_grace_periods)
+    vlib_cli_output (vm, "%llu grace periods, avg %.2f us, max %.2f us",
+		     rm->n_grace_periods,
+		     rm->grace_period_total / rm->n_grace_periods * 1e6,
+		     rm->grace_period_max * 1e6);
+  return 0;
+}
+
+/*?
+ * Show the state of the deferred reclamation: the global epoch, the
+ * epoch each worker last saw at a quiescent point, and how long the grace
+ * periods took.
+ *
+ * @cliexpar
+ * @cliexcmd{show rcu}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_rcu_command, static) = {
+  .path = "show rcu",
+  .short_help = "show rcu",
+  .function = show_rcu,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+vlib_rcu_init (vlib_main_t * vm)
+{
+  vlib_rcu_main_t *rm = &vlib_rcu_main;
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+
+  /* before the workers start */
+  vec_validate_aligned (rm->threads, tm->n_vlib_mains - 1,
+			CLIB_CACHE_LINE_BYTES);
+
+  return 0;
+}
+
+VLIB_INIT_FUNCTION (vlib_rcu_init);
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * rcu.h: read-copy-update style deferred reclamation
+ *
+ * The workers only read the forwarding state, so the main thread can
+ * update it in place, or build a copy and swap a pointer to it, without
+ * stopping the workers. What it can not do is free the old copy while
+ * a worker may still be looking at it.
+ *
+ * Each worker publishes, at the top of its main loop, the global epoch it
+ * last saw; at that point it holds no pointer into shared state. The main
+ * thread advances the global epoch when it retires an object, and the
+ * object can be freed once every worker has published that epoch or a
+ * later one, i.e. a grace period has passed.
+ *
+ * Holding the worker barrier implies a grace period.
+ */
+
+#ifndef included_vlib_rcu_h
+#define included_vlib_rcu_h
+
+#include <vppinfra/clib.h>
+#include <vppinfra/cache.h>
+
+struct vlib_main_t;
+
+typedef void (vlib_rcu_callback_fn_t) (void *arg);
+
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  /* Global epoch seen at this thread's last quiescent point */
+  volatile u64 epoch;
+} vlib_rcu_thread_t;
+
+typedef struct
+{
+  vlib_rcu_callback_fn_t *fn;
+  void *arg;
+  /* Heap current when the callback was queued */
+  void *heap;
+  f64 time;
+  /* Safe to call once all workers have seen this epoch */
+  u64 epoch;
+} vlib_rcu_callback_t;
+
+typedef struct
+{
+  /* Advanced by the main thread only */
+  volatile u64 epoch;
+
+  /* Per thread, thread 0's is unused */
+  vlib_rcu_thread_t *threads;
+
+  /* Callbacks waiting for a grace period, oldest first */
+  vlib_rcu_callback_t *pending;
+
+  /* Statistics */
+  u64 n_callbacks;
+  u64 n_synchronize;
+  u64 n_grace_periods;
+  f64 grace_period_total;
+  f64 grace_period_max;
+} vlib_rcu_main_t;
+
+extern vlib_rcu_main_t vlib_rcu_main;
+
+/*
+ * Called by the workers when they hold no reference to shared state.
+ * Only writes the shared cache line when the epoch has moved.
+ */
+always_inline void
+vlib_rcu_quiescent (u32 thread_index)
+{
+  vlib_rcu_main_t *rm = &vlib_rcu_main;
+  vlib_rcu_thread_t *t = rm->threads + thread_index;
+  u64 epoch = rm->epoch;
+
+  if (PREDICT_FALSE (t->epoch != epoch))
+    t->epoch = epoch;
+}
+
+/*
+ * A worker going to sleep holds no reference until it calls
+ * vlib_rcu_online, so grace periods need not wait for it meanwhile.
+ */
+always_inline void
+vlib_rcu_offline (u32 thread_index)
+{
+  vlib_rcu_main_t *rm = &vlib_rcu_main;
+
+  rm->threads[thread_index].epoch = ~0ULL;
+}
+
+always_inline void
+vlib_rcu_online (u32 thread_index)
+{
+  vlib_rcu_main_t *rm = &vlib_rcu_main;
+
+  rm->threads[thread_index].epoch = rm->epoch;
+  /* Either the main thread sees us online, or we see its updates */
+  CLIB_MEMORY_BARRIER ();
+}
+
+/* Call fn (arg) on the main thread after a grace period */
+void vlib_rcu_call (struct vlib_main_t *vm, vlib_rcu_callback_fn_t * fn,
+		    void *arg);
+
+/* vec_free () a vector after a grace period */
+void vlib_rcu_vec_free (struct vlib_main_t *vm, void *v);
+
+/* Wait, without stopping them, until all the workers pass a quiescent point */
+void vlib_rcu_synchronize (struct vlib_main_t *vm);
+
+/* Wait for the grace period of all the queued callbacks, then run them */
+void vlib_rcu_barrier (struct vlib_main_t *vm);
+
+#endif /* included_vlib_rcu_h */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -26,6 +26,10 @@ DECLARE_CJ_GLOBAL_LOG;
 
 #define FRAME_QUEUE_NELTS 32
 
+/* Default partial frame coalescing: packets, seconds */
+#define FRAME_QUEUE_COALESCE_THRESHOLD (VLIB_FRAME_SIZE / 4)
+#define FRAME_QUEUE_COALESCE_DELAY (20e-6)
+
 u32
 vl (void *p)
 {
@@ -1435,7 +1439,7 @@ vlib_worker_thread_barrier_sync_int (vlib_main_t * vm)
   f64 t_entry;
   f64 t_open;
   f64 t_closed;
-  u32 count;
+  u32 count, i;
 
   if (vec_len (vlib_mains) < 2)
     return;
@@ -1469,6 +1473,8 @@ vlib_worker_thread_barrier_sync_int (vlib_main_t * vm)
   deadline = now + BARRIER_SYNC_TIMEOUT;
 
   *vlib_worker_threads->wait_at_barrier = 1;
+  for (i = 1; i < vec_len (vlib_mains); i++)
+    vlib_main_wakeup (vlib_mains[i]);
   while (*vlib_worker_threads->workers_at_barrier != count)
     {
       if ((now = vlib_time_now (vm)) > deadline)
@@ -1746,6 +1752,7 @@ vlib_frame_queue_main_init (u32 node_index, u32 frame_queue_nelts)
 {
   vlib_thread_main_t *tm = vlib_get_thread_main ();
   vlib_frame_queue_main_t *fqm;
+  vlib_frame_queue_per_thread_data_t *ptd;
   vlib_frame_queue_t *fq;
   int i;
 
@@ -1764,9 +1771,187 @@ vlib_frame_queue_main_init (u32 node_index, u32 frame_queue_nelts)
       vec_add1 (fqm->vlib_frame_queues, fq);
     }
 
+  vec_validate_aligned (fqm->per_thread_data, tm->n_vlib_mains - 1,
+			CLIB_CACHE_LINE_BYTES);
+  for (i = 0; i < tm->n_vlib_mains; i++)
+    {
+      ptd = vec_elt_at_index (fqm->per_thread_data, i);
+      vec_validate_aligned (ptd->staging, tm->n_vlib_mains - 1,
+			    CLIB_CACHE_LINE_BYTES);
+      vec_validate_aligned (ptd->counters, tm->n_vlib_mains - 1,
+			    CLIB_CACHE_LINE_BYTES);
+    }
+
+  fqm->full_policy = VLIB_FRAME_QUEUE_FULL_SPIN;
+  vlib_frame_queue_set_coalesce (fqm - tm->frame_queue_mains,
+				 FRAME_QUEUE_COALESCE_THRESHOLD,
+				 FRAME_QUEUE_COALESCE_DELAY);
+
   return (fqm - tm->frame_queue_mains);
 }
 
+void
+vlib_frame_queue_set_coalesce (u32 frame_queue_index, u32 threshold,
+			       f64 max_delay)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_main_t *vm = vlib_get_main ();
+  vlib_frame_queue_main_t *fqm;
+
+  fqm = vec_elt_at_index (tm->frame_queue_mains, frame_queue_index);
+  fqm->coalesce_threshold = clib_min (threshold, VLIB_FRAME_SIZE);
+  fqm->coalesce_ticks = max_delay * vm->clib_time.clocks_per_second;
+}
+
+/*
+ * Copy the packets staged for thread_index into a frame queue element.
+ * Returns the number of packets dropped, which is non-zero only with the
+ * drop policy when the queue is full.
+ */
+static u32
+vlib_frame_queue_ship (vlib_main_t * vm, vlib_frame_queue_main_t * fqm,
+		       vlib_frame_queue_per_thread_data_t * ptd,
+		       u32 thread_index)
+{
+  vlib_frame_queue_t *fq = fqm->vlib_frame_queues[thread_index];
+  vlib_frame_queue_staging_t *st = ptd->staging + thread_index;
+  vlib_frame_queue_pair_counters_t *c = ptd->counters + thread_index;
+  vlib_frame_queue_elt_t *elt;
+  u32 n_vectors = st->n_vectors;
+  u64 tail, occupancy, t0;
+
+  ASSERT (n_vectors);
+  st->n_vectors = 0;
+  ptd->n_staged--;
+
+  occupancy = fq->tail - fq->head_hint;
+  if (PREDICT_FALSE (occupancy + 1 >= fq->nelts))
+    {
+      c->congested++;
+      fq->enqueue_full_events++;
+    }
+
+  if (fqm->full_policy == VLIB_FRAME_QUEUE_FULL_DROP)
+    {
+      /* Only claim a slot which is known to be free */
+      do
+	{
+	  tail = fq->tail;
+	  if (PREDICT_FALSE (tail + 1 >= fq->head_hint + fq->nelts))
+	    {
+	      vlib_buffer_free (vm, st->buffer_index, n_vectors);
+	      c->drops += n_vectors;
+	      return n_vectors;
+	    }
+	}
+      while (!__sync_bool_compare_and_swap (&fq->tail, tail, tail + 1));
+      tail++;
+    }
+  else
+    {
+      tail = __sync_add_and_fetch (&fq->tail, 1);
+      if (PREDICT_FALSE (tail >= fq->head_hint + fq->nelts))
+	{
+	  t0 = clib_cpu_time_now ();
+	  while (tail >= fq->head_hint + fq->nelts)
+	    vlib_worker_thread_barrier_check ();
+	  c->spin_ticks += clib_cpu_time_now () - t0;
+	}
+    }
+
+  elt = fq->elts + (tail & (fq->nelts - 1));
+
+  /* this would be very bad... */
+  while (elt->valid)
+    ;
+
+  clib_memcpy (elt->buffer_index, st->buffer_index,
+	       n_vectors * sizeof (st->buffer_index[0]));
+  elt->msg_type = VLIB_FRAME_QUEUE_ELT_DISPATCH_FRAME;
+  elt->last_n_vectors = elt->n_vectors = n_vectors;
+  vlib_put_frame_queue_elt (elt);
+  vlib_main_wakeup (vlib_mains[thread_index]);
+
+  c->frames++;
+  c->vectors += n_vectors;
+  c->occupancy_sum += occupancy;
+  c->occupancy_max = clib_max (c->occupancy_max, occupancy);
+  return 0;
+}
+
+/*
+ * Ship the partial frames the calling thread holds, all of them when
+ * force is set, else those which are big enough or have waited long
+ * enough. Returns the number of packets dropped.
+ */
+u32
+vlib_frame_queue_flush (vlib_main_t * vm, vlib_frame_queue_main_t * fqm,
+			int force)
+{
+  vlib_frame_queue_per_thread_data_t *ptd;
+  vlib_frame_queue_staging_t *st;
+  u64 now = clib_cpu_time_now ();
+  u32 n_drop = 0, i;
+
+  ptd = vec_elt_at_index (fqm->per_thread_data, vm->thread_index);
+
+  for (i = 0; ptd->n_staged && i < vec_len (ptd->staging); i++)
+    {
+      st = ptd->staging + i;
+      if (st->n_vectors == 0)
+	continue;
+      if (force || st->n_vectors >= fqm->coalesce_threshold
+	  || now - st->first_enqueue_time >= fqm->coalesce_ticks)
+	n_drop += vlib_frame_queue_ship (vm, fqm, ptd, i);
+    }
+
+  return n_drop;
+}
+
+/*
+ * Hand off packets to the threads given by thread_indices. Packets for
+ * the same thread are coalesced into full frames where possible; partial
+ * frames are held back until they fill up or grow stale, see
+ * vlib_frame_queue_flush. Returns the number of packets handed off, the
+ * remainder were dropped on a full queue.
+ */
+u32
+vlib_frame_queue_enqueue_buffers (vlib_main_t * vm, u32 frame_queue_index,
+				  u32 * buffer_indices, u16 * thread_indices,
+				  u32 n_packets)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_frame_queue_main_t *fqm;
+  vlib_frame_queue_per_thread_data_t *ptd;
+  vlib_frame_queue_staging_t *st;
+  u64 now = clib_cpu_time_now ();
+  u32 n_drop = 0, i;
+
+  fqm = vec_elt_at_index (tm->frame_queue_mains, frame_queue_index);
+  ptd = vec_elt_at_index (fqm->per_thread_data, vm->thread_index);
+
+  for (i = 0; i < n_packets; i++)
+    {
+      ASSERT (thread_indices[i] < vec_len (ptd->staging));
+      st = ptd->staging + thread_indices[i];
+
+      if (st->n_vectors == 0)
+	{
+	  st->first_enqueue_time = now;
+	  ptd->n_staged++;
+	}
+
+      st->buffer_index[st->n_vectors++] = buffer_indices[i];
+
+      if (PREDICT_FALSE (st->n_vectors == VLIB_FRAME_SIZE))
+	n_drop += vlib_frame_queue_ship (vm, fqm, ptd, thread_indices[i]);
+    }
+
+  n_drop += vlib_frame_queue_flush (vm, fqm, 0 /* force */ );
+
+  return n_packets - n_drop;
+}
+
 int
 vlib_thread_cb_register (struct vlib_main_t *vm, vlib_thread_callbacks_t * cb)
 {
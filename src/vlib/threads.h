@@ -161,11 +161,66 @@ typedef struct
 }
 vlib_frame_queue_t;
 
+/* What a sender does when the destination frame queue is full */
+#define foreach_vlib_frame_queue_full_policy	\
+  _(SPIN, "spin")				\
+  _(DROP, "drop")
+
+typedef enum
+{
+#define _(v, s) VLIB_FRAME_QUEUE_FULL_##v,
+  foreach_vlib_frame_queue_full_policy
+#undef _
+} vlib_frame_queue_full_policy_t;
+
+/* Per sender / receiver pair counters, only written by the sender */
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  u64 frames;			/* frame queue elements shipped */
+  u64 vectors;			/* packets shipped */
+  u64 congested;		/* ships which found the queue full */
+  u64 drops;			/* packets dropped on a full queue */
+  u64 spin_ticks;		/* cpu ticks spent waiting for a slot */
+  u64 occupancy_sum;		/* queue depth seen at each ship */
+  u32 occupancy_max;
+} vlib_frame_queue_pair_counters_t;
+
+/* Partial frame a sender holds back for a destination thread */
+typedef struct
+{
+  u32 n_vectors;
+  u64 first_enqueue_time;
+  u32 buffer_index[VLIB_FRAME_SIZE];
+} vlib_frame_queue_staging_t;
+
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  /* Number of destinations with staged packets */
+  u32 n_staged;
+  vlib_frame_queue_staging_t *staging;
+  vlib_frame_queue_pair_counters_t *counters;
+} vlib_frame_queue_per_thread_data_t;
+
 typedef struct
 {
   u32 node_index;
   vlib_frame_queue_t **vlib_frame_queues;
 
+  /* Sender side state, indexed by the sending thread */
+  vlib_frame_queue_per_thread_data_t *per_thread_data;
+
+  /* Full queue policy */
+  vlib_frame_queue_full_policy_t full_policy;
+
+  /*
+   * Partial frames are shipped once they hold coalesce_threshold
+   * packets, or once the oldest packet has waited coalesce_ticks.
+   */
+  u32 coalesce_threshold;
+  u64 coalesce_ticks;
+
   /* for frame queue tracing */
   frame_queue_trace_t *frame_queue_traces;
   frame_queue_nelt_counter_t *frame_queue_histogram;
@@ -188,6 +243,17 @@ int vlib_frame_queue_enqueue (vlib_main_t * vm, u32 node_runtime_index,
 int
 vlib_frame_queue_dequeue (vlib_main_t * vm, vlib_frame_queue_main_t * fqm);
 
+u32 vlib_frame_queue_enqueue_buffers (vlib_main_t * vm,
+				      u32 frame_queue_index,
+				      u32 * buffer_indices,
+				      u16 * thread_indices, u32 n_packets);
+
+u32 vlib_frame_queue_flush (vlib_main_t * vm, vlib_frame_queue_main_t * fqm,
+			    int force);
+
+void vlib_frame_queue_set_coalesce (u32 frame_queue_index,
+				    u32 threshold, f64 max_delay);
+
 void vlib_worker_thread_node_runtime_update (void);
 
 void vlib_create_worker_threads (vlib_main_t * vm, int n,
@@ -217,6 +283,25 @@ void vlib_worker_thread_barrier_sync_int (vlib_main_t * vm);
 void vlib_worker_thread_barrier_release (vlib_main_t * vm);
 void vlib_worker_thread_node_refork (void);
 
+/*
+ * pool_get_aligned() on a pool the workers read without a lock. The
+ * workers are only stopped when the pool is about to move.
+ */
+#define vlib_pool_get_aligned_mt(P,E,A)					\
+do {									\
+  vlib_main_t *_vm = vlib_get_main ();					\
+  u8 _need_barrier_sync = 0;						\
+									\
+  pool_get_aligned_will_expand (P, _need_barrier_sync, A);		\
+  if (_need_barrier_sync)						\
+    vlib_worker_thread_barrier_sync (_vm);				\
+  pool_get_aligned (P, E, A);						\
+  if (_need_barrier_sync)						\
+    vlib_worker_thread_barrier_release (_vm);				\
+} while (0)
+
+#define vlib_pool_get_mt(P,E) vlib_pool_get_aligned_mt(P,E,0)
+
 static_always_inline uword
 vlib_get_thread_index (void)
 {
@@ -466,6 +551,21 @@ vlib_get_frame_queue_elt (u32 frame_queue_index, u32 index)
   return elt;
 }
 
+/*
+ * Ship the partial frames held back by the calling thread which have
+ * waited long enough. Called from the main and worker loops, so
+ * cheap when nothing is staged.
+ */
+always_inline void
+vlib_frame_queue_flush_stale (vlib_main_t * vm, vlib_frame_queue_main_t * fqm)
+{
+  vlib_frame_queue_per_thread_data_t *ptd;
+
+  ptd = vec_elt_at_index (fqm->per_thread_data, vm->thread_index);
+  if (PREDICT_FALSE (ptd->n_staged != 0))
+    vlib_frame_queue_flush (vm, fqm, 0 /* force */ );
+}
+
 static inline vlib_frame_queue_t *
 is_vlib_frame_queue_congested (u32 frame_queue_index,
 			       u32 index,
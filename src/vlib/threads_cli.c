@@ -574,6 +574,397 @@ VLIB_CLI_COMMAND (cmd_test_frame_queue_threshold,static) = {
 };
 /* *INDENT-ON* */
 
+static u8 *
+format_vlib_frame_queue_full_policy (u8 * s, va_list * args)
+{
+  vlib_frame_queue_full_policy_t policy = va_arg (*args, int);
+
+  switch (policy)
+    {
+#define _(v, str) case VLIB_FRAME_QUEUE_FULL_##v: return format (s, str);
+      foreach_vlib_frame_queue_full_policy
+#undef _
+    }
+  return format (s, "unknown");
+}
+
+static uword
+unformat_vlib_frame_queue_full_policy (unformat_input_t * input,
+				       va_list * args)
+{
+  vlib_frame_queue_full_policy_t *policy =
+    va_arg (*args, vlib_frame_queue_full_policy_t *);
+
+  if (0)
+    ;
+#define _(v, str)						\
+  else if (unformat (input, str))				\
+    *policy = VLIB_FRAME_QUEUE_FULL_##v;
+  foreach_vlib_frame_queue_full_policy
+#undef _
+  else
+    return 0;
+  return 1;
+}
+
+/*
+ * Display the per sender / receiver handoff counters
+ */
+static clib_error_t *
+show_frame_queue_counters (vlib_main_t * vm, unformat_input_t * input,
+			   vlib_cli_command_t * cmd)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_frame_queue_main_t *fqm;
+  vlib_frame_queue_per_thread_data_t *ptd;
+  vlib_frame_queue_pair_counters_t *c;
+  f64 ticks_per_us = vm->clib_time.clocks_per_second * 1e-6;
+  u32 from, to;
+
+  vec_foreach (fqm, tm->frame_queue_mains)
+  {
+    vlib_cli_output (vm, "Worker handoff queue index %u (next node '%U'):",
+		     fqm - tm->frame_queue_mains,
+		     format_vlib_node_name, vm, fqm->node_index);
+    vlib_cli_output (vm, "  full policy %U, coalesce %u packets or %.1f us",
+		     format_vlib_frame_queue_full_policy, fqm->full_policy,
+		     fqm->coalesce_threshold,
+		     (f64) fqm->coalesce_ticks / ticks_per_us);
+    vlib_cli_output (vm, "  %-12s%-12s%12s%12s%10s%10s%10s%12s%8s%8s",
+		     "From", "To", "Frames", "Vectors", "Vec/Frame",
+		     "Congested", "Drops", "Spin us", "Avg Occ", "Max Occ");
+
+    vec_foreach_index (from, fqm->per_thread_data)
+    {
+      ptd = vec_elt_at_index (fqm->per_thread_data, from);
+      vec_foreach_index (to, ptd->counters)
+      {
+	c = vec_elt_at_index (ptd->counters, to);
+	if (c->frames == 0 && c->drops == 0)
+	  continue;
+	vlib_cli_output (vm, "  %-12v%-12v%12llu%12llu%10.2f%10llu%10llu"
+			 "%12.1f%8.2f%8u",
+			 vlib_worker_threads[from].name,
+			 vlib_worker_threads[to].name,
+			 c->frames, c->vectors,
+			 c->frames ? (f64) c->vectors / c->frames : 0.0,
+			 c->congested, c->drops,
+			 (f64) c->spin_ticks / ticks_per_us,
+			 c->frames ? (f64) c->occupancy_sum / c->frames : 0.0,
+			 c->occupancy_max);
+      }
+    }
+  }
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (cmd_show_frame_queue_counters,static) = {
+    .path = "show frame-queue counters",
+    .short_help = "show frame-queue counters",
+    .function = show_frame_queue_counters,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+clear_frame_queue_counters (vlib_main_t * vm, unformat_input_t * input,
+			    vlib_cli_command_t * cmd)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_frame_queue_main_t *fqm;
+  vlib_frame_queue_per_thread_data_t *ptd;
+
+  vec_foreach (fqm, tm->frame_queue_mains)
+  {
+    vec_foreach (ptd, fqm->per_thread_data)
+      memset (ptd->counters, 0, vec_bytes (ptd->counters));
+  }
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (cmd_clear_frame_queue_counters,static) = {
+    .path = "clear frame-queue counters",
+    .short_help = "clear frame-queue counters",
+    .function = clear_frame_queue_counters,
+};
+/* *INDENT-ON* */
+
+/*
+ * Set the full queue policy and the partial frame coalescing
+ */
+static clib_error_t *
+set_frame_queue (vlib_main_t * vm, unformat_input_t * input,
+		 vlib_cli_command_t * cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_frame_queue_main_t *fqm;
+  vlib_frame_queue_full_policy_t policy = ~0;
+  clib_error_t *error = NULL;
+  u32 index = ~(u32) 0;
+  u32 threshold = ~(u32) 0;
+  f64 delay = -1.0;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return 0;
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "index %u", &index))
+	;
+      else if (unformat (line_input, "policy %U",
+			 unformat_vlib_frame_queue_full_policy, &policy))
+	;
+      else if (unformat (line_input, "coalesce %u", &threshold))
+	;
+      else if (unformat (line_input, "delay-us %f", &delay))
+	;
+      else
+	{
+	  error = clib_error_return (0, "parse error: '%U'",
+				     format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (index > vec_len (tm->frame_queue_mains) - 1)
+    {
+      error = clib_error_return (0,
+				 "expecting valid worker handoff queue index");
+      goto done;
+    }
+
+  fqm = vec_elt_at_index (tm->frame_queue_mains, index);
+
+  if (policy != ~0)
+    fqm->full_policy = policy;
+
+  if (threshold != ~(u32) 0 || delay >= 0.0)
+    {
+      if (threshold == ~(u32) 0)
+	threshold = fqm->coalesce_threshold;
+      if (delay < 0.0)
+	delay = (f64) fqm->coalesce_ticks / vm->clib_time.clocks_per_second;
+      else
+	delay *= 1e-6;
+      vlib_frame_queue_set_coalesce (index, threshold, delay);
+    }
+
+done:
+  unformat_free (line_input);
+
+  return error;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (cmd_set_frame_queue,static) = {
+    .path = "set frame-queue",
+    .short_help = "set frame-queue index <n> [policy spin|drop] "
+                  "[coalesce <packets>] [delay-us <us>]",
+    .function = set_frame_queue,
+};
+/* *INDENT-ON* */
+
+/*
+ * Handoff benchmark: the main thread hands off timestamped buffers to
+ * the workers, the bench node on the workers measures the latency and
+ * frees them.
+ */
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  volatile u64 n_rx;
+  u64 latency_sum;
+  u64 latency_max;
+  u64 last_rx_time;
+} frame_queue_bench_thread_t;
+
+typedef struct
+{
+  u32 frame_queue_index;
+  frame_queue_bench_thread_t *per_thread;
+} frame_queue_bench_main_t;
+
+static frame_queue_bench_main_t frame_queue_bench_main = {
+  .frame_queue_index = ~0,
+};
+
+static uword
+frame_queue_bench_node_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
+			   vlib_frame_t * frame)
+{
+  frame_queue_bench_main_t *fbm = &frame_queue_bench_main;
+  frame_queue_bench_thread_t *pt;
+  u32 *from = vlib_frame_vector_args (frame);
+  u64 now = clib_cpu_time_now ();
+  u64 latency;
+  u32 i;
+
+  pt = vec_elt_at_index (fbm->per_thread, vm->thread_index);
+
+  for (i = 0; i < frame->n_vectors; i++)
+    {
+      vlib_buffer_t *b = vlib_get_buffer (vm, from[i]);
+      latency = now - clib_mem_unaligned (b->opaque2, u64);
+      pt->latency_sum += latency;
+      pt->latency_max = clib_max (pt->latency_max, latency);
+    }
+
+  vlib_buffer_free (vm, from, frame->n_vectors);
+  pt->last_rx_time = now;
+  CLIB_MEMORY_BARRIER ();
+  pt->n_rx += frame->n_vectors;
+
+  return frame->n_vectors;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (frame_queue_bench_node,static) = {
+  .function = frame_queue_bench_node_fn,
+  .name = "frame-queue-bench",
+  .vector_size = sizeof (u32),
+  .type = VLIB_NODE_TYPE_INTERNAL,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+test_frame_queue_bench (vlib_main_t * vm, unformat_input_t * input,
+			vlib_cli_command_t * cmd)
+{
+  frame_queue_bench_main_t *fbm = &frame_queue_bench_main;
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  frame_queue_bench_thread_t *pt;
+  u32 buffers[VLIB_FRAME_SIZE];
+  u16 thread_indices[VLIB_FRAME_SIZE];
+  u32 n_packets = 1 << 20, batch = VLIB_FRAME_SIZE, n_workers;
+  u64 n_sent = 0, n_enq = 0, n_rx, latency_sum, latency_max, t0, t1;
+  u32 i, n, n_alloc, next_worker = 0;
+  f64 timeout, dt;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "packets %u", &n_packets))
+	;
+      else if (unformat (input, "batch %u", &batch))
+	;
+      else
+	return clib_error_return (0, "parse error: '%U'",
+				  format_unformat_error, input);
+    }
+
+  n_workers = tm->n_vlib_mains - 1;
+  if (n_workers == 0)
+    return clib_error_return (0, "no worker threads");
+  if (batch == 0 || batch > VLIB_FRAME_SIZE)
+    return clib_error_return (0, "batch must be 1 to %d", VLIB_FRAME_SIZE);
+
+  /* This command is mp-safe, the workers walk the frame queue mains */
+  if (fbm->frame_queue_index == ~0)
+    {
+      vlib_worker_thread_barrier_sync (vm);
+      fbm->frame_queue_index =
+	vlib_frame_queue_main_init (frame_queue_bench_node.index, 0);
+      vec_validate_aligned (fbm->per_thread, tm->n_vlib_mains - 1,
+			    CLIB_CACHE_LINE_BYTES);
+      vlib_worker_thread_barrier_release (vm);
+    }
+
+  vec_foreach (pt, fbm->per_thread) memset (pt, 0, sizeof (*pt));
+  CLIB_MEMORY_BARRIER ();
+
+  t0 = clib_cpu_time_now ();
+  timeout = vlib_time_now (vm) + 10.0;
+
+  while (n_sent < n_packets)
+    {
+      n = clib_min (batch, n_packets - n_sent);
+      n_alloc = vlib_buffer_alloc (vm, buffers, n);
+      if (n_alloc == 0)
+	{
+	  /* Wait for the workers to give buffers back */
+	  if (vlib_time_now (vm) > timeout)
+	    break;
+	  vlib_process_suspend (vm, 1e-4);
+	  continue;
+	}
+
+      for (i = 0; i < n_alloc; i++)
+	{
+	  vlib_buffer_t *b = vlib_get_buffer (vm, buffers[i]);
+	  clib_mem_unaligned (b->opaque2, u64) = clib_cpu_time_now ();
+	  /* spread packets over the workers to exercise coalescing */
+	  thread_indices[i] = 1 + next_worker;
+	  if (++next_worker == n_workers)
+	    next_worker = 0;
+	}
+
+      n_enq += vlib_frame_queue_enqueue_buffers (vm, fbm->frame_queue_index,
+						 buffers, thread_indices,
+						 n_alloc);
+      n_sent += n_alloc;
+    }
+
+  n_enq -= vlib_frame_queue_flush
+    (vm, vec_elt_at_index (tm->frame_queue_mains, fbm->frame_queue_index),
+     1 /* force */ );
+
+  /* Wait for the workers to drain the queues */
+  timeout = vlib_time_now (vm) + 1.0;
+  do
+    {
+      n_rx = 0;
+      vec_foreach (pt, fbm->per_thread) n_rx += pt->n_rx;
+      if (n_rx >= n_enq || vlib_time_now (vm) > timeout)
+	break;
+      vlib_process_suspend (vm, 1e-3);
+    }
+  while (1);
+
+  CLIB_MEMORY_BARRIER ();
+  latency_sum = latency_max = 0;
+  t1 = t0;
+  vec_foreach (pt, fbm->per_thread)
+  {
+    latency_sum += pt->latency_sum;
+    latency_max = clib_max (latency_max, pt->latency_max);
+    t1 = clib_max (t1, pt->last_rx_time);
+  }
+
+  dt = (f64) (t1 - t0) / vm->clib_time.clocks_per_second;
+  vlib_cli_output (vm, "%llu packets sent to %u workers, %llu received, "
+		   "%llu dropped", n_sent, n_workers, n_rx, n_sent - n_enq);
+  if (n_sent < n_packets)
+    vlib_cli_output (vm, "out of buffers after %llu packets", n_sent);
+  if (dt > 0 && n_rx)
+    vlib_cli_output (vm, "%.3f Mpps, latency avg %.2f us max %.2f us",
+		     (f64) n_rx / dt * 1e-6,
+		     (f64) latency_sum / n_rx /
+		     vm->clib_time.clocks_per_second * 1e6,
+		     (f64) latency_max /
+		     vm->clib_time.clocks_per_second * 1e6);
+  return 0;
+}
+
+/*?
+ * Measure worker handoff throughput and latency: the main thread hands
+ * timestamped buffers off to the workers round-robin, in batches of
+ * the given size, through a dedicated frame queue. The frame queue's
+ * policy and coalescing can be changed with 'set frame-queue', and its
+ * counters viewed with 'show frame-queue counters'.
+ *
+ * @cliexpar
+ * @cliexcmd{test frame-queue bench packets 1000000 batch 32}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (cmd_test_frame_queue_bench,static) = {
+    .path = "test frame-queue bench",
+    .short_help = "test frame-queue bench [packets <n>] [batch <n>]",
+    .function = test_frame_queue_bench,
+    .is_mp_safe = 1,
+};
+/* *INDENT-ON* */
+
 
 /*
  * fd.io coding-style-patch-verification: ON
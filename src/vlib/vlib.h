@@ -65,6 +65,7 @@ struct vlib_main_t;
 
 /* Inline/extern function declarations. */
 #include <vlib/threads.h>
+#include <vlib/rcu.h>
 #include <vlib/physmem_funcs.h>
 #include <vlib/buffer_funcs.h>
 #include <vlib/cli_funcs.h>
@@ -58,7 +58,8 @@
   _(13, IS_NATED, "nated")				\
   _(14, L2_HDR_OFFSET_VALID, 0)				\
   _(15, L3_HDR_OFFSET_VALID, 0)				\
-  _(16, L4_HDR_OFFSET_VALID, 0)
+  _(16, L4_HDR_OFFSET_VALID, 0)			\
+  _(17, GSO, "gso")
 
 #define VNET_BUFFER_FLAGS_VLAN_BITS \
   (VNET_BUFFER_F_VLAN_1_DEEP | VNET_BUFFER_F_VLAN_2_DEEP)
@@ -339,8 +340,15 @@ typedef struct
       u16 *trajectory_trace;
     };
 #endif
-    u32 unused[12];
+    u32 unused[10];
   };
+
+  /* Generic segmentation offload, valid if VNET_BUFFER_F_GSO is set */
+  struct
+  {
+    u16 size;			/**< l4 payload bytes per segment */
+    u16 l4_hdr_sz;		/**< l4 header, incl. options, bytes */
+  } gso;
 } vnet_buffer_opaque2_t;
 
 #define vnet_buffer2(b) ((vnet_buffer_opaque2_t *) (b)->opaque2)
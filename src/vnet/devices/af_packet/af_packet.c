@@ -19,6 +19,7 @@
 
 #include <linux/if_ether.h>
 #include <linux/if_packet.h>
+#include <linux/filter.h>
 #include <dirent.h>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -44,13 +45,14 @@ af_packet_main_t af_packet_main;
 #define AF_PACKET_TX_BLOCK_SIZE	 	(AF_PACKET_TX_FRAME_SIZE * \
 					 AF_PACKET_TX_FRAMES_PER_BLOCK)
 
-#define AF_PACKET_RX_FRAMES_PER_BLOCK	1024
-#define AF_PACKET_RX_FRAME_SIZE	 	(2048 * 5)
-#define AF_PACKET_RX_BLOCK_NR		1
+/* rx blocks are retired to user space when full or after the timeout */
+#define AF_PACKET_RX_BLOCK_SIZE		(1 << 18)
+#define AF_PACKET_RX_BLOCK_NR		40
+#define AF_PACKET_RX_FRAME_SIZE		2048
 #define AF_PACKET_RX_FRAME_NR		(AF_PACKET_RX_BLOCK_NR * \
-					 AF_PACKET_RX_FRAMES_PER_BLOCK)
-#define AF_PACKET_RX_BLOCK_SIZE		(AF_PACKET_RX_FRAME_SIZE * \
-					 AF_PACKET_RX_FRAMES_PER_BLOCK)
+					 (AF_PACKET_RX_BLOCK_SIZE / \
+					  AF_PACKET_RX_FRAME_SIZE))
+#define AF_PACKET_RX_BLOCK_TIMEOUT_MS	1
 
 #if AF_PACKET_DEBUG_SOCKET == 1
 #define DBG_SOCK(args...) clib_warning(args);
@@ -62,6 +64,7 @@ af_packet_main_t af_packet_main;
 unsigned int if_nametoindex (const char *ifname);
 
 typedef struct tpacket_req tpacket_req_t;
+typedef struct tpacket_req3 tpacket_req3_t;
 
 static u32
 af_packet_eth_flag_change (vnet_main_t * vnm, vnet_hw_interface_t * hi,
@@ -95,14 +98,12 @@ af_packet_fd_read_ready (clib_file_t * uf)
 {
   af_packet_main_t *apm = &af_packet_main;
   vnet_main_t *vnm = vnet_get_main ();
-  u32 idx = uf->private_data;
-  af_packet_if_t *apif = pool_elt_at_index (apm->interfaces, idx);
-
-  apm->pending_input_bitmap =
-    clib_bitmap_set (apm->pending_input_bitmap, idx, 1);
+  u16 qid = uf->private_data & 0xFFFF;
+  af_packet_if_t *apif =
+    pool_elt_at_index (apm->interfaces, uf->private_data >> 16);
 
   /* Schedule the rx node */
-  vnet_device_input_set_interrupt_pending (vnm, apif->hw_if_index, 0);
+  vnet_device_input_set_interrupt_pending (vnm, apif->hw_if_index, qid);
 
   return 0;
 }
@@ -126,76 +127,161 @@ is_bridge (const u8 * host_if_name)
   return -1;
 }
 
+/*
+ * The rx sockets must not see what vpp sends through the tx socket, and the
+ * tx socket must not queue anything it receives.
+ */
+static struct sock_filter af_packet_rx_filter[] = {
+  BPF_STMT (BPF_LD | BPF_B | BPF_ABS, SKF_AD_OFF + SKF_AD_PKTTYPE),
+  BPF_JUMP (BPF_JMP | BPF_JEQ | BPF_K, PACKET_OUTGOING, 0, 1),
+  BPF_STMT (BPF_RET | BPF_K, 0),
+  BPF_STMT (BPF_RET | BPF_K, ~0),
+};
+
+static struct sock_filter af_packet_tx_filter[] = {
+  BPF_STMT (BPF_RET | BPF_K, 0),
+};
+
 static int
-create_packet_v2_sock (int host_if_index, tpacket_req_t * rx_req,
-		       tpacket_req_t * tx_req, int *fd, u8 ** ring)
+af_packet_sock_open (int *fd, int ver, struct sock_filter *filter,
+		     u16 filter_len)
 {
-  int ret, err;
-  struct sockaddr_ll sll;
-  int ver = TPACKET_V2;
-  socklen_t req_sz = sizeof (struct tpacket_req);
-  u32 ring_sz = rx_req->tp_block_size * rx_req->tp_block_nr +
-    tx_req->tp_block_size * tx_req->tp_block_nr;
+  struct sock_fprog prog = {.len = filter_len,.filter = filter };
 
   if ((*fd = socket (AF_PACKET, SOCK_RAW, htons (ETH_P_ALL))) < 0)
     {
       DBG_SOCK ("Failed to create socket");
-      ret = VNET_API_ERROR_SYSCALL_ERROR_1;
-      goto error;
+      return VNET_API_ERROR_SYSCALL_ERROR_1;
     }
 
-  if ((err =
-       setsockopt (*fd, SOL_PACKET, PACKET_VERSION, &ver, sizeof (ver))) < 0)
+  if (setsockopt (*fd, SOL_SOCKET, SO_ATTACH_FILTER, &prog,
+		  sizeof (prog)) < 0)
     {
-      DBG_SOCK ("Failed to set rx packet interface version");
-      ret = VNET_API_ERROR_SYSCALL_ERROR_1;
+      DBG_SOCK ("Failed to attach socket filter");
+      return VNET_API_ERROR_SYSCALL_ERROR_1;
+    }
+
+  if (setsockopt (*fd, SOL_PACKET, PACKET_VERSION, &ver, sizeof (ver)) < 0)
+    {
+      DBG_SOCK ("Failed to set packet interface version");
+      return VNET_API_ERROR_SYSCALL_ERROR_1;
+    }
+
+  return 0;
+}
+
+static int
+af_packet_sock_bind (int fd, int host_if_index)
+{
+  struct sockaddr_ll sll;
+  int err;
+
+  memset (&sll, 0, sizeof (sll));
+  sll.sll_family = PF_PACKET;
+  sll.sll_protocol = htons (ETH_P_ALL);
+  sll.sll_ifindex = host_if_index;
+
+  if ((err = bind (fd, (struct sockaddr *) &sll, sizeof (sll))) < 0)
+    {
+      DBG_SOCK ("Failed to bind packet socket (error %d)", err);
+      return VNET_API_ERROR_SYSCALL_ERROR_1;
+    }
+
+  return 0;
+}
+
+/*
+ * TPACKET_V3 rx socket: the kernel fills whole blocks of frames and hands
+ * them over at once. All the sockets of an interface join the same fanout
+ * group, which spreads flows among them.
+ */
+static int
+create_packet_v3_rx_sock (int host_if_index, tpacket_req3_t * rx_req,
+			  u16 fanout_id, int *fd, u8 ** ring)
+{
+  int ret, fanout;
+  u32 ring_sz = rx_req->tp_block_size * rx_req->tp_block_nr;
+
+  if ((ret = af_packet_sock_open (fd, TPACKET_V3, af_packet_rx_filter,
+				  ARRAY_LEN (af_packet_rx_filter))))
+    goto error;
+
+  ret = VNET_API_ERROR_SYSCALL_ERROR_1;
+
+  if (setsockopt (*fd, SOL_PACKET, PACKET_RX_RING, rx_req,
+		  sizeof (*rx_req)) < 0)
+    {
+      DBG_SOCK ("Failed to set packet rx ring options");
       goto error;
     }
 
-  int opt = 1;
-  if ((err =
-       setsockopt (*fd, SOL_PACKET, PACKET_LOSS, &opt, sizeof (opt))) < 0)
+  *ring = mmap (NULL, ring_sz, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_LOCKED, *fd, 0);
+  if (*ring == MAP_FAILED)
     {
-      DBG_SOCK ("Failed to set packet tx ring error handling option");
-      ret = VNET_API_ERROR_SYSCALL_ERROR_1;
+      DBG_SOCK ("mmap failure");
       goto error;
     }
 
-  if ((err =
-       setsockopt (*fd, SOL_PACKET, PACKET_RX_RING, rx_req, req_sz)) < 0)
+  if ((ret = af_packet_sock_bind (*fd, host_if_index)))
+    goto unmap;
+
+  fanout = fanout_id | (PACKET_FANOUT_HASH << 16);
+  if (setsockopt (*fd, SOL_PACKET, PACKET_FANOUT, &fanout,
+		  sizeof (fanout)) < 0)
     {
-      DBG_SOCK ("Failed to set packet rx ring options");
+      DBG_SOCK ("Failed to join fanout group %u", fanout_id);
       ret = VNET_API_ERROR_SYSCALL_ERROR_1;
+      goto unmap;
+    }
+
+  return 0;
+unmap:
+  munmap (*ring, ring_sz);
+error:
+  if (*fd >= 0)
+    close (*fd);
+  *fd = -1;
+  return ret;
+}
+
+static int
+create_packet_v2_tx_sock (int host_if_index, tpacket_req_t * tx_req,
+			  int *fd, u8 ** ring)
+{
+  int ret, opt = 1;
+  u32 ring_sz = tx_req->tp_block_size * tx_req->tp_block_nr;
+
+  if ((ret = af_packet_sock_open (fd, TPACKET_V2, af_packet_tx_filter,
+				  ARRAY_LEN (af_packet_tx_filter))))
+    goto error;
+
+  ret = VNET_API_ERROR_SYSCALL_ERROR_1;
+
+  if (setsockopt (*fd, SOL_PACKET, PACKET_LOSS, &opt, sizeof (opt)) < 0)
+    {
+      DBG_SOCK ("Failed to set packet tx ring error handling option");
       goto error;
     }
 
-  if ((err =
-       setsockopt (*fd, SOL_PACKET, PACKET_TX_RING, tx_req, req_sz)) < 0)
+  if (setsockopt (*fd, SOL_PACKET, PACKET_TX_RING, tx_req,
+		  sizeof (*tx_req)) < 0)
     {
-      DBG_SOCK ("Failed to set packet rx ring options");
-      ret = VNET_API_ERROR_SYSCALL_ERROR_1;
+      DBG_SOCK ("Failed to set packet tx ring options");
       goto error;
     }
 
-  *ring =
-    mmap (NULL, ring_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED, *fd,
-	  0);
+  *ring = mmap (NULL, ring_sz, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_LOCKED, *fd, 0);
   if (*ring == MAP_FAILED)
     {
       DBG_SOCK ("mmap failure");
-      ret = VNET_API_ERROR_SYSCALL_ERROR_1;
       goto error;
     }
 
-  memset (&sll, 0, sizeof (sll));
-  sll.sll_family = PF_PACKET;
-  sll.sll_protocol = htons (ETH_P_ALL);
-  sll.sll_ifindex = host_if_index;
-
-  if ((err = bind (*fd, (struct sockaddr *) &sll, sizeof (sll))) < 0)
+  if ((ret = af_packet_sock_bind (*fd, host_if_index)))
     {
-      DBG_SOCK ("Failed to bind rx packet socket (error %d)", err);
-      ret = VNET_API_ERROR_SYSCALL_ERROR_1;
+      munmap (*ring, ring_sz);
       goto error;
     }
 
@@ -207,13 +293,79 @@ error:
   return ret;
 }
 
+static void
+af_packet_free_rx_queues (af_packet_if_t * apif)
+{
+  af_packet_queue_t *q;
+
+  vec_foreach (q, apif->rx_queues)
+  {
+    if (q->clib_file_index != ~0)
+      clib_file_del (&file_main, file_main.file_pool + q->clib_file_index);
+    else if (q->fd >= 0)
+      close (q->fd);
+    if (q->rx_ring && munmap (q->rx_ring, q->rx_req->tp_block_size *
+			      q->rx_req->tp_block_nr))
+      clib_warning ("Host interface %s could not free rx ring",
+		    apif->host_if_name);
+    vec_free (q->rx_req);
+  }
+  vec_free (apif->rx_queues);
+}
+
+static int
+af_packet_create_rx_queues (af_packet_if_t * apif, int host_if_index,
+			    u32 num_rx_queues)
+{
+  af_packet_main_t *apm = &af_packet_main;
+  clib_file_t template = { 0 };
+  af_packet_queue_t *q;
+  tpacket_req3_t *rx_req;
+  int i, ret;
+
+  vec_validate_aligned (apif->rx_queues, num_rx_queues - 1,
+			CLIB_CACHE_LINE_BYTES);
+  vec_foreach (q, apif->rx_queues)
+  {
+    q->fd = -1;
+    q->clib_file_index = ~0;
+  }
+
+  vec_foreach_index (i, apif->rx_queues)
+  {
+    q = vec_elt_at_index (apif->rx_queues, i);
+    vec_validate (q->rx_req, 0);
+    rx_req = q->rx_req;
+    rx_req->tp_block_size = AF_PACKET_RX_BLOCK_SIZE;
+    rx_req->tp_frame_size = AF_PACKET_RX_FRAME_SIZE;
+    rx_req->tp_block_nr = AF_PACKET_RX_BLOCK_NR;
+    rx_req->tp_frame_nr = AF_PACKET_RX_FRAME_NR;
+    rx_req->tp_retire_blk_tov = AF_PACKET_RX_BLOCK_TIMEOUT_MS;
+
+    ret = create_packet_v3_rx_sock (host_if_index, rx_req,
+				    apif->fanout_id, &q->fd, &q->rx_ring);
+    if (ret)
+      {
+	q->rx_ring = 0;
+	return ret;
+      }
+
+    template.read_function = af_packet_fd_read_ready;
+    template.file_descriptor = q->fd;
+    template.private_data = ((apif - apm->interfaces) << 16) | i;
+    template.flags = UNIX_FILE_EVENT_EDGE_TRIGGERED;
+    q->clib_file_index = clib_file_add (&file_main, &template);
+  }
+
+  return 0;
+}
+
 int
 af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
-		     u32 * sw_if_index)
+		     u32 num_rx_queues, u32 * sw_if_index)
 {
   af_packet_main_t *apm = &af_packet_main;
   int ret, fd = -1;
-  struct tpacket_req *rx_req = 0;
   struct tpacket_req *tx_req = 0;
   u8 *ring = 0;
   af_packet_if_t *apif = 0;
@@ -227,6 +379,7 @@ af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
   uword if_index;
   u8 *host_if_name_dup = vec_dup (host_if_name);
   int host_if_index = -1;
+  u32 i;
 
   p = mhash_get (&apm->if_index_by_host_if_name, host_if_name);
   if (p)
@@ -234,11 +387,8 @@ af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
       return VNET_API_ERROR_SUBIF_ALREADY_EXISTS;
     }
 
-  vec_validate (rx_req, 0);
-  rx_req->tp_block_size = AF_PACKET_RX_BLOCK_SIZE;
-  rx_req->tp_frame_size = AF_PACKET_RX_FRAME_SIZE;
-  rx_req->tp_block_nr = AF_PACKET_RX_BLOCK_NR;
-  rx_req->tp_frame_nr = AF_PACKET_RX_FRAME_NR;
+  if (num_rx_queues == 0 || num_rx_queues > AF_PACKET_MAX_RX_QUEUES)
+    return VNET_API_ERROR_INVALID_VALUE;
 
   vec_validate (tx_req, 0);
   tx_req->tp_block_size = AF_PACKET_TX_BLOCK_SIZE;
@@ -254,43 +404,44 @@ af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
       return VNET_API_ERROR_INVALID_INTERFACE;
     }
 
-  ret = create_packet_v2_sock (host_if_index, rx_req, tx_req, &fd, &ring);
+  ret = create_packet_v2_tx_sock (host_if_index, tx_req, &fd, &ring);
 
   if (ret != 0)
     goto error;
 
+  pool_get (apm->interfaces, apif);
+  memset (apif, 0, sizeof (*apif));
+  if_index = apif - apm->interfaces;
+
+  /* fanout group ids are shared by all processes in the namespace */
+  apif->fanout_id = (getpid () << 8) ^ if_index;
+  ret = af_packet_create_rx_queues (apif, host_if_index, num_rx_queues);
+  if (ret != 0)
+    {
+      af_packet_free_rx_queues (apif);
+      pool_put (apm->interfaces, apif);
+      munmap (ring, tx_req->tp_block_size * tx_req->tp_block_nr);
+      close (fd);
+      goto error;
+    }
+
   ret = is_bridge (host_if_name);
 
   if (ret == 0)			/* is a bridge, ignore state */
     host_if_index = -1;
 
   /* So far everything looks good, let's create interface */
-  pool_get (apm->interfaces, apif);
-  if_index = apif - apm->interfaces;
-
   apif->host_if_index = host_if_index;
   apif->fd = fd;
-  apif->rx_ring = ring;
-  apif->tx_ring = ring + rx_req->tp_block_size * rx_req->tp_block_nr;
-  apif->rx_req = rx_req;
+  apif->tx_ring = ring;
   apif->tx_req = tx_req;
   apif->host_if_name = host_if_name_dup;
   apif->per_interface_next_index = ~0;
   apif->next_tx_frame = 0;
-  apif->next_rx_frame = 0;
 
   if (tm->n_vlib_mains > 1)
     clib_spinlock_init (&apif->lockp);
 
-  {
-    clib_file_t template = { 0 };
-    template.read_function = af_packet_fd_read_ready;
-    template.file_descriptor = fd;
-    template.private_data = if_index;
-    template.flags = UNIX_FILE_EVENT_EDGE_TRIGGERED;
-    apif->clib_file_index = clib_file_add (&file_main, &template);
-  }
-
   /*use configured or generate random MAC address */
   if (hw_addr_set)
     clib_memcpy (hw_addr, hw_addr_set, 6);
@@ -312,6 +463,9 @@ af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
 
   if (error)
     {
+      af_packet_free_rx_queues (apif);
+      munmap (ring, tx_req->tp_block_size * tx_req->tp_block_nr);
+      close (fd);
       memset (apif, 0, sizeof (*apif));
       pool_put (apm->interfaces, apif);
       clib_error_report (error);
@@ -325,15 +479,20 @@ af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
   vnet_hw_interface_set_input_node (vnm, apif->hw_if_index,
 				    af_packet_input_node.index);
 
-  vnet_hw_interface_assign_rx_thread (vnm, apif->hw_if_index, 0,	/* queue */
-				      ~0 /* any cpu */ );
+  for (i = 0; i < num_rx_queues; i++)
+    vnet_hw_interface_assign_rx_thread (vnm, apif->hw_if_index, i,
+					~0 /* any cpu */ );
 
   hw->flags |= VNET_HW_INTERFACE_FLAG_SUPPORTS_INT_MODE;
+  /* Never poll a kernel socket unless asked to */
+  if (hw->default_rx_mode == VNET_HW_INTERFACE_RX_MODE_POLLING)
+    hw->default_rx_mode = VNET_HW_INTERFACE_RX_MODE_INTERRUPT;
   vnet_hw_interface_set_flags (vnm, apif->hw_if_index,
 			       VNET_HW_INTERFACE_FLAG_LINK_UP);
 
-  vnet_hw_interface_set_rx_mode (vnm, apif->hw_if_index, 0,
-				 VNET_HW_INTERFACE_RX_MODE_INTERRUPT);
+  for (i = 0; i < num_rx_queues; i++)
+    vnet_hw_interface_set_rx_mode (vnm, apif->hw_if_index, i,
+				   VNET_HW_INTERFACE_RX_MODE_DEFAULT);
 
   mhash_set_mem (&apm->if_index_by_host_if_name, host_if_name_dup, &if_index,
 		 0);
@@ -344,7 +503,6 @@ af_packet_create_if (vlib_main_t * vm, u8 * host_if_name, u8 * hw_addr_set,
 
 error:
   vec_free (host_if_name_dup);
-  vec_free (rx_req);
   vec_free (tx_req);
   return ret;
 }
@@ -357,7 +515,7 @@ af_packet_delete_if (vlib_main_t * vm, u8 * host_if_name)
   af_packet_if_t *apif;
   uword *p;
   uword if_index;
-  u32 ring_sz;
+  u32 ring_sz, i;
 
   p = mhash_get (&apm->if_index_by_host_if_name, host_if_name);
   if (p == NULL)
@@ -370,28 +528,20 @@ af_packet_delete_if (vlib_main_t * vm, u8 * host_if_name)
 
   /* bring down the interface */
   vnet_hw_interface_set_flags (vnm, apif->hw_if_index, 0);
-  vnet_hw_interface_unassign_rx_thread (vnm, apif->hw_if_index, 0);
+  vec_foreach_index (i, apif->rx_queues)
+    vnet_hw_interface_unassign_rx_thread (vnm, apif->hw_if_index, i);
 
   /* clean up */
-  if (apif->clib_file_index != ~0)
-    {
-      clib_file_del (&file_main, file_main.file_pool + apif->clib_file_index);
-      apif->clib_file_index = ~0;
-    }
-  else
-    close (apif->fd);
+  af_packet_free_rx_queues (apif);
 
-  ring_sz = apif->rx_req->tp_block_size * apif->rx_req->tp_block_nr +
-    apif->tx_req->tp_block_size * apif->tx_req->tp_block_nr;
-  if (munmap (apif->rx_ring, ring_sz))
-    clib_warning ("Host interface %s could not free rx/tx ring",
+  close (apif->fd);
+  ring_sz = apif->tx_req->tp_block_size * apif->tx_req->tp_block_nr;
+  if (munmap (apif->tx_ring, ring_sz))
+    clib_warning ("Host interface %s could not free tx ring",
 		  host_if_name);
-  apif->rx_ring = NULL;
   apif->tx_ring = NULL;
   apif->fd = -1;
 
-  vec_free (apif->rx_req);
-  apif->rx_req = NULL;
   vec_free (apif->tx_req);
   apif->tx_req = NULL;
 
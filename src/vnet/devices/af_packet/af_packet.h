@@ -19,22 +19,41 @@
 
 #include <vppinfra/lock.h>
 
+#define AF_PACKET_DEFAULT_RX_QUEUES	1
+#define AF_PACKET_MAX_RX_QUEUES		64
+/* largest packet a rx block can carry, e.g. from a GSO enabled veth */
+#define AF_PACKET_RX_MAX_PKT_SIZE	(64 << 10)
+
+/* TPACKET_V3 rx ring, one per queue, all in the interface's fanout group */
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  int fd;
+  struct tpacket_req3 *rx_req;
+  u8 *rx_ring;
+  u32 clib_file_index;
+
+  /* block being consumed and position of its next packet */
+  u32 next_rx_block;
+  u32 n_pkts_left;
+  u32 next_pkt_offset;
+} af_packet_queue_t;
+
 typedef struct
 {
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
   clib_spinlock_t lockp;
   u8 *host_if_name;
   int host_if_index;
-  int fd;
-  struct tpacket_req *rx_req;
+  int fd;			/* tx socket */
   struct tpacket_req *tx_req;
-  u8 *rx_ring;
   u8 *tx_ring;
   u32 hw_if_index;
   u32 sw_if_index;
-  u32 clib_file_index;
 
-  u32 next_rx_frame;
+  af_packet_queue_t *rx_queues;
+  u16 fanout_id;
+
   u32 next_tx_frame;
 
   u32 per_interface_next_index;
@@ -46,9 +65,6 @@ typedef struct
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
   af_packet_if_t *interfaces;
 
-  /* bitmap of pending rx interfaces */
-  uword *pending_input_bitmap;
-
   /* rx buffer cache */
   u32 **rx_buffers;
 
@@ -61,7 +77,8 @@ extern vnet_device_class_t af_packet_device_class;
 extern vlib_node_registration_t af_packet_input_node;
 
 int af_packet_create_if (vlib_main_t * vm, u8 * host_if_name,
-			 u8 * hw_addr_set, u32 * sw_if_index);
+			 u8 * hw_addr_set, u32 num_rx_queues,
+			 u32 * sw_if_index);
 int af_packet_delete_if (vlib_main_t * vm, u8 * host_if_name);
 int af_packet_set_l4_cksum_offload (vlib_main_t * vm, u32 sw_if_index,
 				    u8 set);
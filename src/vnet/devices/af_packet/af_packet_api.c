@@ -61,7 +61,8 @@ vl_api_af_packet_create_t_handler (vl_api_af_packet_create_t * mp)
 
   rv = af_packet_create_if (vm, host_if_name,
 			    mp->use_random_hw_addr ? 0 : mp->hw_addr,
-			    &sw_if_index);
+			    mp->num_rx_queues ? mp->num_rx_queues :
+			    AF_PACKET_DEFAULT_RX_QUEUES, &sw_if_index);
 
   vec_free (host_if_name);
 
@@ -47,6 +47,7 @@ af_packet_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
   u8 *host_if_name = NULL;
   u8 hwaddr[6];
   u8 *hw_addr_ptr = 0;
+  u32 num_rx_queues = AF_PACKET_DEFAULT_RX_QUEUES;
   u32 sw_if_index;
   int r;
   clib_error_t *error = NULL;
@@ -63,6 +64,8 @@ af_packet_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
 	if (unformat
 	    (line_input, "hw-addr %U", unformat_ethernet_address, hwaddr))
 	hw_addr_ptr = hwaddr;
+      else if (unformat (line_input, "num-rx-queues %u", &num_rx_queues))
+	;
       else
 	{
 	  error = clib_error_return (0, "unknown input `%U'",
@@ -77,7 +80,8 @@ af_packet_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
       goto done;
     }
 
-  r = af_packet_create_if (vm, host_if_name, hw_addr_ptr, &sw_if_index);
+  r = af_packet_create_if (vm, host_if_name, hw_addr_ptr, num_rx_queues,
+			   &sw_if_index);
 
   if (r == VNET_API_ERROR_SYSCALL_ERROR_1)
     {
@@ -97,6 +101,13 @@ af_packet_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
       goto done;
     }
 
+  if (r == VNET_API_ERROR_INVALID_VALUE)
+    {
+      error = clib_error_return (0, "num-rx-queues must be between 1 - %u",
+				 AF_PACKET_MAX_RX_QUEUES);
+      goto done;
+    }
+
   vlib_cli_output (vm, "%U\n", format_vnet_sw_if_index_name, vnet_get_main (),
 		   sw_if_index);
 
@@ -120,6 +131,10 @@ done:
  * - <b>hw-addr <mac-addr></b> - Optional ethernet address, can be in either
  * X:X:X:X:X:X unix or X.X.X cisco format.
  *
+ * - <b>num-rx-queues <n></b> - Optional number of rx queues, default 1. Each
+ * queue is a separate PACKET_MMAP socket and can be polled by a different
+ * worker thread. Packets are spread among queues by flow hash.
+ *
  * @cliexpar
  * Example of how to create a host interface tied to one side of an
  * existing linux veth pair named vpp1:
@@ -132,7 +147,8 @@ done:
 /* *INDENT-OFF* */
 VLIB_CLI_COMMAND (af_packet_create_command, static) = {
   .path = "create host-interface",
-  .short_help = "create host-interface name <ifname> [hw-addr <mac-addr>]",
+  .short_help = "create host-interface name <ifname> [hw-addr <mac-addr>] "
+		"[num-rx-queues <n>]",
   .function = af_packet_create_command_fn,
 };
 /* *INDENT-ON* */
@@ -49,8 +49,8 @@ typedef struct
 {
   u32 next_index;
   u32 hw_if_index;
-  int block;
-  struct tpacket2_hdr tph;
+  u16 queue_id;
+  struct tpacket3_hdr tph;
 } af_packet_input_trace_t;
 
 static u8 *
@@ -61,12 +61,12 @@ format_af_packet_input_trace (u8 * s, va_list * args)
   af_packet_input_trace_t *t = va_arg (*args, af_packet_input_trace_t *);
   u32 indent = format_get_indent (s);
 
-  s = format (s, "af_packet: hw_if_index %d next-index %d",
-	      t->hw_if_index, t->next_index);
+  s = format (s, "af_packet: hw_if_index %d queue %u next-index %d",
+	      t->hw_if_index, t->queue_id, t->next_index);
 
   s =
     format (s,
-	    "\n%Utpacket2_hdr:\n%Ustatus 0x%x len %u snaplen %u mac %u net %u"
+	    "\n%Utpacket3_hdr:\n%Ustatus 0x%x len %u snaplen %u mac %u net %u"
 	    "\n%Usec 0x%x nsec 0x%x vlan %U"
 #ifdef TP_STATUS_VLAN_TPID_VALID
 	    " vlan_tpid %u"
@@ -81,9 +81,9 @@ format_af_packet_input_trace (u8 * s, va_list * args)
 	    t->tph.tp_net,
 	    format_white_space, indent + 4,
 	    t->tph.tp_sec,
-	    t->tph.tp_nsec, format_ethernet_vlan_tci, t->tph.tp_vlan_tci
+	    t->tph.tp_nsec, format_ethernet_vlan_tci, t->tph.hv1.tp_vlan_tci
 #ifdef TP_STATUS_VLAN_TPID_VALID
-	    , t->tph.tp_vlan_tpid
+	    , t->tph.hv1.tp_vlan_tpid
 #endif
     );
   return s;
@@ -172,28 +172,68 @@ mark_tcp_udp_cksum_calc (vlib_buffer_t * b)
     }
 }
 
+/*
+ * Get the next packet from the rx ring, moving to the next block once the
+ * current one is consumed. Blocks are given back to the kernel as a whole.
+ */
+static_always_inline struct tpacket3_hdr *
+af_packet_next_rx_packet (af_packet_queue_t * q)
+{
+  struct tpacket_block_desc *bd;
+
+  while (q->n_pkts_left == 0)
+    {
+      bd = (struct tpacket_block_desc *) (q->rx_ring +
+					  q->next_rx_block *
+					  q->rx_req->tp_block_size);
+      if (q->next_pkt_offset)
+	{
+	  /* done with it */
+	  bd->hdr.bh1.block_status = TP_STATUS_KERNEL;
+	  q->next_pkt_offset = 0;
+	  q->next_rx_block = (q->next_rx_block + 1) % q->rx_req->tp_block_nr;
+	  continue;
+	}
+
+      if ((bd->hdr.bh1.block_status & TP_STATUS_USER) == 0)
+	return 0;
+
+      /* Read the packets only after having seen the status */
+      CLIB_MEMORY_BARRIER ();
+      q->n_pkts_left = bd->hdr.bh1.num_pkts;
+      q->next_pkt_offset = bd->hdr.bh1.offset_to_first_pkt;
+    }
+
+  return (struct tpacket3_hdr *) (q->rx_ring +
+				  q->next_rx_block * q->rx_req->tp_block_size
+				  + q->next_pkt_offset);
+}
+
+static_always_inline void
+af_packet_rx_packet_done (af_packet_queue_t * q, struct tpacket3_hdr *tph)
+{
+  q->n_pkts_left--;
+  q->next_pkt_offset += tph->tp_next_offset;
+}
+
 always_inline uword
 af_packet_device_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
-			   vlib_frame_t * frame, af_packet_if_t * apif)
+			   vlib_frame_t * frame, af_packet_if_t * apif,
+			   u16 queue_id)
 {
   af_packet_main_t *apm = &af_packet_main;
-  struct tpacket2_hdr *tph;
+  af_packet_queue_t *q = vec_elt_at_index (apif->rx_queues, queue_id);
+  struct tpacket3_hdr *tph;
   u32 next_index = VNET_DEVICE_INPUT_NEXT_ETHERNET_INPUT;
-  u32 block = 0;
-  u32 rx_frame;
   u32 n_free_bufs;
   u32 n_rx_packets = 0;
   u32 n_rx_bytes = 0;
   u32 *to_next = 0;
-  u32 block_size = apif->rx_req->tp_block_size;
-  u32 frame_size = apif->rx_req->tp_frame_size;
-  u32 frame_num = apif->rx_req->tp_frame_nr;
-  u8 *block_start = apif->rx_ring + block * block_size;
   uword n_trace = vlib_get_trace_count (vm, node);
   u32 thread_index = vlib_get_thread_index ();
   u32 n_buffer_bytes = vlib_buffer_free_list_buffer_size (vm,
 							  VLIB_BUFFER_DEFAULT_FREE_LIST_INDEX);
-  u32 min_bufs = apif->rx_req->tp_frame_size / n_buffer_bytes;
+  u32 min_bufs = AF_PACKET_RX_MAX_PKT_SIZE / n_buffer_bytes;
 
   if (apif->per_interface_next_index != ~0)
     next_index = apif->per_interface_next_index;
@@ -209,17 +249,15 @@ af_packet_device_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
       _vec_len (apm->rx_buffers[thread_index]) = n_free_bufs;
     }
 
-  rx_frame = apif->next_rx_frame;
-  tph = (struct tpacket2_hdr *) (block_start + rx_frame * frame_size);
-  while ((tph->tp_status & TP_STATUS_USER) && (n_free_bufs > min_bufs))
+  tph = af_packet_next_rx_packet (q);
+  while (tph && (n_free_bufs > min_bufs))
     {
       vlib_buffer_t *b0 = 0, *first_b0 = 0;
       u32 next0 = next_index;
 
       u32 n_left_to_next;
       vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
-      while ((tph->tp_status & TP_STATUS_USER) && (n_free_bufs > min_bufs) &&
-	     n_left_to_next)
+      while (tph && (n_free_bufs > min_bufs) && n_left_to_next)
 	{
 	  u32 data_len = tph->tp_snaplen;
 	  u32 offset = 0;
@@ -254,7 +292,7 @@ af_packet_device_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
 		      ethernet_vlan_header_t *vlan =
 			(ethernet_vlan_header_t *) (eth + 1);
 		      vlan->priority_cfi_and_id =
-			clib_host_to_net_u16 (tph->tp_vlan_tci);
+			clib_host_to_net_u16 (tph->hv1.tp_vlan_tci);
 		      vlan->type = eth->type;
 		      eth->type = clib_host_to_net_u16 (ETHERNET_TYPE_VLAN);
 		      vlan_len = sizeof (ethernet_vlan_header_t);
@@ -303,7 +341,8 @@ af_packet_device_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
 	      tr = vlib_add_trace (vm, node, first_b0, sizeof (*tr));
 	      tr->next_index = next0;
 	      tr->hw_if_index = apif->hw_if_index;
-	      clib_memcpy (&tr->tph, tph, sizeof (struct tpacket2_hdr));
+	      tr->queue_id = queue_id;
+	      clib_memcpy (&tr->tph, tph, sizeof (struct tpacket3_hdr));
 	    }
 
 	  /* redirect if feature path enabled */
@@ -314,16 +353,13 @@ af_packet_device_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
 					   n_left_to_next, first_bi0, next0);
 
 	  /* next packet */
-	  tph->tp_status = TP_STATUS_KERNEL;
-	  rx_frame = (rx_frame + 1) % frame_num;
-	  tph = (struct tpacket2_hdr *) (block_start + rx_frame * frame_size);
+	  af_packet_rx_packet_done (q, tph);
+	  tph = af_packet_next_rx_packet (q);
 	}
 
       vlib_put_next_frame (vm, node, next_index, n_left_to_next);
     }
 
-  apif->next_rx_frame = rx_frame;
-
   vlib_increment_combined_counter
     (vnet_get_main ()->interface_main.combined_sw_if_counters
      + VNET_INTERFACE_COUNTER_RX,
@@ -342,12 +378,13 @@ af_packet_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
   vnet_device_input_runtime_t *rt = (void *) node->runtime_data;
   vnet_device_and_queue_t *dq;
 
-  foreach_device_and_queue (dq, rt->devices_and_queues)
+  foreach_device_and_queue_adaptive (dq, rt->devices_and_queues, node)
   {
     af_packet_if_t *apif;
     apif = vec_elt_at_index (apm->interfaces, dq->dev_instance);
     if (apif->is_admin_up)
-      n_rx_packets += af_packet_device_input_fn (vm, node, frame, apif);
+      n_rx_packets += af_packet_device_input_fn (vm, node, frame, apif,
+						 dq->queue_id);
   }
 
   return n_rx_packets;
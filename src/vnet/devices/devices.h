@@ -158,6 +158,26 @@ vnet_device_input_set_interrupt_pending (vnet_main_t * vnm, u32 hw_if_index,
     if (clib_smp_swap (&((var)->interrupt_pending), 0) ||	\
 	var->mode == VNET_HW_INTERFACE_RX_MODE_POLLING)
 
+/* Same, also polling adaptive queues while vlib polls their node */
+#define foreach_device_and_queue_adaptive(var,vec,node) \
+  for (var = (vec); var < vec_end (vec); var++)			\
+    if (clib_smp_swap (&((var)->interrupt_pending), 0) ||	\
+	var->mode == VNET_HW_INTERFACE_RX_MODE_POLLING ||	\
+	(var->mode == VNET_HW_INTERFACE_RX_MODE_ADAPTIVE &&	\
+	 (node)->state == VLIB_NODE_STATE_POLLING))
+
+/*
+ * Default rx mode of the interface queues. Interrupt based modes fall
+ * back to polling on devices which do not support interrupts.
+ */
+static inline vnet_hw_interface_rx_mode
+vnet_hw_interface_default_rx_mode (vnet_hw_interface_t * hw)
+{
+  if (!(hw->flags & VNET_HW_INTERFACE_FLAG_SUPPORTS_INT_MODE))
+    return VNET_HW_INTERFACE_RX_MODE_POLLING;
+  return hw->default_rx_mode;
+}
+
 #endif /* included_vnet_vnet_device_h */
 
 /*
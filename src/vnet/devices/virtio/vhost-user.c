@@ -78,24 +78,26 @@
 #define VHOST_USER_RX_BUFFER_STARVATION 32
 
 /*
- * On the receive side, the host should free descriptors as soon
- * as possible in order to avoid TX drop in the VM.
- * This value controls the number of copy operations that are stacked
- * before copy is done for all and descriptors are given back to
- * the guest.
- * The value 64 was obtained by testing (48 and 128 were not as good).
+ * Copy orders for the data of a whole frame are gathered while parsing
+ * the virtio rings and executed in one batch afterwards, see
+ * vhost_user_copy_batch. However, the static array which we keep the copy
+ * orders in is limited to VHOST_USER_COPY_ARRAY_N entries. In order to not
+ * corrupt memory, we have to do the copies when the array reaches the copy
+ * threshold. We subtract 40 in case the code goes into the inner loop for
+ * a maximum of 64k frames which may require more array entries.
  */
-#define VHOST_USER_RX_COPY_THRESHOLD 64
+#define VHOST_USER_COPY_THRESHOLD (VHOST_USER_COPY_ARRAY_N - 40)
 /*
- * On the transmit side, we keep processing the buffers from vlib in the while
- * loop and prepare the copy order to be executed later. However, the static
- * array which we keep the copy order is limited to VHOST_USER_COPY_ARRAY_N
- * entries. In order to not corrupt memory, we have to do the copy when the
- * static array reaches the copy threshold. We subtract 40 in case the code
- * goes into the inner loop for a maximum of 64k frames which may require
- * more array entries.
+ * Number of copy orders ahead of the current one whose source and
+ * destination are prefetched.
  */
-#define VHOST_USER_TX_COPY_THRESHOLD (VHOST_USER_COPY_ARRAY_N - 40)
+#define VHOST_USER_COPY_PREFETCH 4
+/*
+ * A new rx placement is only applied if it reduces the load of the most
+ * loaded worker by at least this percentage, so that queues do not bounce
+ * between workers on small load variations.
+ */
+#define VHOST_USER_RX_REBALANCE_MIN_GAIN 25
 
 #define UNIX_GET_FD(unixfd_idx) \
     (unixfd_idx != ~0) ? \
@@ -372,6 +374,10 @@ vhost_user_tx_thread_placement (vhost_user_intf_t * vui)
     }
 }
 
+static clib_error_t *vhost_user_interface_rx_mode_change
+  (vnet_main_t * vnm, u32 hw_if_index, u32 qid,
+   vnet_hw_interface_rx_mode mode);
+
 /**
  * @brief Unassign existing interface/queue to thread mappings and re-assign
  * new interface/queue to thread mappings
@@ -411,8 +417,21 @@ vhost_user_rx_thread_placement ()
 	  if (txvq->started)
 	    {
 	      if (txvq->mode == VNET_HW_INTERFACE_RX_MODE_UNKNOWN)
-		/* Set polling as the default */
-		txvq->mode = VNET_HW_INTERFACE_RX_MODE_POLLING;
+		{
+		  vnet_hw_interface_t *hw =
+		    vnet_get_hw_interface (vnm, vui->hw_if_index);
+		  vnet_hw_interface_rx_mode mode =
+		    vnet_hw_interface_default_rx_mode (hw);
+		  clib_error_t *error;
+
+		  txvq->mode = VNET_HW_INTERFACE_RX_MODE_POLLING;
+		  /* Interrupt modes need the driver to kick us */
+		  if (mode != VNET_HW_INTERFACE_RX_MODE_POLLING &&
+		      txvq->kickfd_idx != ~0 &&
+		      (error = vhost_user_interface_rx_mode_change
+		       (vnm, vui->hw_if_index, qid, mode)))
+		    clib_error_free (error);
+		}
 	      vec_add1 (vui->rx_queues, qid);
 	    }
 	}
@@ -439,6 +458,143 @@ vhost_user_rx_thread_placement ()
   /* *INDENT-ON* */
 }
 
+typedef struct
+{
+  u32 dev_instance;
+  u16 qid;
+  u32 load;
+  uword thread_index;
+  uword new_thread_index;
+} vhost_user_rx_load_t;
+
+static int
+vhost_user_rx_load_cmp (void *a1, void *a2)
+{
+  vhost_user_rx_load_t *l1 = a1, *l2 = a2;
+
+  /* heaviest first */
+  return (l1->load < l2->load) - (l1->load > l2->load);
+}
+
+/**
+ * @brief Re-assign rx queues to workers according to their measured load
+ *
+ * The load of a queue is the number of packets it received since the
+ * previous pass. Queues are placed, heaviest first, on the least loaded
+ * worker, and the new placement is applied if it relieves the most loaded
+ * worker by at least VHOST_USER_RX_REBALANCE_MIN_GAIN percent. Idle queues
+ * stay where they are. Only vhost-user queues are accounted for.
+ */
+static void
+vhost_user_rx_rebalance (void)
+{
+  vhost_user_main_t *vum = &vhost_user_main;
+  vnet_device_main_t *vdm = &vnet_device_main;
+  vnet_main_t *vnm = vnet_get_main ();
+  vhost_user_rx_load_t *loads = 0, *l;
+  vhost_user_intf_t *vui;
+  vhost_user_vring_t *txvq;
+  u64 *old_load = 0, *new_load = 0;
+  u64 old_max = 0, new_max = 0;
+  uword ti, best;
+  u16 *queue;
+  int rv;
+
+  /* Nothing to balance without at least two workers */
+  if (vdm->first_worker_thread_index == 0 ||
+      vdm->first_worker_thread_index == vdm->last_worker_thread_index)
+    return;
+
+  vec_validate (old_load, vdm->last_worker_thread_index);
+  vec_validate (new_load, vdm->last_worker_thread_index);
+
+  /* *INDENT-OFF* */
+  pool_foreach (vui, vum->vhost_user_interfaces, {
+      vec_foreach (queue, vui->rx_queues)
+	{
+	  txvq = &vui->vrings[VHOST_VRING_IDX_TX (*queue)];
+	  vec_add2 (loads, l, 1);
+	  l->dev_instance = vui - vum->vhost_user_interfaces;
+	  l->qid = *queue;
+	  l->load = txvq->n_rx_packets - txvq->n_rx_packets_last;
+	  txvq->n_rx_packets_last = txvq->n_rx_packets;
+	  l->thread_index =
+	    vnet_get_device_input_thread_index (vnm, vui->hw_if_index,
+						*queue);
+	  l->new_thread_index = l->thread_index;
+	  if (l->thread_index < vec_len (old_load))
+	    old_load[l->thread_index] += l->load;
+	}
+  });
+  /* *INDENT-ON* */
+
+  if (vec_len (loads) < 2)
+    goto done;
+
+  vec_sort_with_function (loads, vhost_user_rx_load_cmp);
+
+  vec_foreach (l, loads)
+  {
+    if (l->load == 0)
+      break;
+
+    best = vdm->first_worker_thread_index;
+    for (ti = best + 1; ti <= vdm->last_worker_thread_index; ti++)
+      if (new_load[ti] < new_load[best])
+	best = ti;
+
+    /* Prefer not moving the queue when it makes no difference */
+    if (l->thread_index >= vdm->first_worker_thread_index &&
+	l->thread_index <= vdm->last_worker_thread_index &&
+	new_load[l->thread_index] == new_load[best])
+      best = l->thread_index;
+
+    new_load[best] += l->load;
+    l->new_thread_index = best;
+  }
+
+  /* Idle queues stay where they are and count for nothing */
+  vec_foreach_index (ti, old_load)
+  {
+    old_max = clib_max (old_max, old_load[ti]);
+    new_max = clib_max (new_max, new_load[ti]);
+  }
+
+  if (old_max == 0 ||
+      new_max * 100 > old_max * (100 - VHOST_USER_RX_REBALANCE_MIN_GAIN))
+    goto done;
+
+  vec_foreach (l, loads)
+  {
+    if (l->new_thread_index == l->thread_index)
+      continue;
+
+    vui = pool_elt_at_index (vum->vhost_user_interfaces, l->dev_instance);
+    txvq = &vui->vrings[VHOST_VRING_IDX_TX (l->qid)];
+
+    rv = vnet_hw_interface_unassign_rx_thread (vnm, vui->hw_if_index,
+					       l->qid);
+    if (rv)
+      {
+	clib_warning ("Warning: unable to unassign interface %d, "
+		      "queue %d: rc=%d", vui->hw_if_index, l->qid, rv);
+	continue;
+      }
+    vnet_hw_interface_assign_rx_thread (vnm, vui->hw_if_index, l->qid,
+					l->new_thread_index);
+    rv = vnet_hw_interface_set_rx_mode (vnm, vui->hw_if_index, l->qid,
+					txvq->mode);
+    if (rv)
+      clib_warning ("Warning: unable to set rx mode for interface %d, "
+		    "queue %d: rc=%d", vui->hw_if_index, l->qid, rv);
+  }
+
+done:
+  vec_free (loads);
+  vec_free (old_load);
+  vec_free (new_load);
+}
+
 /** @brief Returns whether at least one TX and one RX vring are enabled */
 int
 vhost_user_intf_ready (vhost_user_intf_t * vui)
@@ -1358,47 +1514,62 @@ vhost_user_send_call (vlib_main_t * vm, vhost_user_vring_t * vq)
   vq->int_deadline = vlib_time_now (vm) + vum->coalesce_time;
 }
 
+/**
+ * Execute a batch of copy orders between guest memory and vlib buffers.
+ *
+ * Guest addresses are all translated first, so that the copy loop does
+ * nothing but memcpy and can prefetch both ends of the orders
+ * VHOST_USER_COPY_PREFETCH entries ahead. On the rx path (is_tx = 0) the
+ * source is in guest memory, on the tx path the destination is, and the
+ * pages written are logged for live migration once the copies are done.
+ *
+ * Returns 1 if a guest address could not be mapped. No copy is done then.
+ */
 static_always_inline u32
-vhost_user_input_copy (vhost_user_intf_t * vui, vhost_copy_t * cpy,
-		       u16 copy_len, u32 * map_hint)
+vhost_user_copy_batch (vhost_user_intf_t * vui, vhost_cpu_t * cpu,
+		       u16 copy_len, u32 * map_hint, int is_tx)
 {
-  void *src0, *src1, *src2, *src3;
-  if (PREDICT_TRUE (copy_len >= 4))
+  vhost_copy_t *cpy = cpu->copy;
+  void **addr = cpu->copy_addr;
+  void *src, *dst;
+  u32 i, j;
+
+  for (i = 0; i < copy_len; i++)
     {
-      if (PREDICT_FALSE (!(src2 = map_guest_mem (vui, cpy[0].src, map_hint))))
-	return 1;
-      if (PREDICT_FALSE (!(src3 = map_guest_mem (vui, cpy[1].src, map_hint))))
+      addr[i] = map_guest_mem (vui, is_tx ? cpy[i].dst : cpy[i].src,
+			       map_hint);
+      if (PREDICT_FALSE (addr[i] == 0))
 	return 1;
+    }
 
-      while (PREDICT_TRUE (copy_len >= 4))
+  for (i = 0; i < copy_len && i < VHOST_USER_COPY_PREFETCH; i++)
+    {
+      CLIB_PREFETCH (is_tx ? (void *) cpy[i].src : addr[i],
+		     CLIB_CACHE_LINE_BYTES, LOAD);
+      CLIB_PREFETCH (is_tx ? addr[i] : (void *) cpy[i].dst,
+		     CLIB_CACHE_LINE_BYTES, STORE);
+    }
+
+  for (i = 0; i < copy_len; i++)
+    {
+      j = i + VHOST_USER_COPY_PREFETCH;
+      if (PREDICT_TRUE (j < copy_len))
 	{
-	  src0 = src2;
-	  src1 = src3;
+	  CLIB_PREFETCH (is_tx ? (void *) cpy[j].src : addr[j],
+			 CLIB_CACHE_LINE_BYTES, LOAD);
+	  CLIB_PREFETCH (is_tx ? addr[j] : (void *) cpy[j].dst,
+			 CLIB_CACHE_LINE_BYTES, STORE);
+	}
 
-	  if (PREDICT_FALSE
-	      (!(src2 = map_guest_mem (vui, cpy[2].src, map_hint))))
-	    return 1;
-	  if (PREDICT_FALSE
-	      (!(src3 = map_guest_mem (vui, cpy[3].src, map_hint))))
-	    return 1;
+      src = is_tx ? (void *) cpy[i].src : addr[i];
+      dst = is_tx ? addr[i] : (void *) cpy[i].dst;
+      clib_memcpy (dst, src, cpy[i].len);
+    }
 
-	  CLIB_PREFETCH (src2, 64, LOAD);
-	  CLIB_PREFETCH (src3, 64, LOAD);
+  if (is_tx && PREDICT_FALSE (vui->log_base_addr != 0))
+    for (i = 0; i < copy_len; i++)
+      vhost_user_log_dirty_pages_2 (vui, cpy[i].dst, cpy[i].len, 1);
 
-	  clib_memcpy ((void *) cpy[0].dst, src0, cpy[0].len);
-	  clib_memcpy ((void *) cpy[1].dst, src1, cpy[1].len);
-	  copy_len -= 2;
-	  cpy += 2;
-	}
-    }
-  while (copy_len)
-    {
-      if (PREDICT_FALSE (!(src0 = map_guest_mem (vui, cpy->src, map_hint))))
-	return 1;
-      clib_memcpy ((void *) cpy->dst, src0, cpy->len);
-      copy_len -= 1;
-      cpy += 1;
-    }
   return 0;
 }
 
@@ -1735,6 +1906,18 @@ vhost_user_if_input (vlib_main_t * vm,
 		  b_current = vlib_get_buffer (vm, bi_current);
 		}
 
+	      /* Huge packet in a full batch, do the copies done so far */
+	      if (PREDICT_FALSE (copy_len == VHOST_USER_COPY_ARRAY_N))
+		{
+		  if (PREDICT_FALSE
+		      (vhost_user_copy_batch (vui, &vum->cpus[thread_index],
+					      copy_len, &map_hint, 0)))
+		    vlib_error_count (vm, node->node_index,
+				      VHOST_USER_INPUT_FUNC_ERROR_MMAP_FAIL,
+				      1);
+		  copy_len = 0;
+		}
+
 	      /* Prepare a copy order executed later for the data */
 	      vhost_copy_t *cpy = &vum->cpus[thread_index].copy[copy_len];
 	      copy_len++;
@@ -1787,15 +1970,15 @@ vhost_user_if_input (vlib_main_t * vm,
 	  n_left--;
 
 	  /*
-	   * Although separating memory copies from virtio ring parsing
-	   * is beneficial, we can offer to perform the copies from time
-	   * to time in order to free some space in the ring.
+	   * The copies are batched for the whole frame. Only flush them
+	   * early, and give the descriptors back, when the copy order
+	   * array is about to overflow.
 	   */
-	  if (PREDICT_FALSE (copy_len >= VHOST_USER_RX_COPY_THRESHOLD))
+	  if (PREDICT_FALSE (copy_len >= VHOST_USER_COPY_THRESHOLD))
 	    {
 	      if (PREDICT_FALSE
-		  (vhost_user_input_copy (vui, vum->cpus[thread_index].copy,
-					  copy_len, &map_hint)))
+		  (vhost_user_copy_batch (vui, &vum->cpus[thread_index],
+					  copy_len, &map_hint, 0)))
 		{
 		  vlib_error_count (vm, node->node_index,
 				    VHOST_USER_INPUT_FUNC_ERROR_MMAP_FAIL, 1);
@@ -1814,8 +1997,8 @@ vhost_user_if_input (vlib_main_t * vm,
 
   /* Do the memory copies */
   if (PREDICT_FALSE
-      (vhost_user_input_copy (vui, vum->cpus[thread_index].copy,
-			      copy_len, &map_hint)))
+      (vhost_user_copy_batch (vui, &vum->cpus[thread_index],
+			      copy_len, &map_hint, 0)))
     {
       vlib_error_count (vm, node->node_index,
 			VHOST_USER_INPUT_FUNC_ERROR_MMAP_FAIL, 1);
@@ -1844,6 +2027,9 @@ vhost_user_if_input (vlib_main_t * vm,
 
   vnet_device_increment_rx_packets (thread_index, n_rx_packets);
 
+  /* per vring load, for rx placement */
+  txvq->n_rx_packets += n_rx_packets;
+
   return n_rx_packets;
 }
 
@@ -1865,8 +2051,8 @@ vhost_user_input (vlib_main_t * vm,
       {
 	vui =
 	  pool_elt_at_index (vum->vhost_user_interfaces, dq->dev_instance);
-	n_rx_packets = vhost_user_if_input (vm, vum, vui, dq->queue_id, node,
-					    dq->mode);
+	n_rx_packets += vhost_user_if_input (vm, vum, vui, dq->queue_id, node,
+					     dq->mode);
       }
   }
 
@@ -1929,54 +2115,6 @@ vhost_user_tx_trace (vhost_trace_t * t,
   t->first_desc_len = hdr_desc ? hdr_desc->len : 0;
 }
 
-static_always_inline u32
-vhost_user_tx_copy (vhost_user_intf_t * vui, vhost_copy_t * cpy,
-		    u16 copy_len, u32 * map_hint)
-{
-  void *dst0, *dst1, *dst2, *dst3;
-  if (PREDICT_TRUE (copy_len >= 4))
-    {
-      if (PREDICT_FALSE (!(dst2 = map_guest_mem (vui, cpy[0].dst, map_hint))))
-	return 1;
-      if (PREDICT_FALSE (!(dst3 = map_guest_mem (vui, cpy[1].dst, map_hint))))
-	return 1;
-      while (PREDICT_TRUE (copy_len >= 4))
-	{
-	  dst0 = dst2;
-	  dst1 = dst3;
-
-	  if (PREDICT_FALSE
-	      (!(dst2 = map_guest_mem (vui, cpy[2].dst, map_hint))))
-	    return 1;
-	  if (PREDICT_FALSE
-	      (!(dst3 = map_guest_mem (vui, cpy[3].dst, map_hint))))
-	    return 1;
-
-	  CLIB_PREFETCH ((void *) cpy[2].src, 64, LOAD);
-	  CLIB_PREFETCH ((void *) cpy[3].src, 64, LOAD);
-
-	  clib_memcpy (dst0, (void *) cpy[0].src, cpy[0].len);
-	  clib_memcpy (dst1, (void *) cpy[1].src, cpy[1].len);
-
-	  vhost_user_log_dirty_pages_2 (vui, cpy[0].dst, cpy[0].len, 1);
-	  vhost_user_log_dirty_pages_2 (vui, cpy[1].dst, cpy[1].len, 1);
-	  copy_len -= 2;
-	  cpy += 2;
-	}
-    }
-  while (copy_len)
-    {
-      if (PREDICT_FALSE (!(dst0 = map_guest_mem (vui, cpy->dst, map_hint))))
-	return 1;
-      clib_memcpy (dst0, (void *) cpy->src, cpy->len);
-      vhost_user_log_dirty_pages_2 (vui, cpy->dst, cpy->len, 1);
-      copy_len -= 1;
-      cpy += 1;
-    }
-  return 0;
-}
-
-
 static uword
 vhost_user_tx (vlib_main_t * vm,
 	       vlib_node_runtime_t * node, vlib_frame_t * frame)
@@ -2227,11 +2365,11 @@ retry:
        * Do the copy periodically to prevent
        * vum->cpus[thread_index].copy array overflow and corrupt memory
        */
-      if (PREDICT_FALSE (copy_len >= VHOST_USER_TX_COPY_THRESHOLD))
+      if (PREDICT_FALSE (copy_len >= VHOST_USER_COPY_THRESHOLD))
 	{
 	  if (PREDICT_FALSE
-	      (vhost_user_tx_copy (vui, vum->cpus[thread_index].copy,
-				   copy_len, &map_hint)))
+	      (vhost_user_copy_batch (vui, &vum->cpus[thread_index],
+				      copy_len, &map_hint, 1)))
 	    {
 	      vlib_error_count (vm, node->node_index,
 				VHOST_USER_TX_FUNC_ERROR_MMAP_FAIL, 1);
@@ -2249,8 +2387,8 @@ retry:
 done:
   //Do the memory copies
   if (PREDICT_FALSE
-      (vhost_user_tx_copy (vui, vum->cpus[thread_index].copy,
-			   copy_len, &map_hint)))
+      (vhost_user_copy_batch (vui, &vum->cpus[thread_index],
+			      copy_len, &map_hint, 1)))
     {
       vlib_error_count (vm, node->node_index,
 			VHOST_USER_TX_FUNC_ERROR_MMAP_FAIL, 1);
@@ -2525,6 +2663,18 @@ vhost_user_process (vlib_main_t * vm,
 
       timeout = 3.0;
 
+      if (vum->rx_rebalance_interval > 0.0)
+	{
+	  f64 now = vlib_time_now (vm);
+
+	  if (now - vum->rx_rebalance_last >= vum->rx_rebalance_interval)
+	    {
+	      vum->rx_rebalance_last = now;
+	      vhost_user_rx_rebalance ();
+	    }
+	  timeout = clib_min (timeout, vum->rx_rebalance_interval);
+	}
+
       /* *INDENT-OFF* */
       pool_foreach (vui, vum->vhost_user_interfaces, {
 
@@ -3196,6 +3346,9 @@ show_vhost_user_command_fn (vlib_main_t * vm,
 		   vum->coalesce_frames, vum->coalesce_time);
   vlib_cli_output (vm, "  number of rx virtqueues in interrupt mode: %d",
 		   vum->ifq_count);
+  if (vum->rx_rebalance_interval > 0.0)
+    vlib_cli_output (vm, "  rx placement rebalanced every %.2f sec",
+		     vum->rx_rebalance_interval);
 
   for (i = 0; i < vec_len (hw_if_indices); i++)
     {
@@ -3637,6 +3790,9 @@ vhost_user_config (vlib_main_t * vm, unformat_input_t * input)
 	;
       else if (unformat (input, "dont-dump-memory"))
 	vum->dont_dump_vhost_user_memory = 1;
+      else if (unformat (input, "rx-rebalance-interval %f",
+			 &vum->rx_rebalance_interval))
+	;
       else
 	return clib_error_return (0, "unknown input `%U'",
 				  format_unformat_error, input);
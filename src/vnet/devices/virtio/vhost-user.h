@@ -203,6 +203,8 @@ typedef struct
   u8 started;
   u8 enabled;
   u8 log_used;
+  /* Packets received on this vring, written by its input thread only */
+  u32 n_rx_packets;
   //Put non-runtime in a different cache line
     CLIB_CACHE_LINE_ALIGN_MARK (cacheline1);
   int errfd;
@@ -212,6 +214,9 @@ typedef struct
 
   /* The rx queue policy (interrupt/adaptive/polling) for this queue */
   u32 mode;
+
+  /* n_rx_packets at the last rx placement rebalancing */
+  u32 n_rx_packets_last;
 } vhost_user_vring_t;
 
 #define VHOST_USER_EVENT_START_TIMER 1
@@ -287,6 +292,8 @@ typedef struct
 
   virtio_net_hdr_mrg_rxbuf_t tx_headers[VLIB_FRAME_SIZE];
   vhost_copy_t copy[VHOST_USER_COPY_ARRAY_N];
+  /* Host address of the guest side of each copy order */
+  void *copy_addr[VHOST_USER_COPY_ARRAY_N];
 
   /* This is here so it doesn't end-up
    * using stack or registers. */
@@ -312,6 +319,10 @@ typedef struct
   /* The number of rx interface/queue pairs in interrupt mode */
   u32 ifq_count;
 
+  /* Seconds between load based rx placement passes, 0 if disabled */
+  f64 rx_rebalance_interval;
+  f64 rx_rebalance_last;
+
   /* debug on or off */
   u8 debug;
 } vhost_user_main_t;
@@ -83,13 +83,38 @@ load_balance_get_buckets (load_balance_t *lb)
 static load_balance_t *
 load_balance_alloc_i (void)
 {
+    vlib_main_t *vm = vlib_get_main();
     load_balance_t *lb;
+    u8 need_barrier_sync = 0;
+
+    /*
+     * The workers read the pool and the counters without a lock, so
+     * stop them only if either is about to move.
+     */
+    pool_get_aligned_will_expand(load_balance_pool, need_barrier_sync,
+                                 CLIB_CACHE_LINE_BYTES);
+    if (need_barrier_sync)
+        vlib_worker_thread_barrier_sync(vm);
 
     pool_get_aligned(load_balance_pool, lb, CLIB_CACHE_LINE_BYTES);
     memset(lb, 0, sizeof(*lb));
 
     lb->lb_map = INDEX_INVALID;
     lb->lb_urpf = INDEX_INVALID;
+
+    if (!need_barrier_sync)
+    {
+        need_barrier_sync =
+            (vlib_validate_combined_counter_will_expand
+             (&(load_balance_main.lbm_to_counters),
+              load_balance_get_index(lb)) ||
+             vlib_validate_combined_counter_will_expand
+             (&(load_balance_main.lbm_via_counters),
+              load_balance_get_index(lb)));
+        if (need_barrier_sync)
+            vlib_worker_thread_barrier_sync(vm);
+    }
+
     vlib_validate_combined_counter(&(load_balance_main.lbm_to_counters),
                                    load_balance_get_index(lb));
     vlib_validate_combined_counter(&(load_balance_main.lbm_via_counters),
@@ -99,9 +124,28 @@ load_balance_alloc_i (void)
     vlib_zero_combined_counter(&(load_balance_main.lbm_via_counters),
                                load_balance_get_index(lb));
 
+    if (need_barrier_sync)
+        vlib_worker_thread_barrier_release(vm);
+
     return (lb);
 }
 
+/**
+ * Release a bucket array the data-plane may still be reading, once
+ * all the workers have moved on.
+ */
+static void
+load_balance_buckets_free (void *arg)
+{
+    dpo_id_t *buckets = arg, *tmp_dpo;
+
+    vec_foreach(tmp_dpo, buckets)
+    {
+        dpo_reset(tmp_dpo);
+    }
+    vec_free(buckets);
+}
+
 static u8*
 load_balance_format (index_t lbi,
                      load_balance_format_flags_t flags,
@@ -489,7 +533,6 @@ load_balance_multipath_update (const dpo_id_t *dpo,
     u32 sum_of_weights, n_buckets, ii;
     index_t lbmi, old_lbmi;
     load_balance_t *lb;
-    dpo_id_t *tmp_dpo;
 
     nhs = NULL;
 
@@ -611,7 +654,7 @@ load_balance_multipath_update (const dpo_id_t *dpo,
                      * we are not crossing the threshold. We need a new bucket array to
                      * hold the increased number of choices.
                      */
-                    dpo_id_t *new_buckets, *old_buckets, *tmp_dpo;
+                    dpo_id_t *new_buckets, *old_buckets;
 
                     new_buckets = NULL;
                     old_buckets = load_balance_get_buckets(lb);
@@ -626,11 +669,9 @@ load_balance_multipath_update (const dpo_id_t *dpo,
                     CLIB_MEMORY_BARRIER();
                     load_balance_set_n_buckets(lb, n_buckets);
 
-                    vec_foreach(tmp_dpo, old_buckets)
-                    {
-                        dpo_reset(tmp_dpo);
-                    }
-                    vec_free(old_buckets);
+                    vlib_rcu_call(vlib_get_main(),
+                                  load_balance_buckets_free,
+                                  old_buckets);
                 }
             }
 
@@ -669,11 +710,10 @@ load_balance_multipath_update (const dpo_id_t *dpo,
                 load_balance_set_n_buckets(lb, n_buckets);
                 CLIB_MEMORY_BARRIER();
 
-                vec_foreach(tmp_dpo, lb->lb_buckets)
-                {
-                    dpo_reset(tmp_dpo);
-                }
-                vec_free(lb->lb_buckets);
+                vlib_rcu_call(vlib_get_main(),
+                              load_balance_buckets_free,
+                              lb->lb_buckets);
+                lb->lb_buckets = NULL;
             }
             else
             {
@@ -740,7 +780,8 @@ load_balance_destroy (load_balance_t *lb)
     LB_DBG(lb, "destroy");
     if (!LB_HAS_INLINE_BUCKETS(lb))
     {
-        vec_free(lb->lb_buckets);
+        vlib_rcu_vec_free(vlib_get_main(), lb->lb_buckets);
+        lb->lb_buckets = NULL;
     }
 
     fib_urpf_list_unlock(lb->lb_urpf);
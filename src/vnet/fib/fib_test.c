@@ -8781,6 +8781,436 @@ lfib_test (void)
     return (0);
 }
 
+/*
+ * The reference the mtries are checked against; a hash table per prefix
+ * length, as the IPv4 FIB itself keeps.
+ */
+typedef struct fib_test_mtrie_ref_t_ {
+    uword *by_len[33];
+} fib_test_mtrie_ref_t;
+
+static u32
+fib_test_mtrie_ref_lookup (const fib_test_mtrie_ref_t *ref,
+                           const ip4_address_t *addr,
+                           int max_len,
+                           u32 *len)
+{
+    uword *p;
+    int ii;
+
+    for (ii = max_len; ii >= 0; ii--)
+    {
+        p = hash_get(ref->by_len[ii],
+                     addr->as_u32 & ip4_main.fib_masks[ii]);
+        if (NULL != p)
+        {
+            *len = ii;
+            return (p[0]);
+        }
+    }
+    /* no cover, the miss */
+    *len = 0;
+    return (0);
+}
+
+static u32
+fib_test_mtrie_lookup (const ip4_fib_mtrie_t *m,
+                       const ip4_address_t *addr)
+{
+    ip4_fib_mtrie_leaf_t leaf;
+
+    leaf = ip4_fib_mtrie_lookup_step_one(m, addr);
+    leaf = ip4_fib_mtrie_lookup_step(m, leaf, addr, 2);
+    leaf = ip4_fib_mtrie_lookup_step(m, leaf, addr, 3);
+
+    return (ip4_fib_mtrie_leaf_get_adj_index(leaf));
+}
+
+/*
+ * Compare the memory usage, build rate and lookup rate of mtries built
+ * from full and compressed plies, over the same random table, and check
+ * each gives the same answer as the reference. The last mtrie bulk loads
+ * half the table onto the other half.
+ */
+static int
+fib_test_mtrie (unformat_input_t * input)
+{
+    static const char *names[] = {
+        "full",
+        "compressed",
+        "compressed-bulk",
+        "compressed-rebulk",
+    };
+    u32 n_routes, n_lookups, seed, n_plies, n_c_plies;
+    u32 ii, jj, lb, len, n_addrs;
+    ip4_address_t *dsts, *addrs;
+    fib_test_mtrie_ref_t ref;
+    ip4_fib_mtrie_t *mtries[4];
+    vlib_main_t *vm;
+    uword acc;
+    u8 *lens;
+    f64 t[2];
+
+    vm = vlib_get_main();
+    n_routes = 100000;
+    n_lookups = 10000000;
+    n_addrs = 1 << 16;
+    seed = 0xdeadbeef;
+    dsts = addrs = NULL;
+    lens = NULL;
+    acc = 0;
+    memset(&ref, 0, sizeof(ref));
+
+    while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+        if (unformat (input, "routes %d", &n_routes))
+            ;
+        else if (unformat (input, "lookups %d", &n_lookups))
+            ;
+        else if (unformat (input, "seed %d", &seed))
+            ;
+        else
+            break;
+    }
+
+    /* plies freed by the previous tests may still be waiting */
+    vlib_rcu_barrier(vm);
+    n_plies = pool_elts(ip4_ply_pool);
+    n_c_plies = pool_elts(ip4_c_ply_pool);
+
+    /*
+     * A table whose prefix length distribution is not unlike the
+     * Internet's; mostly /24s, then the /16 to /23 aggregates and a
+     * sprinkling of short and longer than /24 prefixes.
+     */
+    for (ii = 0; ii < n_routes; ii++)
+    {
+        ip4_address_t dst;
+        u32 r;
+
+        r = random_u32(&seed) % 100;
+
+        if (r < 55)
+            len = 24;
+        else if (r < 85)
+            len = 16 + (r % 8);
+        else if (r < 90)
+            len = 8 + (r % 8);
+        else
+            len = 25 + (r % 8);
+
+        dst.as_u32 = random_u32(&seed) & ip4_main.fib_masks[len];
+
+        if (NULL != hash_get(ref.by_len[len], dst.as_u32))
+        {
+            /* duplicate, try again */
+            ii--;
+            continue;
+        }
+        /* LB index 0 is the miss, so the route's index + 1 */
+        hash_set(ref.by_len[len], dst.as_u32, ii + 1);
+        vec_add1(dsts, dst);
+        vec_add1(lens, len);
+    }
+
+    /*
+     * half the addresses to lookup hit a route, the rest are random
+     */
+    for (ii = 0; ii < n_addrs; ii++)
+    {
+        ip4_address_t addr;
+
+        addr.as_u32 = random_u32(&seed);
+        if (ii & 1)
+        {
+            jj = random_u32(&seed) % vec_len(dsts);
+            addr.as_u32 = (dsts[jj].as_u32 |
+                           (addr.as_u32 & ~ip4_main.fib_masks[lens[jj]]));
+        }
+        vec_add1(addrs, addr);
+    }
+
+    for (ii = 0; ii < ARRAY_LEN(mtries); ii++)
+    {
+        mtries[ii] = clib_mem_alloc_aligned(sizeof(ip4_fib_mtrie_t),
+                                            CLIB_CACHE_LINE_BYTES);
+        ip4_mtrie_init_w_type(mtries[ii],
+                              (0 == ii ?
+                               IP4_FIB_MTRIE_PLY_TYPE_FULL :
+                               IP4_FIB_MTRIE_PLY_TYPE_COMPRESSED));
+
+        t[0] = vlib_time_now(vm);
+        if (2 == ii)
+            ip4_fib_mtrie_bulk_begin(mtries[ii]);
+        vec_foreach_index(jj, dsts)
+        {
+            if (3 == ii && jj == vec_len(dsts) / 2)
+                ip4_fib_mtrie_bulk_begin(mtries[ii]);
+            ip4_fib_mtrie_route_add(mtries[ii], &dsts[jj], lens[jj], jj + 1);
+        }
+        if (2 <= ii)
+            ip4_fib_mtrie_bulk_end(mtries[ii]);
+        t[1] = vlib_time_now(vm);
+
+        vlib_cli_output(vm, "%-16s build: %.6e routes/sec, memory usage %U",
+                        names[ii], vec_len(dsts) / (t[1] - t[0]),
+                        format_memory_size,
+                        ip4_fib_mtrie_memory_usage(mtries[ii]));
+    }
+
+    /*
+     * the plies do not depend on the order the routes are added in, so
+     * a bulk update leaving no full ply behind uses as much memory
+     */
+    for (ii = 2; ii < ARRAY_LEN(mtries); ii++)
+    {
+        FIB_TEST((ip4_fib_mtrie_memory_usage(mtries[1]) ==
+                  ip4_fib_mtrie_memory_usage(mtries[ii])),
+                 "%s mtrie has only compressed plies", names[ii]);
+    }
+
+    vec_foreach_index(jj, addrs)
+    {
+        lb = fib_test_mtrie_ref_lookup(&ref, &addrs[jj], 32, &len);
+
+        for (ii = 0; ii < ARRAY_LEN(mtries); ii++)
+        {
+            FIB_TEST((lb == fib_test_mtrie_lookup(mtries[ii], &addrs[jj])),
+                     "%s mtrie: %U -> %d, expected %d",
+                     names[ii], format_ip4_address, &addrs[jj],
+                     fib_test_mtrie_lookup(mtries[ii], &addrs[jj]), lb);
+        }
+    }
+
+    for (ii = 0; ii < ARRAY_LEN(mtries); ii++)
+    {
+        t[0] = vlib_time_now(vm);
+        for (jj = 0; jj < n_lookups; jj++)
+        {
+            acc += fib_test_mtrie_lookup(mtries[ii],
+                                         &addrs[jj & (n_addrs - 1)]);
+        }
+        t[1] = vlib_time_now(vm);
+
+        vlib_cli_output(vm, "%-16s lookup: %.6e lookups/sec",
+                        names[ii], n_lookups / (t[1] - t[0]));
+    }
+    vlib_cli_output(vm, "(lookup checksum %wx)", acc);
+
+    /*
+     * remove the routes, most recently added first, replacing each with
+     * its cover from those that remain.
+     */
+    for (jj = vec_len(dsts); jj > 0; jj--)
+    {
+        hash_unset(ref.by_len[lens[jj - 1]], dsts[jj - 1].as_u32);
+        lb = fib_test_mtrie_ref_lookup(&ref, &dsts[jj - 1],
+                                       lens[jj - 1], &len);
+
+        for (ii = 0; ii < ARRAY_LEN(mtries); ii++)
+        {
+            ip4_fib_mtrie_route_del(mtries[ii], &dsts[jj - 1], lens[jj - 1],
+                                    jj, len, lb);
+        }
+    }
+
+    /*
+     * the workers may still be walking the removed plies, so they
+     * are only returned to the pools after a grace period
+     */
+    if (vec_len(dsts))
+    {
+        FIB_TEST((n_plies < pool_elts(ip4_ply_pool)),
+                 "removed plies are freed after a grace period: %d",
+                 pool_elts(ip4_ply_pool) - n_plies);
+    }
+    vlib_rcu_barrier(vm);
+
+    FIB_TEST((n_plies == pool_elts(ip4_ply_pool)),
+             "all plies removed: %d", pool_elts(ip4_ply_pool) - n_plies);
+    FIB_TEST((n_c_plies == pool_elts(ip4_c_ply_pool)),
+             "all compressed plies removed: %d",
+             pool_elts(ip4_c_ply_pool) - n_c_plies);
+
+    for (ii = 0; ii < ARRAY_LEN(mtries); ii++)
+    {
+        ip4_mtrie_free(mtries[ii]);
+        clib_mem_free(mtries[ii]);
+    }
+    for (ii = 0; ii < ARRAY_LEN(ref.by_len); ii++)
+    {
+        hash_free(ref.by_len[ii]);
+    }
+    vec_free(dsts);
+    vec_free(addrs);
+    vec_free(lens);
+
+    return (0);
+}
+
+/*
+ * Compare the binary search on prefix lengths with the probe of each
+ * length, then measure both.
+ */
+static int
+fib_test_ip6_lpm (unformat_input_t * input)
+{
+    u32 n_prefixes, n_lookups, seed, fib_index, n_addrs;
+    ip6_address_t *addrs;
+    fib_prefix_t *pfxs;
+    vlib_main_t *vm;
+    u32 ii, jj, lb;
+    uword acc;
+    f64 t[2];
+
+    vm = vlib_get_main();
+    n_prefixes = 60000;
+    n_lookups = 10000000;
+    n_addrs = 1 << 16;
+    seed = 0xdeadbeef;
+    addrs = NULL;
+    pfxs = NULL;
+    acc = 0;
+
+    while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+        if (unformat (input, "prefixes %d", &n_prefixes))
+            ;
+        else if (unformat (input, "lookups %d", &n_lookups))
+            ;
+        else if (unformat (input, "seed %d", &seed))
+            ;
+        else
+            break;
+    }
+
+    fib_index = fib_table_find_or_create_and_lock(FIB_PROTOCOL_IP6, 16,
+                                                  FIB_SOURCE_API);
+
+    /*
+     * A table whose prefix length distribution is not unlike the
+     * Internet's; mostly /48s and /32s, then the allocation sizes
+     * between, and a few /56, /64 and host routes.
+     */
+    for (ii = 0; ii < n_prefixes; ii++)
+    {
+        static const u8 lens[] = {
+            48, 48, 48, 48, 48, 48, 48, 48, 48, 48,
+            32, 32, 32, 32, 32, 29, 29, 36, 40, 44,
+            56, 64, 128, 47, 46,
+        };
+        fib_prefix_t pfx = {
+            .fp_proto = FIB_PROTOCOL_IP6,
+        };
+
+        pfx.fp_len = lens[random_u32(&seed) % ARRAY_LEN(lens)];
+        /* within 2000::/3 */
+        pfx.fp_addr.ip6.as_u32[0] = ((random_u32(&seed) & 0x1fffffff) |
+                                     0x20000000);
+        pfx.fp_addr.ip6.as_u32[1] = random_u32(&seed);
+        pfx.fp_addr.ip6.as_u32[2] = random_u32(&seed);
+        pfx.fp_addr.ip6.as_u32[3] = random_u32(&seed);
+        pfx.fp_addr.ip6.as_u32[0] =
+            clib_host_to_net_u32(pfx.fp_addr.ip6.as_u32[0]);
+        ip6_address_mask(&pfx.fp_addr.ip6,
+                         &ip6_main.fib_masks[pfx.fp_len]);
+
+        fib_table_entry_special_add(fib_index, &pfx,
+                                    FIB_SOURCE_SPECIAL,
+                                    FIB_ENTRY_FLAG_DROP);
+        vec_add1(pfxs, pfx);
+    }
+
+    /*
+     * half the addresses to lookup are within a prefix, the rest are
+     * random
+     */
+    for (ii = 0; ii < n_addrs; ii++)
+    {
+        ip6_address_t addr;
+
+        for (jj = 0; jj < 4; jj++)
+            addr.as_u32[jj] = random_u32(&seed);
+
+        if (ii & 1)
+        {
+            fib_prefix_t *pfx;
+
+            pfx = &pfxs[random_u32(&seed) % vec_len(pfxs)];
+            addr.as_u64[0] = (pfx->fp_addr.ip6.as_u64[0] |
+                              (addr.as_u64[0] &
+                               ~ip6_main.fib_masks[pfx->fp_len].as_u64[0]));
+            addr.as_u64[1] = (pfx->fp_addr.ip6.as_u64[1] |
+                              (addr.as_u64[1] &
+                               ~ip6_main.fib_masks[pfx->fp_len].as_u64[1]));
+        }
+        vec_add1(addrs, addr);
+    }
+
+    t[0] = vlib_time_now(vm);
+    ip6_fib_table_fwding_lpm_rebuild();
+    t[1] = vlib_time_now(vm);
+
+    vlib_cli_output(vm, "%d prefixes, %d lengths, %d markers, compiled in %.6fs",
+                    vec_len(pfxs),
+                    vec_len(ip6_main.ip6_lpm.prefix_lengths[ip6_main.ip6_lpm.active]),
+                    ip6_main.ip6_lpm.n_markers,
+                    t[1] - t[0]);
+
+    vec_foreach_index(jj, addrs)
+    {
+        lb = ip6_fib_table_fwding_lookup_by_length(&ip6_main, fib_index,
+                                                   &addrs[jj]);
+
+        FIB_TEST((lb == ip6_fib_table_fwding_lpm_lookup(&ip6_main, fib_index,
+                                                        &addrs[jj])),
+                 "LPM: %U -> %d, expected %d",
+                 format_ip6_address, &addrs[jj],
+                 ip6_fib_table_fwding_lpm_lookup(&ip6_main, fib_index,
+                                                 &addrs[jj]),
+                 lb);
+    }
+
+    t[0] = vlib_time_now(vm);
+    for (jj = 0; jj < n_lookups; jj++)
+    {
+        acc += ip6_fib_table_fwding_lookup_by_length(&ip6_main, fib_index,
+                                                     &addrs[jj & (n_addrs - 1)]);
+    }
+    t[1] = vlib_time_now(vm);
+    vlib_cli_output(vm, "%-16s lookup: %.6e lookups/sec",
+                    "by-length", n_lookups / (t[1] - t[0]));
+
+    t[0] = vlib_time_now(vm);
+    for (jj = 0; jj < n_lookups; jj++)
+    {
+        acc += ip6_fib_table_fwding_lpm_lookup(&ip6_main, fib_index,
+                                               &addrs[jj & (n_addrs - 1)]);
+    }
+    t[1] = vlib_time_now(vm);
+    vlib_cli_output(vm, "%-16s lookup: %.6e lookups/sec",
+                    "binary-search", n_lookups / (t[1] - t[0]));
+    vlib_cli_output(vm, "(lookup checksum %wx)", acc);
+
+    /*
+     * the removals make the compiled table stale, so the data-plane
+     * reverts to the probe of each length.
+     */
+    vec_foreach_index(jj, pfxs)
+    {
+        fib_table_entry_special_remove(fib_index, &pfxs[jj],
+                                       FIB_SOURCE_SPECIAL);
+    }
+    FIB_TEST(!ip6_main.ip6_lpm.is_valid,
+             "LPM table is stale after removals");
+
+    fib_table_unlock(fib_index, FIB_PROTOCOL_IP6, FIB_SOURCE_API);
+    vec_free(addrs);
+    vec_free(pfxs);
+
+    return (0);
+}
+
 static clib_error_t *
 fib_test (vlib_main_t * vm, 
 	  unformat_input_t * input,
@@ -8825,6 +9255,14 @@ fib_test (vlib_main_t * vm,
     {
 	res += fib_test_bfd();
     }
+    else if (unformat (input, "mtrie"))
+    {
+	res += fib_test_mtrie(input);
+    }
+    else if (unformat (input, "ip6-lpm"))
+    {
+	res += fib_test_ip6_lpm(input);
+    }
     else
     {
 	res += fib_test_v4();
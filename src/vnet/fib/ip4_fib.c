@@ -400,6 +400,18 @@ ip4_fib_table_fwding_dpo_remove (ip4_fib_t *fib,
                             cover_dpo->dpoi_index);
 }
 
+void
+ip4_fib_table_bulk_begin (ip4_fib_t *fib)
+{
+    ip4_fib_mtrie_bulk_begin(&fib->mtrie);
+}
+
+void
+ip4_fib_table_bulk_end (ip4_fib_t *fib)
+{
+    ip4_fib_mtrie_bulk_end(&fib->mtrie);
+}
+
 void
 ip4_fib_table_walk (ip4_fib_t *fib,
                     fib_table_walk_fn_t fn,
@@ -98,6 +98,14 @@ extern void ip4_fib_table_walk(ip4_fib_t *fib,
                                fib_table_walk_fn_t fn,
                                void *ctx);
 
+/**
+ * @brief Bracket a bulk update of the table's forwarding entries, e.g. an
+ * initial table load, so the mtrie can defer the cost of building
+ * compressed plies until the update is complete.
+ */
+extern void ip4_fib_table_bulk_begin(ip4_fib_t *fib);
+extern void ip4_fib_table_bulk_end(ip4_fib_t *fib);
+
 /**
  * @brief Get the FIB at the given index
  */
@@ -365,6 +365,250 @@ ip6_fib_table_get_index_for_sw_if_index (u32 sw_if_index)
     return (ip6_main.fib_index_by_sw_if_index[sw_if_index]);
 }
 
+/**
+ * Wait this long after an update before compiling the fwding table, so a
+ * burst of updates is compiled only once.
+ */
+#define IP6_FIB_LPM_REBUILD_HOLDOFF 0.1
+
+static vlib_node_registration_t ip6_fib_lpm_process_node;
+
+/**
+ * The fwding table is changing, the compiled table is stale; lookups
+ * probe each length until it is rebuilt.
+ */
+static void
+ip6_fib_lpm_invalidate (void)
+{
+    ip6_fib_lpm_t *lpm = &ip6_main.ip6_lpm;
+
+    if (lpm->is_valid)
+    {
+	lpm->is_valid = 0;
+	CLIB_MEMORY_BARRIER();
+
+	vlib_process_signal_event(vlib_get_main(),
+				  ip6_fib_lpm_process_node.index,
+				  0, 0);
+    }
+}
+
+typedef struct ip6_fib_lpm_build_ctx_t_
+{
+    /**
+     * The table being built
+     */
+    BVT(clib_bihash) *h;
+
+    /**
+     * The prefix lengths it contains, shortest first
+     */
+    u8 *lengths;
+
+    /**
+     * The position in the lengths vector of each length
+     */
+    u8 index_by_length[129];
+
+    u32 n_markers;
+} ip6_fib_lpm_build_ctx_t;
+
+/**
+ * The LB index of the longest prefix in the fwding table that matches the
+ * marker
+ */
+static u32
+ip6_fib_lpm_best_match (const BVT(clib_bihash_kv) *marker)
+{
+    ip6_fib_table_instance_t *table;
+    BVT(clib_bihash_kv) kv, value;
+    int i, len;
+    u64 fib;
+
+    table = &ip6_main.ip6_table[IP6_FIB_TABLE_FWDING];
+    fib = marker->key[2] & ~0xffffffffULL;
+    len = marker->key[2] & 0xff;
+
+    for (i = 0; i < vec_len (table->prefix_lengths_in_search_order); i++)
+    {
+	int dst_address_length = table->prefix_lengths_in_search_order[i];
+	ip6_address_t * mask = &ip6_main.fib_masks[dst_address_length];
+
+	if (dst_address_length > len)
+	    continue;
+
+	kv.key[0] = marker->key[0] & mask->as_u64[0];
+	kv.key[1] = marker->key[1] & mask->as_u64[1];
+	kv.key[2] = fib | dst_address_length;
+
+	if (0 == BV(clib_bihash_search)(&table->ip6_hash, &kv, &value))
+	    return (value.value);
+    }
+
+    return (0);
+}
+
+static int
+ip6_fib_lpm_add_prefix (BVT(clib_bihash_kv) *kvp,
+			void *arg)
+{
+    ip6_fib_lpm_build_ctx_t *ctx = arg;
+
+    BV(clib_bihash_add_del)(ctx->h, kvp, 1);
+
+    return (1);
+}
+
+/**
+ * Add the markers the search for this prefix passes through; a marker is
+ * needed at each shorter length at which the search must move on to the
+ * longer lengths.
+ */
+static int
+ip6_fib_lpm_add_markers (BVT(clib_bihash_kv) *kvp,
+			 void *arg)
+{
+    ip6_fib_lpm_build_ctx_t *ctx = arg;
+    BVT(clib_bihash_kv) marker, value;
+    int lo, hi, mid, target;
+    u64 fib;
+
+    fib = kvp->key[2] & ~0xffffffffULL;
+    target = ctx->index_by_length[kvp->key[2] & 0xff];
+    lo = 0;
+    hi = vec_len (ctx->lengths) - 1;
+
+    while (lo <= hi)
+    {
+	ip6_address_t * mask;
+
+	mid = (lo + hi) >> 1;
+
+	if (mid == target)
+	    break;
+	if (mid > target)
+	{
+	    hi = mid - 1;
+	    continue;
+	}
+
+	mask = &ip6_main.fib_masks[ctx->lengths[mid]];
+	marker.key[0] = kvp->key[0] & mask->as_u64[0];
+	marker.key[1] = kvp->key[1] & mask->as_u64[1];
+	marker.key[2] = fib | ctx->lengths[mid];
+
+	/*
+	 * a prefix, or marker, at that length already steers the search
+	 */
+	if (0 != BV(clib_bihash_search)(ctx->h, &marker, &value))
+	{
+	    marker.value = ip6_fib_lpm_best_match(&marker);
+	    BV(clib_bihash_add_del)(ctx->h, &marker, 1);
+	    ctx->n_markers++;
+	}
+	lo = mid + 1;
+    }
+
+    return (1);
+}
+
+void
+ip6_fib_table_fwding_lpm_rebuild (void)
+{
+    ip6_fib_table_instance_t *table;
+    ip6_fib_lpm_build_ctx_t ctx;
+    ip6_main_t *im = &ip6_main;
+    ip6_fib_lpm_t *lpm;
+    u32 next;
+    f64 start;
+    int i;
+
+    start = vlib_time_now(vlib_get_main());
+    table = &im->ip6_table[IP6_FIB_TABLE_FWDING];
+    lpm = &im->ip6_lpm;
+    next = !lpm->active;
+
+    /*
+     * the route updates do not stop the workers, so one may still be
+     * searching the inactive table it picked up before the previous
+     * rebuild swapped it out. Wait for them to move on before emptying it.
+     */
+    vlib_rcu_synchronize(vlib_get_main());
+    if (NULL != lpm->ip6_hash[next].mheap)
+	BV(clib_bihash_free)(&lpm->ip6_hash[next]);
+
+    /* room for a marker per prefix */
+    BV(clib_bihash_init)(&lpm->ip6_hash[next],
+			 "ip6 FIB fwding LPM table",
+			 im->lookup_table_nbuckets,
+			 2 * im->lookup_table_size);
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.h = &lpm->ip6_hash[next];
+    ctx.lengths = lpm->prefix_lengths[next];
+    vec_reset_length(ctx.lengths);
+
+    for (i = vec_len (table->prefix_lengths_in_search_order) - 1; i >= 0; i--)
+    {
+	ctx.index_by_length[table->prefix_lengths_in_search_order[i]] =
+	    vec_len(ctx.lengths);
+	vec_add1(ctx.lengths, table->prefix_lengths_in_search_order[i]);
+    }
+    lpm->prefix_lengths[next] = ctx.lengths;
+
+    /*
+     * all prefixes first, so markers are only added where there is
+     * no prefix.
+     */
+    BV(clib_bihash_foreach_key_value_pair)(&table->ip6_hash,
+					   ip6_fib_lpm_add_prefix,
+					   &ctx);
+    BV(clib_bihash_foreach_key_value_pair)(&table->ip6_hash,
+					   ip6_fib_lpm_add_markers,
+					   &ctx);
+
+    lpm->n_markers = ctx.n_markers;
+    lpm->n_rebuilds++;
+    lpm->rebuild_time = vlib_time_now(vlib_get_main()) - start;
+
+    CLIB_MEMORY_BARRIER();
+    lpm->active = next;
+    lpm->is_valid = 1;
+}
+
+static uword
+ip6_fib_lpm_process (vlib_main_t * vm,
+		     vlib_node_runtime_t * rt,
+		     vlib_frame_t * f)
+{
+    while (1)
+    {
+	if (!ip6_main.ip6_lpm.is_valid)
+	{
+	    /*
+	     * let the burst of updates complete
+	     */
+	    vlib_process_suspend(vm, IP6_FIB_LPM_REBUILD_HOLDOFF);
+
+	    if (!ip6_main.ip6_lpm.is_valid)
+		ip6_fib_table_fwding_lpm_rebuild();
+	}
+
+	vlib_process_wait_for_event(vm);
+	vlib_process_get_events(vm, NULL);
+    }
+
+    return (0);
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (ip6_fib_lpm_process_node,static) = {
+    .function = ip6_fib_lpm_process,
+    .type = VLIB_NODE_TYPE_PROCESS,
+    .name = "ip6-fib-lpm-process",
+};
+/* *INDENT-ON* */
+
 void
 ip6_fib_table_fwding_dpo_update (u32 fib_index,
 				 const ip6_address_t *addr,
@@ -376,6 +620,8 @@ ip6_fib_table_fwding_dpo_update (u32 fib_index,
     ip6_address_t *mask;
     u64 fib;
 
+    ip6_fib_lpm_invalidate();
+
     table = &ip6_main.ip6_table[IP6_FIB_TABLE_FWDING];
     mask = &ip6_main.fib_masks[len];
     fib = ((u64)((fib_index))<<32);
@@ -406,6 +652,8 @@ ip6_fib_table_fwding_dpo_remove (u32 fib_index,
     ip6_address_t *mask;
     u64 fib;
 
+    ip6_fib_lpm_invalidate();
+
     table = &ip6_main.ip6_table[IP6_FIB_TABLE_FWDING];
     mask = &ip6_main.fib_masks[len];
     fib = ((u64)((fib_index))<<32);
@@ -544,6 +792,29 @@ count_routes_in_fib_at_prefix_length (BVT(clib_bihash_kv) * kvp,
   ap->count_by_prefix_length[mask_width]++;
 }
 
+static u8 *
+format_ip6_fib_lpm (u8 * s, va_list * args)
+{
+    ip6_fib_lpm_t *lpm = va_arg (*args, ip6_fib_lpm_t *);
+    u8 *len;
+
+    s = format(s, "%s, %d markers, %d rebuilds, last took %.6fs",
+	       (lpm->is_valid ? "valid" : "stale"),
+	       lpm->n_markers,
+	       lpm->n_rebuilds,
+	       lpm->rebuild_time);
+    s = format(s, "\n search lengths:");
+    vec_foreach(len, lpm->prefix_lengths[lpm->active])
+    {
+	s = format(s, " %d", *len);
+    }
+    if (NULL != lpm->ip6_hash[lpm->active].mheap)
+	s = format(s, "\n%U", BV(format_bihash),
+		   &lpm->ip6_hash[lpm->active], 0);
+
+    return (s);
+}
+
 static clib_error_t *
 ip6_show_fib (vlib_main_t * vm,
 	      unformat_input_t * input,
@@ -558,6 +829,7 @@ ip6_show_fib (vlib_main_t * vm,
     u32 mask_len  = 128;
     int table_id = -1, fib_index = ~0;
     int detail = 0;
+    int lpm = 0;
 
     verbose = 1;
     matching = 0;
@@ -584,10 +856,18 @@ ip6_show_fib (vlib_main_t * vm,
 	    ;
 	else if (unformat (input, "index %d", &fib_index))
 	    ;
+	else if (unformat (input, "lpm"))
+	    lpm = 1;
 	else
 	    break;
     }
 
+    if (lpm)
+    {
+	vlib_cli_output (vm, "%U", format_ip6_fib_lpm, &im6->ip6_lpm);
+	return (NULL);
+    }
+
     pool_foreach (fib_table, im6->fibs,
     ({
         fib_source_t source;
@@ -751,7 +1031,7 @@ ip6_show_fib (vlib_main_t * vm,
 /* *INDENT-OFF* */
 VLIB_CLI_COMMAND (ip6_show_fib_command, static) = {
     .path = "show ip6 fib",
-    .short_help = "show ip6 fib [summary] [table <table-id>] [index <fib-id>] [<ip6-addr>[/<width>]] [detail]",
+    .short_help = "show ip6 fib [summary] [table <table-id>] [index <fib-id>] [<ip6-addr>[/<width>]] [detail] [lpm]",
     .function = ip6_show_fib,
 };
 /* *INDENT-ON* */
@@ -63,10 +63,21 @@ extern void ip6_fib_table_walk(u32 fib_index,
                                fib_table_walk_fn_t fn,
                                void *ctx);
 
+/**
+ * @brief Compile the fwding table for the binary search on prefix lengths.
+ * This is done by a process after each burst of updates; this is for
+ * those that cannot wait.
+ */
+extern void ip6_fib_table_fwding_lpm_rebuild(void);
+
+/**
+ * @brief Forwarding lookup that probes the fwding table once per
+ * prefix length present, longest first.
+ */
 always_inline u32
-ip6_fib_table_fwding_lookup (ip6_main_t * im,
-                             u32 fib_index,
-                             const ip6_address_t * dst)
+ip6_fib_table_fwding_lookup_by_length (ip6_main_t * im,
+                                       u32 fib_index,
+                                       const ip6_address_t * dst)
 {
     ip6_fib_table_instance_t *table;
     int i, len;
@@ -102,6 +113,68 @@ ip6_fib_table_fwding_lookup (ip6_main_t * im,
     return 0;
 }
 
+/**
+ * @brief Forwarding lookup by binary search on the prefix lengths of the
+ * compiled table. A hit, on a prefix or a marker, means the best match is
+ * that entry's or a longer one, so the search continues with the longer
+ * lengths; a miss continues with the shorter.
+ */
+always_inline u32
+ip6_fib_table_fwding_lpm_lookup (ip6_main_t * im,
+                                 u32 fib_index,
+                                 const ip6_address_t * dst)
+{
+    BVT(clib_bihash_kv) kv, value;
+    ip6_address_t * mask;
+    ip6_fib_lpm_t *lpm;
+    int lo, hi, mid;
+    u32 active, best;
+    u8 *lengths;
+    u64 fib;
+
+    lpm = &ip6_main.ip6_lpm;
+    active = lpm->active;
+    lengths = lpm->prefix_lengths[active];
+    fib = ((u64)((fib_index))<<32);
+    best = 0;
+    lo = 0;
+    hi = vec_len (lengths) - 1;
+
+    while (lo <= hi)
+    {
+	mid = (lo + hi) >> 1;
+	mask = &ip6_main.fib_masks[lengths[mid]];
+
+	kv.key[0] = dst->as_u64[0] & mask->as_u64[0];
+	kv.key[1] = dst->as_u64[1] & mask->as_u64[1];
+	kv.key[2] = fib | lengths[mid];
+
+	if (0 == BV(clib_bihash_search_inline_2)(&lpm->ip6_hash[active],
+                                                  &kv, &value))
+	{
+	    best = value.value;
+	    lo = mid + 1;
+	}
+	else
+	{
+	    hi = mid - 1;
+	}
+    }
+
+    return (best);
+}
+
+always_inline u32
+ip6_fib_table_fwding_lookup (ip6_main_t * im,
+                             u32 fib_index,
+                             const ip6_address_t * dst)
+{
+    if (PREDICT_TRUE(ip6_main.ip6_lpm.is_valid))
+	return (ip6_fib_table_fwding_lpm_lookup(im, fib_index, dst));
+
+    return (ip6_fib_table_fwding_lookup_by_length(im, fib_index, dst));
+}
+
 /**
  * @brief return the DPO that the LB stacks on.
  */
@@ -70,33 +70,35 @@ format_worker_handoff_trace (u8 * s, va_list * args)
 
 vlib_node_registration_t handoff_node;
 
+#define foreach_worker_handoff_error			\
+  _(CONGESTION_DROP, "congestion drop")
+
+typedef enum
+{
+#define _(sym,str) WORKER_HANDOFF_ERROR_##sym,
+  foreach_worker_handoff_error
+#undef _
+    WORKER_HANDOFF_N_ERROR,
+} worker_handoff_error_t;
+
+static char *worker_handoff_error_strings[] = {
+#define _(sym,string) string,
+  foreach_worker_handoff_error
+#undef _
+};
+
 static uword
 worker_handoff_node_fn (vlib_main_t * vm,
 			vlib_node_runtime_t * node, vlib_frame_t * frame)
 {
   handoff_main_t *hm = &handoff_main;
-  vlib_thread_main_t *tm = vlib_get_thread_main ();
-  u32 n_left_from, *from;
-  static __thread vlib_frame_queue_elt_t **handoff_queue_elt_by_worker_index;
-  static __thread vlib_frame_queue_t **congested_handoff_queue_by_worker_index
-    = 0;
-  vlib_frame_queue_elt_t *hf = 0;
-  int i;
-  u32 n_left_to_next_worker = 0, *to_next_worker = 0;
+  u32 n_left_from, *from, n_enq;
+  u16 thread_indices[VLIB_FRAME_SIZE], *ti;
   u32 next_worker_index = 0;
-  u32 current_worker_index = ~0;
-
-  if (PREDICT_FALSE (handoff_queue_elt_by_worker_index == 0))
-    {
-      vec_validate (handoff_queue_elt_by_worker_index, tm->n_vlib_mains - 1);
-
-      vec_validate_init_empty (congested_handoff_queue_by_worker_index,
-			       hm->first_worker_index + hm->num_workers - 1,
-			       (vlib_frame_queue_t *) (~0));
-    }
 
   from = vlib_frame_vector_args (frame);
   n_left_from = frame->n_vectors;
+  ti = thread_indices;
 
   while (n_left_from > 0)
     {
@@ -147,34 +149,8 @@ worker_handoff_node_fn (vlib_main_t * vm,
 	index0 = hash % vec_len (ihd0->workers);
 
       next_worker_index += ihd0->workers[index0];
-
-      if (next_worker_index != current_worker_index)
-	{
-	  if (hf)
-	    hf->n_vectors = VLIB_FRAME_SIZE - n_left_to_next_worker;
-
-	  hf = vlib_get_worker_handoff_queue_elt (hm->frame_queue_index,
-						  next_worker_index,
-						  handoff_queue_elt_by_worker_index);
-
-	  n_left_to_next_worker = VLIB_FRAME_SIZE - hf->n_vectors;
-	  to_next_worker = &hf->buffer_index[hf->n_vectors];
-	  current_worker_index = next_worker_index;
-	}
-
-      /* enqueue to correct worker thread */
-      to_next_worker[0] = bi0;
-      to_next_worker++;
-      n_left_to_next_worker--;
-
-      if (n_left_to_next_worker == 0)
-	{
-	  hf->n_vectors = VLIB_FRAME_SIZE;
-	  vlib_put_frame_queue_elt (hf);
-	  current_worker_index = ~0;
-	  handoff_queue_elt_by_worker_index[next_worker_index] = 0;
-	  hf = 0;
-	}
+      ti[0] = next_worker_index;
+      ti += 1;
 
       if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE)
 			 && (b0->flags & VLIB_BUFFER_IS_TRACED)))
@@ -188,32 +164,19 @@ worker_handoff_node_fn (vlib_main_t * vm,
 
     }
 
-  if (hf)
-    hf->n_vectors = VLIB_FRAME_SIZE - n_left_to_next_worker;
+  /*
+   * Ship frames to the worker nodes. Full frames go at once, partial
+   * frames are coalesced across calls, see vlib_frame_queue_flush.
+   */
+  n_enq = vlib_frame_queue_enqueue_buffers (vm, hm->frame_queue_index,
+					    vlib_frame_vector_args (frame),
+					    thread_indices, frame->n_vectors);
+
+  if (n_enq < frame->n_vectors)
+    vlib_node_increment_counter (vm, node->node_index,
+				 WORKER_HANDOFF_ERROR_CONGESTION_DROP,
+				 frame->n_vectors - n_enq);
 
-  /* Ship frames to the worker nodes */
-  for (i = 0; i < vec_len (handoff_queue_elt_by_worker_index); i++)
-    {
-      if (handoff_queue_elt_by_worker_index[i])
-	{
-	  hf = handoff_queue_elt_by_worker_index[i];
-	  /*
-	   * It works better to let the handoff node
-	   * rate-adapt, always ship the handoff queue element.
-	   */
-	  if (1 || hf->n_vectors == hf->last_n_vectors)
-	    {
-	      vlib_put_frame_queue_elt (hf);
-	      handoff_queue_elt_by_worker_index[i] = 0;
-	    }
-	  else
-	    hf->last_n_vectors = hf->n_vectors;
-	}
-      congested_handoff_queue_by_worker_index[i] =
-	(vlib_frame_queue_t *) (~0);
-    }
-  hf = 0;
-  current_worker_index = ~0;
   return frame->n_vectors;
 }
 
@@ -224,6 +187,8 @@ VLIB_REGISTER_NODE (worker_handoff_node) = {
   .vector_size = sizeof (u32),
   .format_trace = format_worker_handoff_trace,
   .type = VLIB_NODE_TYPE_INTERNAL,
+  .n_errors = ARRAY_LEN (worker_handoff_error_strings),
+  .error_strings = worker_handoff_error_strings,
 
   .n_next_nodes = 1,
   .next_nodes = {
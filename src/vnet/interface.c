@@ -707,7 +707,8 @@ vnet_register_interface (vnet_main_t * vnm,
 
   hw_index = hw - im->hw_interfaces;
   hw->hw_if_index = hw_index;
-  hw->default_rx_mode = VNET_HW_INTERFACE_RX_MODE_POLLING;
+  hw->default_rx_mode = vlib_global_main.adaptive_input ?
+    VNET_HW_INTERFACE_RX_MODE_ADAPTIVE : VNET_HW_INTERFACE_RX_MODE_POLLING;
 
   if (dev_class->format_device_name)
     hw->name = format (0, "%U", dev_class->format_device_name, dev_instance);
@@ -841,6 +842,8 @@ vnet_register_interface (vnet_main_t * vnm,
 	static char *e[] = {
 	  "interface is down",
 	  "interface is deleted",
+	  "no buffers to segment gso packet",
+	  "gso segment larger than a buffer",
 	};
 
 	r.n_errors = ARRAY_LEN (e);
@@ -1210,6 +1213,8 @@ vnet_interface_init (vlib_main_t * vm)
 
   im->sw_if_counter_lock[0] = 0;
 
+  vec_validate (im->gso_buffers, vlib_get_thread_main ()->n_vlib_mains - 1);
+
   im->device_class_by_name = hash_create_string ( /* size */ 0,
 						 sizeof (uword));
   {
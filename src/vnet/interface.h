@@ -422,6 +422,9 @@ typedef struct vnet_hw_interface_t
   /* tx checksum offload */
 #define VNET_HW_INTERFACE_FLAG_SUPPORTS_TX_L4_CKSUM_OFFLOAD (1 << 11)
 
+  /* tcp segmentation offload, segments VNET_BUFFER_F_GSO buffers */
+#define VNET_HW_INTERFACE_FLAG_SUPPORTS_GSO (1 << 12)
+
   /* Hardware address as vector.  Zero (e.g. zero-length vector) if no
      address for this class (e.g. PPP). */
   u8 *hw_address;
@@ -679,6 +682,12 @@ typedef struct
 
   /* feature_arc_index */
   u8 output_feature_arc_index;
+
+  /* Set if some node may emit VNET_BUFFER_F_GSO buffers */
+  u8 gso_enabled;
+
+  /* Per-thread scratch vector of segmented buffer indices */
+  u32 **gso_buffers;
 } vnet_interface_main_t;
 
 static inline void
@@ -1304,7 +1304,7 @@ set_hw_interface_rx_mode (vnet_main_t * vnm, u32 hw_if_index,
   int rv;
 
   if (mode == VNET_HW_INTERFACE_RX_MODE_DEFAULT)
-    mode = hw->default_rx_mode;
+    mode = vnet_hw_interface_default_rx_mode (hw);
 
   rv = vnet_hw_interface_get_rx_mode (vnm, hw_if_index, queue_id, &old_mode);
   switch (rv)
@@ -336,6 +336,8 @@ typedef enum
 {
   VNET_INTERFACE_OUTPUT_ERROR_INTERFACE_DOWN,
   VNET_INTERFACE_OUTPUT_ERROR_INTERFACE_DELETED,
+  VNET_INTERFACE_OUTPUT_ERROR_NO_BUFFERS_FOR_GSO,
+  VNET_INTERFACE_OUTPUT_ERROR_GSO_SEGMENT_TOO_BIG,
 } vnet_interface_output_error_t;
 
 /* Format for interface output traces. */
@@ -199,6 +199,185 @@ calc_checksums (vlib_main_t * vm, vlib_buffer_t * b)
   b->flags &= ~VNET_BUFFER_F_OFFLOAD_IP_CKSUM;
 }
 
+/* Buffer flags inherited by the segments of a GSO buffer */
+#define VNET_GSO_SEGMENT_FLAGS				\
+  (VNET_BUFFER_F_LOCALLY_ORIGINATED | VNET_BUFFER_F_IS_IP4	\
+   | VNET_BUFFER_F_IS_IP6 | VNET_BUFFER_F_OFFLOAD_IP_CKSUM	\
+   | VNET_BUFFER_F_OFFLOAD_TCP_CKSUM | VNET_BUFFER_F_L2_HDR_OFFSET_VALID \
+   | VNET_BUFFER_F_L3_HDR_OFFSET_VALID | VNET_BUFFER_F_L4_HDR_OFFSET_VALID)
+
+/**
+ * Split a GSO buffer into segments that carry at most gso.size bytes of
+ * payload. Headers, up to and including tcp options, are replicated in
+ * every segment at the same offsets and the ip length, tcp sequence number
+ * and flags are fixed up. Checksums are left to the offload flags the
+ * segments inherit. Appends the segments to @a segs and frees the original.
+ * Each segment goes out in a single buffer, so a gso.size that does not fit
+ * one next to the headers is refused.
+ *
+ * @return number of segments, 0 if out of buffers, ~0 if a segment does
+ *         not fit in a buffer
+ */
+static u32
+vnet_gso_segment_buffer (vlib_main_t * vm, u32 bi, u32 ** segs)
+{
+  vlib_buffer_t *b, *sb, *nb;
+  u32 hdr_len, l2_len, left, seg_len, n_copy, src_off, seq, i;
+  u32 n_segs, n_alloc, n_segs_before, *seg_bis;
+  u16 gso_size;
+  u8 *hdr, *dst, tcp_flags;
+  tcp_header_t *th;
+
+  b = vlib_get_buffer (vm, bi);
+  gso_size = vnet_buffer2 (b)->gso.size;
+  hdr = vlib_buffer_get_current (b);
+  th = (tcp_header_t *) (b->data + vnet_buffer (b)->l4_hdr_offset);
+  hdr_len = (u8 *) th + vnet_buffer2 (b)->gso.l4_hdr_sz - hdr;
+  l2_len = vnet_buffer (b)->l3_hdr_offset - b->current_data;
+
+  if (PREDICT_FALSE (gso_size == 0 || hdr_len > b->current_length
+		     || b->current_data + hdr_len + gso_size >
+		     vlib_buffer_free_list_buffer_size
+		     (vm, VLIB_BUFFER_DEFAULT_FREE_LIST_INDEX)))
+    return ~0;
+
+  left = vlib_buffer_length_in_chain (vm, b) - hdr_len;
+  n_segs = (left + gso_size - 1) / gso_size;
+
+  n_segs_before = vec_len (*segs);
+  vec_validate (*segs, n_segs_before + n_segs - 1);
+  seg_bis = *segs + n_segs_before;
+  n_alloc = vlib_buffer_alloc (vm, seg_bis, n_segs);
+  if (PREDICT_FALSE (n_alloc != n_segs))
+    {
+      if (n_alloc)
+	vlib_buffer_free (vm, seg_bis, n_alloc);
+      _vec_len (*segs) = n_segs_before;
+      return 0;
+    }
+
+  seq = clib_net_to_host_u32 (th->seq_number);
+  tcp_flags = th->flags;
+  sb = b;
+  src_off = hdr_len;
+
+  for (i = 0; i < n_segs; i++)
+    {
+      ip4_header_t *ip4;
+      ip6_header_t *ip6;
+      tcp_header_t *nth;
+
+      nb = vlib_get_buffer (vm, seg_bis[i]);
+      nb->current_data = b->current_data;
+      dst = vlib_buffer_get_current (nb);
+      clib_memcpy (dst, hdr, hdr_len);
+      dst += hdr_len;
+
+      seg_len = clib_min (gso_size, left);
+      nb->current_length = hdr_len + seg_len;
+      left -= seg_len;
+
+      /* Copy payload, walking the original chain */
+      n_copy = seg_len;
+      while (n_copy)
+	{
+	  u32 len;
+	  if (src_off == sb->current_length)
+	    {
+	      ASSERT (sb->flags & VLIB_BUFFER_NEXT_PRESENT);
+	      sb = vlib_get_buffer (vm, sb->next_buffer);
+	      src_off = 0;
+	    }
+	  len = clib_min (n_copy, sb->current_length - src_off);
+	  clib_memcpy (dst, vlib_buffer_get_current (sb) + src_off, len);
+	  dst += len;
+	  src_off += len;
+	  n_copy -= len;
+	}
+
+      clib_memcpy (nb->opaque, b->opaque, sizeof (b->opaque));
+      nb->flags = (nb->flags & VLIB_BUFFER_FREE_LIST_INDEX_MASK)
+	| (b->flags & VNET_GSO_SEGMENT_FLAGS);
+      nb->total_length_not_including_first_buffer = 0;
+      nb->error = b->error;
+
+      if (b->flags & VNET_BUFFER_F_IS_IP4)
+	{
+	  ip4 = (ip4_header_t *) (nb->data + vnet_buffer (b)->l3_hdr_offset);
+	  ip4->length = clib_host_to_net_u16 (nb->current_length - l2_len);
+	}
+      else
+	{
+	  ip6 = (ip6_header_t *) (nb->data + vnet_buffer (b)->l3_hdr_offset);
+	  ip6->payload_length =
+	    clib_host_to_net_u16 (nb->current_length - l2_len
+				  - sizeof (*ip6));
+	}
+
+      /* FIN and PSH go on the last segment only, CWR on the first */
+      nth = (tcp_header_t *) (nb->data + vnet_buffer (b)->l4_hdr_offset);
+      nth->seq_number = clib_host_to_net_u32 (seq);
+      nth->flags = tcp_flags;
+      if (i != n_segs - 1)
+	nth->flags &= ~(TCP_FLAG_FIN | TCP_FLAG_PSH);
+      if (i)
+	nth->flags &= ~TCP_FLAG_CWR;
+      seq += seg_len;
+    }
+
+  vlib_buffer_free (vm, &bi, 1);
+  return n_segs;
+}
+
+/**
+ * Replace the GSO buffers in a frame with their segments
+ *
+ * @return vector of buffers to be sent, valid until the next call
+ */
+static u32 *
+vnet_interface_output_gso (vlib_main_t * vm, vlib_node_runtime_t * node,
+			   vnet_interface_main_t * im, u32 * from,
+			   u32 * n_buffers)
+{
+  u32 thread_index = vm->thread_index;
+  u32 *segs = im->gso_buffers[thread_index];
+  vlib_buffer_t *b0;
+  u32 i, n_segs, n_no_buffers = 0, n_too_big = 0;
+
+  vec_reset_length (segs);
+  for (i = 0; i < *n_buffers; i++)
+    {
+      b0 = vlib_get_buffer (vm, from[i]);
+      if (PREDICT_TRUE (!(b0->flags & VNET_BUFFER_F_GSO)))
+	{
+	  vec_add1 (segs, from[i]);
+	  continue;
+	}
+      n_segs = vnet_gso_segment_buffer (vm, from[i], &segs);
+      if (PREDICT_FALSE (n_segs == 0 || n_segs == ~0))
+	{
+	  vlib_buffer_free (vm, &from[i], 1);
+	  if (n_segs)
+	    n_too_big++;
+	  else
+	    n_no_buffers++;
+	}
+    }
+
+  if (n_no_buffers)
+    vlib_error_count (vm, node->node_index,
+		      VNET_INTERFACE_OUTPUT_ERROR_NO_BUFFERS_FOR_GSO,
+		      n_no_buffers);
+  if (n_too_big)
+    vlib_error_count (vm, node->node_index,
+		      VNET_INTERFACE_OUTPUT_ERROR_GSO_SEGMENT_TOO_BIG,
+		      n_too_big);
+
+  im->gso_buffers[thread_index] = segs;
+  *n_buffers = vec_len (segs);
+  return segs;
+}
+
 static_always_inline uword
 vnet_interface_output_node_inline (vlib_main_t * vm,
 				   vlib_node_runtime_t * node,
@@ -253,6 +432,11 @@ vnet_interface_output_node_inline (vlib_main_t * vm,
 				      VNET_INTERFACE_OUTPUT_ERROR_INTERFACE_DOWN);
     }
 
+  /* Segment in software what the device can't */
+  if (PREDICT_FALSE (im->gso_enabled
+		     && !(hi->flags & VNET_HW_INTERFACE_FLAG_SUPPORTS_GSO)))
+    from = vnet_interface_output_gso (vm, node, im, from, &n_buffers);
+
   from_end = from + n_buffers;
 
   /* Total byte count of all buffers. */
@@ -440,7 +624,7 @@ vnet_interface_output_node_inline (vlib_main_t * vm,
 				   + VNET_INTERFACE_COUNTER_TX,
 				   thread_index,
 				   rt->sw_if_index, n_packets, n_bytes);
-  return n_buffers;
+  return frame->n_vectors;
 }
 
 static_always_inline uword
@@ -179,6 +179,23 @@ ip_incremental_checksum_buffer (vlib_main_t * vm,
   return sum;
 }
 
+/**
+ * Length to check against the outgoing mtu. GSO buffers sent straight to
+ * interface-output are segmented to size before they reach the wire, so
+ * they always fit. Midchain (tunnel) adjacencies and output features
+ * encapsulate or transform the super-segment first, so there it is
+ * checked whole.
+ */
+always_inline u32
+ip_buffer_mtu_check_length (vlib_main_t * vm, vlib_buffer_t * b,
+			    const ip_adjacency_t * adj, int is_midchain)
+{
+  if (PREDICT_FALSE (b->flags & VNET_BUFFER_F_GSO) && !is_midchain
+      && !(adj->rewrite_header.flags & VNET_REWRITE_HAS_FEATURES))
+    return 0;
+  return vlib_buffer_length_in_chain (vm, b);
+}
+
 void ip_del_all_interface_addresses (vlib_main_t * vm, u32 sw_if_index);
 
 extern vlib_node_registration_t ip4_inacl_node;
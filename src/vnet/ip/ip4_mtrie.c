@@ -47,6 +47,18 @@
  */
 ip4_fib_mtrie_8_ply_t *ip4_ply_pool;
 
+/**
+ * Global pool of compressed IPv4 8bit PLYs
+ */
+ip4_fib_mtrie_c_ply_t **ip4_c_ply_pool;
+
+/**
+ * The type of ply new mtries are created with
+ */
+ip4_fib_mtrie_ply_type_t ip4_fib_mtrie_default_ply_type;
+
+static const char *ip4_fib_mtrie_ply_type_names[] = IP4_FIB_MTRIE_PLY_TYPES;
+
 always_inline u32
 ip4_fib_mtrie_leaf_is_non_empty (ip4_fib_mtrie_8_ply_t * p, u8 dst_byte)
 {
@@ -79,15 +91,25 @@ always_inline u32
 ip4_fib_mtrie_leaf_get_next_ply_index (ip4_fib_mtrie_leaf_t n)
 {
   ASSERT (ip4_fib_mtrie_leaf_is_next_ply (n));
-  return n >> 1;
+  return n >> 2;
 }
 
 always_inline ip4_fib_mtrie_leaf_t
 ip4_fib_mtrie_leaf_set_next_ply_index (u32 i)
 {
   ip4_fib_mtrie_leaf_t l;
-  l = 0 + 2 * i;
+  l = 0 + 4 * i;
+  ASSERT (ip4_fib_mtrie_leaf_get_next_ply_index (l) == i);
+  return l;
+}
+
+always_inline ip4_fib_mtrie_leaf_t
+ip4_fib_mtrie_leaf_set_next_c_ply_index (u32 i)
+{
+  ip4_fib_mtrie_leaf_t l;
+  l = 2 + 4 * i;
   ASSERT (ip4_fib_mtrie_leaf_get_next_ply_index (l) == i);
+  ASSERT (ip4_fib_mtrie_leaf_is_c_ply (l));
   return l;
 }
 
@@ -170,6 +192,101 @@ ply_16_init (ip4_fib_mtrie_16_ply_t * p,
   PLY_INIT_LEAVES (p);
 }
 
+/**
+ * The prefix lengths of a compressed ply's runs follow its leaves
+ */
+always_inline u8 *
+c_ply_dst_address_bits_of_leaves (const ip4_fib_mtrie_c_ply_t * cp)
+{
+  return ((u8 *) (cp->leaves + cp->n_leaves));
+}
+
+always_inline uword
+c_ply_size (u32 n_leaves)
+{
+  return (sizeof (ip4_fib_mtrie_c_ply_t) +
+	  n_leaves * (sizeof (ip4_fib_mtrie_leaf_t) + sizeof (u8)));
+}
+
+always_inline u32
+c_ply_slot_starts_run (const ip4_fib_mtrie_c_ply_t * cp, u32 slot)
+{
+  return ((cp->bitmap[slot >> 6] >> (slot & 63)) & 1);
+}
+
+/**
+ * Build the compressed form of a full ply
+ */
+static ip4_fib_mtrie_c_ply_t *
+c_ply_compress (const ip4_fib_mtrie_8_ply_t * p)
+{
+  ip4_fib_mtrie_c_ply_t *cp;
+  u32 i, n_leaves, run;
+  u8 *bits;
+
+  /*
+   * A run ends when either the leaf or its prefix length changes; the
+   * length is needed by the control plane to decide whether a more
+   * specific route replaces the slot.
+   */
+  n_leaves = 1;
+  for (i = 1; i < ARRAY_LEN (p->leaves); i++)
+    if (p->leaves[i] != p->leaves[i - 1] ||
+	p->dst_address_bits_of_leaves[i] !=
+	p->dst_address_bits_of_leaves[i - 1])
+      n_leaves++;
+
+  cp = clib_mem_alloc_aligned (c_ply_size (n_leaves), CLIB_CACHE_LINE_BYTES);
+  memset (cp, 0, sizeof (*cp));
+  cp->n_leaves = n_leaves;
+  cp->dst_address_bits_base = p->dst_address_bits_base;
+  bits = c_ply_dst_address_bits_of_leaves (cp);
+
+  run = 0;
+  for (i = 0; i < ARRAY_LEN (p->leaves); i++)
+    {
+      if (0 == (i & 63))
+	cp->base[i >> 6] = run;
+
+      if (0 == i ||
+	  p->leaves[i] != p->leaves[i - 1] ||
+	  p->dst_address_bits_of_leaves[i] !=
+	  p->dst_address_bits_of_leaves[i - 1])
+	{
+	  cp->bitmap[i >> 6] |= 1ULL << (i & 63);
+	  cp->leaves[run] = p->leaves[i];
+	  bits[run] = p->dst_address_bits_of_leaves[i];
+	  run++;
+	}
+    }
+  ASSERT (run == n_leaves);
+
+  return (cp);
+}
+
+/**
+ * Expand a compressed ply into a full ply that the control plane can modify
+ */
+static void
+c_ply_expand (const ip4_fib_mtrie_c_ply_t * cp, ip4_fib_mtrie_8_ply_t * p)
+{
+  const u8 *bits;
+  i32 i, run;
+
+  bits = c_ply_dst_address_bits_of_leaves (cp);
+  p->dst_address_bits_base = cp->dst_address_bits_base;
+  p->n_non_empty_leafs = 0;
+  run = -1;
+
+  for (i = 0; i < ARRAY_LEN (p->leaves); i++)
+    {
+      run += c_ply_slot_starts_run (cp, i);
+      p->leaves[i] = cp->leaves[run];
+      p->dst_address_bits_of_leaves[i] = bits[run];
+      p->n_non_empty_leafs += ip4_fib_mtrie_leaf_is_non_empty (p, i);
+    }
+}
+
 static ip4_fib_mtrie_leaf_t
 ply_create (ip4_fib_mtrie_t * m,
 	    ip4_fib_mtrie_leaf_t init_leaf,
@@ -177,8 +294,23 @@ ply_create (ip4_fib_mtrie_t * m,
 {
   ip4_fib_mtrie_8_ply_t *p;
 
+  if (IP4_FIB_MTRIE_PLY_TYPE_COMPRESSED == m->ply_type && !m->in_bulk)
+    {
+      ip4_fib_mtrie_c_ply_t **cpp;
+      ip4_fib_mtrie_8_ply_t scratch;
+
+      p = &scratch;
+      ply_8_init (p, init_leaf, leaf_prefix_len, ply_base_len);
+
+      vlib_pool_get_mt (ip4_c_ply_pool, cpp);
+      *cpp = c_ply_compress (p);
+
+      return (ip4_fib_mtrie_leaf_set_next_c_ply_index
+	      (cpp - ip4_c_ply_pool));
+    }
+
   /* Get cache aligned ply. */
-  pool_get_aligned (ip4_ply_pool, p, CLIB_CACHE_LINE_BYTES);
+  vlib_pool_get_aligned_mt (ip4_ply_pool, p, CLIB_CACHE_LINE_BYTES);
 
   ply_8_init (p, init_leaf, leaf_prefix_len, ply_base_len);
   return ip4_fib_mtrie_leaf_set_next_ply_index (p - ip4_ply_pool);
@@ -189,9 +321,79 @@ get_next_ply_for_leaf (ip4_fib_mtrie_t * m, ip4_fib_mtrie_leaf_t l)
 {
   uword n = ip4_fib_mtrie_leaf_get_next_ply_index (l);
 
+  ASSERT (!ip4_fib_mtrie_leaf_is_c_ply (l));
   return pool_elt_at_index (ip4_ply_pool, n);
 }
 
+/**
+ * Get the ply the non-terminal leaf refers to in a form that can be
+ * modified. A full ply is modified in place, a compressed ply is expanded
+ * into the caller's scratch ply and written back with ply_8_commit()
+ */
+always_inline ip4_fib_mtrie_8_ply_t *
+ply_8_get (ip4_fib_mtrie_t * m,
+	   ip4_fib_mtrie_leaf_t l, ip4_fib_mtrie_8_ply_t * scratch)
+{
+  if (ip4_fib_mtrie_leaf_is_c_ply (l))
+    {
+      c_ply_expand (ip4_c_ply_pool[ip4_fib_mtrie_leaf_get_next_ply_index
+				   (l)], scratch);
+      return (scratch);
+    }
+  return (get_next_ply_for_leaf (m, l));
+}
+
+/**
+ * Publish the modifications made to the ply obtained from ply_8_get()
+ */
+static void
+ply_8_commit (ip4_fib_mtrie_t * m,
+	      ip4_fib_mtrie_leaf_t l, const ip4_fib_mtrie_8_ply_t * p)
+{
+  ip4_fib_mtrie_c_ply_t *old, *new;
+  u32 index;
+
+  if (!ip4_fib_mtrie_leaf_is_c_ply (l))
+    /* modified in place */
+    return;
+
+  index = ip4_fib_mtrie_leaf_get_next_ply_index (l);
+  old = ip4_c_ply_pool[index];
+  new = c_ply_compress (p);
+
+  /*
+   * the new ply must be complete before the data-plane can see it,
+   * and the old one stays until the workers are done with it.
+   */
+  CLIB_MEMORY_BARRIER ();
+  ip4_c_ply_pool[index] = new;
+  vlib_rcu_call (vlib_get_main (), clib_mem_free, old);
+}
+
+static void
+ply_8_put (void *arg)
+{
+  ip4_fib_mtrie_leaf_t l = pointer_to_uword (arg);
+  u32 index;
+
+  index = ip4_fib_mtrie_leaf_get_next_ply_index (l);
+
+  if (ip4_fib_mtrie_leaf_is_c_ply (l))
+    {
+      clib_mem_free (ip4_c_ply_pool[index]);
+      pool_put_index (ip4_c_ply_pool, index);
+    }
+  else
+    pool_put_index (ip4_ply_pool, index);
+}
+
+static void
+ply_8_free (ip4_fib_mtrie_t * m, ip4_fib_mtrie_leaf_t l)
+{
+  /* a worker may still be walking the ply, do not reuse it yet */
+  vlib_rcu_call (vlib_get_main (), ply_8_put, uword_to_pointer (l, void *));
+}
+
 void
 ip4_mtrie_free (ip4_fib_mtrie_t * m)
 {
@@ -209,9 +411,17 @@ ip4_mtrie_free (ip4_fib_mtrie_t * m)
 }
 
 void
-ip4_mtrie_init (ip4_fib_mtrie_t * m)
+ip4_mtrie_init_w_type (ip4_fib_mtrie_t * m, ip4_fib_mtrie_ply_type_t type)
 {
   ply_16_init (&m->root_ply, IP4_FIB_MTRIE_LEAF_EMPTY, 0);
+  m->ply_type = type;
+  m->in_bulk = 0;
+}
+
+void
+ip4_mtrie_init (ip4_fib_mtrie_t * m)
+{
+  ip4_mtrie_init_w_type (m, ip4_fib_mtrie_default_ply_type);
 }
 
 typedef struct
@@ -225,15 +435,18 @@ typedef struct
 
 static void
 set_ply_with_more_specific_leaf (ip4_fib_mtrie_t * m,
-				 ip4_fib_mtrie_8_ply_t * ply,
+				 ip4_fib_mtrie_leaf_t ply_leaf,
 				 ip4_fib_mtrie_leaf_t new_leaf,
 				 uword new_leaf_dst_address_bits)
 {
+  ip4_fib_mtrie_8_ply_t scratch, *ply;
   ip4_fib_mtrie_leaf_t old_leaf;
   uword i;
 
   ASSERT (ip4_fib_mtrie_leaf_is_terminal (new_leaf));
 
+  ply = ply_8_get (m, ply_leaf, &scratch);
+
   for (i = 0; i < ARRAY_LEN (ply->leaves); i++)
     {
       old_leaf = ply->leaves[i];
@@ -241,9 +454,7 @@ set_ply_with_more_specific_leaf (ip4_fib_mtrie_t * m,
       /* Recurse into sub plies. */
       if (!ip4_fib_mtrie_leaf_is_terminal (old_leaf))
 	{
-	  ip4_fib_mtrie_8_ply_t *sub_ply =
-	    get_next_ply_for_leaf (m, old_leaf);
-	  set_ply_with_more_specific_leaf (m, sub_ply, new_leaf,
+	  set_ply_with_more_specific_leaf (m, old_leaf, new_leaf,
 					   new_leaf_dst_address_bits);
 	}
 
@@ -257,19 +468,21 @@ set_ply_with_more_specific_leaf (ip4_fib_mtrie_t * m,
 	  ply->n_non_empty_leafs += ip4_fib_mtrie_leaf_is_non_empty (ply, i);
 	}
     }
+
+  ply_8_commit (m, ply_leaf, ply);
 }
 
 static void
 set_leaf (ip4_fib_mtrie_t * m,
 	  const ip4_fib_mtrie_set_unset_leaf_args_t * a,
-	  u32 old_ply_index, u32 dst_address_byte_index)
+	  ip4_fib_mtrie_leaf_t old_ply_leaf, u32 dst_address_byte_index)
 {
   ip4_fib_mtrie_leaf_t old_leaf, new_leaf;
   i32 n_dst_bits_next_plies;
   u8 dst_byte;
-  ip4_fib_mtrie_8_ply_t *old_ply;
+  ip4_fib_mtrie_8_ply_t scratch, *old_ply;
 
-  old_ply = pool_elt_at_index (ip4_ply_pool, old_ply_index);
+  old_ply = ply_8_get (m, old_ply_leaf, &scratch);
 
   ASSERT (a->dst_address_length <= 32);
   ASSERT (dst_address_byte_index < ARRAY_LEN (a->dst_address.as_u8));
@@ -296,8 +509,6 @@ set_leaf (ip4_fib_mtrie_t * m,
        * fill the buckets/slots of the ply */
       for (i = dst_byte; i < dst_byte + (1 << n_dst_bits_this_ply); i++)
 	{
-	  ip4_fib_mtrie_8_ply_t *new_ply;
-
 	  old_leaf = old_ply->leaves[i];
 	  old_leaf_is_terminal = ip4_fib_mtrie_leaf_is_terminal (old_leaf);
 
@@ -329,8 +540,7 @@ set_leaf (ip4_fib_mtrie_t * m,
 		{
 		  /* Existing leaf points to another ply.  We need to place
 		   * new_leaf into all more specific slots. */
-		  new_ply = get_next_ply_for_leaf (m, old_leaf);
-		  set_ply_with_more_specific_leaf (m, new_ply, new_leaf,
+		  set_ply_with_more_specific_leaf (m, old_leaf, new_leaf,
 						   a->dst_address_length);
 		}
 	    }
@@ -338,9 +548,7 @@ set_leaf (ip4_fib_mtrie_t * m,
 	    {
 	      /* The current leaf is less specific and not termial (i.e. a ply),
 	       * recurse on down the trie */
-	      new_ply = get_next_ply_for_leaf (m, old_leaf);
-	      set_leaf (m, a, new_ply - ip4_ply_pool,
-			dst_address_byte_index + 1);
+	      set_leaf (m, a, old_leaf, dst_address_byte_index + 1);
 	    }
 	  /*
 	   * else
@@ -348,12 +556,13 @@ set_leaf (ip4_fib_mtrie_t * m,
 	   *  occupying this slot. leave it there
 	   */
 	}
+
+      ply_8_commit (m, old_ply_leaf, old_ply);
     }
   else
     {
       /* The address to insert requires us to move down at a lower level of
        * the trie - recurse on down */
-      ip4_fib_mtrie_8_ply_t *new_ply;
       u8 ply_base_len;
 
       ply_base_len = 8 * (dst_address_byte_index + 1);
@@ -363,17 +572,17 @@ set_leaf (ip4_fib_mtrie_t * m,
       if (ip4_fib_mtrie_leaf_is_terminal (old_leaf))
 	{
 	  /* There is a leaf occupying the slot. Replace it with a new ply */
-	  old_ply->n_non_empty_leafs -=
-	    ip4_fib_mtrie_leaf_is_non_empty (old_ply, dst_byte);
-
 	  new_leaf = ply_create (m, old_leaf,
 				 clib_max (old_ply->dst_address_bits_of_leaves
 					   [dst_byte], ply_base_len),
 				 ply_base_len);
-	  new_ply = get_next_ply_for_leaf (m, new_leaf);
 
 	  /* Refetch since ply_create may move pool. */
-	  old_ply = pool_elt_at_index (ip4_ply_pool, old_ply_index);
+	  if (!ip4_fib_mtrie_leaf_is_c_ply (old_ply_leaf))
+	    old_ply = get_next_ply_for_leaf (m, old_ply_leaf);
+
+	  old_ply->n_non_empty_leafs -=
+	    ip4_fib_mtrie_leaf_is_non_empty (old_ply, dst_byte);
 
 	  __sync_val_compare_and_swap (&old_ply->leaves[dst_byte], old_leaf,
 				       new_leaf);
@@ -383,11 +592,13 @@ set_leaf (ip4_fib_mtrie_t * m,
 	  old_ply->n_non_empty_leafs +=
 	    ip4_fib_mtrie_leaf_is_non_empty (old_ply, dst_byte);
 	  ASSERT (old_ply->n_non_empty_leafs >= 0);
+
+	  ply_8_commit (m, old_ply_leaf, old_ply);
 	}
       else
-	new_ply = get_next_ply_for_leaf (m, old_leaf);
+	new_leaf = old_leaf;
 
-      set_leaf (m, a, new_ply - ip4_ply_pool, dst_address_byte_index + 1);
+      set_leaf (m, a, new_leaf, dst_address_byte_index + 1);
     }
 }
 
@@ -425,7 +636,6 @@ set_root_leaf (ip4_fib_mtrie_t * m,
        * fill the buckets/slots of the ply */
       for (i = 0; i < (1 << n_dst_bits_this_ply); i++)
 	{
-	  ip4_fib_mtrie_8_ply_t *new_ply;
 	  u16 slot;
 
 	  slot = clib_net_to_host_u16 (dst_byte);
@@ -456,8 +666,7 @@ set_root_leaf (ip4_fib_mtrie_t * m,
 		{
 		  /* Existing leaf points to another ply.  We need to place
 		   * new_leaf into all more specific slots. */
-		  new_ply = get_next_ply_for_leaf (m, old_leaf);
-		  set_ply_with_more_specific_leaf (m, new_ply, new_leaf,
+		  set_ply_with_more_specific_leaf (m, old_leaf, new_leaf,
 						   a->dst_address_length);
 		}
 	    }
@@ -465,8 +674,7 @@ set_root_leaf (ip4_fib_mtrie_t * m,
 	    {
 	      /* The current leaf is less specific and not termial (i.e. a ply),
 	       * recurse on down the trie */
-	      new_ply = get_next_ply_for_leaf (m, old_leaf);
-	      set_leaf (m, a, new_ply - ip4_ply_pool, 2);
+	      set_leaf (m, a, old_leaf, 2);
 	    }
 	  /*
 	   * else
@@ -479,7 +687,6 @@ set_root_leaf (ip4_fib_mtrie_t * m,
     {
       /* The address to insert requires us to move down at a lower level of
        * the trie - recurse on down */
-      ip4_fib_mtrie_8_ply_t *new_ply;
       u8 ply_base_len;
 
       ply_base_len = 16;
@@ -493,7 +700,6 @@ set_root_leaf (ip4_fib_mtrie_t * m,
 				 clib_max (old_ply->dst_address_bits_of_leaves
 					   [dst_byte], ply_base_len),
 				 ply_base_len);
-	  new_ply = get_next_ply_for_leaf (m, new_leaf);
 
 	  __sync_val_compare_and_swap (&old_ply->leaves[dst_byte], old_leaf,
 				       new_leaf);
@@ -501,25 +707,29 @@ set_root_leaf (ip4_fib_mtrie_t * m,
 	  old_ply->dst_address_bits_of_leaves[dst_byte] = ply_base_len;
 	}
       else
-	new_ply = get_next_ply_for_leaf (m, old_leaf);
+	new_leaf = old_leaf;
 
-      set_leaf (m, a, new_ply - ip4_ply_pool, 2);
+      set_leaf (m, a, new_leaf, 2);
     }
 }
 
 static uword
 unset_leaf (ip4_fib_mtrie_t * m,
 	    const ip4_fib_mtrie_set_unset_leaf_args_t * a,
-	    ip4_fib_mtrie_8_ply_t * old_ply, u32 dst_address_byte_index)
+	    ip4_fib_mtrie_leaf_t old_ply_leaf, u32 dst_address_byte_index)
 {
   ip4_fib_mtrie_leaf_t old_leaf, del_leaf;
+  ip4_fib_mtrie_8_ply_t scratch, *old_ply;
   i32 n_dst_bits_next_plies;
   i32 i, n_dst_bits_this_ply, old_leaf_is_terminal;
-  u8 dst_byte;
+  u8 dst_byte, modified;
 
   ASSERT (a->dst_address_length <= 32);
   ASSERT (dst_address_byte_index < ARRAY_LEN (a->dst_address.as_u8));
 
+  old_ply = ply_8_get (m, old_ply_leaf, &scratch);
+  modified = 0;
+
   n_dst_bits_next_plies =
     a->dst_address_length - BITS (u8) * (dst_address_byte_index + 1);
 
@@ -540,9 +750,9 @@ unset_leaf (ip4_fib_mtrie_t * m,
 
       if (old_leaf == del_leaf
 	  || (!old_leaf_is_terminal
-	      && unset_leaf (m, a, get_next_ply_for_leaf (m, old_leaf),
-			     dst_address_byte_index + 1)))
+	      && unset_leaf (m, a, old_leaf, dst_address_byte_index + 1)))
 	{
+	  modified = 1;
 	  old_ply->n_non_empty_leafs -=
 	    ip4_fib_mtrie_leaf_is_non_empty (old_ply, i);
 
@@ -558,7 +768,7 @@ unset_leaf (ip4_fib_mtrie_t * m,
 	  ASSERT (old_ply->n_non_empty_leafs >= 0);
 	  if (old_ply->n_non_empty_leafs == 0 && dst_address_byte_index > 0)
 	    {
-	      pool_put (ip4_ply_pool, old_ply);
+	      ply_8_free (m, old_ply_leaf);
 	      /* Old ply was deleted. */
 	      return 1;
 	    }
@@ -576,6 +786,9 @@ unset_leaf (ip4_fib_mtrie_t * m,
 	}
     }
 
+  if (modified)
+    ply_8_commit (m, old_ply_leaf, old_ply);
+
   /* Old ply was not deleted. */
   return 0;
 }
@@ -616,8 +829,7 @@ unset_root_leaf (ip4_fib_mtrie_t * m,
       old_leaf_is_terminal = ip4_fib_mtrie_leaf_is_terminal (old_leaf);
 
       if (old_leaf == del_leaf
-	  || (!old_leaf_is_terminal
-	      && unset_leaf (m, a, get_next_ply_for_leaf (m, old_leaf), 2)))
+	  || (!old_leaf_is_terminal && unset_leaf (m, a, old_leaf, 2)))
 	{
 	  old_ply->leaves[slot] =
 	    ip4_fib_mtrie_leaf_set_adj_index (a->cover_adj_index);
@@ -665,26 +877,151 @@ ip4_fib_mtrie_route_del (ip4_fib_mtrie_t * m,
   unset_root_leaf (m, &a);
 }
 
+static void ply_8_compress (ip4_fib_mtrie_t * m,
+			    ip4_fib_mtrie_leaf_t * slot);
+
+/**
+ * Compress the full plies below a compressed ply. A bulk update adds
+ * full plies below the compressed plies already in the trie, so these
+ * are walked too, and rewritten if they refer to a full ply.
+ */
+static void
+c_ply_compress_children (ip4_fib_mtrie_t * m, ip4_fib_mtrie_leaf_t l)
+{
+  ip4_fib_mtrie_8_ply_t scratch, *p;
+  ip4_fib_mtrie_c_ply_t *cp;
+  int i, n_full = 0;
+
+  cp = ip4_c_ply_pool[ip4_fib_mtrie_leaf_get_next_ply_index (l)];
+
+  for (i = 0; i < cp->n_leaves; i++)
+    {
+      if (!ip4_fib_mtrie_leaf_is_next_ply (cp->leaves[i]))
+	continue;
+      if (ip4_fib_mtrie_leaf_is_c_ply (cp->leaves[i]))
+	/* rewritten in place, its index in the pool does not change */
+	c_ply_compress_children (m, cp->leaves[i]);
+      else
+	n_full++;
+    }
+
+  if (0 == n_full)
+    return;
+
+  p = ply_8_get (m, l, &scratch);
+  for (i = 0; i < ARRAY_LEN (p->leaves); i++)
+    {
+      if (ip4_fib_mtrie_leaf_is_next_ply (p->leaves[i]) &&
+	  !ip4_fib_mtrie_leaf_is_c_ply (p->leaves[i]))
+	ply_8_compress (m, &p->leaves[i]);
+    }
+  ply_8_commit (m, l, p);
+}
+
+/**
+ * Replace the full plies in, and below, the non-terminal leaf in the slot
+ * with their compressed equivalents
+ */
+static void
+ply_8_compress (ip4_fib_mtrie_t * m, ip4_fib_mtrie_leaf_t * slot)
+{
+  ip4_fib_mtrie_leaf_t old_leaf, new_leaf;
+  ip4_fib_mtrie_c_ply_t **cpp;
+  ip4_fib_mtrie_8_ply_t *p;
+  int i;
+
+  old_leaf = *slot;
+
+  if (ip4_fib_mtrie_leaf_is_c_ply (old_leaf))
+    {
+      c_ply_compress_children (m, old_leaf);
+      return;
+    }
+
+  p = get_next_ply_for_leaf (m, old_leaf);
+
+  for (i = 0; i < ARRAY_LEN (p->leaves); i++)
+    {
+      if (ip4_fib_mtrie_leaf_is_next_ply (p->leaves[i]))
+	ply_8_compress (m, &p->leaves[i]);
+    }
+
+  vlib_pool_get_mt (ip4_c_ply_pool, cpp);
+  *cpp = c_ply_compress (p);
+  new_leaf = ip4_fib_mtrie_leaf_set_next_c_ply_index (cpp - ip4_c_ply_pool);
+
+  __sync_val_compare_and_swap (slot, old_leaf, new_leaf);
+  ASSERT (*slot == new_leaf);
+
+  ply_8_free (m, old_leaf);
+}
+
+void
+ip4_fib_mtrie_bulk_begin (ip4_fib_mtrie_t * m)
+{
+  m->in_bulk = 1;
+}
+
+void
+ip4_fib_mtrie_bulk_end (ip4_fib_mtrie_t * m)
+{
+  int i;
+
+  m->in_bulk = 0;
+
+  if (IP4_FIB_MTRIE_PLY_TYPE_COMPRESSED != m->ply_type)
+    return;
+
+  /* the trie may have been populated before the bulk update began */
+  for (i = 0; i < ARRAY_LEN (m->root_ply.leaves); i++)
+    {
+      if (ip4_fib_mtrie_leaf_is_next_ply (m->root_ply.leaves[i]))
+	ply_8_compress (m, &m->root_ply.leaves[i]);
+    }
+}
+
 /* Returns number of bytes of memory used by mtrie. */
 static uword
-mtrie_ply_memory_usage (ip4_fib_mtrie_t * m, ip4_fib_mtrie_8_ply_t * p)
+mtrie_ply_memory_usage (ip4_fib_mtrie_t * m, ip4_fib_mtrie_leaf_t pl)
 {
   uword bytes, i;
 
-  bytes = sizeof (p[0]);
-  for (i = 0; i < ARRAY_LEN (p->leaves); i++)
+  if (ip4_fib_mtrie_leaf_is_c_ply (pl))
     {
-      ip4_fib_mtrie_leaf_t l = p->leaves[i];
-      if (ip4_fib_mtrie_leaf_is_next_ply (l))
-	bytes += mtrie_ply_memory_usage (m, get_next_ply_for_leaf (m, l));
+      ip4_fib_mtrie_c_ply_t *cp;
+
+      cp = ip4_c_ply_pool[ip4_fib_mtrie_leaf_get_next_ply_index (pl)];
+      bytes = round_pow2 (c_ply_size (cp->n_leaves), CLIB_CACHE_LINE_BYTES);
+      bytes += sizeof (cp);
+
+      for (i = 0; i < cp->n_leaves; i++)
+	{
+	  ip4_fib_mtrie_leaf_t l = cp->leaves[i];
+	  if (ip4_fib_mtrie_leaf_is_next_ply (l))
+	    bytes += mtrie_ply_memory_usage (m, l);
+	}
+    }
+  else
+    {
+      ip4_fib_mtrie_8_ply_t *p;
+
+      p = get_next_ply_for_leaf (m, pl);
+      bytes = sizeof (p[0]);
+
+      for (i = 0; i < ARRAY_LEN (p->leaves); i++)
+	{
+	  ip4_fib_mtrie_leaf_t l = p->leaves[i];
+	  if (ip4_fib_mtrie_leaf_is_next_ply (l))
+	    bytes += mtrie_ply_memory_usage (m, l);
+	}
     }
 
   return bytes;
 }
 
 /* Returns number of bytes of memory used by mtrie. */
-static uword
-mtrie_memory_usage (ip4_fib_mtrie_t * m)
+uword
+ip4_fib_mtrie_memory_usage (ip4_fib_mtrie_t * m)
 {
   uword bytes, i;
 
@@ -693,7 +1030,7 @@ mtrie_memory_usage (ip4_fib_mtrie_t * m)
     {
       ip4_fib_mtrie_leaf_t l = m->root_ply.leaves[i];
       if (ip4_fib_mtrie_leaf_is_next_ply (l))
-	bytes += mtrie_ply_memory_usage (m, get_next_ply_for_leaf (m, l));
+	bytes += mtrie_ply_memory_usage (m, l);
     }
 
   return bytes;
@@ -706,6 +1043,9 @@ format_ip4_fib_mtrie_leaf (u8 * s, va_list * va)
 
   if (ip4_fib_mtrie_leaf_is_terminal (l))
     s = format (s, "lb-index %d", ip4_fib_mtrie_leaf_get_adj_index (l));
+  else if (ip4_fib_mtrie_leaf_is_c_ply (l))
+    s = format (s, "next compressed ply %d",
+		ip4_fib_mtrie_leaf_get_next_ply_index (l));
   else
     s = format (s, "next ply %d", ip4_fib_mtrie_leaf_get_next_ply_index (l));
   return s;
@@ -715,7 +1055,7 @@ format_ip4_fib_mtrie_leaf (u8 * s, va_list * va)
 ({                                                                      \
   u32 a, ia_length;                                                     \
   ip4_address_t ia;                                                     \
-  ip4_fib_mtrie_leaf_t _l = p->leaves[(_i)];                            \
+  ip4_fib_mtrie_leaf_t _l = (_p)->leaves[(_i)];                         \
                                                                         \
   a = (_base_address) + ((_i) << (32 - (_ply_max_len)));                \
   ia.as_u32 = clib_host_to_net_u32 (a);                                 \
@@ -728,8 +1068,7 @@ format_ip4_fib_mtrie_leaf (u8 * s, va_list * va)
   if (ip4_fib_mtrie_leaf_is_next_ply (_l))                              \
     s = format (s, "\n%U%U",                                            \
                 format_white_space, (_indent) + 2,                      \
-                format_ip4_fib_mtrie_ply, m, a,                         \
-                ip4_fib_mtrie_leaf_get_next_ply_index (_l));            \
+                format_ip4_fib_mtrie_ply, m, a, _l);                    \
   s;                                                                    \
 })
 
@@ -738,15 +1077,20 @@ format_ip4_fib_mtrie_ply (u8 * s, va_list * va)
 {
   ip4_fib_mtrie_t *m = va_arg (*va, ip4_fib_mtrie_t *);
   u32 base_address = va_arg (*va, u32);
-  u32 ply_index = va_arg (*va, u32);
-  ip4_fib_mtrie_8_ply_t *p;
+  ip4_fib_mtrie_leaf_t ply_leaf = va_arg (*va, ip4_fib_mtrie_leaf_t);
+  ip4_fib_mtrie_8_ply_t scratch, *p;
   u32 indent;
   int i;
 
-  p = pool_elt_at_index (ip4_ply_pool, ply_index);
+  p = ply_8_get (m, ply_leaf, &scratch);
   indent = format_get_indent (s);
-  s = format (s, "ply index %d, %d non-empty leaves", ply_index,
+  s = format (s, "ply index %d, %d non-empty leaves",
+	      ip4_fib_mtrie_leaf_get_next_ply_index (ply_leaf),
 	      p->n_non_empty_leafs);
+  if (ip4_fib_mtrie_leaf_is_c_ply (ply_leaf))
+    s = format (s, ", compressed to %d runs",
+		ip4_c_ply_pool[ip4_fib_mtrie_leaf_get_next_ply_index
+			       (ply_leaf)]->n_leaves);
 
   for (i = 0; i < ARRAY_LEN (p->leaves); i++)
     {
@@ -769,9 +1113,11 @@ format_ip4_fib_mtrie (u8 * s, va_list * va)
   u32 base_address = 0;
   int i;
 
-  s = format (s, "%d plies, memory usage %U\n",
+  s = format (s, "%d plies, %d compressed plies, %s plies, memory usage %U\n",
 	      pool_elts (ip4_ply_pool),
-	      format_memory_size, mtrie_memory_usage (m));
+	      pool_elts (ip4_c_ply_pool),
+	      ip4_fib_mtrie_ply_type_names[m->ply_type],
+	      format_memory_size, ip4_fib_mtrie_memory_usage (m));
 
   if (verbose)
     {
@@ -807,6 +1153,34 @@ ip4_mtrie_module_init (vlib_main_t * vm)
 
 VLIB_INIT_FUNCTION (ip4_mtrie_module_init);
 
+static clib_error_t *
+ip4_mtrie_config (vlib_main_t * vm, unformat_input_t * input)
+{
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "mtrie-plies full"))
+	ip4_fib_mtrie_default_ply_type = IP4_FIB_MTRIE_PLY_TYPE_FULL;
+      else if (unformat (input, "mtrie-plies compressed"))
+	ip4_fib_mtrie_default_ply_type = IP4_FIB_MTRIE_PLY_TYPE_COMPRESSED;
+      else
+	return clib_error_return (0, "unknown input '%U'",
+				  format_unformat_error, input);
+    }
+
+  return 0;
+}
+
+/*?
+ * The type of the 8 bit plies below the 16 bit root of every IPv4
+ * forwarding mtrie. 'full' plies are 256 leaves, one index per lookup
+ * step; 'compressed' plies store each run of identical leaves once and
+ * use a popcount per lookup step, which cuts the memory, and hence cache,
+ * footprint of large tables many times over.
+ *
+ * @cfgcmd{ip4 { mtrie-plies compressed }}
+?*/
+VLIB_EARLY_CONFIG_FUNCTION (ip4_mtrie_config, "ip4");
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
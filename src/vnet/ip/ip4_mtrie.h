@@ -47,7 +47,8 @@
 
 /* ip4 fib leafs: 4 ply 8-8-8-8 mtrie.
    1 + 2*adj_index for terminal leaves.
-   0 + 2*next_ply_index for non-terminals, i.e. PLYs
+   0 + 4*next_ply_index for non-terminals, i.e. PLYs
+   2 + 4*next_ply_index for non-terminals that are compressed PLYs
    1 => empty (adjacency index of zero is special miss adjacency). */
 typedef u32 ip4_fib_mtrie_leaf_t;
 
@@ -122,6 +123,69 @@ ip4_fib_mtrie_8_ply_t;
 STATIC_ASSERT (0 == sizeof (ip4_fib_mtrie_8_ply_t) % CLIB_CACHE_LINE_BYTES,
 	       "IP4 Mtrie ply cache line");
 
+/**
+ * @brief A compressed 8 bit stride ply.
+ * Consecutive slots of an 8 bit ply very often hold the same leaf, since
+ * a ply only exists because of a handful of more specific routes. The
+ * compressed ply stores each run of identical slots once; a bit in the
+ * bitmap is set for each slot that starts a new run, so the leaf for a
+ * slot is found by counting the set bits up to and including the slot.
+ *
+ * The ply is a single variable length allocation which is never modified
+ * once published; updates build a new copy and swap the pointer.
+ */
+typedef struct ip4_fib_mtrie_c_ply_t_
+{
+  /**
+   * One bit per slot, set if the slot starts a new run of leaves
+   */
+  u64 bitmap[4];
+
+  /**
+   * The number of runs that start in the preceding bitmap words,
+   * so the index computation is a single popcount.
+   */
+  u8 base[4];
+
+  /**
+   * The length of the ply's covering prefix.
+   */
+  u8 dst_address_bits_base;
+
+  u8 pad;
+
+  /**
+   * The number of runs, i.e. the number of leaves stored.
+   */
+  u16 n_leaves;
+
+  /**
+   * One leaf per run. These are followed by the prefix length of each
+   * run; an array that is used only by the control plane.
+   */
+  ip4_fib_mtrie_leaf_t leaves[0];
+} ip4_fib_mtrie_c_ply_t;
+
+/**
+ * @brief The types of 8 bit stride ply the mtrie can be built from
+ */
+typedef enum ip4_fib_mtrie_ply_type_t_
+{
+  /**
+   * 256 slots, each a leaf. One index to find the next leaf.
+   */
+  IP4_FIB_MTRIE_PLY_TYPE_FULL,
+  /**
+   * Bitmap compressed. A popcount to find the next leaf.
+   */
+  IP4_FIB_MTRIE_PLY_TYPE_COMPRESSED,
+} __attribute__ ((packed)) ip4_fib_mtrie_ply_type_t;
+
+#define IP4_FIB_MTRIE_PLY_TYPES {                       \
+    [IP4_FIB_MTRIE_PLY_TYPE_FULL] = "full",             \
+    [IP4_FIB_MTRIE_PLY_TYPE_COMPRESSED] = "compressed", \
+}
+
 /**
  * @brief The mutiway-TRIE.
  * There is no data associated with the mtrie apart from the top PLY
@@ -134,6 +198,18 @@ typedef struct
    * to it. therefore no cachline misses in the data-path.
    */
   ip4_fib_mtrie_16_ply_t root_ply;
+
+  /**
+   * The type of the 8 bit plies created below the root.
+   * Control plane only.
+   */
+  ip4_fib_mtrie_ply_type_t ply_type;
+
+  /**
+   * Set whilst a bulk update is in progress. New plies are then
+   * created full, and are compressed once the bulk update ends.
+   */
+  u8 in_bulk;
 } ip4_fib_mtrie_t;
 
 /**
@@ -141,6 +217,34 @@ typedef struct
  */
 void ip4_mtrie_init (ip4_fib_mtrie_t * m);
 
+/**
+ * @brief Initialise an mtrie whose 8 bit plies are of the given type
+ */
+void ip4_mtrie_init_w_type (ip4_fib_mtrie_t * m,
+			    ip4_fib_mtrie_ply_type_t type);
+
+/**
+ * @brief Start a bulk update of the mtrie, e.g. an initial table load.
+ * The per-route cost of maintaining compressed plies is deferred until
+ * ip4_fib_mtrie_bulk_end().
+ */
+void ip4_fib_mtrie_bulk_begin (ip4_fib_mtrie_t * m);
+
+/**
+ * @brief End a bulk update; compress the plies created during it.
+ */
+void ip4_fib_mtrie_bulk_end (ip4_fib_mtrie_t * m);
+
+/**
+ * @brief Number of bytes of memory used by the mtrie
+ */
+uword ip4_fib_mtrie_memory_usage (ip4_fib_mtrie_t * m);
+
+/**
+ * @brief The type of ply new mtries are created with
+ */
+extern ip4_fib_mtrie_ply_type_t ip4_fib_mtrie_default_ply_type;
+
 /**
  * @brief Free an mtrie, It must be emty when free'd
  */
@@ -171,6 +275,11 @@ format_function_t format_ip4_fib_mtrie;
  */
 extern ip4_fib_mtrie_8_ply_t *ip4_ply_pool;
 
+/**
+ * @brief A global pool of compressed 8bit stride plys
+ */
+extern ip4_fib_mtrie_c_ply_t **ip4_c_ply_pool;
+
 /**
  * Is the leaf terminal (i.e. an LB index) or non-terminak (i.e. a PLY index)
  */
@@ -180,6 +289,29 @@ ip4_fib_mtrie_leaf_is_terminal (ip4_fib_mtrie_leaf_t n)
   return n & 1;
 }
 
+/**
+ * Is the non-terminal leaf the index of a compressed PLY
+ */
+always_inline u32
+ip4_fib_mtrie_leaf_is_c_ply (ip4_fib_mtrie_leaf_t n)
+{
+  return (n & 3) == 2;
+}
+
+/**
+ * @brief Find the leaf for the given slot of a compressed ply
+ */
+always_inline ip4_fib_mtrie_leaf_t
+ip4_fib_mtrie_c_ply_get_leaf (const ip4_fib_mtrie_c_ply_t * cp, u8 slot)
+{
+  u32 word = slot >> 6;
+
+  /* count the run starts up to and including the slot's bit */
+  return (cp->leaves[cp->base[word] +
+		     __builtin_popcountll (cp->bitmap[word] << (63 - (slot & 63)))
+		     - 1]);
+}
+
 /**
  * From the stored slot value extract the LB index value
  */
@@ -205,7 +337,12 @@ ip4_fib_mtrie_lookup_step (const ip4_fib_mtrie_t * m,
 
   if (!current_is_terminal)
     {
-      ply = ip4_ply_pool + (current_leaf >> 1);
+      if (PREDICT_FALSE (ip4_fib_mtrie_leaf_is_c_ply (current_leaf)))
+	return (ip4_fib_mtrie_c_ply_get_leaf
+		(ip4_c_ply_pool[current_leaf >> 2],
+		 dst_address->as_u8[dst_address_byte_index]));
+
+      ply = ip4_ply_pool + (current_leaf >> 2);
       return (ply->leaves[dst_address->as_u8[dst_address_byte_index]]);
     }
 
@@ -148,6 +148,37 @@ typedef struct ip6_fib_table_instance_t_
   i32 dst_address_length_refcounts[129];
 } ip6_fib_table_instance_t;
 
+/**
+ * The forwarding table compiled for a binary search on prefix lengths
+ * (Waldvogel et al.). Each forwarding prefix, and each marker needed to
+ * steer the search towards longer prefixes, is stored with the LB index
+ * of its best matching prefix. A lookup therefore probes at most
+ * log2 of the number of distinct prefix lengths.
+ * The compiled table is rebuilt from the IP6_FIB_TABLE_FWDING table after
+ * each burst of updates; until then lookups probe each length in turn.
+ */
+typedef struct ip6_fib_lpm_t_
+{
+  /* The active table and the table that is rebuilt */
+  BVT (clib_bihash) ip6_hash[2];
+
+  /* The prefix lengths in each table, shortest first */
+  u8 *prefix_lengths[2];
+
+  /* Index of the active table */
+  volatile u32 active;
+
+  /* Non-zero when the active table is up to date with the fwding table */
+  volatile u32 is_valid;
+
+  /* Number of markers in the active table */
+  u32 n_markers;
+
+  /* Number of rebuilds and the duration of the last */
+  u32 n_rebuilds;
+  f64 rebuild_time;
+} ip6_fib_lpm_t;
+
 typedef struct ip6_main_t
 {
   /**
@@ -155,6 +186,11 @@ typedef struct ip6_main_t
    */
   ip6_fib_table_instance_t ip6_table[IP6_FIB_NUM_TABLES];
 
+  /**
+   * The fwding table compiled for the data-plane
+   */
+  ip6_fib_lpm_t ip6_lpm;
+
   ip_lookup_main_t lookup_main;
 
   /* Pool of FIBs. */
@@ -489,6 +489,13 @@ vnet_ip_route_cmd (vlib_main_t * vm,
 	  incr = 1 << ((FIB_PROTOCOL_IP4 == prefixs[0].fp_proto ? 32 : 128) -
 		       prefixs[i].fp_len);
 
+	  /*
+	   * loading many routes at once; let the table defer work until
+	   * all are added
+	   */
+	  if (FIB_PROTOCOL_IP4 == prefixs[0].fp_proto && count > 1)
+	    ip4_fib_table_bulk_begin (ip4_fib_get (fib_index));
+
 	  for (k = 0; k < n; k++)
 	    {
 	      for (j = 0; j < vec_len (rpaths); j++)
@@ -505,6 +512,8 @@ vnet_ip_route_cmd (vlib_main_t * vm,
 		      error =
 			clib_error_return (0, "Via table %d does not exist",
 					   rpaths[i].frp_fib_index);
+		      if (FIB_PROTOCOL_IP4 == prefixs[0].fp_proto && count > 1)
+			ip4_fib_table_bulk_end (ip4_fib_get (fib_index));
 		      goto done;
 		    }
 		  rpaths[i].frp_fib_index = fi;
@@ -544,6 +553,9 @@ vnet_ip_route_cmd (vlib_main_t * vm,
 
 		}
 	    }
+	  if (FIB_PROTOCOL_IP4 == prefixs[0].fp_proto && count > 1)
+	    ip4_fib_table_bulk_end (ip4_fib_get (fib_index));
+
 	  t[1] = vlib_time_now (vm);
 	  if (count > 1)
 	    vlib_cli_output (vm, "%.6e routes/sec", count / (t[1] - t[0]));
@@ -49,11 +49,40 @@ typedef CLIB_PACKED (struct {
 }) ip6_and_esp_header_t;
 /* *INDENT-ON* */
 
+/* AEAD (RFC 4106, RFC 7634) salt, explicit IV and ICV sizes */
+#define ESP_AEAD_SALT_SIZE	4
+#define ESP_AEAD_IV_SIZE	8
+#define ESP_AEAD_ICV_SIZE	16
+
 typedef struct
 {
   const EVP_CIPHER *type;
+  /* combined mode, no separate integrity algorithm */
+  u8 is_aead;
 } esp_crypto_alg_t;
 
+/*
+ * One packet's AEAD work. The nodes queue one per packet and process
+ * the whole frame in one go, see esp_aead_process_ops ().
+ */
+typedef struct
+{
+  u32 sa_index;
+  u32 len;
+  u8 *src;
+  u8 *dst;
+  u8 *tag;
+  /* salt followed by the explicit IV */
+  u8 nonce[ESP_AEAD_SALT_SIZE + ESP_AEAD_IV_SIZE];
+  /* SPI, [high order sequence number,] sequence number */
+  u8 aad[12];
+  u8 aad_len;
+  /* set by the caller to leave the op out */
+  u8 skip;
+  /* set on decrypt when the ICV does not match */
+  u8 auth_failed;
+} esp_aead_op_t;
+
 typedef struct
 {
   const EVP_MD *md;
@@ -83,6 +112,12 @@ typedef struct
   ipsec_crypto_alg_t last_encrypt_alg;
   ipsec_crypto_alg_t last_decrypt_alg;
   ipsec_integ_alg_t last_integ_alg;
+    CLIB_CACHE_LINE_ALIGN_MARK (cacheline3);
+  /* AEAD contexts, indexed by is_encrypt, keyed for the SA last used */
+  EVP_CIPHER_CTX *aead_ctx[2];
+  u32 aead_sa_index[2];
+  u32 aead_sa_generation[2];
+  esp_aead_op_t *aead_ops;
 } esp_main_per_thread_data_t;
 
 typedef struct
@@ -90,6 +125,8 @@ typedef struct
   esp_crypto_alg_t *esp_crypto_algs;
   esp_integ_alg_t *esp_integ_algs;
   esp_main_per_thread_data_t *per_thread_data;
+  /* bumped when an SA's keys may have changed */
+  volatile u32 sa_generation;
 } esp_main_t;
 
 extern esp_main_t esp_main;
@@ -219,15 +256,22 @@ esp_replay_advance_esn (ipsec_sa_t * sa, u32 seq)
     }
 }
 
+/**
+ * Advance the SA's outbound sequence number, return 1 if it is exhausted.
+ * AEAD SAs build their IV from the sequence number, so they must never
+ * wrap, whether or not anti-replay is enabled.
+ */
 always_inline int
 esp_seq_advance (ipsec_sa_t * sa)
 {
+  u8 no_wrap = sa->use_anti_replay ||
+    esp_main.esp_crypto_algs[sa->crypto_alg].is_aead;
+
   if (PREDICT_TRUE (sa->use_esn))
     {
       if (PREDICT_FALSE (sa->seq == ESP_SEQ_MAX))
 	{
-	  if (PREDICT_FALSE
-	      (sa->use_anti_replay && sa->seq_hi == ESP_SEQ_MAX))
+	  if (PREDICT_FALSE (no_wrap && sa->seq_hi == ESP_SEQ_MAX))
 	    return 1;
 	  sa->seq_hi++;
 	}
@@ -235,7 +279,7 @@ esp_seq_advance (ipsec_sa_t * sa)
     }
   else
     {
-      if (PREDICT_FALSE (sa->use_anti_replay && sa->seq == ESP_SEQ_MAX))
+      if (PREDICT_FALSE (no_wrap && sa->seq == ESP_SEQ_MAX))
 	return 1;
       sa->seq++;
     }
@@ -255,6 +299,17 @@ esp_init ()
   em->esp_crypto_algs[IPSEC_CRYPTO_ALG_AES_CBC_128].type = EVP_aes_128_cbc ();
   em->esp_crypto_algs[IPSEC_CRYPTO_ALG_AES_CBC_192].type = EVP_aes_192_cbc ();
   em->esp_crypto_algs[IPSEC_CRYPTO_ALG_AES_CBC_256].type = EVP_aes_256_cbc ();
+  em->esp_crypto_algs[IPSEC_CRYPTO_ALG_AES_GCM_128].type = EVP_aes_128_gcm ();
+  em->esp_crypto_algs[IPSEC_CRYPTO_ALG_AES_GCM_128].is_aead = 1;
+  em->esp_crypto_algs[IPSEC_CRYPTO_ALG_AES_GCM_192].type = EVP_aes_192_gcm ();
+  em->esp_crypto_algs[IPSEC_CRYPTO_ALG_AES_GCM_192].is_aead = 1;
+  em->esp_crypto_algs[IPSEC_CRYPTO_ALG_AES_GCM_256].type = EVP_aes_256_gcm ();
+  em->esp_crypto_algs[IPSEC_CRYPTO_ALG_AES_GCM_256].is_aead = 1;
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L && !defined (OPENSSL_NO_CHACHA)
+  em->esp_crypto_algs[IPSEC_CRYPTO_ALG_CHACHA20_POLY1305].type =
+    EVP_chacha20_poly1305 ();
+  em->esp_crypto_algs[IPSEC_CRYPTO_ALG_CHACHA20_POLY1305].is_aead = 1;
+#endif
 
   vec_validate (em->esp_integ_algs, IPSEC_INTEG_N_ALG - 1);
   esp_integ_alg_t *i;
@@ -283,17 +338,211 @@ esp_init ()
 			CLIB_CACHE_LINE_BYTES);
   int thread_id;
 
-  for (thread_id = 0; thread_id < tm->n_vlib_mains - 1; thread_id++)
+  for (thread_id = 0; thread_id < tm->n_vlib_mains; thread_id++)
+    {
+      esp_main_per_thread_data_t *ptd = &em->per_thread_data[thread_id];
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+      ptd->encrypt_ctx = EVP_CIPHER_CTX_new ();
+      ptd->decrypt_ctx = EVP_CIPHER_CTX_new ();
+      ptd->hmac_ctx = HMAC_CTX_new ();
+#else
+      EVP_CIPHER_CTX_init (&(ptd->encrypt_ctx));
+      EVP_CIPHER_CTX_init (&(ptd->decrypt_ctx));
+      HMAC_CTX_init (&(ptd->hmac_ctx));
+#endif
+      ptd->aead_ctx[0] = EVP_CIPHER_CTX_new ();
+      ptd->aead_ctx[1] = EVP_CIPHER_CTX_new ();
+      ptd->aead_sa_index[0] = ptd->aead_sa_index[1] = ~0;
+    }
+}
+
+/*
+ * Derive the per-SA crypto state, called whenever an SA is added or
+ * its keys change.
+ */
+always_inline void
+esp_sa_update (ipsec_sa_t * sa)
+{
+  esp_main_t *em = &esp_main;
+
+  /* the salt is the last 4 bytes of the keying material */
+  if (em->esp_crypto_algs[sa->crypto_alg].is_aead &&
+      sa->crypto_key_len >= ESP_AEAD_SALT_SIZE)
+    clib_memcpy (&sa->salt,
+		 &sa->crypto_key[sa->crypto_key_len - ESP_AEAD_SALT_SIZE],
+		 ESP_AEAD_SALT_SIZE);
+
+  /* the workers key their AEAD contexts again */
+  em->sa_generation++;
+}
+
+always_inline void
+esp_encrypt_aes_cbc (ipsec_crypto_alg_t alg,
+		     u8 * in, u8 * out, size_t in_len, u8 * key, u8 * iv)
+{
+  esp_main_t *em = &esp_main;
+  u32 thread_index = vlib_get_thread_index ();
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+  EVP_CIPHER_CTX *ctx = em->per_thread_data[thread_index].encrypt_ctx;
+#else
+  EVP_CIPHER_CTX *ctx = &(em->per_thread_data[thread_index].encrypt_ctx);
+#endif
+  const EVP_CIPHER *cipher = NULL;
+  int out_len;
+
+  ASSERT (alg < IPSEC_CRYPTO_N_ALG);
+
+  if (PREDICT_FALSE (em->esp_crypto_algs[alg].type == IPSEC_CRYPTO_ALG_NONE))
+    return;
+
+  if (PREDICT_FALSE
+      (alg != em->per_thread_data[thread_index].last_encrypt_alg))
     {
+      cipher = em->esp_crypto_algs[alg].type;
+      em->per_thread_data[thread_index].last_encrypt_alg = alg;
+    }
+
+  EVP_EncryptInit_ex (ctx, cipher, NULL, key, iv);
+
+  EVP_EncryptUpdate (ctx, out, &out_len, in, in_len);
+  EVP_EncryptFinal_ex (ctx, out + out_len, &out_len);
+}
+
+always_inline void
+esp_decrypt_aes_cbc (ipsec_crypto_alg_t alg,
+		     u8 * in, u8 * out, size_t in_len, u8 * key, u8 * iv)
+{
+  esp_main_t *em = &esp_main;
+  u32 thread_index = vlib_get_thread_index ();
 #if OPENSSL_VERSION_NUMBER >= 0x10100000L
-      em->per_thread_data[thread_id].encrypt_ctx = EVP_CIPHER_CTX_new ();
-      em->per_thread_data[thread_id].decrypt_ctx = EVP_CIPHER_CTX_new ();
-      em->per_thread_data[thread_id].hmac_ctx = HMAC_CTX_new ();
+  EVP_CIPHER_CTX *ctx = em->per_thread_data[thread_index].decrypt_ctx;
 #else
-      EVP_CIPHER_CTX_init (&(em->per_thread_data[thread_id].encrypt_ctx));
-      EVP_CIPHER_CTX_init (&(em->per_thread_data[thread_id].decrypt_ctx));
-      HMAC_CTX_init (&(em->per_thread_data[thread_id].hmac_ctx));
+  EVP_CIPHER_CTX *ctx = &(em->per_thread_data[thread_index].decrypt_ctx);
 #endif
+  const EVP_CIPHER *cipher = NULL;
+  int out_len;
+
+  ASSERT (alg < IPSEC_CRYPTO_N_ALG);
+
+  if (PREDICT_FALSE (em->esp_crypto_algs[alg].type == 0))
+    return;
+
+  if (PREDICT_FALSE
+      (alg != em->per_thread_data[thread_index].last_decrypt_alg))
+    {
+      cipher = em->esp_crypto_algs[alg].type;
+      em->per_thread_data[thread_index].last_decrypt_alg = alg;
+    }
+
+  EVP_DecryptInit_ex (ctx, cipher, NULL, key, iv);
+
+  EVP_DecryptUpdate (ctx, out, &out_len, in, in_len);
+  EVP_DecryptFinal_ex (ctx, out + out_len, &out_len);
+}
+
+/* Fill in the nonce and the AAD of an op, the explicit IV is given */
+always_inline void
+esp_aead_op_init (esp_aead_op_t * op, ipsec_sa_t * sa, u32 sa_index,
+		  esp_header_t * esp, u8 * iv)
+{
+  op->sa_index = sa_index;
+  op->skip = 0;
+  op->auth_failed = 0;
+
+  clib_memcpy (op->nonce, &sa->salt, ESP_AEAD_SALT_SIZE);
+  clib_memcpy (op->nonce + ESP_AEAD_SALT_SIZE, iv, ESP_AEAD_IV_SIZE);
+
+  /* SPI and sequence number, as on the wire */
+  clib_memcpy (op->aad, &esp->spi, sizeof (esp->spi));
+  if (sa->use_esn)
+    {
+      u32 seq_hi = clib_host_to_net_u32 (sa->seq_hi);
+      clib_memcpy (op->aad + 4, &seq_hi, sizeof (seq_hi));
+      clib_memcpy (op->aad + 8, &esp->seq, sizeof (esp->seq));
+      op->aad_len = 12;
+    }
+  else
+    {
+      clib_memcpy (op->aad + 4, &esp->seq, sizeof (esp->seq));
+      op->aad_len = 8;
+    }
+}
+
+always_inline EVP_CIPHER_CTX *
+esp_aead_get_ctx (esp_main_per_thread_data_t * ptd, u32 sa_index,
+		  int is_encrypt)
+{
+  esp_main_t *em = &esp_main;
+  EVP_CIPHER_CTX *ctx = ptd->aead_ctx[is_encrypt];
+  ipsec_sa_t *sa;
+
+  /* expand the key schedule once per run of packets on the same SA */
+  if (PREDICT_FALSE (ptd->aead_sa_index[is_encrypt] != sa_index ||
+		     ptd->aead_sa_generation[is_encrypt] !=
+		     em->sa_generation))
+    {
+      sa = pool_elt_at_index (ipsec_main.sad, sa_index);
+      ptd->aead_sa_generation[is_encrypt] = em->sa_generation;
+      ptd->aead_sa_index[is_encrypt] = sa_index;
+      if (is_encrypt)
+	EVP_EncryptInit_ex (ctx, em->esp_crypto_algs[sa->crypto_alg].type,
+			    NULL, sa->crypto_key, NULL);
+      else
+	EVP_DecryptInit_ex (ctx, em->esp_crypto_algs[sa->crypto_alg].type,
+			    NULL, sa->crypto_key, NULL);
+    }
+
+  return ctx;
+}
+
+/*
+ * Encrypt and compute the ICV, or decrypt and check it, for a frame's
+ * worth of ops. Keeping the crypto out of the per packet work means the
+ * key schedule is expanded once per SA rather than once per packet, and
+ * the AES-NI/PCLMUL (or ChaCha20 SIMD) code stays hot in the cache.
+ */
+always_inline void
+esp_aead_process_ops (esp_aead_op_t * ops, u32 n_ops, int is_encrypt)
+{
+  esp_main_t *em = &esp_main;
+  esp_main_per_thread_data_t *ptd;
+  esp_aead_op_t *op;
+  EVP_CIPHER_CTX *ctx;
+  int len;
+
+  ptd = vec_elt_at_index (em->per_thread_data, vlib_get_thread_index ());
+
+  for (op = ops; op < ops + n_ops; op++)
+    {
+      if (PREDICT_TRUE (op + 2 < ops + n_ops))
+	{
+	  CLIB_PREFETCH (op[2].src, CLIB_CACHE_LINE_BYTES, LOAD);
+	  CLIB_PREFETCH (op[2].dst, CLIB_CACHE_LINE_BYTES, STORE);
+	}
+
+      if (PREDICT_FALSE (op->skip))
+	continue;
+
+      ctx = esp_aead_get_ctx (ptd, op->sa_index, is_encrypt);
+
+      if (is_encrypt)
+	{
+	  EVP_EncryptInit_ex (ctx, NULL, NULL, NULL, op->nonce);
+	  EVP_EncryptUpdate (ctx, NULL, &len, op->aad, op->aad_len);
+	  EVP_EncryptUpdate (ctx, op->dst, &len, op->src, op->len);
+	  EVP_EncryptFinal_ex (ctx, op->dst + len, &len);
+	  EVP_CIPHER_CTX_ctrl (ctx, EVP_CTRL_GCM_GET_TAG, ESP_AEAD_ICV_SIZE,
+			       op->tag);
+	}
+      else
+	{
+	  EVP_DecryptInit_ex (ctx, NULL, NULL, NULL, op->nonce);
+	  EVP_DecryptUpdate (ctx, NULL, &len, op->aad, op->aad_len);
+	  EVP_DecryptUpdate (ctx, op->dst, &len, op->src, op->len);
+	  EVP_CIPHER_CTX_ctrl (ctx, EVP_CTRL_GCM_SET_TAG, ESP_AEAD_ICV_SIZE,
+			       op->tag);
+	  op->auth_failed = EVP_DecryptFinal_ex (ctx, op->dst + len, &len) <= 0;
+	}
     }
 }
 
@@ -80,36 +80,163 @@ format_esp_decrypt_trace (u8 * s, va_list * args)
   return s;
 }
 
-always_inline void
-esp_decrypt_aes_cbc (ipsec_crypto_alg_t alg,
-		     u8 * in, u8 * out, size_t in_len, u8 * key, u8 * iv)
+/*
+ * Authenticate and decrypt, in place, the frame's AEAD packets in one go.
+ * The per packet work which follows needs their plaintext. One op is
+ * queued per AEAD packet, in frame order, ops which can not be done are
+ * marked skip.
+ */
+static_always_inline void
+esp_decrypt_aead_prepare (vlib_main_t * vm, esp_main_per_thread_data_t * ptd,
+			  u32 * from, u32 n_left_from)
 {
+  ipsec_main_t *im = &ipsec_main;
   esp_main_t *em = &esp_main;
-  u32 thread_index = vlib_get_thread_index ();
-#if OPENSSL_VERSION_NUMBER >= 0x10100000L
-  EVP_CIPHER_CTX *ctx = em->per_thread_data[thread_index].decrypt_ctx;
-#else
-  EVP_CIPHER_CTX *ctx = &(em->per_thread_data[thread_index].decrypt_ctx);
-#endif
-  const EVP_CIPHER *cipher = NULL;
-  int out_len;
+  vlib_buffer_t *b0;
+  esp_header_t *esp0;
+  esp_aead_op_t *op0;
+  ipsec_sa_t *sa0;
+  u32 sa_index0, seq0;
+  const u32 overhead = sizeof (esp_header_t) + ESP_AEAD_IV_SIZE +
+    sizeof (esp_footer_t) + ESP_AEAD_ICV_SIZE;
+
+  vec_reset_length (ptd->aead_ops);
+
+  while (n_left_from > 0)
+    {
+      b0 = vlib_get_buffer (vm, from[0]);
+      from += 1;
+      n_left_from -= 1;
 
-  ASSERT (alg < IPSEC_CRYPTO_N_ALG);
+      sa_index0 = vnet_buffer (b0)->ipsec.sad_index;
+      sa0 = pool_elt_at_index (im->sad, sa_index0);
 
-  if (PREDICT_FALSE (em->esp_crypto_algs[alg].type == 0))
-    return;
+      if (!em->esp_crypto_algs[sa0->crypto_alg].is_aead)
+	continue;
 
-  if (PREDICT_FALSE
-      (alg != em->per_thread_data[thread_index].last_decrypt_alg))
+      vec_add2 (ptd->aead_ops, op0, 1);
+      esp0 = vlib_buffer_get_current (b0);
+      seq0 = clib_host_to_net_u32 (esp0->seq);
+
+      /* also picks the high order sequence number the AAD needs */
+      if (sa0->use_anti_replay)
+	{
+	  if (PREDICT_TRUE (sa0->use_esn))
+	    op0->skip = esp_replay_check_esn (sa0, seq0);
+	  else
+	    op0->skip = esp_replay_check (sa0, seq0);
+	  if (PREDICT_FALSE (op0->skip))
+	    continue;
+	}
+
+      if (PREDICT_FALSE (b0->current_length < overhead ||
+			 (b0->flags & VLIB_BUFFER_NEXT_PRESENT)))
+	{
+	  op0->skip = 1;
+	  continue;
+	}
+
+      esp_aead_op_init (op0, sa0, sa_index0, esp0, esp0->data);
+      op0->src = op0->dst = esp0->data + ESP_AEAD_IV_SIZE;
+      op0->len = b0->current_length - sizeof (esp_header_t) -
+	ESP_AEAD_IV_SIZE - ESP_AEAD_ICV_SIZE;
+      op0->tag = op0->src + op0->len;
+    }
+
+  esp_aead_process_ops (ptd->aead_ops, vec_len (ptd->aead_ops),
+			0 /* is_encrypt */ );
+}
+
+/*
+ * Strip the ESP header, IV, trailer and ICV from a decrypted AEAD packet,
+ * which is forwarded in the buffer it came in. Returns an error, or ~0.
+ */
+static_always_inline u32
+esp_decrypt_aead_rewrite (vlib_main_t * vm, vlib_buffer_t * b0,
+			  ipsec_sa_t * sa0, esp_aead_op_t * op0, u32 * next0)
+{
+  esp_footer_t *f0;
+  ip4_header_t *ih4, *oh4, ip4;
+  ip6_header_t *ih6, *oh6, ip6;
+  u32 len0;
+
+  f0 = (esp_footer_t *) (op0->dst + op0->len - sizeof (*f0));
+  if (PREDICT_FALSE (f0->pad_length + sizeof (*f0) > op0->len))
+    return ESP_DECRYPT_ERROR_DECRYPTION_FAILED;
+  len0 = op0->len - sizeof (*f0) - f0->pad_length;
+
+  if (PREDICT_TRUE (sa0->is_tunnel || sa0->is_tunnel_ip6))
+    {
+      if (PREDICT_TRUE (f0->next_header == IP_PROTOCOL_IP_IN_IP))
+	*next0 = ESP_DECRYPT_NEXT_IP4_INPUT;
+      else if (f0->next_header == IP_PROTOCOL_IPV6)
+	*next0 = ESP_DECRYPT_NEXT_IP6_INPUT;
+      else
+	return ESP_DECRYPT_ERROR_DECRYPTION_FAILED;
+
+      vlib_buffer_advance (b0, sizeof (esp_header_t) + ESP_AEAD_IV_SIZE);
+      b0->current_length = len0;
+    }
+  else
     {
-      cipher = em->esp_crypto_algs[alg].type;
-      em->per_thread_data[thread_index].last_decrypt_alg = alg;
+      /*
+       * transport mode: the IP header moves up to the payload, over
+       * the ESP header and IV, which it may overlap, so copy it first.
+       */
+      ih4 = (ip4_header_t *) (b0->data + sizeof (ethernet_header_t));
+      if (PREDICT_TRUE ((ih4->ip_version_and_header_length & 0xF0) == 0x40))
+	{
+	  ip4 = *ih4;
+	  vlib_buffer_advance (b0, (word) (sizeof (esp_header_t) +
+					   ESP_AEAD_IV_SIZE) -
+			       (word) sizeof (ip4_header_t));
+	  b0->current_length = len0 + sizeof (ip4_header_t);
+	  oh4 = vlib_buffer_get_current (b0);
+	  oh4->ip_version_and_header_length = 0x45;
+	  oh4->tos = ip4.tos;
+	  oh4->fragment_id = 0;
+	  oh4->flags_and_fragment_offset = 0;
+	  oh4->ttl = ip4.ttl;
+	  oh4->protocol = f0->next_header;
+	  oh4->src_address.as_u32 = ip4.src_address.as_u32;
+	  oh4->dst_address.as_u32 = ip4.dst_address.as_u32;
+	  oh4->length = clib_host_to_net_u16 (b0->current_length);
+	  oh4->checksum = ip4_header_checksum (oh4);
+	  *next0 = ESP_DECRYPT_NEXT_IP4_INPUT;
+	}
+      else if ((ih4->ip_version_and_header_length & 0xF0) == 0x60)
+	{
+	  ih6 = (ip6_header_t *) ih4;
+	  ip6 = *ih6;
+	  vlib_buffer_advance (b0, (word) (sizeof (esp_header_t) +
+					   ESP_AEAD_IV_SIZE) -
+			       (word) sizeof (ip6_header_t));
+	  b0->current_length = len0 + sizeof (ip6_header_t);
+	  oh6 = vlib_buffer_get_current (b0);
+	  oh6->ip_version_traffic_class_and_flow_label =
+	    ip6.ip_version_traffic_class_and_flow_label;
+	  oh6->protocol = f0->next_header;
+	  oh6->hop_limit = ip6.hop_limit;
+	  oh6->src_address.as_u64[0] = ip6.src_address.as_u64[0];
+	  oh6->src_address.as_u64[1] = ip6.src_address.as_u64[1];
+	  oh6->dst_address.as_u64[0] = ip6.dst_address.as_u64[0];
+	  oh6->dst_address.as_u64[1] = ip6.dst_address.as_u64[1];
+	  oh6->payload_length = clib_host_to_net_u16 (len0);
+	  *next0 = ESP_DECRYPT_NEXT_IP6_INPUT;
+	}
+      else
+	return ESP_DECRYPT_ERROR_NOT_IP;
     }
 
-  EVP_DecryptInit_ex (ctx, cipher, NULL, key, iv);
+  /* for IPSec-GRE tunnel next node is ipsec-gre-input */
+  if (PREDICT_FALSE
+      ((vnet_buffer (b0)->ipsec.flags) & IPSEC_FLAG_IPSEC_GRE_TUNNEL))
+    *next0 = ESP_DECRYPT_NEXT_IPSEC_GRE_INPUT;
+
+  b0->flags |= VLIB_BUFFER_TOTAL_LENGTH_VALID;
+  vnet_buffer (b0)->sw_if_index[VLIB_TX] = (u32) ~ 0;
 
-  EVP_DecryptUpdate (ctx, out, &out_len, in, in_len);
-  EVP_DecryptFinal_ex (ctx, out + out_len, &out_len);
+  return ~0;
 }
 
 static uword
@@ -123,6 +250,9 @@ esp_decrypt_node_fn (vlib_main_t * vm,
   from = vlib_frame_vector_args (from_frame);
   n_left_from = from_frame->n_vectors;
   u32 thread_index = vlib_get_thread_index ();
+  esp_main_per_thread_data_t *ptd =
+    vec_elt_at_index (em->per_thread_data, thread_index);
+  esp_aead_op_t *aead_op = 0;
 
   ipsec_alloc_empty_buffers (vm, im);
 
@@ -135,6 +265,9 @@ esp_decrypt_node_fn (vlib_main_t * vm,
       goto free_buffers_and_exit;
     }
 
+  esp_decrypt_aead_prepare (vm, ptd, from, n_left_from);
+  aead_op = ptd->aead_ops;
+
   next_index = node->cached_next_index;
 
   while (n_left_from > 0)
@@ -156,6 +289,8 @@ esp_decrypt_node_fn (vlib_main_t * vm,
 	  ip6_header_t *ih6 = 0, *oh6 = 0;
 	  u8 tunnel_mode = 1;
 	  u8 transport_ip6 = 0;
+	  esp_aead_op_t *op0 = 0;
+	  u32 error0;
 
 
 	  i_bi0 = from[0];
@@ -173,6 +308,10 @@ esp_decrypt_node_fn (vlib_main_t * vm,
 
 	  seq = clib_host_to_net_u32 (esp0->seq);
 
+	  /* the AEAD ops are in frame order */
+	  if (em->esp_crypto_algs[sa0->crypto_alg].is_aead)
+	    op0 = aead_op++;
+
 	  /* anti-replay check */
 	  if (sa0->use_anti_replay)
 	    {
@@ -197,6 +336,37 @@ esp_decrypt_node_fn (vlib_main_t * vm,
 
 	  sa0->total_data_size += i_b0->current_length;
 
+	  if (op0)
+	    {
+	      if (PREDICT_FALSE (op0->skip))
+		error0 = ESP_DECRYPT_ERROR_DECRYPTION_FAILED;
+	      else if (PREDICT_FALSE (op0->auth_failed))
+		error0 = ESP_DECRYPT_ERROR_INTEG_ERROR;
+	      else
+		error0 = esp_decrypt_aead_rewrite (vm, i_b0, sa0, op0, &next0);
+
+	      o_bi0 = i_bi0;
+	      to_next[0] = o_bi0;
+	      to_next += 1;
+	      if (PREDICT_FALSE (error0 != ~0))
+		{
+		  vlib_node_increment_counter (vm, esp_decrypt_node.index,
+					       error0, 1);
+		  next0 = ESP_DECRYPT_NEXT_DROP;
+		  goto trace;
+		}
+
+	      if (PREDICT_TRUE (sa0->use_anti_replay))
+		{
+		  if (PREDICT_TRUE (sa0->use_esn))
+		    esp_replay_advance_esn (sa0, seq);
+		  else
+		    esp_replay_advance (sa0, seq);
+		}
+	      o_b0 = i_b0;
+	      goto trace;
+	    }
+
 	  if (PREDICT_TRUE (sa0->integ_alg != IPSEC_INTEG_ALG_NONE))
 	    {
 	      u8 sig[64];
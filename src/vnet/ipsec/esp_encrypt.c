@@ -84,38 +84,6 @@ format_esp_encrypt_trace (u8 * s, va_list * args)
   return s;
 }
 
-always_inline void
-esp_encrypt_aes_cbc (ipsec_crypto_alg_t alg,
-		     u8 * in, u8 * out, size_t in_len, u8 * key, u8 * iv)
-{
-  esp_main_t *em = &esp_main;
-  u32 thread_index = vlib_get_thread_index ();
-#if OPENSSL_VERSION_NUMBER >= 0x10100000L
-  EVP_CIPHER_CTX *ctx = em->per_thread_data[thread_index].encrypt_ctx;
-#else
-  EVP_CIPHER_CTX *ctx = &(em->per_thread_data[thread_index].encrypt_ctx);
-#endif
-  const EVP_CIPHER *cipher = NULL;
-  int out_len;
-
-  ASSERT (alg < IPSEC_CRYPTO_N_ALG);
-
-  if (PREDICT_FALSE (em->esp_crypto_algs[alg].type == IPSEC_CRYPTO_ALG_NONE))
-    return;
-
-  if (PREDICT_FALSE
-      (alg != em->per_thread_data[thread_index].last_encrypt_alg))
-    {
-      cipher = em->esp_crypto_algs[alg].type;
-      em->per_thread_data[thread_index].last_encrypt_alg = alg;
-    }
-
-  EVP_EncryptInit_ex (ctx, cipher, NULL, key, iv);
-
-  EVP_EncryptUpdate (ctx, out, &out_len, in, in_len);
-  EVP_EncryptFinal_ex (ctx, out + out_len, &out_len);
-}
-
 static uword
 esp_encrypt_node_fn (vlib_main_t * vm,
 		     vlib_node_runtime_t * node, vlib_frame_t * from_frame)
@@ -124,10 +92,14 @@ esp_encrypt_node_fn (vlib_main_t * vm,
   from = vlib_frame_vector_args (from_frame);
   n_left_from = from_frame->n_vectors;
   ipsec_main_t *im = &ipsec_main;
+  esp_main_t *em = &esp_main;
   u32 *recycle = 0;
   u32 thread_index = vlib_get_thread_index ();
+  esp_main_per_thread_data_t *ptd =
+    vec_elt_at_index (em->per_thread_data, thread_index);
 
   ipsec_alloc_empty_buffers (vm, im);
+  vec_reset_length (ptd->aead_ops);
 
   u32 *empty_buffers = im->empty_buffers[thread_index];
 
@@ -302,7 +274,44 @@ esp_encrypt_node_fn (vlib_main_t * vm,
 
 	  ASSERT (sa0->crypto_alg < IPSEC_CRYPTO_N_ALG);
 
-	  if (PREDICT_TRUE (sa0->crypto_alg != IPSEC_CRYPTO_ALG_NONE))
+	  if (em->esp_crypto_algs[sa0->crypto_alg].is_aead)
+	    {
+	      esp_aead_op_t *op0;
+	      u32 len0 = i_b0->current_length;
+	      /* no block alignment, only a 4 byte aligned trailer */
+	      u8 pad_bytes = (4 - ((len0 + sizeof (esp_footer_t)) & 3)) & 3;
+	      u8 i;
+	      u8 *padding = vlib_buffer_get_current (i_b0) + len0;
+	      u32 iv0[2];
+
+	      for (i = 0; i < pad_bytes; ++i)
+		padding[i] = i + 1;
+	      len0 += pad_bytes + sizeof (esp_footer_t);
+	      i_b0->current_length = len0;
+	      f0 = vlib_buffer_get_current (i_b0) + len0 - sizeof (*f0);
+	      f0->pad_length = pad_bytes;
+	      f0->next_header = next_hdr_type;
+
+	      o_b0->current_length = ip_hdr_size + sizeof (esp_header_t) +
+		ESP_AEAD_IV_SIZE + len0 + ESP_AEAD_ICV_SIZE;
+
+	      vnet_buffer (o_b0)->sw_if_index[VLIB_RX] =
+		vnet_buffer (i_b0)->sw_if_index[VLIB_RX];
+
+	      /* the sequence number is unique per SA, it makes a fine IV */
+	      iv0[0] = clib_host_to_net_u32 (sa0->seq_hi);
+	      iv0[1] = clib_host_to_net_u32 (sa0->seq);
+	      clib_memcpy (o_esp0->data, iv0, sizeof (iv0));
+
+	      /* the crypto is done for the whole frame, below */
+	      vec_add2 (ptd->aead_ops, op0, 1);
+	      esp_aead_op_init (op0, sa0, sa_index0, o_esp0, o_esp0->data);
+	      op0->src = vlib_buffer_get_current (i_b0);
+	      op0->dst = o_esp0->data + ESP_AEAD_IV_SIZE;
+	      op0->len = len0;
+	      op0->tag = op0->dst + len0;
+	    }
+	  else if (PREDICT_TRUE (sa0->crypto_alg != IPSEC_CRYPTO_ALG_NONE))
 	    {
 
 	      const int BLOCK_SIZE = 16;
@@ -343,6 +352,7 @@ esp_encrypt_node_fn (vlib_main_t * vm,
 				   sa0->crypto_key, iv);
 	    }
 
+	  /* AEAD SAs have no integ-alg, hmac_calc () adds nothing */
 	  o_b0->current_length += hmac_calc (sa0->integ_alg, sa0->integ_key,
 					     sa0->integ_key_len,
 					     (u8 *) o_esp0,
@@ -391,6 +401,11 @@ esp_encrypt_node_fn (vlib_main_t * vm,
 	}
       vlib_put_next_frame (vm, node, next_index, n_left_to_next);
     }
+
+  /* before the input buffers, which hold the plaintext, are freed */
+  esp_aead_process_ops (ptd->aead_ops, vec_len (ptd->aead_ops),
+			1 /* is_encrypt */ );
+
   vlib_node_increment_counter (vm, esp_encrypt_node.index,
 			       ESP_ENCRYPT_ERROR_RX_PKTS,
 			       from_frame->n_vectors);
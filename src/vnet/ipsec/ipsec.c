@@ -126,6 +126,7 @@ ipsec_add_del_spd (vlib_main_t * vm, u32 spd_id, int is_add)
       spd->id = spd_id;
       hash_set (im->spd_index_by_spd_id, spd_id, spd_index);
     }
+  ipsec_spd_flow_cache_flush ();
   return 0;
 }
 
@@ -376,9 +377,32 @@ ipsec_add_del_policy (vlib_main_t * vm, ipsec_policy_t * policy, int is_add)
       /* *INDENT-ON* */
     }
 
+  ipsec_spd_flow_cache_flush ();
   return 0;
 }
 
+void
+ipsec_spd_flow_cache_flush (void)
+{
+  ipsec_main_t *im = &ipsec_main;
+  ipsec_spd_flow_cache_t *fc;
+
+  /*
+   * Called with the workers stopped. Epoch 0 is never current, so the
+   * zeroed tables start out empty; on wrap clear them so that a slot left
+   * over from 2^32 flushes ago cannot match.
+   */
+  if (PREDICT_TRUE (++im->spd_flow_cache_epoch != 0))
+    return;
+
+  vec_foreach (fc, im->spd_flow_caches)
+  {
+    vec_zero (fc->ip4_entries);
+    vec_zero (fc->ip6_entries);
+  }
+  im->spd_flow_cache_epoch = 1;
+}
+
 u8
 ipsec_is_sa_used (u32 sa_index)
 {
@@ -525,14 +549,48 @@ ipsec_rand_seed (void)
 static clib_error_t *
 ipsec_check_support (ipsec_sa_t * sa)
 {
-  if (sa->crypto_alg == IPSEC_CRYPTO_ALG_AES_GCM_128)
-    return clib_error_return (0, "unsupported aes-gcm-128 crypto-alg");
+  esp_main_t *em = &esp_main;
+  esp_crypto_alg_t *alg;
+
+  ASSERT (sa->crypto_alg < IPSEC_CRYPTO_N_ALG);
+  alg = &em->esp_crypto_algs[sa->crypto_alg];
+
+  if (sa->crypto_alg != IPSEC_CRYPTO_ALG_NONE && !alg->type)
+    return clib_error_return (0, "unsupported %U crypto-alg",
+			      format_ipsec_crypto_alg, sa->crypto_alg);
+
+  if (alg->is_aead)
+    {
+      if (sa->integ_alg != IPSEC_INTEG_ALG_NONE)
+	return clib_error_return (0, "%U crypto-alg requires none integ-alg",
+				  format_ipsec_crypto_alg, sa->crypto_alg);
+      /* the keying material ends with the salt */
+      if (sa->crypto_key_len !=
+	  EVP_CIPHER_key_length (alg->type) + ESP_AEAD_SALT_SIZE)
+	return clib_error_return (0, "%U crypto-key must be %d bytes",
+				  format_ipsec_crypto_alg, sa->crypto_alg,
+				  EVP_CIPHER_key_length (alg->type) +
+				  ESP_AEAD_SALT_SIZE);
+      return 0;
+    }
+
   if (sa->integ_alg == IPSEC_INTEG_ALG_NONE)
     return clib_error_return (0, "unsupported none integ-alg");
 
   return 0;
 }
 
+static clib_error_t *
+ipsec_add_del_sa_sess (u32 sa_index, u8 is_add)
+{
+  ipsec_main_t *im = &ipsec_main;
+
+  /* also called, with is_add 0, when the keys change */
+  esp_sa_update (pool_elt_at_index (im->sad, sa_index));
+
+  return 0;
+}
+
 static clib_error_t *
 ipsec_init (vlib_main_t * vm)
 {
@@ -555,6 +613,16 @@ ipsec_init (vlib_main_t * vm)
   vec_validate_aligned (im->empty_buffers, tm->n_vlib_mains - 1,
 			CLIB_CACHE_LINE_BYTES);
 
+  /* the tables themselves are allocated by each thread on first use */
+  vec_validate_aligned (im->spd_flow_caches, tm->n_vlib_mains - 1,
+			CLIB_CACHE_LINE_BYTES);
+  im->spd_flow_cache_epoch = 1;
+  im->spd_flow_cache_enabled = 1;
+  im->spd_flow_cache_ip4_log2_size =
+    IPSEC_SPD_FLOW_CACHE_DEFAULT_IP4_LOG2_SIZE;
+  im->spd_flow_cache_ip6_log2_size =
+    IPSEC_SPD_FLOW_CACHE_DEFAULT_IP6_LOG2_SIZE;
+
   node = vlib_get_node_by_name (vm, (u8 *) "error-drop");
   ASSERT (node);
   im->error_drop_node_index = node->index;
@@ -571,6 +639,7 @@ ipsec_init (vlib_main_t * vm)
   im->esp_decrypt_next_index = IPSEC_INPUT_NEXT_ESP_DECRYPT;
 
   im->cb.check_support_cb = ipsec_check_support;
+  im->cb.add_del_sa_sess_cb = ipsec_add_del_sa_sess;
 
   if ((error = vlib_call_init_function (vm, ipsec_cli_init)))
     return error;
@@ -17,6 +17,7 @@
 
 #include <vnet/ip/ip.h>
 #include <vnet/feature/feature.h>
+#include <vppinfra/xxhash.h>
 
 #define IPSEC_FLAG_IPSEC_GRE_TUNNEL (1 << 0)
 
@@ -71,7 +72,8 @@ typedef enum
   _(6, AES_CTR_256, "aes-ctr-256")  \
   _(7, AES_GCM_128, "aes-gcm-128")  \
   _(8, AES_GCM_192, "aes-gcm-192")  \
-  _(9, AES_GCM_256, "aes-gcm-256")
+  _(9, AES_GCM_256, "aes-gcm-256")  \
+  _(10, CHACHA20_POLY1305, "chacha20-poly1305")
 
 typedef enum
 {
@@ -224,6 +226,80 @@ typedef struct
   u32 *ipv6_inbound_policy_discard_and_bypass_indices;
 } ipsec_spd_t;
 
+/*
+ * SPD flow cache.
+ *
+ * The policies of an SPD are address and port ranges which have to be
+ * scanned in priority order, so instead of compiling them the result of
+ * the ordered scan is cached per flow. Each thread owns a direct-mapped
+ * table keyed on the SPD and the packet's selector; a slot is valid only
+ * while its epoch matches ipsec_main.spd_flow_cache_epoch, which is bumped
+ * (with the workers stopped) whenever a policy or an SPD is added or
+ * deleted. The cached value is exactly what the linear scan returned, so
+ * the priority semantics are unchanged.
+ */
+typedef enum
+{
+  IPSEC_SPD_FLOW_OUTBOUND,
+  IPSEC_SPD_FLOW_INBOUND_PROTECT,
+} ipsec_spd_flow_dir_t;
+
+typedef struct
+{
+  union
+  {
+    struct
+    {
+      u32 spd_index;
+      u32 laddr;
+      u32 raddr;
+      /* ports (local << 16 | remote) outbound, SPI inbound */
+      u32 ports_or_spi;
+      u8 protocol;
+      u8 dir;
+      u16 pad;
+      u32 pad1;
+    };
+    u64 as_u64[3];
+  };
+  u32 policy_index;
+  u32 epoch;
+} ipsec_spd_flow_cache_ip4_entry_t;
+
+typedef struct
+{
+  union
+  {
+    struct
+    {
+      ip6_address_t laddr;
+      ip6_address_t raddr;
+      u32 spd_index;
+      u32 ports_or_spi;
+      u8 protocol;
+      u8 dir;
+      u16 pad;
+      u32 pad1;
+    };
+    u64 as_u64[6];
+  };
+  u32 policy_index;
+  u32 epoch;
+  u64 pad2;
+} ipsec_spd_flow_cache_ip6_entry_t;
+
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  ipsec_spd_flow_cache_ip4_entry_t *ip4_entries;
+  ipsec_spd_flow_cache_ip6_entry_t *ip6_entries;
+  u64 hits;
+  u64 misses;
+} ipsec_spd_flow_cache_t;
+
+#define IPSEC_SPD_FLOW_CACHE_DEFAULT_IP4_LOG2_SIZE 16
+#define IPSEC_SPD_FLOW_CACHE_DEFAULT_IP6_LOG2_SIZE 14
+
 typedef struct
 {
   u32 spd_index;
@@ -284,6 +360,13 @@ typedef struct
 
   /* callbacks */
   ipsec_main_callbacks_t cb;
+
+  /* per-thread SPD flow caches */
+  ipsec_spd_flow_cache_t *spd_flow_caches;
+  volatile u32 spd_flow_cache_epoch;
+  u8 spd_flow_cache_enabled;
+  u8 spd_flow_cache_ip4_log2_size;
+  u8 spd_flow_cache_ip6_log2_size;
 } ipsec_main_t;
 
 extern ipsec_main_t ipsec_main;
@@ -327,6 +410,7 @@ int ipsec_set_interface_key (vnet_main_t * vnm, u32 hw_if_index,
 			     ipsec_if_set_key_type_t type, u8 alg, u8 * key);
 int ipsec_set_interface_sa (vnet_main_t * vnm, u32 hw_if_index, u32 sa_id,
 			    u8 is_outbound);
+void ipsec_spd_flow_cache_flush (void);
 
 
 /*
@@ -354,6 +438,95 @@ ipsec_alloc_empty_buffers (vlib_main_t * vm, ipsec_main_t * im)
     }
 }
 
+/*
+ * Find the flow cache slot for a key. On a hit the slot's policy_index is
+ * the cached result; on a miss the slot has been claimed for the key and
+ * the caller stores the result of the linear scan in policy_index. Returns
+ * 0 if the cache is disabled.
+ */
+always_inline ipsec_spd_flow_cache_ip4_entry_t *
+ipsec_spd_flow_cache_ip4_find (ipsec_main_t * im, u32 thread_index,
+			       ipsec_spd_flow_cache_ip4_entry_t * key,
+			       int *hit)
+{
+  ipsec_spd_flow_cache_t *fc;
+  ipsec_spd_flow_cache_ip4_entry_t *e;
+  u64 h;
+
+  if (PREDICT_FALSE (!im->spd_flow_cache_enabled))
+    return 0;
+
+  fc = vec_elt_at_index (im->spd_flow_caches, thread_index);
+  if (PREDICT_FALSE (fc->ip4_entries == 0))
+    vec_validate_aligned (fc->ip4_entries,
+			  (1 << im->spd_flow_cache_ip4_log2_size) - 1,
+			  CLIB_CACHE_LINE_BYTES);
+
+  h = clib_xxhash (key->as_u64[0] ^ key->as_u64[1] ^
+		   (key->as_u64[2] << 7));
+  e = fc->ip4_entries + (h & (vec_len (fc->ip4_entries) - 1));
+
+  if (PREDICT_TRUE (e->epoch == im->spd_flow_cache_epoch &&
+		    e->as_u64[0] == key->as_u64[0] &&
+		    e->as_u64[1] == key->as_u64[1] &&
+		    e->as_u64[2] == key->as_u64[2]))
+    {
+      fc->hits++;
+      *hit = 1;
+      return e;
+    }
+
+  fc->misses++;
+  *hit = 0;
+  e->as_u64[0] = key->as_u64[0];
+  e->as_u64[1] = key->as_u64[1];
+  e->as_u64[2] = key->as_u64[2];
+  e->epoch = im->spd_flow_cache_epoch;
+  return e;
+}
+
+always_inline ipsec_spd_flow_cache_ip6_entry_t *
+ipsec_spd_flow_cache_ip6_find (ipsec_main_t * im, u32 thread_index,
+			       ipsec_spd_flow_cache_ip6_entry_t * key,
+			       int *hit)
+{
+  ipsec_spd_flow_cache_t *fc;
+  ipsec_spd_flow_cache_ip6_entry_t *e;
+  u64 h;
+  int i;
+
+  if (PREDICT_FALSE (!im->spd_flow_cache_enabled))
+    return 0;
+
+  fc = vec_elt_at_index (im->spd_flow_caches, thread_index);
+  if (PREDICT_FALSE (fc->ip6_entries == 0))
+    vec_validate_aligned (fc->ip6_entries,
+			  (1 << im->spd_flow_cache_ip6_log2_size) - 1,
+			  CLIB_CACHE_LINE_BYTES);
+
+  h = clib_xxhash (key->as_u64[0] ^ key->as_u64[1] ^
+		   (key->as_u64[2] << 3) ^ (key->as_u64[3] << 5) ^
+		   (key->as_u64[4] << 7) ^ (key->as_u64[5] << 11));
+  e = fc->ip6_entries + (h & (vec_len (fc->ip6_entries) - 1));
+
+  if (PREDICT_TRUE (e->epoch == im->spd_flow_cache_epoch))
+    {
+      for (i = 0; i < ARRAY_LEN (key->as_u64); i++)
+	if (e->as_u64[i] != key->as_u64[i])
+	  goto miss;
+      fc->hits++;
+      *hit = 1;
+      return e;
+    }
+
+miss:
+  fc->misses++;
+  *hit = 0;
+  clib_memcpy (e->as_u64, key->as_u64, sizeof (key->as_u64));
+  e->epoch = im->spd_flow_cache_epoch;
+  return e;
+}
+
 static_always_inline u32
 get_next_output_feature_node_index (vlib_buffer_t * b,
 				    vlib_node_runtime_t * nr)
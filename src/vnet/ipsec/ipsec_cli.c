@@ -21,6 +21,7 @@
 #include <vnet/interface.h>
 
 #include <vnet/ipsec/ipsec.h>
+#include <vnet/ipsec/esp.h>
 
 static clib_error_t *
 set_interface_spd_command_fn (vlib_main_t * vm,
@@ -662,6 +663,7 @@ clear_ipsec_counters_command_fn (vlib_main_t * vm,
   ipsec_main_t *im = &ipsec_main;
   ipsec_spd_t *spd;
   ipsec_policy_t *p;
+  ipsec_spd_flow_cache_t *fc;
 
   /* *INDENT-OFF* */
   pool_foreach (spd, im->spds, ({
@@ -671,6 +673,11 @@ clear_ipsec_counters_command_fn (vlib_main_t * vm,
   }));
   /* *INDENT-ON* */
 
+  vec_foreach (fc, im->spd_flow_caches)
+  {
+    fc->hits = fc->misses = 0;
+  }
+
   return 0;
 }
 
@@ -682,6 +689,122 @@ VLIB_CLI_COMMAND (clear_ipsec_counters_command, static) = {
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+show_ipsec_spd_flow_cache_command_fn (vlib_main_t * vm,
+				      unformat_input_t * input,
+				      vlib_cli_command_t * cmd)
+{
+  ipsec_main_t *im = &ipsec_main;
+  ipsec_spd_flow_cache_t *fc;
+  u64 hits = 0, misses = 0;
+
+  vlib_cli_output (vm, "SPD flow cache: %s, epoch %u",
+		   im->spd_flow_cache_enabled ? "enabled" : "disabled",
+		   im->spd_flow_cache_epoch);
+  vlib_cli_output (vm, "  ip4 entries %u, ip6 entries %u (per thread)",
+		   1 << im->spd_flow_cache_ip4_log2_size,
+		   1 << im->spd_flow_cache_ip6_log2_size);
+
+  vec_foreach (fc, im->spd_flow_caches)
+  {
+    if (fc->ip4_entries == 0 && fc->ip6_entries == 0)
+      continue;
+    vlib_cli_output (vm, "  thread %u: hits %llu misses %llu",
+		     fc - im->spd_flow_caches, fc->hits, fc->misses);
+    hits += fc->hits;
+    misses += fc->misses;
+  }
+
+  if (hits + misses)
+    vlib_cli_output (vm, "  total: hits %llu misses %llu hit rate %.2f%%",
+		     hits, misses, 100.0 * hits / (hits + misses));
+
+  return 0;
+}
+
+/*?
+ * Show the state of the per-thread SPD flow caches which hold the result
+ * of the SPD policy lookup for recently seen flows.
+ *
+ * @cliexpar
+ * @cliexstart{show ipsec spd flow-cache}
+ * SPD flow cache: enabled, epoch 7
+ *   ip4 entries 65536, ip6 entries 16384 (per thread)
+ *   thread 1: hits 998723 misses 1277
+ *   total: hits 998723 misses 1277 hit rate 99.87%
+ * @cliexend
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_ipsec_spd_flow_cache_command, static) = {
+    .path = "show ipsec spd flow-cache",
+    .short_help = "show ipsec spd flow-cache",
+    .function = show_ipsec_spd_flow_cache_command_fn,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+set_ipsec_spd_flow_cache_command_fn (vlib_main_t * vm,
+				     unformat_input_t * input,
+				     vlib_cli_command_t * cmd)
+{
+  ipsec_main_t *im = &ipsec_main;
+  ipsec_spd_flow_cache_t *fc;
+  u32 ip4_log2_size = im->spd_flow_cache_ip4_log2_size;
+  u32 ip6_log2_size = im->spd_flow_cache_ip6_log2_size;
+  int enable = im->spd_flow_cache_enabled;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "enable"))
+	enable = 1;
+      else if (unformat (input, "disable"))
+	enable = 0;
+      else if (unformat (input, "ip4-log2-size %u", &ip4_log2_size))
+	;
+      else if (unformat (input, "ip6-log2-size %u", &ip6_log2_size))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (ip4_log2_size < 4 || ip4_log2_size > 24 ||
+      ip6_log2_size < 4 || ip6_log2_size > 24)
+    return clib_error_return (0, "log2 size must be between 4 and 24");
+
+  /* the workers are stopped; they reallocate their tables on first use */
+  if (ip4_log2_size != im->spd_flow_cache_ip4_log2_size ||
+      ip6_log2_size != im->spd_flow_cache_ip6_log2_size || !enable)
+    vec_foreach (fc, im->spd_flow_caches)
+    {
+      vec_free (fc->ip4_entries);
+      vec_free (fc->ip6_entries);
+    }
+
+  im->spd_flow_cache_ip4_log2_size = ip4_log2_size;
+  im->spd_flow_cache_ip6_log2_size = ip6_log2_size;
+  im->spd_flow_cache_enabled = enable;
+  ipsec_spd_flow_cache_flush ();
+
+  return 0;
+}
+
+/*?
+ * Enable, disable or resize the per-thread SPD flow caches. Disabling the
+ * cache makes every packet do the linear scan of the SPD policies.
+ *
+ * @cliexpar
+ * @cliexcmd{set ipsec spd flow-cache ip4-log2-size 18}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (set_ipsec_spd_flow_cache_command, static) = {
+    .path = "set ipsec spd flow-cache",
+    .short_help =
+    "set ipsec spd flow-cache [enable|disable] [ip4-log2-size <n>] [ip6-log2-size <n>]",
+    .function = set_ipsec_spd_flow_cache_command_fn,
+};
+/* *INDENT-ON* */
+
 static clib_error_t *
 create_ipsec_tunnel_command_fn (vlib_main_t * vm,
 				unformat_input_t * input,
@@ -845,6 +968,271 @@ VLIB_CLI_COMMAND (set_interface_key_command, static) = {
 };
 /* *INDENT-ON* */
 
+typedef struct
+{
+  u64 encrypt_cycles;
+  u64 decrypt_cycles;
+  u64 n_bytes;
+  u32 n_failed;
+} esp_crypto_bench_result_t;
+
+/*
+ * Time the software ESP crypto over a batch of same sized packets, the
+ * way esp-encrypt and esp-decrypt do it: CBC plus HMAC one packet at a
+ * time, AEAD a frame at a time. The packets are decrypted and compared
+ * against the plaintext, so the result doubles as a self test.
+ */
+static void
+esp_crypto_bench (vlib_main_t * vm, ipsec_crypto_alg_t crypto_alg,
+		  ipsec_integ_alg_t integ_alg, u32 size, u32 n_packets,
+		  esp_crypto_bench_result_t * r)
+{
+  ipsec_main_t *im = &ipsec_main;
+  esp_main_t *em = &esp_main;
+  esp_main_per_thread_data_t *ptd;
+  esp_crypto_alg_t *alg = &em->esp_crypto_algs[crypto_alg];
+  u32 i, n, n_done, sa_index, len, iv_size, icv_size, stride;
+  u8 *plaintext = 0, *packets = 0, *p, sig[64];
+  esp_header_t *esp;
+  esp_aead_op_t *op;
+  ipsec_sa_t *sa;
+  u64 t0;
+
+  memset (r, 0, sizeof (*r));
+  ptd = vec_elt_at_index (em->per_thread_data, vm->thread_index);
+
+  /* a scratch SA, the workers are held at the barrier */
+  pool_get (im->sad, sa);
+  memset (sa, 0, sizeof (*sa));
+  sa_index = sa - im->sad;
+  sa->crypto_alg = crypto_alg;
+  sa->integ_alg = integ_alg;
+  sa->crypto_key_len = EVP_CIPHER_key_length (alg->type) +
+    (alg->is_aead ? ESP_AEAD_SALT_SIZE : 0);
+  RAND_bytes (sa->crypto_key, sa->crypto_key_len);
+  if (!alg->is_aead)
+    {
+      sa->integ_key_len = EVP_MD_size (em->esp_integ_algs[integ_alg].md);
+      RAND_bytes (sa->integ_key, sa->integ_key_len);
+    }
+  esp_sa_update (sa);
+
+  /* payload and ESP trailer, padded to the cipher's block */
+  if (alg->is_aead)
+    {
+      len = round_pow2 (size + sizeof (esp_footer_t), 4);
+      iv_size = ESP_AEAD_IV_SIZE;
+      icv_size = ESP_AEAD_ICV_SIZE;
+    }
+  else
+    {
+      len = round_pow2 (size + sizeof (esp_footer_t), 16);
+      iv_size = 16;
+      icv_size = em->esp_integ_algs[integ_alg].trunc_size;
+    }
+  stride = round_pow2 (sizeof (esp_header_t) + iv_size + len + 64,
+		       CLIB_CACHE_LINE_BYTES);
+
+  vec_validate_aligned (plaintext, VLIB_FRAME_SIZE * len - 1,
+			CLIB_CACHE_LINE_BYTES);
+  vec_validate_aligned (packets, VLIB_FRAME_SIZE * stride - 1,
+			CLIB_CACHE_LINE_BYTES);
+  RAND_bytes (plaintext, vec_len (plaintext));
+
+  for (n_done = 0; n_done < n_packets; n_done += n)
+    {
+      n = clib_min (VLIB_FRAME_SIZE, n_packets - n_done);
+
+      for (i = 0; i < n; i++)
+	{
+	  esp = (esp_header_t *) (packets + i * stride);
+	  esp->spi = clib_host_to_net_u32 (sa_index);
+	  esp->seq = clib_host_to_net_u32 (++sa->seq);
+	}
+
+      t0 = clib_cpu_time_now ();
+      if (alg->is_aead)
+	{
+	  vec_reset_length (ptd->aead_ops);
+	  for (i = 0; i < n; i++)
+	    {
+	      esp = (esp_header_t *) (packets + i * stride);
+	      /* the IV is the sequence number, as in esp-encrypt */
+	      memset (esp->data, 0, sizeof (u32));
+	      clib_memcpy (esp->data + sizeof (u32), &esp->seq, sizeof (u32));
+	      vec_add2 (ptd->aead_ops, op, 1);
+	      esp_aead_op_init (op, sa, sa_index, esp, esp->data);
+	      op->src = plaintext + i * len;
+	      op->dst = esp->data + iv_size;
+	      op->len = len;
+	      op->tag = op->dst + len;
+	    }
+	  esp_aead_process_ops (ptd->aead_ops, n, 1 /* is_encrypt */ );
+	}
+      else
+	{
+	  for (i = 0; i < n; i++)
+	    {
+	      esp = (esp_header_t *) (packets + i * stride);
+	      RAND_bytes (esp->data, iv_size);
+	      esp_encrypt_aes_cbc (crypto_alg, plaintext + i * len,
+				   esp->data + iv_size, len, sa->crypto_key,
+				   esp->data);
+	      hmac_calc (integ_alg, sa->integ_key, sa->integ_key_len,
+			 (u8 *) esp, sizeof (*esp) + iv_size + len,
+			 esp->data + iv_size + len, 0, 0);
+	    }
+	}
+      r->encrypt_cycles += clib_cpu_time_now () - t0;
+
+      /* decrypt in place */
+      t0 = clib_cpu_time_now ();
+      if (alg->is_aead)
+	{
+	  vec_foreach (op, ptd->aead_ops) op->src = op->dst;
+	  esp_aead_process_ops (ptd->aead_ops, n, 0 /* is_encrypt */ );
+	}
+      else
+	{
+	  for (i = 0; i < n; i++)
+	    {
+	      esp = (esp_header_t *) (packets + i * stride);
+	      hmac_calc (integ_alg, sa->integ_key, sa->integ_key_len,
+			 (u8 *) esp, sizeof (*esp) + iv_size + len, sig, 0, 0);
+	      if (memcmp (sig, esp->data + iv_size + len, icv_size))
+		r->n_failed++;
+	      esp_decrypt_aes_cbc (crypto_alg, esp->data + iv_size,
+				   esp->data + iv_size, len, sa->crypto_key,
+				   esp->data);
+	    }
+	}
+      r->decrypt_cycles += clib_cpu_time_now () - t0;
+
+      for (i = 0; i < n; i++)
+	{
+	  p = packets + i * stride + sizeof (esp_header_t) + iv_size;
+	  if (alg->is_aead && ptd->aead_ops[i].auth_failed)
+	    r->n_failed++;
+	  else if (memcmp (p, plaintext + i * len, len))
+	    r->n_failed++;
+	}
+      r->n_bytes += n * len;
+    }
+
+  vec_reset_length (ptd->aead_ops);
+  vec_free (plaintext);
+  vec_free (packets);
+  pool_put (im->sad, sa);
+}
+
+static clib_error_t *
+test_esp_crypto_bench_command_fn (vlib_main_t * vm,
+				  unformat_input_t * input,
+				  vlib_cli_command_t * cmd)
+{
+  esp_main_t *em = &esp_main;
+  u32 crypto_alg = ~0, integ_alg = IPSEC_INTEG_ALG_NONE;
+  u32 size = 1024, n_packets = 100000;
+  esp_crypto_bench_result_t r;
+  f64 cps = vm->clib_time.clocks_per_second;
+  /* the CBC+HMAC pairs the software path supports, and the AEADs */
+  u32 defaults[][2] = {
+    {IPSEC_CRYPTO_ALG_AES_CBC_128, IPSEC_INTEG_ALG_SHA1_96},
+    {IPSEC_CRYPTO_ALG_AES_CBC_256, IPSEC_INTEG_ALG_SHA_256_128},
+    {IPSEC_CRYPTO_ALG_AES_GCM_128, IPSEC_INTEG_ALG_NONE},
+    {IPSEC_CRYPTO_ALG_AES_GCM_256, IPSEC_INTEG_ALG_NONE},
+    {IPSEC_CRYPTO_ALG_CHACHA20_POLY1305, IPSEC_INTEG_ALG_NONE},
+  };
+  u32 i;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "crypto-alg %U", unformat_ipsec_crypto_alg,
+		    &crypto_alg))
+	;
+      else if (unformat (input, "integ-alg %U", unformat_ipsec_integ_alg,
+			 &integ_alg))
+	;
+      else if (unformat (input, "size %u", &size))
+	;
+      else if (unformat (input, "packets %u", &n_packets))
+	;
+      else
+	return clib_error_return (0, "unknown input '%U'",
+				  format_unformat_error, input);
+    }
+
+  if (size == 0 || size > 9000 || n_packets == 0)
+    return clib_error_return (0, "size must be 1 to 9000, packets non-zero");
+
+  if (crypto_alg != ~0)
+    {
+      if (crypto_alg >= IPSEC_CRYPTO_N_ALG
+	  || !em->esp_crypto_algs[crypto_alg].type)
+	return clib_error_return (0, "unsupported crypto-alg");
+      if (!em->esp_crypto_algs[crypto_alg].is_aead
+	  && !em->esp_integ_algs[integ_alg].md)
+	return clib_error_return (0, "%U needs an integ-alg",
+				  format_ipsec_crypto_alg, crypto_alg);
+      if (em->esp_crypto_algs[crypto_alg].is_aead)
+	integ_alg = IPSEC_INTEG_ALG_NONE;
+    }
+
+  vlib_cli_output (vm, "%u packets of %u bytes, %.2f GHz",
+		   n_packets, size, cps * 1e-9);
+  vlib_cli_output (vm, "%-18s %-12s %14s %10s %14s %10s",
+		   "crypto", "integrity", "encrypt c/b", "Gbps",
+		   "decrypt c/b", "Gbps");
+
+  for (i = 0; i < ARRAY_LEN (defaults); i++)
+    {
+      if (crypto_alg != ~0)
+	{
+	  if (i)
+	    break;
+	  defaults[0][0] = crypto_alg;
+	  defaults[0][1] = integ_alg;
+	}
+      if (!em->esp_crypto_algs[defaults[i][0]].type)
+	continue;
+
+      esp_crypto_bench (vm, defaults[i][0], defaults[i][1], size,
+			n_packets, &r);
+
+      vlib_cli_output (vm, "%-18U %-12U %14.2f %10.2f %14.2f %10.2f%s",
+		       format_ipsec_crypto_alg, defaults[i][0],
+		       format_ipsec_integ_alg, defaults[i][1],
+		       (f64) r.encrypt_cycles / r.n_bytes,
+		       r.n_bytes * 8 * cps / r.encrypt_cycles * 1e-9,
+		       (f64) r.decrypt_cycles / r.n_bytes,
+		       r.n_bytes * 8 * cps / r.decrypt_cycles * 1e-9,
+		       r.n_failed ? " FAILED" : "");
+    }
+
+  return 0;
+}
+
+/*?
+ * Measure the single core throughput of the software ESP crypto: CBC
+ * with a separate HMAC, done one packet at a time, against the AEAD
+ * algorithms, done a frame at a time. Without a crypto-alg, compares
+ * the usual choices. The cost covers the ESP payload only, the header
+ * rewrites are not included.
+ *
+ * @cliexpar
+ * @cliexcmd{test esp crypto-bench size 1420 packets 1000000}
+ * @cliexcmd{test esp crypto-bench crypto-alg aes-cbc-128 integ-alg sha-256-128}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (test_esp_crypto_bench_command, static) = {
+    .path = "test esp crypto-bench",
+    .short_help =
+    "test esp crypto-bench [crypto-alg <alg>] [integ-alg <alg>] "
+    "[size <bytes>] [packets <n>]",
+    .function = test_esp_crypto_bench_command_fn,
+};
+/* *INDENT-ON* */
+
 clib_error_t *
 ipsec_cli_init (vlib_main_t * vm)
 {
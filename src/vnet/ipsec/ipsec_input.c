@@ -167,6 +167,67 @@ ipsec_input_ip6_protect_policy_match (ipsec_spd_t * spd,
   return 0;
 }
 
+always_inline ipsec_policy_t *
+ipsec_input_protect_policy_lookup (ipsec_main_t * im, u32 thread_index,
+				   ipsec_spd_t * spd, u32 sa, u32 da, u32 spi)
+{
+  ipsec_spd_flow_cache_ip4_entry_t key, *e;
+  ipsec_policy_t *p;
+  int hit;
+
+  key.spd_index = spd - im->spds;
+  key.laddr = da;
+  key.raddr = sa;
+  key.ports_or_spi = spi;
+  key.protocol = IP_PROTOCOL_IPSEC_ESP;
+  key.dir = IPSEC_SPD_FLOW_INBOUND_PROTECT;
+  key.pad = 0;
+  key.pad1 = 0;
+
+  e = ipsec_spd_flow_cache_ip4_find (im, thread_index, &key, &hit);
+  if (PREDICT_FALSE (e == 0))
+    return ipsec_input_protect_policy_match (spd, sa, da, spi);
+
+  if (PREDICT_TRUE (hit))
+    return e->policy_index == ~0 ? 0 :
+      pool_elt_at_index (spd->policies, e->policy_index);
+
+  p = ipsec_input_protect_policy_match (spd, sa, da, spi);
+  e->policy_index = p ? p - spd->policies : ~0;
+  return p;
+}
+
+always_inline ipsec_policy_t *
+ipsec_input_ip6_protect_policy_lookup (ipsec_main_t * im, u32 thread_index,
+				       ipsec_spd_t * spd, ip6_address_t * sa,
+				       ip6_address_t * da, u32 spi)
+{
+  ipsec_spd_flow_cache_ip6_entry_t key, *e;
+  ipsec_policy_t *p;
+  int hit;
+
+  key.laddr = *da;
+  key.raddr = *sa;
+  key.spd_index = spd - im->spds;
+  key.ports_or_spi = spi;
+  key.protocol = IP_PROTOCOL_IPSEC_ESP;
+  key.dir = IPSEC_SPD_FLOW_INBOUND_PROTECT;
+  key.pad = 0;
+  key.pad1 = 0;
+
+  e = ipsec_spd_flow_cache_ip6_find (im, thread_index, &key, &hit);
+  if (PREDICT_FALSE (e == 0))
+    return ipsec_input_ip6_protect_policy_match (spd, sa, da, spi);
+
+  if (PREDICT_TRUE (hit))
+    return e->policy_index == ~0 ? 0 :
+      pool_elt_at_index (spd->policies, e->policy_index);
+
+  p = ipsec_input_ip6_protect_policy_match (spd, sa, da, spi);
+  e->policy_index = p ? p - spd->policies : ~0;
+  return p;
+}
+
 static vlib_node_registration_t ipsec_input_ip4_node;
 
 static uword
@@ -176,6 +237,7 @@ ipsec_input_ip4_node_fn (vlib_main_t * vm,
 {
   u32 n_left_from, *from, next_index, *to_next;
   ipsec_main_t *im = &ipsec_main;
+  u32 thread_index = vlib_get_thread_index ();
 
   from = vlib_frame_vector_args (from_frame);
   n_left_from = from_frame->n_vectors;
@@ -226,15 +288,15 @@ ipsec_input_ip4_node_fn (vlib_main_t * vm,
 		 clib_net_to_host_u16 (ip0->length), spd0->id);
 #endif
 
-	      p0 = ipsec_input_protect_policy_match (spd0,
-						     clib_net_to_host_u32
-						     (ip0->src_address.
-						      as_u32),
-						     clib_net_to_host_u32
-						     (ip0->dst_address.
-						      as_u32),
-						     clib_net_to_host_u32
-						     (esp0->spi));
+	      p0 = ipsec_input_protect_policy_lookup (im, thread_index, spd0,
+						      clib_net_to_host_u32
+						      (ip0->src_address.
+						       as_u32),
+						      clib_net_to_host_u32
+						      (ip0->dst_address.
+						       as_u32),
+						      clib_net_to_host_u32
+						      (esp0->spi));
 
 	      if (PREDICT_TRUE (p0 != 0))
 		{
@@ -308,6 +370,7 @@ VLIB_NODE_FUNCTION_MULTIARCH (ipsec_input_ip4_node, ipsec_input_ip4_node_fn)
 {
   u32 n_left_from, *from, next_index, *to_next;
   ipsec_main_t *im = &ipsec_main;
+  u32 thread_index = vlib_get_thread_index ();
 
   from = vlib_frame_vector_args (from_frame);
   n_left_from = from_frame->n_vectors;
@@ -358,11 +421,12 @@ VLIB_NODE_FUNCTION_MULTIARCH (ipsec_input_ip4_node, ipsec_input_ip4_node_fn)
 		 clib_net_to_host_u16 (ip0->payload_length) + header_size,
 		 spd0->id);
 #endif
-	      p0 = ipsec_input_ip6_protect_policy_match (spd0,
-							 &ip0->src_address,
-							 &ip0->dst_address,
-							 clib_net_to_host_u32
-							 (esp0->spi));
+	      p0 = ipsec_input_ip6_protect_policy_lookup (im, thread_index,
+							  spd0,
+							  &ip0->src_address,
+							  &ip0->dst_address,
+							  clib_net_to_host_u32
+							  (esp0->spi));
 
 	      if (PREDICT_TRUE (p0 != 0))
 		{
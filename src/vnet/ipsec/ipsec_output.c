@@ -174,11 +174,87 @@ ipsec_output_ip6_policy_match (ipsec_spd_t * spd,
   return 0;
 }
 
+always_inline ipsec_policy_t *
+ipsec_output_policy_lookup (ipsec_main_t * im, u32 thread_index,
+			    ipsec_spd_t * spd, u8 pr, u32 la, u32 ra,
+			    u16 lp, u16 rp)
+{
+  ipsec_spd_flow_cache_ip4_entry_t key, *e;
+  ipsec_policy_t *p;
+  int hit;
+
+  if (!spd)
+    return 0;
+
+  key.spd_index = spd - im->spds;
+  key.laddr = la;
+  key.raddr = ra;
+  /* the ports only take part in the match for TCP and UDP */
+  if ((pr == IP_PROTOCOL_TCP) || (pr == IP_PROTOCOL_UDP))
+    key.ports_or_spi = ((u32) lp << 16) | rp;
+  else
+    key.ports_or_spi = 0;
+  key.protocol = pr;
+  key.dir = IPSEC_SPD_FLOW_OUTBOUND;
+  key.pad = 0;
+  key.pad1 = 0;
+
+  e = ipsec_spd_flow_cache_ip4_find (im, thread_index, &key, &hit);
+  if (PREDICT_FALSE (e == 0))
+    return ipsec_output_policy_match (spd, pr, la, ra, lp, rp);
+
+  if (PREDICT_TRUE (hit))
+    return e->policy_index == ~0 ? 0 :
+      pool_elt_at_index (spd->policies, e->policy_index);
+
+  p = ipsec_output_policy_match (spd, pr, la, ra, lp, rp);
+  e->policy_index = p ? p - spd->policies : ~0;
+  return p;
+}
+
+always_inline ipsec_policy_t *
+ipsec_output_ip6_policy_lookup (ipsec_main_t * im, u32 thread_index,
+				ipsec_spd_t * spd, ip6_address_t * la,
+				ip6_address_t * ra, u16 lp, u16 rp, u8 pr)
+{
+  ipsec_spd_flow_cache_ip6_entry_t key, *e;
+  ipsec_policy_t *p;
+  int hit;
+
+  if (!spd)
+    return 0;
+
+  key.laddr = *la;
+  key.raddr = *ra;
+  key.spd_index = spd - im->spds;
+  if ((pr == IP_PROTOCOL_TCP) || (pr == IP_PROTOCOL_UDP))
+    key.ports_or_spi = ((u32) lp << 16) | rp;
+  else
+    key.ports_or_spi = 0;
+  key.protocol = pr;
+  key.dir = IPSEC_SPD_FLOW_OUTBOUND;
+  key.pad = 0;
+  key.pad1 = 0;
+
+  e = ipsec_spd_flow_cache_ip6_find (im, thread_index, &key, &hit);
+  if (PREDICT_FALSE (e == 0))
+    return ipsec_output_ip6_policy_match (spd, la, ra, lp, rp, pr);
+
+  if (PREDICT_TRUE (hit))
+    return e->policy_index == ~0 ? 0 :
+      pool_elt_at_index (spd->policies, e->policy_index);
+
+  p = ipsec_output_ip6_policy_match (spd, la, ra, lp, rp, pr);
+  e->policy_index = p ? p - spd->policies : ~0;
+  return p;
+}
+
 static inline uword
 ipsec_output_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 		     vlib_frame_t * from_frame, int is_ipv6)
 {
   ipsec_main_t *im = &ipsec_main;
+  u32 thread_index = vlib_get_thread_index ();
 
   u32 *from, *to_next = 0;
   u32 n_left_from, sw_if_index0, last_sw_if_index = (u32) ~ 0;
@@ -233,14 +309,14 @@ ipsec_output_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 	     spd0->id);
 #endif
 
-	  p0 = ipsec_output_ip6_policy_match (spd0,
-					      &ip6_0->src_address,
-					      &ip6_0->dst_address,
-					      clib_net_to_host_u16
-					      (udp0->src_port),
-					      clib_net_to_host_u16
-					      (udp0->dst_port),
-					      ip6_0->protocol);
+	  p0 = ipsec_output_ip6_policy_lookup (im, thread_index, spd0,
+					       &ip6_0->src_address,
+					       &ip6_0->dst_address,
+					       clib_net_to_host_u16
+					       (udp0->src_port),
+					       clib_net_to_host_u16
+					       (udp0->dst_port),
+					       ip6_0->protocol);
 	}
       else
 	{
@@ -255,15 +331,16 @@ ipsec_output_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 			sw_if_index0, spd_index0, spd0->id);
 #endif
 
-	  p0 = ipsec_output_policy_match (spd0, ip0->protocol,
-					  clib_net_to_host_u32
-					  (ip0->src_address.as_u32),
-					  clib_net_to_host_u32
-					  (ip0->dst_address.as_u32),
-					  clib_net_to_host_u16
-					  (udp0->src_port),
-					  clib_net_to_host_u16
-					  (udp0->dst_port));
+	  p0 = ipsec_output_policy_lookup (im, thread_index, spd0,
+					   ip0->protocol,
+					   clib_net_to_host_u32
+					   (ip0->src_address.as_u32),
+					   clib_net_to_host_u32
+					   (ip0->dst_address.as_u32),
+					   clib_net_to_host_u16
+					   (udp0->src_port),
+					   clib_net_to_host_u16
+					   (udp0->dst_port));
 	}
 
       if (PREDICT_TRUE (p0 != NULL))
@@ -946,8 +946,17 @@ allocate_mac_evt_buf (u32 client, u32 client_index)
   return mp;
 }
 
+/**
+ * Scan n_buckets buckets of the mac table, starting at first_bucket, to
+ * send the MAC events and, unless event_only, age the MACs out.
+ * Returns the scan duration, in learn_countp the number of learned MACs
+ * left in the buckets scanned and in aged_countp the number of learned
+ * MACs aged out.
+ */
 static_always_inline f64
-l2fib_scan (vlib_main_t * vm, f64 start_time, u8 event_only)
+l2fib_scan (vlib_main_t * vm, f64 start_time, u8 event_only,
+	    u32 first_bucket, u32 n_buckets, u32 * learn_countp,
+	    u32 * aged_countp)
 {
   l2fib_main_t *fm = &l2fib_main;
   l2learn_main_t *lm = &l2learn_main;
@@ -959,6 +968,7 @@ l2fib_scan (vlib_main_t * vm, f64 start_time, u8 event_only)
   f64 delta_t = 0;
   u32 evt_idx = 0;
   u32 learn_count = 0;
+  u32 aged_count = 0;
   u32 client = lm->client_pid;
   u32 cl_idx = lm->client_index;
   vl_api_l2_macs_event_t *mp = 0;
@@ -970,7 +980,7 @@ l2fib_scan (vlib_main_t * vm, f64 start_time, u8 event_only)
       q = vl_api_client_index_to_input_queue (lm->client_index);
     }
 
-  for (i = 0; i < h->nbuckets; i++)
+  for (i = first_bucket; i < first_bucket + n_buckets; i++)
     {
       /* allow no more than 20us without a pause */
       delta_t = vlib_time_now (vm) - last_start;
@@ -1088,13 +1098,14 @@ l2fib_scan (vlib_main_t * vm, f64 start_time, u8 event_only)
 	      kv.key = key.raw;
 	      BV (clib_bihash_add_del) (&fm->mac_table, &kv, 0);
 	      learn_count--;
+	      aged_count++;
 	    }
 	  v++;
 	}
     }
 
-  /* keep learn count consistent */
-  l2learn_main.global_learn_count = learn_count;
+  *learn_countp = learn_count;
+  *aged_countp = aged_count;
 
   if (mp)
     {
@@ -1123,6 +1134,35 @@ l2fib_scan (vlib_main_t * vm, f64 start_time, u8 event_only)
 /* Maximum f64 value */
 #define TIME_MAX (1.7976931348623157e+308)
 
+/**
+ * Age one slice of the mac table. The learn count keeps being maintained
+ * by the learning and the aging; the MACs learned in the slices already
+ * swept while the sweep goes on would be missing from a count summed
+ * slice by slice, so it is only reset by the full table scans.
+ */
+static void
+l2fib_age_scan_slice (vlib_main_t * vm, f64 start_time)
+{
+  l2fib_main_t *fm = &l2fib_main;
+  l2learn_main_t *lm = &l2learn_main;
+  u32 nbuckets = fm->mac_table.nbuckets;
+  u32 n_buckets, learn_count, aged_count;
+
+  n_buckets = clib_min (fm->age_scan_buckets, nbuckets - fm->age_scan_cursor);
+  fm->age_sweep_duration += l2fib_scan (vm, start_time, 0,
+					fm->age_scan_cursor, n_buckets,
+					&learn_count, &aged_count);
+  lm->global_learn_count -= clib_min (aged_count, lm->global_learn_count);
+  fm->age_scan_cursor += n_buckets;
+
+  if (fm->age_scan_cursor >= nbuckets)
+    {
+      fm->age_scan_duration = fm->age_sweep_duration;
+      fm->age_scan_cursor = 0;
+      fm->age_sweep_duration = 0;
+    }
+}
+
 static uword
 l2fib_mac_age_scanner_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
 			       vlib_frame_t * f)
@@ -1132,6 +1172,7 @@ l2fib_mac_age_scanner_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
   l2learn_main_t *lm = &l2learn_main;
   bool enabled = 0;
   f64 start_time, next_age_scan_time = TIME_MAX;
+  u32 learn_count, aged_count;
 
   while (1)
     {
@@ -1150,13 +1191,16 @@ l2fib_mac_age_scanner_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
 
       start_time = vlib_time_now (vm);
       enum
-      { SCAN_MAC_AGE, SCAN_MAC_EVENT, SCAN_DISABLE } scan = SCAN_MAC_AGE;
+      { SCAN_MAC_AGE, SCAN_MAC_AGE_SLICE, SCAN_MAC_EVENT, SCAN_DISABLE }
+      scan = SCAN_MAC_AGE;
 
       switch (event_type)
 	{
 	case ~0:		/* timer expired */
 	  if (lm->client_pid != 0 && start_time < next_age_scan_time)
 	    scan = SCAN_MAC_EVENT;
+	  else
+	    scan = SCAN_MAC_AGE_SLICE;
 	  break;
 
 	case L2_MAC_AGE_PROCESS_EVENT_START:
@@ -1176,11 +1220,30 @@ l2fib_mac_age_scanner_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
 	}
 
       if (scan == SCAN_MAC_EVENT)
-	l2fib_main.evt_scan_duration = l2fib_scan (vm, start_time, 1);
+	{
+	  l2fib_main.evt_scan_duration =
+	    l2fib_scan (vm, start_time, 1, 0, fm->mac_table.nbuckets,
+			&learn_count, &aged_count);
+	  lm->global_learn_count = learn_count;
+	}
       else
 	{
+	  /*
+	   * On configuration changes and flushes, sweep the whole table at
+	   * once. Otherwise age a slice, the next one in scan interval
+	   * times the share of the table a slice is.
+	   */
 	  if (scan == SCAN_MAC_AGE)
-	    l2fib_main.age_scan_duration = l2fib_scan (vm, start_time, 0);
+	    {
+	      fm->age_scan_duration =
+		l2fib_scan (vm, start_time, 0, 0, fm->mac_table.nbuckets,
+			    &learn_count, &aged_count);
+	      lm->global_learn_count = learn_count;
+	      fm->age_scan_cursor = 0;
+	      fm->age_sweep_duration = 0;
+	    }
+	  else if (scan == SCAN_MAC_AGE_SLICE)
+	    l2fib_age_scan_slice (vm, start_time);
 	  if (scan == SCAN_DISABLE)
 	    {
 	      l2fib_main.age_scan_duration = 0;
@@ -1188,7 +1251,9 @@ l2fib_mac_age_scanner_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
 	    }
 	  /* schedule next scan */
 	  if (enabled)
-	    next_age_scan_time = start_time + L2FIB_AGE_SCAN_INTERVAL;
+	    next_age_scan_time = start_time + L2FIB_AGE_SCAN_INTERVAL *
+	      clib_min (fm->age_scan_buckets, fm->mac_table.nbuckets) /
+	      fm->mac_table.nbuckets;
 	  else
 	    next_age_scan_time = TIME_MAX;
 	}
@@ -1218,6 +1283,8 @@ l2fib_init (vlib_main_t * vm)
   BV (clib_bihash_init) (&mp->mac_table, "l2fib mac table",
 			 L2FIB_NUM_BUCKETS, L2FIB_MEMORY_SIZE);
 
+  mp->age_scan_buckets = L2FIB_AGE_SCAN_BUCKETS_DEFAULT;
+
   /* verify the key constructor is good, since it is endian-sensitive */
   memset (test_mac, 0, sizeof (test_mac));
   test_mac[0] = 0x11;
@@ -1231,6 +1298,28 @@ l2fib_init (vlib_main_t * vm)
 
 VLIB_INIT_FUNCTION (l2fib_init);
 
+static clib_error_t *
+l2fib_config (vlib_main_t * vm, unformat_input_t * input)
+{
+  l2fib_main_t *mp = &l2fib_main;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "age-scan-buckets %d", &mp->age_scan_buckets))
+	{
+	  if (mp->age_scan_buckets == 0)
+	    return clib_error_return (0, "age-scan-buckets must be non-zero");
+	}
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  return 0;
+}
+
+VLIB_CONFIG_FUNCTION (l2fib_config, "l2fib");
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
@@ -30,6 +30,12 @@
 /* Ager scan interval is 1 minute for aging */
 #define L2FIB_AGE_SCAN_INTERVAL		(60.0)
 
+/*
+ * The ager sweeps the table a slice of buckets at a time, the slices
+ * spread over the scan interval
+ */
+#define L2FIB_AGE_SCAN_BUCKETS_DEFAULT	(1024)
+
 /* MAC event scan delay is 100 msec unless specified by MAC event client */
 #define L2FIB_EVENT_SCAN_DELAY_DEFAULT	(0.1)
 
@@ -52,6 +58,11 @@ typedef struct
   f64 evt_scan_duration;
   f64 age_scan_duration;
 
+  /* buckets per ager slice, next bucket to age, sweep in progress stats */
+  u32 age_scan_buckets;
+  u32 age_scan_cursor;
+  f64 age_sweep_duration;
+
   /* delay between event scans, default to 100 msec */
   f64 event_scan_delay;
 
@@ -272,22 +283,22 @@ l2fib_lookup_2 (BVT (clib_bihash) * mac_table,
     }
   else
     {
-      BVT (clib_bihash_kv) kv0, kv1;
+      BVT (clib_bihash_kv) kv[2], value[2];
+      int rv[2];
 
       /*
        * Do a regular mac table lookup
-       * Interleave lookups for packet 0 and packet 1
+       * Batch the lookups for packet 0 and packet 1
        */
-      kv0.key = key0->raw;
-      kv1.key = key1->raw;
-      kv0.value = ~0ULL;
-      kv1.value = ~0ULL;
+      kv[0].key = key0->raw;
+      kv[1].key = key1->raw;
+      value[0].value = ~0ULL;
+      value[1].value = ~0ULL;
 
-      BV (clib_bihash_search_inline) (mac_table, &kv0);
-      BV (clib_bihash_search_inline) (mac_table, &kv1);
+      BV (clib_bihash_search_batch) (mac_table, kv, value, rv, 2);
 
-      result0->raw = kv0.value;
-      result1->raw = kv1.value;
+      result0->raw = value[0].value;
+      result1->raw = value[1].value;
 
       /* Update one-entry cache */
       cached_key->raw = key1->raw;
@@ -342,30 +353,28 @@ l2fib_lookup_4 (BVT (clib_bihash) * mac_table,
     }
   else
     {
-      BVT (clib_bihash_kv) kv0, kv1, kv2, kv3;
+      BVT (clib_bihash_kv) kv[4], value[4];
+      int rv[4];
 
       /*
        * Do a regular mac table lookup
-       * Interleave lookups for packet 0 and packet 1
+       * Batch the lookups for the 4 packets
        */
-      kv0.key = key0->raw;
-      kv1.key = key1->raw;
-      kv2.key = key2->raw;
-      kv3.key = key3->raw;
-      kv0.value = ~0ULL;
-      kv1.value = ~0ULL;
-      kv2.value = ~0ULL;
-      kv3.value = ~0ULL;
-
-      BV (clib_bihash_search_inline) (mac_table, &kv0);
-      BV (clib_bihash_search_inline) (mac_table, &kv1);
-      BV (clib_bihash_search_inline) (mac_table, &kv2);
-      BV (clib_bihash_search_inline) (mac_table, &kv3);
-
-      result0->raw = kv0.value;
-      result1->raw = kv1.value;
-      result2->raw = kv2.value;
-      result3->raw = kv3.value;
+      kv[0].key = key0->raw;
+      kv[1].key = key1->raw;
+      kv[2].key = key2->raw;
+      kv[3].key = key3->raw;
+      value[0].value = ~0ULL;
+      value[1].value = ~0ULL;
+      value[2].value = ~0ULL;
+      value[3].value = ~0ULL;
+
+      BV (clib_bihash_search_batch) (mac_table, kv, value, rv, 4);
+
+      result0->raw = value[0].value;
+      result1->raw = value[1].value;
+      result2->raw = value[2].value;
+      result3->raw = value[3].value;
 
       /* Update one-entry cache */
       cached_key->raw = key1->raw;
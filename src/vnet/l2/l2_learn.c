@@ -45,6 +45,14 @@ l2learn_main_t l2learn_main;
  * differ in certain cases (mac move tests), but this not expected to cause
  * problems in real-world networks. It is much simpler to separate learning
  * and forwarding into separate nodes.
+ *
+ * The l2-learn node does not update the mac table itself. It queues the
+ * updates in a per thread ring, drained by the learn process on the main
+ * thread. The process coalesces the updates of the same entry made by all
+ * threads, limits the rate of updates, and applies them with a single
+ * acquisition of the mac table writer lock. Until then, the packets from
+ * a newly learned mac keep being learned, i.e., queued again, which the
+ * node filters out within a frame.
  */
 
 
@@ -81,7 +89,12 @@ _(MAC_MOVE,          "L2 mac moves")			\
 _(MAC_MOVE_VIOLATE,  "L2 mac move violations")		\
 _(LIMIT,             "L2 not learned due to limit")	\
 _(HIT_UPDATE,        "L2 learn hit updates")		\
-_(FILTER_DROP,       "L2 filter mac drops")
+_(FILTER_DROP,       "L2 filter mac drops")			\
+_(QUEUED,            "L2 learn events queued")		\
+_(COALESCED,         "L2 learn events coalesced")		\
+_(QUEUE_FULL,        "L2 learn events dropped, queue full")	\
+_(RATE_LIMIT,        "L2 learn events dropped, rate limit")	\
+_(STALE,             "L2 learn events stale")
 
 typedef enum
 {
@@ -110,11 +123,14 @@ typedef enum
 static_always_inline void
 l2learn_process (vlib_node_runtime_t * node,
 		 l2learn_main_t * msm,
+		 l2learn_event_ring_t * ring,
 		 u64 * counter_base,
 		 vlib_buffer_t * b0,
 		 u32 sw_if_index0,
 		 l2fib_entry_key_t * key0,
 		 l2fib_entry_key_t * cached_key,
+		 l2fib_entry_result_t * cached_result,
+		 l2fib_entry_key_t * queued_key,
 		 u32 * count,
 		 l2fib_entry_result_t * result0, u32 * next0, u8 timestamp)
 {
@@ -122,6 +138,16 @@ l2learn_process (vlib_node_runtime_t * node,
   *next0 = vnet_l2_feature_next (b0, msm->feat_next_node_index,
 				 L2INPUT_FEAT_LEARN);
 
+  /*
+   * Update already queued by a previous packet, looked up together with
+   * this one
+   */
+  if (PREDICT_FALSE (key0->raw == queued_key->raw))
+    {
+      counter_base[L2LEARN_ERROR_COALESCED] += 1;
+      return;
+    }
+
   /* Check mac table lookup result */
   if (PREDICT_TRUE (result0->fields.sw_if_index == sw_if_index0))
     {
@@ -167,8 +193,7 @@ l2learn_process (vlib_node_runtime_t * node,
       if (key.raw == 0)
 	return;
 
-      /* It is ok to learn */
-      msm->global_learn_count++;
+      /* It is ok to learn, the learn process does the accounting */
       result0->raw = 0;		/* clear all fields */
       result0->fields.sw_if_index = sw_if_index0;
       result0->fields.lrn_evt = (msm->client_pid != 0);
@@ -201,11 +226,7 @@ l2learn_process (vlib_node_runtime_t * node,
        * TODO: check global/bridge domain/interface learn limits
        */
       result0->fields.sw_if_index = sw_if_index0;
-      if (result0->fields.age_not)	/* The mac was provisioned */
-	{
-	  msm->global_learn_count++;
-	  result0->fields.age_not = 0;
-	}
+      result0->fields.age_not = 0;	/* The mac may have been provisioned */
       result0->fields.lrn_evt = (msm->client_pid != 0);
       counter_base[L2LEARN_ERROR_MAC_MOVE] += 1;
     }
@@ -214,16 +235,22 @@ l2learn_process (vlib_node_runtime_t * node,
   result0->fields.timestamp = timestamp;
   result0->fields.sn.as_u16 = vnet_buffer (b0)->l2.l2fib_sn;
 
-  BVT (clib_bihash_kv) kv;
-  kv.key = key0->raw;
-  kv.value = result0->raw;
-  BV (clib_bihash_add_del) (msm->mac_table, &kv, 1 /* is_add */ );
+  if (PREDICT_FALSE (!l2learn_event_enqueue (ring, key0, result0)))
+    {
+      counter_base[L2LEARN_ERROR_QUEUE_FULL] += 1;
+      return;
+    }
+  counter_base[L2LEARN_ERROR_QUEUED] += 1;
 
-  /* Invalidate the cache */
-  cached_key->raw = ~0;
+  /* Next packets of the frame from this mac see the entry up to date */
+  queued_key->raw = key0->raw;
+  cached_key->raw = key0->raw;
+  cached_result->raw = result0->raw;
 }
 
 
+static vlib_node_registration_t l2learn_event_process_node;
+
 static_always_inline uword
 l2learn_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 		     vlib_frame_t * frame, int do_trace)
@@ -234,7 +261,9 @@ l2learn_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   vlib_node_t *n = vlib_get_node (vm, l2learn_node.index);
   u32 node_counter_base_index = n->error_heap_index;
   vlib_error_main_t *em = &vm->error_main;
-  l2fib_entry_key_t cached_key;
+  l2learn_event_ring_t *ring = vec_elt_at_index (msm->event_rings,
+						  vm->thread_index);
+  l2fib_entry_key_t cached_key, queued_key;
   l2fib_entry_result_t cached_result;
   u8 timestamp = (u8) (vlib_time_now (vm) / 60);
   u32 count = 0;
@@ -246,6 +275,7 @@ l2learn_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   /* Clear the one-entry cache in case mac table was updated */
   cached_key.raw = ~0;
   cached_result.raw = ~0;	/* warning be gone */
+  queued_key.raw = ~0;
 
   while (n_left_from > 0)
     {
@@ -371,21 +401,25 @@ l2learn_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 			  &bucket0, &bucket1, &bucket2, &bucket3,
 			  &result0, &result1, &result2, &result3);
 
-	  l2learn_process (node, msm, &em->counters[node_counter_base_index],
-			   b0, sw_if_index0, &key0, &cached_key,
-			   &count, &result0, &next0, timestamp);
+	  l2learn_process (node, msm, ring,
+			   &em->counters[node_counter_base_index], b0,
+			   sw_if_index0, &key0, &cached_key, &cached_result,
+			   &queued_key, &count, &result0, &next0, timestamp);
 
-	  l2learn_process (node, msm, &em->counters[node_counter_base_index],
-			   b1, sw_if_index1, &key1, &cached_key,
-			   &count, &result1, &next1, timestamp);
+	  l2learn_process (node, msm, ring,
+			   &em->counters[node_counter_base_index], b1,
+			   sw_if_index1, &key1, &cached_key, &cached_result,
+			   &queued_key, &count, &result1, &next1, timestamp);
 
-	  l2learn_process (node, msm, &em->counters[node_counter_base_index],
-			   b2, sw_if_index2, &key2, &cached_key,
-			   &count, &result2, &next2, timestamp);
+	  l2learn_process (node, msm, ring,
+			   &em->counters[node_counter_base_index], b2,
+			   sw_if_index2, &key2, &cached_key, &cached_result,
+			   &queued_key, &count, &result2, &next2, timestamp);
 
-	  l2learn_process (node, msm, &em->counters[node_counter_base_index],
-			   b3, sw_if_index3, &key3, &cached_key,
-			   &count, &result3, &next3, timestamp);
+	  l2learn_process (node, msm, ring,
+			   &em->counters[node_counter_base_index], b3,
+			   sw_if_index3, &key3, &cached_key, &cached_result,
+			   &queued_key, &count, &result3, &next3, timestamp);
 
 	  /* verify speculative enqueues, maybe switch current next frame */
 	  /* if next0==next1==next_index then nothing special needs to be done */
@@ -438,9 +472,10 @@ l2learn_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 			  h0->src_address, vnet_buffer (b0)->l2.bd_index,
 			  &key0, &bucket0, &result0);
 
-	  l2learn_process (node, msm, &em->counters[node_counter_base_index],
-			   b0, sw_if_index0, &key0, &cached_key,
-			   &count, &result0, &next0, timestamp);
+	  l2learn_process (node, msm, ring,
+			   &em->counters[node_counter_base_index], b0,
+			   sw_if_index0, &key0, &cached_key, &cached_result,
+			   &queued_key, &count, &result0, &next0, timestamp);
 
 	  /* verify speculative enqueue, maybe switch current next frame */
 	  vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
@@ -451,6 +486,13 @@ l2learn_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
       vlib_put_next_frame (vm, node, next_index, n_left_to_next);
     }
 
+  /* Publish the tail before checking if the learn process went to sleep */
+  CLIB_MEMORY_BARRIER ();
+  if (PREDICT_FALSE (msm->process_sleeping && ring->tail != ring->head)
+      && __sync_bool_compare_and_swap (&msm->process_sleeping, 1, 0))
+    vlib_process_signal_event_mt (vm, l2learn_event_process_node.index,
+				  0, 0);
+
   return frame->n_vectors;
 }
 
@@ -485,13 +527,220 @@ VLIB_REGISTER_NODE (l2learn_node,static) = {
 /* *INDENT-ON* */
 
 VLIB_NODE_FUNCTION_MULTIARCH (l2learn_node, l2learn_node_fn)
-     clib_error_t *l2learn_init (vlib_main_t * vm)
+
+/* Learn process period while there are updates */
+#define L2LEARN_PROCESS_BUSY_INTERVAL 1e-3
+/* Longest burst of updates above the rate limit, in seconds */
+#define L2LEARN_RATE_LIMIT_BURST 0.1
+
+/**
+ * Number of updates the rate limit allows for now
+ */
+static u32
+l2learn_update_budget (vlib_main_t * vm, l2learn_main_t * lm)
+{
+  f64 now = vlib_time_now (vm);
+
+  if (lm->update_rate_limit == 0)
+    return ~0;
+
+  lm->update_tokens += (now - lm->last_update_time) * lm->update_rate_limit;
+  lm->update_tokens = clib_min (lm->update_tokens,
+				lm->update_rate_limit *
+				L2LEARN_RATE_LIMIT_BURST);
+  lm->last_update_time = now;
+  return (u32) lm->update_tokens;
+}
+
+/**
+ * Drain the learn event rings of all threads into one batch of updates,
+ * in which every entry appears once, with its last update
+ */
+static void
+l2learn_collect_events (vlib_main_t * vm, l2learn_main_t * lm, u32 budget)
+{
+  u32 head, tail, n_coalesced = 0, n_rate_limited = 0;
+  l2learn_event_ring_t *ring;
+  l2learn_event_t *e;
+  uword *p;
+
+  vec_foreach (ring, lm->event_rings)
+  {
+    head = ring->head;
+    tail = ring->tail;
+
+    /* Read the events only after having seen the tail */
+    CLIB_MEMORY_BARRIER ();
+
+    for (; head != tail; head++)
+      {
+	e = &ring->events[head & (L2LEARN_EVENT_RING_SIZE - 1)];
+	p = hash_get (lm->pending_event_by_key, e->key.raw);
+	if (p)
+	  {
+	    lm->pending_events[p[0]] = *e;
+	    n_coalesced++;
+	  }
+	else if (vec_len (lm->pending_events) >= budget)
+	  n_rate_limited++;
+	else
+	  {
+	    hash_set (lm->pending_event_by_key, e->key.raw,
+		      vec_len (lm->pending_events));
+	    vec_add1 (lm->pending_events, *e);
+	  }
+      }
+
+    /* Slots are free only once read */
+    CLIB_MEMORY_BARRIER ();
+    ring->head = head;
+  }
+
+  vlib_node_increment_counter (vm, l2learn_node.index,
+			       L2LEARN_ERROR_COALESCED, n_coalesced);
+  vlib_node_increment_counter (vm, l2learn_node.index,
+			       L2LEARN_ERROR_RATE_LIMIT, n_rate_limited);
+}
+
+/**
+ * Apply the batch to the mac table
+ *
+ * The entries may have changed since l2-learn looked them up, so check
+ * them once more and do the learn count accounting.
+ */
+static void
+l2learn_apply_events (vlib_main_t * vm, l2learn_main_t * lm)
+{
+  BVT (clib_bihash_kv) kv, *kvp;
+  l2fib_entry_result_t cur;
+  u32 n_stale = 0, n_limit = 0;
+  l2learn_event_t *e;
+
+  vec_reset_length (lm->pending_kvs);
+
+  vec_foreach (e, lm->pending_events)
+  {
+    kv.key = e->key.raw;
+    if (BV (clib_bihash_search) (lm->mac_table, &kv, &kv))
+      {
+	/* New entry */
+	if (lm->global_learn_count >= lm->global_learn_limit)
+	  {
+	    n_limit++;
+	    continue;
+	  }
+	lm->global_learn_count++;
+      }
+    else
+      {
+	cur.raw = kv.value;
+
+	/* Made static, filter or provisioned in the meantime */
+	if (cur.fields.static_mac || cur.fields.filter ||
+	    (cur.fields.age_not &&
+	     cur.fields.sw_if_index == e->result.fields.sw_if_index))
+	  {
+	    n_stale++;
+	    continue;
+	  }
+
+	/* Provisioned mac that moved, it is now learned */
+	if (cur.fields.age_not)
+	  lm->global_learn_count++;
+      }
+
+    vec_add2 (lm->pending_kvs, kvp, 1);
+    kvp->key = e->key.raw;
+    kvp->value = e->result.raw;
+  }
+
+  BV (clib_bihash_add_del_batch) (lm->mac_table, lm->pending_kvs,
+				  vec_len (lm->pending_kvs), 1 /* is_add */ );
+
+  if (lm->update_rate_limit)
+    lm->update_tokens -= vec_len (lm->pending_kvs);
+
+  vlib_node_increment_counter (vm, l2learn_node.index,
+			       L2LEARN_ERROR_STALE, n_stale);
+  vlib_node_increment_counter (vm, l2learn_node.index,
+			       L2LEARN_ERROR_LIMIT, n_limit);
+}
+
+static int
+l2learn_events_pending (l2learn_main_t * lm)
+{
+  l2learn_event_ring_t *ring;
+
+  vec_foreach (ring, lm->event_rings)
+  {
+    if (ring->tail != ring->head)
+      return 1;
+  }
+  return 0;
+}
+
+/**
+ * Sleep until l2-learn queues an event, then poll the rings, batching
+ * the updates, until they are all empty again
+ */
+static uword
+l2learn_event_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
+		       vlib_frame_t * f)
+{
+  l2learn_main_t *lm = &l2learn_main;
+
+  lm->last_update_time = vlib_time_now (vm);
+
+  while (1)
+    {
+      if (l2learn_events_pending (lm))
+	vlib_process_suspend (vm, L2LEARN_PROCESS_BUSY_INTERVAL);
+      else
+	{
+	  lm->process_sleeping = 1;
+	  CLIB_MEMORY_BARRIER ();
+	  /* Last check, l2-learn now sees us asleep */
+	  if (!l2learn_events_pending (lm))
+	    {
+	      vlib_process_wait_for_event (vm);
+	      vlib_process_get_events (vm, NULL);
+	    }
+	  lm->process_sleeping = 0;
+	}
+
+      l2learn_collect_events (vm, lm, l2learn_update_budget (vm, lm));
+
+      if (vec_len (lm->pending_events) == 0)
+	continue;
+
+      l2learn_apply_events (vm, lm);
+
+      hash_free (lm->pending_event_by_key);
+      vec_reset_length (lm->pending_events);
+    }
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (l2learn_event_process_node, static) = {
+  .function = l2learn_event_process,
+  .type = VLIB_NODE_TYPE_PROCESS,
+  .name = "l2learn-event-process",
+};
+/* *INDENT-ON* */
+
+clib_error_t *
+l2learn_init (vlib_main_t * vm)
 {
   l2learn_main_t *mp = &l2learn_main;
 
   mp->vlib_main = vm;
   mp->vnet_main = vnet_get_main ();
 
+  vec_validate_aligned (mp->event_rings,
+			vlib_get_thread_main ()->n_vlib_mains - 1,
+			CLIB_CACHE_LINE_BYTES);
+
   /* Initialize the feature next-node indexes */
   feat_bitmap_init_next_nodes (vm,
 			       l2learn_node.index,
@@ -507,6 +756,7 @@ VLIB_NODE_FUNCTION_MULTIARCH (l2learn_node, l2learn_node_fn)
    * of buckets.
    */
   mp->global_learn_limit = L2LEARN_DEFAULT_LIMIT;
+  mp->update_rate_limit = L2LEARN_DEFAULT_RATE_LIMIT;
 
   return 0;
 }
@@ -578,6 +828,9 @@ l2learn_config (vlib_main_t * vm, unformat_input_t * input)
       if (unformat (input, "limit %d", &mp->global_learn_limit))
 	;
 
+      else if (unformat (input, "rate-limit %d", &mp->update_rate_limit))
+	;
+
       else
 	return clib_error_return (0, "unknown input `%U'",
 				  format_unformat_error, input);
@@ -20,7 +20,34 @@
 
 #include <vlib/vlib.h>
 #include <vnet/ethernet/ethernet.h>
+#include <vnet/l2/l2_fib.h>
 
+/**
+ * A mac table update decided by l2-learn, applied by the learn process
+ */
+typedef struct
+{
+  l2fib_entry_key_t key;
+  l2fib_entry_result_t result;
+} l2learn_event_t;
+
+#define L2LEARN_EVENT_RING_SIZE 4096
+
+/**
+ * Per thread ring of learn events
+ *
+ * Single producer, the l2-learn node of the thread, single consumer, the
+ * learn process on the main thread. Head and tail are free running.
+ */
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  volatile u32 tail;		/**< next slot to write, l2-learn owned */
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline1);
+  volatile u32 head;		/**< next slot to read, process owned */
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline2);
+  l2learn_event_t events[L2LEARN_EVENT_RING_SIZE];
+} l2learn_event_ring_t;
 
 typedef struct
 {
@@ -34,6 +61,22 @@ typedef struct
   /* maximum number of dynamically learned mac entries */
   u32 global_learn_limit;
 
+  /* per thread learn event rings */
+  l2learn_event_ring_t *event_rings;
+
+  /* set while the learn process waits for the first event */
+  volatile u32 process_sleeping;
+
+  /* learn process state: events of the batch being built, by key */
+  l2learn_event_t *pending_events;
+  uword *pending_event_by_key;
+  BVT (clib_bihash_kv) * pending_kvs;
+
+  /* maximum number of mac table updates per second, 0 for no limit */
+  u32 update_rate_limit;
+  f64 update_tokens;
+  f64 last_update_time;
+
   /* client waiting for L2 MAC events for learned and aged MACs */
   u32 client_pid;
   u32 client_index;
@@ -47,11 +90,35 @@ typedef struct
 } l2learn_main_t;
 
 #define L2LEARN_DEFAULT_LIMIT (L2FIB_NUM_BUCKETS * 64)
+#define L2LEARN_DEFAULT_RATE_LIMIT (100 * 1000)
 
 extern l2learn_main_t l2learn_main;
 
 extern vlib_node_registration_t l2fib_mac_age_scanner_process_node;
 
+/**
+ * Queue a mac table update for the learn process
+ *
+ * @return 0 if the ring is full and the event is dropped
+ */
+static_always_inline int
+l2learn_event_enqueue (l2learn_event_ring_t * ring,
+		       l2fib_entry_key_t * key, l2fib_entry_result_t * result)
+{
+  u32 tail = ring->tail;
+  l2learn_event_t *e;
+
+  if (PREDICT_FALSE (tail - ring->head >= L2LEARN_EVENT_RING_SIZE))
+    return 0;
+
+  e = &ring->events[tail & (L2LEARN_EVENT_RING_SIZE - 1)];
+  e->key.raw = key->raw;
+  e->result.raw = result->raw;
+  CLIB_MEMORY_STORE_BARRIER ();
+  ring->tail = tail + 1;
+  return 1;
+}
+
 enum
 {
   L2_MAC_AGE_PROCESS_EVENT_START = 1,
@@ -258,6 +258,8 @@ application_init (application_t * app, u32 api_client_index, u64 * options,
   props->preallocated_fifo_pairs = options[APP_OPTIONS_PREALLOC_FIFO_PAIRS];
   props->use_private_segment = options[APP_OPTIONS_FLAGS]
     & APP_OPTIONS_FLAGS_IS_BUILTIN;
+  props->elastic_fifos = (options[APP_OPTIONS_FLAGS]
+			  & APP_OPTIONS_FLAGS_ELASTIC_FIFOS) != 0;
   props->private_segment_count = options[APP_OPTIONS_PRIVATE_SEGMENT_COUNT];
   props->private_segment_size = options[APP_OPTIONS_PRIVATE_SEGMENT_SIZE];
 
@@ -284,6 +286,10 @@ application_init (application_t * app, u32 api_client_index, u64 * options,
 
   /* Allocate app event queue in the first shared-memory segment */
   app->event_queue = segment_manager_alloc_queue (sm, app_evt_queue_size);
+  if (app->flags & APP_OPTIONS_FLAGS_EVT_MQ)
+    app->event_mqs = segment_manager_alloc_event_mqs (sm, vlib_num_workers ()
+						      + 1,
+						      app_evt_queue_size);
 
   /* Check that the obvious things are properly set up */
   application_verify_cb_fns (cb_fns);
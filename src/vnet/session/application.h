@@ -74,6 +74,10 @@ typedef struct _application
   /** Application listens for events on this svm queue */
   unix_shared_memory_queue_t *event_queue;
 
+  /** If the app asked for them, per vpp thread event queues used instead
+   *  of @a event_queue to deliver rx events */
+  svm_msg_q_t **event_mqs;
+
   /*
    * Callbacks: shoulder-taps for the server/client
    */
@@ -43,6 +43,7 @@ typedef struct _vnet_app_attach_args_t
   u32 segment_name_length;
   u32 segment_size;
   u64 app_event_queue_address;
+  u64 app_mqs_address;
   u32 app_index;
 } vnet_app_attach_args_t;
 
@@ -124,7 +125,9 @@ typedef enum
   _(IS_BUILTIN, "Application is builtin")			\
   _(IS_PROXY, "Application is proxying")				\
   _(USE_GLOBAL_SCOPE, "App can use global session scope")	\
-  _(USE_LOCAL_SCOPE, "App can use local session scope")
+  _(USE_LOCAL_SCOPE, "App can use local session scope")		\
+  _(ELASTIC_FIFOS, "Fifos grow and shrink with their data")	\
+  _(EVT_MQ, "Use per thread lock-free event message queues")
 
 typedef enum _app_options
 {
@@ -402,17 +402,30 @@ again:
       *fifo_segment_index = sm->segment_indices[i];
       fifo_segment = svm_fifo_segment_get_segment (*fifo_segment_index);
 
+      /* Elastic fifos need their producer in vpp, as chunks are carved out
+       * of the segment's heap. That's always the case for rx fifos, but tx
+       * fifos qualify only if the app is builtin. */
       fifo_size = props->rx_fifo_size;
       fifo_size = (fifo_size == 0) ? default_fifo_size : fifo_size;
-      *server_rx_fifo =
-	svm_fifo_segment_alloc_fifo (fifo_segment, fifo_size,
-				     FIFO_SEGMENT_RX_FREELIST);
+      if (props->elastic_fifos)
+	*server_rx_fifo =
+	  svm_fifo_segment_alloc_elastic_fifo (fifo_segment, fifo_size,
+					       FIFO_SEGMENT_RX_FREELIST);
+      else
+	*server_rx_fifo =
+	  svm_fifo_segment_alloc_fifo (fifo_segment, fifo_size,
+				       FIFO_SEGMENT_RX_FREELIST);
 
       fifo_size = props->tx_fifo_size;
       fifo_size = (fifo_size == 0) ? default_fifo_size : fifo_size;
-      *server_tx_fifo =
-	svm_fifo_segment_alloc_fifo (fifo_segment, fifo_size,
-				     FIFO_SEGMENT_TX_FREELIST);
+      if (props->elastic_fifos && props->use_private_segment)
+	*server_tx_fifo =
+	  svm_fifo_segment_alloc_elastic_fifo (fifo_segment, fifo_size,
+					       FIFO_SEGMENT_TX_FREELIST);
+      else
+	*server_tx_fifo =
+	  svm_fifo_segment_alloc_fifo (fifo_segment, fifo_size,
+				       FIFO_SEGMENT_TX_FREELIST);
 
       if (*server_rx_fifo == 0)
 	{
@@ -580,6 +593,37 @@ segment_manager_dealloc_queue (segment_manager_t * sm,
   ssvm_pop_heap (oldheap);
 }
 
+/**
+ * Allocates, in the first segment, one event message queue per vpp thread
+ *
+ * Every queue has a single producer, the thread owning the sessions whose
+ * events it carries. All share one consumer wakeup notification. Like the
+ * app event queue, they go away with the segment.
+ */
+svm_msg_q_t **
+segment_manager_alloc_event_mqs (segment_manager_t * sm, u32 n_mqs,
+				 u32 queue_size)
+{
+  svm_fifo_segment_private_t *segment;
+  svm_msg_q_notify_t *notify;
+  svm_msg_q_t **mqs = 0;
+  void *oldheap;
+  int i;
+
+  ASSERT (sm->segment_indices != 0);
+
+  segment = svm_fifo_segment_get_segment (sm->segment_indices[0]);
+
+  oldheap = ssvm_push_heap (segment->ssvm.sh);
+  notify = svm_msg_q_notify_alloc ();
+  vec_validate (mqs, n_mqs - 1);
+  for (i = 0; i < n_mqs; i++)
+    mqs[i] = svm_msg_q_alloc (queue_size, sizeof (session_fifo_event_t),
+			      notify);
+  ssvm_pop_heap (oldheap);
+  return mqs;
+}
+
 static clib_error_t *
 segment_manager_show_fn (vlib_main_t * vm, unformat_input_t * input,
 			 vlib_cli_command_t * cmd)
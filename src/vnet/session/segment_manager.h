@@ -17,6 +17,7 @@
 
 #include <vnet/vnet.h>
 #include <svm/svm_fifo_segment.h>
+#include <svm/svm_msg_q.h>
 
 #include <vlibmemory/unix_shared_memory_queue.h>
 #include <vlibmemory/api.h>
@@ -40,6 +41,9 @@ typedef struct _segment_manager_properties
   /** Use private memory segment instead of shared memory */
   u8 use_private_segment;
 
+  /** Allocate fifo memory in chunks, as data arrives */
+  u8 elastic_fifos;
+
   /** Use one or more private mheaps, instead of the global heap */
   u32 private_segment_count;
   u32 private_segment_size;
@@ -118,6 +122,9 @@ unix_shared_memory_queue_t *segment_manager_alloc_queue (segment_manager_t *
 							 sm, u32 queue_size);
 void segment_manager_dealloc_queue (segment_manager_t * sm,
 				    unix_shared_memory_queue_t * q);
+svm_msg_q_t **segment_manager_alloc_event_mqs (segment_manager_t * sm,
+					       u32 n_mqs, u32 queue_size);
+
 void segment_manager_app_detach (segment_manager_t * sm);
 
 segment_manager_properties_t *segment_manager_properties_alloc (void);
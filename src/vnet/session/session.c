@@ -101,12 +101,14 @@ session_alloc (u32 thread_index)
   memset (s, 0, sizeof (*s));
   s->session_index = s - session_manager_main.sessions[thread_index];
   s->thread_index = thread_index;
+  s->tx_pacer_handle = ~0;
   return s;
 }
 
 static void
 session_free (stream_session_t * s)
 {
+  session_tx_pacer_cancel (s);
   pool_put (session_manager_main.sessions[s->thread_index], s);
   if (CLIB_DEBUG)
     memset (s, 0xFA, sizeof (*s));
@@ -474,6 +476,18 @@ session_enqueue_notify (stream_session_t * s, u8 block)
       evt.fifo = s->server_rx_fifo;
       evt.event_type = FIFO_EVENT_APP_RX;
 
+      /* Lock-free per thread queue, if the app uses them */
+      if (app->event_mqs)
+	{
+	  if (svm_msg_q_add (app->event_mqs[s->thread_index], &evt))
+	    {
+	      /* Let the next enqueue try again */
+	      svm_fifo_unset_event (s->server_rx_fifo);
+	      return -1;
+	    }
+	  goto done;
+	}
+
       /* Add event to server's event queue */
       q = app->event_queue;
 
@@ -488,6 +502,8 @@ session_enqueue_notify (stream_session_t * s, u8 block)
 	}
     }
 
+done:
+
   /* *INDENT-OFF* */
   SESSION_EVT_DBG(SESSION_EVT_ENQ, s, ({
       ed->data[0] = evt.event_type;
@@ -931,6 +947,7 @@ void
 stream_session_disconnect (stream_session_t * s)
 {
   s->session_state = SESSION_STATE_CLOSED;
+  session_tx_pacer_cancel (s);
   tp_vfts[s->session_type].close (s->connection_index, s->thread_index);
 }
 
@@ -946,6 +963,7 @@ stream_session_cleanup (stream_session_t * s)
   int rv;
 
   s->session_state = SESSION_STATE_CLOSED;
+  session_tx_pacer_cancel (s);
 
   /* Delete from the main lookup table to avoid more enqueues */
   rv = session_lookup_del_session (s);
@@ -1063,6 +1081,7 @@ session_manager_main_enable (vlib_main_t * vm)
   vec_validate (smm->tx_buffers, num_threads - 1);
   vec_validate (smm->pending_event_vector, num_threads - 1);
   vec_validate (smm->pending_disconnects, num_threads - 1);
+  vec_validate (smm->tx_pacer_wheels, num_threads - 1);
   vec_validate (smm->free_event_vector, num_threads - 1);
   vec_validate (smm->vpp_event_queues, num_threads - 1);
   vec_validate (smm->session_peekers, num_threads - 1);
@@ -1084,6 +1103,10 @@ session_manager_main_enable (vlib_main_t * vm)
       _vec_len (smm->pending_event_vector[i]) = 0;
       vec_validate (smm->pending_disconnects[i], 0);
       _vec_len (smm->pending_disconnects[i]) = 0;
+      tw_timer_wheel_init_16t_2w_512sl (&smm->tx_pacer_wheels[i],
+					0 /* no callback */ ,
+					TRANSPORT_PACER_TICK,
+					~0 /* max expirations */ );
       if (num_threads > 1)
 	{
 	  clib_spinlock_init (&smm->peekers_readers_locks[i]);
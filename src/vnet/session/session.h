@@ -21,6 +21,7 @@
 #include <vlibmemory/unix_shared_memory_queue.h>
 #include <vnet/session/session_debug.h>
 #include <vnet/session/segment_manager.h>
+#include <vppinfra/tw_timer_16t_2w_512sl.h>
 
 #define HALF_OPEN_LOOKUP_INVALID_VALUE ((u64)~0)
 #define INVALID_INDEX ((u32)~0)
@@ -122,6 +123,7 @@ extern session_fifo_rx_fn session_tx_fifo_peek_and_snd;
 extern session_fifo_rx_fn session_tx_fifo_dequeue_and_snd;
 
 u8 session_node_lookup_fifo_event (svm_fifo_t * f, session_fifo_event_t * e);
+void session_tx_pacer_cancel (stream_session_t * s);
 
 struct _session_manager_main
 {
@@ -156,6 +158,10 @@ struct _session_manager_main
   /** per-worker postponed disconnects */
   session_fifo_event_t **pending_disconnects;
 
+  /** Per worker-thread wheel that releases tx events postponed by
+   *  pacing. Timers are keyed by session index */
+  tw_timer_wheel_16t_2w_512sl_t *tx_pacer_wheels;
+
   /** vpp fifo event queue */
   unix_shared_memory_queue_t **vpp_event_queues;
 
@@ -389,6 +395,7 @@ session_clone_safe (u32 session_index, u32 thread_index)
   session_pool_remove_peeker (thread_index);
   new_s->thread_index = current_thread_index;
   new_s->session_index = session_get_index (new_s);
+  new_s->tx_pacer_handle = ~0;
   return new_s;
 }
 
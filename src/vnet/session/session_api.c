@@ -354,6 +354,7 @@ done:
 	    rmp->segment_name_length = a->segment_name_length;
 	  }
 	rmp->app_event_queue_address = a->app_event_queue_address;
+	rmp->app_mqs_address = a->app_mqs_address;
       }
   }));
   /* *INDENT-ON* */
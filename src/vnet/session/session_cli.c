@@ -195,12 +195,42 @@ unformat_transport_connection (unformat_input_t * input, va_list * args)
   return 0;
 }
 
+/**
+ * Memory used by the fifos of all segments. Chunk memory is in use by, or
+ * free to be used by, elastic fifos.
+ */
+static void
+show_session_segments (vlib_main_t * vm)
+{
+  svm_fifo_segment_private_t *segments, *seg;
+  u8 *name;
+
+  segments = svm_fifo_segment_segments_pool ();
+  vlib_cli_output (vm, "%-20s%-10s%-10s%-12s%-12s%-12s%s", "Segment",
+		   "Fifos", "Elastic", "Fifo-mem", "Chunk-mem", "Chunk-free",
+		   "Heap used/size");
+
+  /* *INDENT-OFF* */
+  pool_foreach (seg, segments, ({
+    if (seg->h->flags & FIFO_SEGMENT_F_IS_PRIVATE)
+      name = format (0, "%s", seg->h->flags & FIFO_SEGMENT_F_IS_MAIN_HEAP ?
+                     "main heap" : "private heap");
+    else
+      name = format (0, "%s", seg->ssvm.name);
+    vlib_cli_output (vm, "%-20v%U", name, format_svm_fifo_segment_usage,
+                     seg);
+    vec_free (name);
+  }));
+  /* *INDENT-ON* */
+}
+
 static clib_error_t *
 show_session_command_fn (vlib_main_t * vm, unformat_input_t * input,
 			 vlib_cli_command_t * cmd)
 {
   session_manager_main_t *smm = &session_manager_main;
   u8 *str = 0, one_session = 0, do_listeners = 0, sst, *app_name;
+  u8 do_segments = 0;
   int verbose = 0, i;
   stream_session_t *pool, *s;
   u32 transport_proto = ~0;
@@ -219,6 +249,8 @@ show_session_command_fn (vlib_main_t * vm, unformat_input_t * input,
       else if (unformat (input, "listeners %U", unformat_transport_proto,
 			 &transport_proto))
 	do_listeners = 1;
+      else if (unformat (input, "segments"))
+	do_segments = 1;
       else if (unformat (input, "%U", unformat_stream_session, &s))
 	{
 	  one_session = 1;
@@ -234,6 +266,12 @@ show_session_command_fn (vlib_main_t * vm, unformat_input_t * input,
       return 0;
     }
 
+  if (do_segments)
+    {
+      show_session_segments (vm);
+      return 0;
+    }
+
   if (do_listeners)
     {
       sst = session_type_from_proto_and_ip (transport_proto, 1);
@@ -302,7 +340,7 @@ show_session_command_fn (vlib_main_t * vm, unformat_input_t * input,
 VLIB_CLI_COMMAND (vlib_cli_show_session_command) =
 {
   .path = "show session",
-  .short_help = "show session [verbose [nnn]]",
+  .short_help = "show session [verbose [nnn]][segments]",
   .function = show_session_command_fn,
 };
 /* *INDENT-ON* */
@@ -131,6 +131,86 @@ session_tx_fifo_chain_tail (session_manager_main_t * smm, vlib_main_t * vm,
   *left_to_snd0 -= left_from_seg;
 }
 
+/**
+ * Park the tx event of a session on the pacer wheel until its connection
+ * may send again. The timer is keyed by session index, not by fifo, and is
+ * stopped if the session is disconnected or cleaned up.
+ */
+static void
+session_tx_pacer_postpone (session_manager_main_t * smm, u32 thread_index,
+			   stream_session_t * s, f64 wait)
+{
+  u32 ticks;
+
+  if (PREDICT_FALSE (s->tx_pacer_handle != ~0))
+    return;
+
+  ASSERT (s->session_index <= 0x0FFFFFFF);
+  ticks = ceil (wait / TRANSPORT_PACER_TICK);
+  ticks = clib_max (ticks, 1);
+  ticks = clib_min (ticks, (512 * 512) - 1);
+  s->tx_pacer_handle =
+    tw_timer_start_16t_2w_512sl (&smm->tx_pacer_wheels[thread_index],
+				 s->session_index, 0, ticks);
+}
+
+/**
+ * Drop the parked tx event of a session, if any
+ *
+ * Should be called from the session's thread.
+ */
+void
+session_tx_pacer_cancel (stream_session_t * s)
+{
+  session_manager_main_t *smm = vnet_get_session_manager_main ();
+
+  if (PREDICT_TRUE (s->tx_pacer_handle == ~0))
+    return;
+
+  tw_timer_stop_16t_2w_512sl (&smm->tx_pacer_wheels[s->thread_index],
+			      s->tx_pacer_handle);
+  s->tx_pacer_handle = ~0;
+}
+
+always_inline void
+session_tx_pacer_event (stream_session_t * s, session_fifo_event_t * e)
+{
+  e->fifo = s->server_tx_fifo;
+  e->event_type = FIFO_EVENT_APP_TX;
+  e->postponed = 0;
+}
+
+/**
+ * Move the paced tx events whose wait is over to the pending event vector
+ */
+always_inline void
+session_tx_pacer_expire (session_manager_main_t * smm, u32 thread_index,
+			 f64 now)
+{
+  tw_timer_wheel_16t_2w_512sl_t *tw = &smm->tx_pacer_wheels[thread_index];
+  session_fifo_event_t *e;
+  stream_session_t *s;
+  u32 *expired, i;
+
+  /* Run even if there's nothing parked to keep the wheel's time current */
+  if (PREDICT_TRUE (now < tw->next_run_time))
+    return;
+
+  expired = tw_timer_expire_timers_16t_2w_512sl (tw, now);
+  for (i = 0; i < vec_len (expired); i++)
+    {
+      s = session_get_if_valid (expired[i] & 0x0FFFFFFF, thread_index);
+      if (PREDICT_FALSE (!s || s->tx_pacer_handle == ~0))
+	{
+	  clib_warning ("paced session %u is gone", expired[i] & 0x0FFFFFFF);
+	  continue;
+	}
+      s->tx_pacer_handle = ~0;
+      vec_add2 (smm->pending_event_vector[thread_index], e, 1);
+      session_tx_pacer_event (s, e);
+    }
+}
+
 always_inline int
 session_tx_fifo_read_and_snd_i (vlib_main_t * vm, vlib_node_runtime_t * node,
 				session_manager_main_t * smm,
@@ -151,6 +231,8 @@ session_tx_fifo_read_and_snd_i (vlib_main_t * vm, vlib_node_runtime_t * node,
   int i, n_bytes_read;
   u32 n_bytes_per_buf, deq_per_buf, deq_per_first_buf;
   u32 buffers_allocated, buffers_allocated_this_call;
+  u32 burst0;
+  u8 is_paced0, pacer_limited0 = 0;
 
   next_index = next0 = session_type_to_next[s0->session_type];
 
@@ -168,6 +250,26 @@ session_tx_fifo_read_and_snd_i (vlib_main_t * vm, vlib_node_runtime_t * node,
       return 0;
     }
 
+  /* Spread the window over the rtt instead of sending it in one burst */
+  is_paced0 = transport_connection_is_tx_paced (tc0);
+  if (is_paced0)
+    {
+      burst0 = transport_connection_tx_pacer_burst (tc0, vlib_time_now (vm));
+      if (burst0 < snd_mss0)
+	{
+	  session_tx_pacer_postpone (smm, thread_index, s0,
+				     transport_connection_tx_pacer_wait
+				     (tc0, snd_mss0));
+	  return 0;
+	}
+      burst0 -= burst0 % snd_mss0;
+      if (burst0 < snd_space0)
+	{
+	  snd_space0 = burst0;
+	  pacer_limited0 = 1;
+	}
+    }
+
   /* Allow enqueuing of a new event */
   svm_fifo_unset_event (s0->server_tx_fifo);
 
@@ -209,7 +311,9 @@ session_tx_fifo_read_and_snd_i (vlib_main_t * vm, vlib_node_runtime_t * node,
   n_bufs_per_seg = ceil ((double) n_bytes_per_seg / n_bytes_per_buf);
   n_bufs_per_evt = ceil ((double) max_len_to_snd0 / n_bytes_per_seg);
   n_frames_per_evt = ceil ((double) n_bufs_per_evt / VLIB_FRAME_SIZE);
-  n_bufs_per_frame = n_bufs_per_seg * VLIB_FRAME_SIZE;
+  /* Don't hoard buffers if segments are large, i.e., with GSO */
+  n_bufs_per_frame = n_bufs_per_seg *
+    clib_min (VLIB_FRAME_SIZE, ceil ((double) max_len_to_snd0 / snd_mss0));
 
   deq_per_buf = clib_min (snd_mss0, n_bytes_per_buf);
   deq_per_first_buf = clib_min (snd_mss0, n_bytes_per_buf - MAX_HDRS_LEN);
@@ -346,13 +450,22 @@ session_tx_fifo_read_and_snd_i (vlib_main_t * vm, vlib_node_runtime_t * node,
       vlib_put_next_frame (vm, node, next_index, n_left_to_next);
     }
 
+  if (is_paced0)
+    transport_connection_tx_pacer_update_bytes (tc0, max_len_to_snd0
+						- left_to_snd0);
+
   /* If we couldn't dequeue all bytes mark as partially read */
   if (max_len_to_snd0 < max_dequeue0)
     {
       /* If we don't already have new event */
       if (svm_fifo_set_event (s0->server_tx_fifo))
 	{
-	  vec_add1 (smm->pending_event_vector[thread_index], *e0);
+	  if (pacer_limited0)
+	    session_tx_pacer_postpone (smm, thread_index, s0,
+				       transport_connection_tx_pacer_wait
+				       (tc0, snd_mss0));
+	  else
+	    vec_add1 (smm->pending_event_vector[thread_index], *e0);
 	}
     }
   return 0;
@@ -495,6 +608,7 @@ session_node_lookup_fifo_event (svm_fifo_t * f, session_fifo_event_t * e)
   session_manager_main_t *smm = vnet_get_session_manager_main ();
   unix_shared_memory_queue_t *q;
   session_fifo_event_t *pending_event_vector, *evt;
+  stream_session_t *s;
   int i, index, found = 0;
   i8 *headp;
   u8 thread_index;
@@ -529,6 +643,18 @@ session_node_lookup_fifo_event (svm_fifo_t * f, session_fifo_event_t * e)
 	break;
       }
   }
+  /*
+   * Search tx events parked by the pacer
+   */
+  if (!found)
+    {
+      s = session_get_if_valid (f->master_session_index, thread_index);
+      if (s && s->server_tx_fifo == f && s->tx_pacer_handle != ~0)
+	{
+	  session_tx_pacer_event (s, e);
+	  found = 1;
+	}
+    }
   return found;
 }
 
@@ -562,6 +688,11 @@ session_queue_node_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
   if (PREDICT_FALSE (q == 0))
     return 0;
 
+  /*
+   * Release tx events postponed by pacing
+   */
+  session_tx_pacer_expire (smm, my_thread_index, now);
+
   my_fifo_events = smm->free_event_vector[my_thread_index];
 
   /* min number of events we can dequeue without blocking */
@@ -653,6 +784,15 @@ skip_dequeue:
 	      continue;
 	    }
 	  s0 = session_get_from_handle (e0->session_handle);
+	  /* Data held back by the pacer goes out before the disconnect */
+	  if (PREDICT_FALSE (s0->tx_pacer_handle != ~0))
+	    {
+	      session_tx_pacer_cancel (s0);
+	      vec_add2 (smm->pending_event_vector[my_thread_index], e, 1);
+	      session_tx_pacer_event (s0, e);
+	      vec_add1 (smm->pending_disconnects[my_thread_index], *e0);
+	      continue;
+	    }
 	  stream_session_disconnect (s0);
 	  break;
 	case FIFO_EVENT_BUILTIN_RX:
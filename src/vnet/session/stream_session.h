@@ -80,6 +80,9 @@ typedef struct _stream_session_t
   /** Parent listener session if the result of an accept */
   u32 listener_index;
 
+  /** Pacer timer of the parked tx event, ~0 if none is parked */
+  u32 tx_pacer_handle;
+
     CLIB_CACHE_LINE_ALIGN_MARK (pad);
 } stream_session_t;
 
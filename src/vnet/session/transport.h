@@ -20,6 +20,24 @@
 #include <vnet/ip/ip.h>
 #include <vnet/tcp/tcp_debug.h>
 
+/** Pacer time granularity (s). Paced sends are postponed by multiples of it */
+#define TRANSPORT_PACER_TICK		100e-6
+/** Pacer bucket size, in ticks worth of bytes at the pacing rate */
+#define TRANSPORT_PACER_BURST_TICKS	2
+/** Min pacer bucket size, in segments */
+#define TRANSPORT_PACER_MIN_BURST_SEGS	2
+
+/**
+ * Transmit pacer. Token bucket of bytes refilled at the pacing rate
+ */
+typedef struct _transport_pacer
+{
+  f64 bytes_per_sec;		/**< Refill rate. Not paced if 0 */
+  f64 last_update;		/**< Last time the bucket was refilled */
+  u32 bucket;			/**< Bytes that can be sent now */
+  u32 max_burst;		/**< Bucket size */
+} transport_pacer_t;
+
 /*
  * Protocol independent transport properties associated to a session
  */
@@ -40,6 +58,8 @@ typedef struct _transport_connection
   fib_node_index_t rmt_fei;	/**< FIB entry index for rmt */
   dpo_id_t rmt_dpo;		/**< Forwarding DPO for rmt */
 
+  transport_pacer_t pacer;	/**< Transmit pacer */
+
 #if TRANSPORT_DEBUG
   elog_track_t elog_track;	/**< Event logging */
   u32 cc_stat_tstamp;		/**< CC stats timestamp */
@@ -64,6 +84,7 @@ typedef struct _transport_connection
 #define c_cc_stat_tstamp connection.cc_stat_tstamp
 #define c_rmt_fei connection.rmt_fei
 #define c_rmt_dpo connection.rmt_dpo
+#define c_pacer connection.pacer
 } transport_connection_t;
 
 typedef enum _transport_proto
@@ -106,6 +127,72 @@ transport_endpoint_fib_proto (transport_endpoint_t * tep)
   return tep->is_ip4 ? FIB_PROTOCOL_IP4 : FIB_PROTOCOL_IP6;
 }
 
+always_inline u8
+transport_connection_is_tx_paced (transport_connection_t * tc)
+{
+  return tc->pacer.bytes_per_sec != 0;
+}
+
+/**
+ * Set the pacing rate of a connection
+ *
+ * The bucket is sized such that the rate can be sustained even if sends
+ * are only scheduled once per pacer tick.
+ *
+ * @param tc		transport connection
+ * @param bytes_per_sec	pacing rate, 0 to stop pacing
+ * @param mss		connection's max segment size
+ */
+always_inline void
+transport_connection_tx_pacer_update (transport_connection_t * tc,
+				      f64 bytes_per_sec, u32 mss)
+{
+  transport_pacer_t *pacer = &tc->pacer;
+  f64 burst;
+
+  burst = bytes_per_sec * TRANSPORT_PACER_TICK * TRANSPORT_PACER_BURST_TICKS;
+  pacer->bytes_per_sec = bytes_per_sec;
+  pacer->max_burst = clib_max (burst, TRANSPORT_PACER_MIN_BURST_SEGS * mss);
+}
+
+/**
+ * Refill the pacer bucket and return the number of bytes that can be sent
+ */
+always_inline u32
+transport_connection_tx_pacer_burst (transport_connection_t * tc, f64 now)
+{
+  transport_pacer_t *pacer = &tc->pacer;
+  f64 tokens;
+
+  tokens = pacer->bucket + (now - pacer->last_update) * pacer->bytes_per_sec;
+  pacer->bucket = clib_min (tokens, (f64) pacer->max_burst);
+  pacer->last_update = now;
+  return pacer->bucket;
+}
+
+/**
+ * Account for bytes sent
+ */
+always_inline void
+transport_connection_tx_pacer_update_bytes (transport_connection_t * tc,
+					    u32 bytes)
+{
+  transport_pacer_t *pacer = &tc->pacer;
+  pacer->bucket -= clib_min (bytes, pacer->bucket);
+}
+
+/**
+ * Time, in seconds, until the pacer allows sending @a bytes
+ */
+always_inline f64
+transport_connection_tx_pacer_wait (transport_connection_t * tc, u32 bytes)
+{
+  transport_pacer_t *pacer = &tc->pacer;
+  if (pacer->bucket >= bytes)
+    return 0;
+  return (bytes - pacer->bucket) / pacer->bytes_per_sec;
+}
+
 always_inline u8
 transport_is_stream (u8 proto)
 {
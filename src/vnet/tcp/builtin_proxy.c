@@ -167,6 +167,7 @@ server_rx_callback (stream_session_t * s)
   uword *p;
   svm_fifo_t *active_open_tx_fifo;
   session_fifo_event_t evt;
+  svm_fifo_iovec_t iov[2];
 
   ASSERT (s->thread_index == thread_index);
 
@@ -204,9 +205,10 @@ server_rx_callback (stream_session_t * s)
       if (PREDICT_FALSE (max_dequeue == 0))
 	return 0;
 
-      actual_transfer = svm_fifo_peek (rx_fifo, 0 /* relative_offset */ ,
-				       max_dequeue,
-				       bpm->rx_buf[thread_index]);
+      /* Look at the data in place, it stays in the fifo for the proxy */
+      actual_transfer = svm_fifo_peek_in_place (rx_fifo,
+						0 /* relative_offset */ ,
+						max_dequeue, iov);
 
       /* $$$ your message in this space: parse url, etc. */
 
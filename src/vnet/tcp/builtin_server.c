@@ -34,6 +34,7 @@ typedef struct
    * Config params
    */
   u8 no_echo;			/**< Don't echo traffic */
+  u8 elastic_fifos;		/**< Fifos grow and shrink with data */
   u32 fifo_size;			/**< Fifo size */
   u32 rcv_buffer_size;		/**< Rcv buffer size */
   u32 prealloc_fifos;		/**< Preallocate fifos */
@@ -128,25 +129,13 @@ test_bytes (builtin_server_main_t * bsm, int actual_transfer)
 }
 
 /*
- * If no-echo, just read the data and be done with it
+ * If no-echo, just drop the data and be done with it
  */
 int
 builtin_server_rx_callback_no_echo (stream_session_t * s)
 {
-  builtin_server_main_t *bsm = &builtin_server_main;
-  u32 my_thread_id = vlib_get_thread_index ();
-  int actual_transfer;
-  svm_fifo_t *rx_fifo;
-
-  rx_fifo = s->server_rx_fifo;
-
-  do
-    {
-      actual_transfer =
-	svm_fifo_dequeue_nowait (rx_fifo, bsm->rcv_buffer_size,
-				 bsm->rx_buf[my_thread_id]);
-    }
-  while (actual_transfer > 0);
+  svm_fifo_dequeue_drop (s->server_rx_fifo,
+			 svm_fifo_max_dequeue (s->server_rx_fifo));
   return 0;
 }
 
@@ -156,6 +145,7 @@ builtin_server_rx_callback (stream_session_t * s)
   u32 n_written, max_dequeue, max_enqueue, max_transfer;
   int actual_transfer;
   svm_fifo_t *tx_fifo, *rx_fifo;
+  svm_fifo_iovec_t iov[2];
   builtin_server_main_t *bsm = &builtin_server_main;
   session_fifo_event_t evt;
   u32 thread_index = vlib_get_thread_index ();
@@ -207,24 +197,23 @@ builtin_server_rx_callback (stream_session_t * s)
       return 0;
     }
 
-  _vec_len (bsm->rx_buf[thread_index]) = max_transfer;
-
-  actual_transfer = svm_fifo_dequeue_nowait (rx_fifo, max_transfer,
-					     bsm->rx_buf[thread_index]);
-  ASSERT (actual_transfer == max_transfer);
-
-//  test_bytes (bsm, actual_transfer);
+  /* Read in place, no need to copy to an intermediate buffer. Elastic
+   * fifos may return less than asked for */
+  actual_transfer = svm_fifo_peek_in_place (rx_fifo, 0, max_transfer, iov);
 
   /*
    * Echo back
    */
 
-  n_written = svm_fifo_enqueue_nowait (tx_fifo, actual_transfer,
-				       bsm->rx_buf[thread_index]);
+  n_written = svm_fifo_enqueue_nowait (tx_fifo, iov[0].len, iov[0].data);
+  if (iov[1].len)
+    n_written += svm_fifo_enqueue_nowait (tx_fifo, iov[1].len, iov[1].data);
 
-  if (n_written != max_transfer)
+  if (n_written != actual_transfer)
     clib_warning ("short trout!");
 
+  svm_fifo_dequeue_drop (rx_fifo, actual_transfer);
+
   if (svm_fifo_set_event (tx_fifo))
     {
       /* Fabricate TX event, send to vpp */
@@ -297,6 +286,8 @@ server_attach (u8 * appns_id, u64 appns_flags, u64 appns_secret)
     bsm->prealloc_fifos ? bsm->prealloc_fifos : 1;
 
   a->options[APP_OPTIONS_FLAGS] = APP_OPTIONS_FLAGS_IS_BUILTIN;
+  if (bsm->elastic_fifos)
+    a->options[APP_OPTIONS_FLAGS] |= APP_OPTIONS_FLAGS_ELASTIC_FIFOS;
   if (appns_id)
     {
       a->namespace_id = appns_id;
@@ -375,6 +366,7 @@ server_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
   int rv;
 
   bsm->no_echo = 0;
+  bsm->elastic_fifos = 0;
   bsm->fifo_size = 64 << 10;
   bsm->rcv_buffer_size = 128 << 10;
   bsm->prealloc_fifos = 0;
@@ -388,6 +380,8 @@ server_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
 	bsm->no_echo = 1;
       else if (unformat (input, "fifo-size %d", &bsm->fifo_size))
 	bsm->fifo_size <<= 10;
+      else if (unformat (input, "elastic-fifos"))
+	bsm->elastic_fifos = 1;
       else if (unformat (input, "rcv-buf-size %d", &bsm->rcv_buffer_size))
 	;
       else if (unformat (input, "prealloc-fifos %d", &bsm->prealloc_fifos))
@@ -444,6 +438,7 @@ VLIB_CLI_COMMAND (server_create_command, static) =
 {
   .path = "test tcp server",
   .short_help = "test tcp server [no echo][fifo-size <mbytes>] "
+      "[elastic-fifos]"
       "[rcv-buf-size <bytes>][prealloc-fifos <count>]"
       "[private-segment-count <count>][private-segment-size <bytes[m|g]>]"
       "[uri <tcp://ip/port>]",
@@ -479,6 +479,27 @@ tcp_init_snd_vars (tcp_connection_t * tc)
   tc->snd_una_max = tc->snd_nxt;
 }
 
+/**
+ * Update the connection's pacing rate
+ *
+ * The window is spread over the smoothed rtt. The rate is inflated such
+ * that pacing does not limit cwnd growth: in slow start cwnd doubles every
+ * rtt, in congestion avoidance it grows slowly.
+ */
+void
+tcp_connection_tx_pacer_update (tcp_connection_t * tc)
+{
+  f64 srtt, rate;
+
+  if (!tcp_main.tx_pacing || !tc->srtt)
+    return;
+
+  srtt = tc->srtt * TCP_TICK;
+  rate = tc->cwnd / srtt;
+  rate *= tcp_in_slowstart (tc) ? 2.0 : 1.25;
+  transport_connection_tx_pacer_update (&tc->connection, rate, tc->snd_mss);
+}
+
 /** Initialize tcp connection variables
  *
  * Should be called after having received a msg from the peer, i.e., a SYN or
@@ -659,6 +680,39 @@ format_tcp_timers (u8 * s, va_list * args)
   return s;
 }
 
+const char *tcp_cc_algo_strs[] = {
+#define _(sym, str) str,
+  foreach_tcp_cc_algorithm
+#undef _
+};
+
+u8 *
+format_tcp_cc_algo (u8 * s, va_list * args)
+{
+  u32 type = va_arg (*args, u32);
+
+  if (type < TCP_CC_N_ALGORITHMS)
+    s = format (s, "%s", tcp_cc_algo_strs[type]);
+  else
+    s = format (s, "UNKNOWN (%d)", type);
+  return s;
+}
+
+uword
+unformat_tcp_cc_algo (unformat_input_t * input, va_list * va)
+{
+  u32 *result = va_arg (*va, u32 *);
+  int i;
+
+  for (i = 0; i < TCP_CC_N_ALGORITHMS; i++)
+    if (unformat (input, tcp_cc_algo_strs[i]))
+      {
+	*result = i;
+	return 1;
+      }
+  return 0;
+}
+
 u8 *
 format_tcp_congestion_status (u8 * s, va_list * args)
 {
@@ -689,7 +743,9 @@ format_tcp_vars (u8 * s, va_list * args)
   s = format (s, " flight size %u send space %u rcv_wnd_av %d\n",
 	      tcp_flight_size (tc), tcp_available_output_snd_space (tc),
 	      tcp_rcv_wnd_available (tc));
-  s = format (s, " cong %U ", format_tcp_congestion_status, tc);
+  s = format (s, " cc %U cong %U ", format_tcp_cc_algo,
+	      tc->cc_algo - tcp_main.cc_algos, format_tcp_congestion_status,
+	      tc);
   s = format (s, "cwnd %u ssthresh %u rtx_bytes %u bytes_acked %u\n",
 	      tc->cwnd, tc->ssthresh, tc->snd_rxt_bytes, tc->bytes_acked);
   s = format (s, " prev_ssthresh %u snd_congestion %u dupack %u",
@@ -701,6 +757,10 @@ format_tcp_vars (u8 * s, va_list * args)
   s = format (s, " rto %u rto_boff %u srtt %u rttvar %u rtt_ts %u ", tc->rto,
 	      tc->rto_boff, tc->srtt, tc->rttvar, tc->rtt_ts);
   s = format (s, "rtt_seq %u\n", tc->rtt_seq);
+  if (transport_connection_is_tx_paced (&tc->connection))
+    s = format (s, " pacer rate %.0f Bps bucket %u max_burst %u\n",
+		tc->c_pacer.bytes_per_sec, tc->c_pacer.bucket,
+		tc->c_pacer.max_burst);
   s = format (s, " tsval_recent %u tsval_recent_age %u\n", tc->tsval_recent,
 	      tcp_time_now () - tc->tsval_recent_age);
   if (tc->state >= TCP_STATE_ESTABLISHED)
@@ -894,6 +954,22 @@ tcp_half_open_session_get_transport (u32 conn_index)
  * the tcp options to be used in the next burst and subtracts their
  * length from the connection's snd_mss.
  */
+/**
+ * Size of the super-segments the session layer should build, a multiple
+ * of snd_mss. Paced connections don't get more than the pacer would
+ * let out in one burst.
+ */
+static u32
+tcp_gso_size (tcp_connection_t * tc)
+{
+  u32 size = TCP_MAX_GSO_SZ;
+
+  if (transport_connection_is_tx_paced (&tc->connection))
+    size = clib_min (size, tc->connection.pacer.max_burst);
+  size -= size % tc->snd_mss;
+  return clib_max (size, tc->snd_mss);
+}
+
 u16
 tcp_session_send_mss (transport_connection_t * trans_conn)
 {
@@ -904,6 +980,9 @@ tcp_session_send_mss (transport_connection_t * trans_conn)
    * the current state of the connection. */
   tcp_update_snd_mss (tc);
 
+  if (tcp_main.gso)
+    return tcp_gso_size (tc);
+
   return tc->snd_mss;
 }
 
@@ -1278,6 +1357,7 @@ tcp_init (vlib_main_t * vm)
 
   /* Session layer, and by implication tcp, are disabled by default */
   tm->is_enabled = 0;
+  tm->tx_pacing = 0;
 
   /* Register with IP for header parsing */
   pi = ip_get_protocol_info (im, IP_PROTOCOL_TCP);
@@ -1318,6 +1398,18 @@ tcp_config_fn (vlib_main_t * vm, unformat_input_t * input)
       else if (unformat (input, "local-endpoints-table-buckets %d",
 			 &tm->local_endpoints_table_buckets))
 	;
+      else if (unformat (input, "cc-algo %U", unformat_tcp_cc_algo,
+			 &tm->cc_algo))
+	;
+      else if (unformat (input, "tx-pacing"))
+	tm->tx_pacing = 1;
+      else if (unformat (input, "no-tx-pacing"))
+	tm->tx_pacing = 0;
+      else if (unformat (input, "gso"))
+	{
+	  tm->gso = 1;
+	  vnet_get_main ()->interface_main.gso_enabled = 1;
+	}
 
 
       else
@@ -1799,6 +1891,53 @@ VLIB_CLI_COMMAND (show_tcp_punt_command, static) =
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+tcp_set_cc_algo_fn (vlib_main_t * vm, unformat_input_t * input,
+		    vlib_cli_command_t * cmd_arg)
+{
+  tcp_main_t *tm = vnet_get_tcp_main ();
+  transport_connection_t *tconn = 0;
+  tcp_connection_t *tc;
+  u32 type = ~0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "%U", unformat_tcp_cc_algo, &type))
+	;
+      else if (unformat (input, "%U", unformat_transport_connection, &tconn,
+			 TRANSPORT_PROTO_TCP))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (type == ~0)
+    return clib_error_return (0, "congestion control algorithm required");
+
+  if (!tconn)
+    {
+      tm->cc_algo = type;
+      return 0;
+    }
+
+  tc = tcp_get_connection_from_transport (tconn);
+  if (!tc)
+    return clib_error_return (0, "connection not found");
+
+  tcp_cc_algo_set (tc, type);
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (tcp_set_cc_algo_command, static) =
+{
+  .path = "set tcp cc-algo",
+  .short_help = "set tcp cc-algo <newreno|cubic|bbr> [<connection>]",
+  .function = tcp_set_cc_algo_fn,
+};
+/* *INDENT-ON* */
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
@@ -30,6 +30,7 @@
 #define TCP_PAWS_IDLE 24 * 24 * 60 * 60 * THZ /**< 24 days */
 #define TCP_FIB_RECHECK_PERIOD	1 * THZ	/**< Recheck every 1s */
 #define TCP_MAX_OPTION_SPACE 40
+#define TCP_MAX_GSO_SZ 65000		/**< Max payload of a super-segment */
 
 #define TCP_DUPACK_THRESHOLD 	3
 #define TCP_MAX_RX_FIFO_SIZE 	4 << 20
@@ -64,6 +65,7 @@ format_function_t format_tcp_state;
 format_function_t format_tcp_flags;
 format_function_t format_tcp_sacks;
 format_function_t format_tcp_rcv_sacks;
+format_function_t format_tcp_cc_algo;
 
 /** TCP timers */
 #define foreach_tcp_timer               \
@@ -225,11 +227,22 @@ typedef struct _sack_scoreboard
 #define tcp_scoreboard_trace_add(_tc, _ack)
 #endif
 
+#define foreach_tcp_cc_algorithm		\
+  _(NEWRENO, "newreno")				\
+  _(CUBIC, "cubic")				\
+  _(BBR, "bbr")
+
 typedef enum _tcp_cc_algorithm_type
 {
-  TCP_CC_NEWRENO,
+#define _(sym, str) TCP_CC_##sym,
+  foreach_tcp_cc_algorithm
+#undef _
+  TCP_CC_N_ALGORITHMS
 } tcp_cc_algorithm_type_e;
 
+/** Size, in u64s, of the per connection congestion control state */
+#define TCP_CC_DATA_SZ 12
+
 typedef struct _tcp_cc_algorithm tcp_cc_algorithm_t;
 
 typedef enum _tcp_cc_ack_t
@@ -292,12 +305,14 @@ typedef struct _tcp_connection
   u32 tsecr_last_ack;	/**< Timestamp echoed to us in last healthy ACK */
   u32 snd_congestion;	/**< snd_una_max when congestion is detected */
   tcp_cc_algorithm_t *cc_algo;	/**< Congestion control algorithm */
+  u64 cc_data[TCP_CC_DATA_SZ];	/**< Congestion control algorithm data */
 
   /* RTT and RTO */
   u32 rto;		/**< Retransmission timeout */
   u32 rto_boff;		/**< Index for RTO backoff */
   u32 srtt;		/**< Smoothed RTT */
   u32 rttvar;		/**< Smoothed mean RTT difference. Approximates variance */
+  u32 mrtt;		/**< Last valid RTT measurement */
   u32 rtt_ts;		/**< Timestamp for tracked ACK */
   u32 rtt_seq;		/**< Sequence number for tracked ACK */
 
@@ -312,6 +327,7 @@ struct _tcp_cc_algorithm
   void (*rcv_cong_ack) (tcp_connection_t * tc, tcp_cc_ack_t ack);
   void (*congestion) (tcp_connection_t * tc);
   void (*recovered) (tcp_connection_t * tc);
+  void (*loss) (tcp_connection_t * tc);		/**< optional, on rto */
   void (*init) (tcp_connection_t * tc);
 };
 
@@ -388,6 +404,15 @@ typedef struct _tcp_main
   /* Congestion control algorithms registered */
   tcp_cc_algorithm_t *cc_algos;
 
+  /** Congestion control algorithm used by new connections */
+  tcp_cc_algorithm_type_e cc_algo;
+
+  /** Pace transmissions at the rate allowed by cwnd/srtt. Off by default */
+  u8 tx_pacing;
+
+  /** Send super-segments, segmented late by software GSO or the NIC */
+  u8 gso;
+
   /* Flag that indicates if stack is on or off */
   u8 is_enabled;
 
@@ -901,7 +926,16 @@ tcp_cc_algo_get (tcp_cc_algorithm_type_e type)
   return &tm->cc_algos[type];
 }
 
+always_inline void *
+tcp_cc_data (tcp_connection_t * tc)
+{
+  return (void *) tc->cc_data;
+}
+
 void tcp_cc_init (tcp_connection_t * tc);
+void tcp_connection_tx_pacer_update (tcp_connection_t * tc);
+void tcp_cc_algo_set (tcp_connection_t * tc, tcp_cc_algorithm_type_e type);
+uword unformat_tcp_cc_algo (unformat_input_t * input, va_list * va);
 
 /**
  * Push TCP header to buffer
@@ -0,0 +1,296 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Model based congestion control in the spirit of BBR
+ * (draft-cardwell-iccrg-bbr-congestion-control).
+ *
+ * The sender keeps estimates of the bottleneck bandwidth, as the windowed
+ * max of the per round delivery rate, and of the round trip propagation
+ * delay, as the windowed min of the measured rtt. The congestion window
+ * is set to a multiple of their product, the bandwidth-delay product (BDP),
+ * instead of being driven by losses. Delivery rate is sampled once per
+ * round trip from the bytes acked, not per packet.
+ */
+
+#include <vnet/tcp/tcp.h>
+
+/** Number of rounds over which the max bandwidth is tracked */
+#define BBR_BW_FILTER_LEN	8
+/** Min rtt window, in ticks */
+#define BBR_MIN_RTT_WINDOW	(10 * THZ)
+/** Time spent in PROBE_RTT, in ticks */
+#define BBR_PROBE_RTT_TIME	(THZ / 5)
+/** Gains, scaled by BBR_UNIT */
+#define BBR_UNIT		256
+#define BBR_CWND_GAIN		(BBR_UNIT * 2)
+/** Rounds without 25% bw growth after which the pipe is deemed full */
+#define BBR_FULL_BW_ROUNDS	3
+#define BBR_MIN_CWND_SEGS	4
+
+typedef enum _bbr_state
+{
+  BBR_STARTUP,
+  BBR_DRAIN,
+  BBR_PROBE_BW,
+  BBR_PROBE_RTT,
+} bbr_state_e;
+
+typedef struct bbr_data_
+{
+  u32 bw[BBR_BW_FILTER_LEN];	/**< Delivery rate of last rounds (B/tick) */
+  u32 max_bw;			/**< Bottleneck bandwidth estimate (B/tick) */
+  u32 full_bw;			/**< Bw at last 25% growth in STARTUP */
+  u32 min_rtt;			/**< Propagation delay estimate (ticks) */
+  u32 min_rtt_stamp;		/**< When min_rtt was last updated */
+  u32 round_start;		/**< Start time of current round */
+  u32 round_delivered;		/**< Bytes delivered in current round */
+  u32 probe_rtt_done;		/**< Time PROBE_RTT ends */
+  u32 prior_cwnd;		/**< cwnd before loss recovery or PROBE_RTT */
+  u16 round_count;		/**< Number of rounds sampled */
+  u8 state;			/**< bbr_state_e */
+  u8 full_bw_count;		/**< Rounds without bw growth */
+  u8 full_bw_reached;		/**< STARTUP filled the pipe */
+} bbr_data_t;
+
+STATIC_ASSERT (sizeof (bbr_data_t) <= TCP_CC_DATA_SZ * sizeof (u64),
+	       "bbr data len");
+
+static inline u32
+bbr_min_cwnd (tcp_connection_t * tc)
+{
+  return BBR_MIN_CWND_SEGS * tc->snd_mss;
+}
+
+/**
+ * Congestion window that allows @a gain times the estimated BDP in flight
+ */
+static u32
+bbr_target_cwnd (tcp_connection_t * tc, bbr_data_t * bd, u32 gain)
+{
+  u64 bdp;
+
+  /* No estimates yet */
+  if (!bd->max_bw || bd->min_rtt == ~0)
+    return tcp_initial_cwnd (tc);
+
+  bdp = (u64) bd->max_bw * bd->min_rtt;
+  bdp = (bdp * gain) / BBR_UNIT;
+  return clib_max (clib_min (bdp, 1 << 30), bbr_min_cwnd (tc));
+}
+
+static void
+bbr_update_max_bw (bbr_data_t * bd, u32 bw)
+{
+  int i;
+
+  bd->bw[bd->round_count % BBR_BW_FILTER_LEN] = bw;
+  bd->round_count++;
+  bd->max_bw = 0;
+  for (i = 0; i < BBR_BW_FILTER_LEN; i++)
+    bd->max_bw = clib_max (bd->max_bw, bd->bw[i]);
+}
+
+static void
+bbr_check_full_bw (bbr_data_t * bd)
+{
+  if (bd->full_bw_reached)
+    return;
+
+  if ((u64) bd->max_bw * 4 >= (u64) bd->full_bw * 5)
+    {
+      bd->full_bw = bd->max_bw;
+      bd->full_bw_count = 0;
+      return;
+    }
+  if (++bd->full_bw_count >= BBR_FULL_BW_ROUNDS)
+    bd->full_bw_reached = 1;
+}
+
+/**
+ * Sample delivery rate and advance the state machine once per round
+ */
+static void
+bbr_update_round (tcp_connection_t * tc, bbr_data_t * bd, u32 now)
+{
+  u32 elapsed = now - bd->round_start;
+  u32 round_len;
+
+  bd->round_delivered += tc->bytes_acked;
+
+  round_len = bd->min_rtt == ~0 ? clib_max (tc->srtt, 1) : bd->min_rtt;
+  if (elapsed < clib_max (round_len, 1))
+    return;
+
+  bbr_update_max_bw (bd, bd->round_delivered / elapsed);
+  bd->round_start = now;
+  bd->round_delivered = 0;
+
+  switch (bd->state)
+    {
+    case BBR_STARTUP:
+      bbr_check_full_bw (bd);
+      if (bd->full_bw_reached)
+	bd->state = BBR_DRAIN;
+      break;
+    case BBR_DRAIN:
+      if (tcp_flight_size (tc) <= bbr_target_cwnd (tc, bd, BBR_UNIT))
+	bd->state = BBR_PROBE_BW;
+      break;
+    default:
+      break;
+    }
+}
+
+static void
+bbr_update_min_rtt (tcp_connection_t * tc, bbr_data_t * bd, u32 now)
+{
+  u8 expired = now - bd->min_rtt_stamp > BBR_MIN_RTT_WINDOW;
+
+  if (tc->mrtt && (tc->mrtt <= bd->min_rtt || expired))
+    {
+      bd->min_rtt = tc->mrtt;
+      bd->min_rtt_stamp = now;
+    }
+
+  /* Drain the queue for a while to measure the propagation delay */
+  if (expired && bd->state != BBR_PROBE_RTT)
+    {
+      bd->state = BBR_PROBE_RTT;
+      bd->prior_cwnd = clib_max (bd->prior_cwnd, tc->cwnd);
+      bd->probe_rtt_done = now + clib_max (BBR_PROBE_RTT_TIME, bd->min_rtt);
+      tc->cwnd = bbr_min_cwnd (tc);
+    }
+}
+
+static void
+bbr_rcv_ack (tcp_connection_t * tc)
+{
+  bbr_data_t *bd = (bbr_data_t *) tcp_cc_data (tc);
+  u32 now = tcp_time_now (), target;
+
+  bbr_update_min_rtt (tc, bd, now);
+  bbr_update_round (tc, bd, now);
+
+  switch (bd->state)
+    {
+    case BBR_STARTUP:
+      /* Exponential growth until the bw estimate stops growing */
+      tc->cwnd += tc->bytes_acked;
+      return;
+    case BBR_DRAIN:
+      target = bbr_target_cwnd (tc, bd, BBR_UNIT);
+      break;
+    case BBR_PROBE_RTT:
+      if (timestamp_lt (now, bd->probe_rtt_done))
+	{
+	  tc->cwnd = bbr_min_cwnd (tc);
+	  return;
+	}
+      bd->min_rtt_stamp = now;
+      bd->state = bd->full_bw_reached ? BBR_PROBE_BW : BBR_STARTUP;
+      tc->cwnd = clib_max (tc->cwnd, bd->prior_cwnd);
+      bd->prior_cwnd = 0;
+      /* fallthrough */
+    default:
+      target = bbr_target_cwnd (tc, bd, BBR_CWND_GAIN);
+      break;
+    }
+
+  /* Converge to the target, but never by more than the bytes acked */
+  if (tc->cwnd < target)
+    tc->cwnd = clib_min (tc->cwnd + tc->bytes_acked, target);
+  else
+    tc->cwnd = target;
+}
+
+/**
+ * Losses are not taken as a signal of congestion. During recovery keep
+ * in flight what is already there (packet conservation) and go back to
+ * the model once done.
+ */
+static void
+bbr_congestion (tcp_connection_t * tc)
+{
+  bbr_data_t *bd = (bbr_data_t *) tcp_cc_data (tc);
+
+  if (bd->state != BBR_PROBE_RTT)
+    bd->prior_cwnd = tc->cwnd;
+  tc->ssthresh = clib_max (tcp_flight_size (tc), 2 * tc->snd_mss);
+}
+
+static void
+bbr_recovered (tcp_connection_t * tc)
+{
+  bbr_data_t *bd = (bbr_data_t *) tcp_cc_data (tc);
+
+  tc->cwnd = clib_max (tc->ssthresh, bd->prior_cwnd);
+  if (bd->state != BBR_PROBE_RTT)
+    bd->prior_cwnd = 0;
+}
+
+static void
+bbr_rcv_cong_ack (tcp_connection_t * tc, tcp_cc_ack_t ack_type)
+{
+  if (ack_type == TCP_CC_DUPACK)
+    {
+      if (!tcp_opts_sack_permitted (&tc->rcv_opts))
+	tc->cwnd += tc->snd_mss;
+    }
+}
+
+static void
+bbr_conn_init (tcp_connection_t * tc)
+{
+  bbr_data_t *bd = (bbr_data_t *) tcp_cc_data (tc);
+  u32 now = tcp_time_now ();
+
+  memset (bd, 0, sizeof (*bd));
+  bd->state = BBR_STARTUP;
+  bd->min_rtt = ~0;
+  bd->min_rtt_stamp = now;
+  bd->round_start = now;
+
+  tc->ssthresh = tc->snd_wnd;
+  tc->cwnd = tcp_initial_cwnd (tc);
+}
+
+const static tcp_cc_algorithm_t tcp_bbr = {
+  .congestion = bbr_congestion,
+  .recovered = bbr_recovered,
+  .rcv_ack = bbr_rcv_ack,
+  .rcv_cong_ack = bbr_rcv_cong_ack,
+  .init = bbr_conn_init
+};
+
+clib_error_t *
+bbr_init (vlib_main_t * vm)
+{
+  clib_error_t *error = 0;
+
+  tcp_cc_algo_register (TCP_CC_BBR, &tcp_bbr);
+
+  return error;
+}
+
+VLIB_INIT_FUNCTION (bbr_init);
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,270 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * CUBIC congestion control, RFC 8312
+ */
+
+#include <vnet/tcp/tcp.h>
+#include <math.h>
+
+#define beta_cubic 	0.7
+#define cubic_c		0.4
+#define west_const 	(3 * (1 - beta_cubic) / (1 + beta_cubic))
+
+typedef struct cubic_data_
+{
+  /** time period (in seconds) needed to increase the current window
+   *  size to W_max if there are no further congestion events */
+  f64 K;
+
+  /** time (in sec) since the start of current congestion avoidance,
+   *  zero if the epoch starts with the next ack in congestion avoidance */
+  f64 t_start;
+
+  /** Inflection point of the cubic function, in segments */
+  f64 w_max;
+
+  /** Bytes acked since cwnd was last incremented */
+  u32 acc_bytes;
+} cubic_data_t;
+
+STATIC_ASSERT (sizeof (cubic_data_t) <= TCP_CC_DATA_SZ * sizeof (u64),
+	       "cubic data len");
+
+static inline f64
+cubic_time (void)
+{
+  return (f64) tcp_time_now () * TCP_TICK;
+}
+
+/**
+ * RFC 8312 Eq. 1
+ *
+ * W_cubic(t) = C*(t-K)^3 + W_max
+ */
+static inline f64
+W_cubic (cubic_data_t * cd, f64 t)
+{
+  f64 diff = t - cd->K;
+  return cubic_c * diff * diff * diff + cd->w_max;
+}
+
+/**
+ * RFC 8312 Eq. 2
+ *
+ * K = cubic_root (W_max*(1-beta_cubic)/C)
+ */
+static inline f64
+K_cubic (cubic_data_t * cd)
+{
+  return cbrt (cd->w_max * (1 - beta_cubic) / cubic_c);
+}
+
+/**
+ * RFC 8312 Eq. 4
+ *
+ * W_est(t) = W_max*beta_cubic + [3*(1-beta_cubic)/(1+beta_cubic)] * (t/RTT)
+ */
+static inline f64
+W_est (cubic_data_t * cd, f64 t, f64 rtt)
+{
+  return cd->w_max * beta_cubic + west_const * (t / rtt);
+}
+
+/**
+ * Grow cwnd by one segment for every @a thresh bytes acked
+ */
+static inline void
+cubic_cwnd_accumulate (tcp_connection_t * tc, cubic_data_t * cd, u32 thresh)
+{
+  cd->acc_bytes += tc->bytes_acked;
+  if (cd->acc_bytes >= thresh)
+    {
+      u32 inc = cd->acc_bytes / thresh;
+      cd->acc_bytes -= inc * thresh;
+      tc->cwnd += inc * tc->snd_mss;
+    }
+}
+
+/**
+ * Record the window at which congestion was detected as the new inflection
+ * point and reduce ssthresh, RFC 8312 Sec. 4.5 and 4.6
+ */
+static inline void
+cubic_window_reduce (tcp_connection_t * tc, cubic_data_t * cd)
+{
+  f64 w_max;
+
+  w_max = (f64) tc->cwnd / tc->snd_mss;
+
+  /* Fast convergence, RFC 8312 Sec. 4.6 */
+  if (w_max < cd->w_max)
+    w_max = w_max * (1.0 + beta_cubic) / 2.0;
+
+  cd->w_max = w_max;
+  tc->ssthresh = clib_max (tc->cwnd * beta_cubic, 2 * tc->snd_mss);
+}
+
+static void
+cubic_congestion (tcp_connection_t * tc)
+{
+  cubic_data_t *cd = (cubic_data_t *) tcp_cc_data (tc);
+  cubic_window_reduce (tc, cd);
+}
+
+/**
+ * Retransmit timeout, RFC 8312 Sec. 4.7. Reduce the window as for any
+ * other congestion event, restart from the loss window and begin a new
+ * epoch once slow start hands over to congestion avoidance.
+ */
+static void
+cubic_loss (tcp_connection_t * tc)
+{
+  cubic_data_t *cd = (cubic_data_t *) tcp_cc_data (tc);
+  cubic_window_reduce (tc, cd);
+  tc->cwnd = tcp_loss_wnd (tc);
+  cd->K = K_cubic (cd);
+  cd->t_start = 0;
+  cd->acc_bytes = 0;
+}
+
+static void
+cubic_recovered (tcp_connection_t * tc)
+{
+  cubic_data_t *cd = (cubic_data_t *) tcp_cc_data (tc);
+  cd->t_start = cubic_time ();
+  cd->K = K_cubic (cd);
+  cd->acc_bytes = 0;
+  tc->cwnd = tc->ssthresh;
+}
+
+static void
+cubic_rcv_ack (tcp_connection_t * tc)
+{
+  cubic_data_t *cd = (cubic_data_t *) tcp_cc_data (tc);
+  f64 t, rtt, w_cubic, w_aimd;
+  u32 thresh;
+
+  if (tcp_in_slowstart (tc))
+    {
+      tc->cwnd += clib_min (tc->snd_mss, tc->bytes_acked);
+      return;
+    }
+
+  /* First ack in congestion avoidance after slow start, start the epoch.
+   * If slow start went past w_max, the window is already beyond the
+   * inflection point and growth continues from here in the convex region */
+  if (cd->t_start == 0)
+    {
+      f64 w = (f64) tc->cwnd / tc->snd_mss;
+      cd->t_start = cubic_time ();
+      cd->K = w < cd->w_max ? cbrt ((cd->w_max - w) / cubic_c) : 0;
+      if (w > cd->w_max)
+	cd->w_max = w;
+      cd->acc_bytes = 0;
+    }
+
+  t = cubic_time () - cd->t_start;
+  rtt = (f64) clib_max (tc->srtt, 1) * TCP_TICK;
+
+  w_cubic = W_cubic (cd, t + rtt) * tc->snd_mss;
+  w_aimd = W_est (cd, t, rtt) * tc->snd_mss;
+
+  if (w_cubic < w_aimd)
+    {
+      /* TCP friendly region, grow like NewReno: 1 mss per rtt */
+      thresh = tc->cwnd;
+    }
+  else if (w_cubic > tc->cwnd)
+    {
+      /* Concave or convex region. Instead of incrementing cwnd by
+       * (W_cubic(t+RTT) - cwnd)/cwnd for every ack, compute the number of
+       * bytes that need to be acked before adding 1 mss to cwnd. Never
+       * grow faster than 1 mss per segment acked, i.e., slow start. */
+      thresh = (u64) tc->snd_mss * tc->cwnd / (w_cubic - tc->cwnd);
+      thresh = clib_max (thresh, tc->snd_mss);
+    }
+  else
+    {
+      /* At or above the target. Grow very slowly */
+      thresh = 100 * tc->cwnd;
+    }
+
+  cubic_cwnd_accumulate (tc, cd, thresh);
+}
+
+static void
+cubic_rcv_cong_ack (tcp_connection_t * tc, tcp_cc_ack_t ack_type)
+{
+  if (ack_type == TCP_CC_DUPACK)
+    {
+      if (!tcp_opts_sack_permitted (&tc->rcv_opts))
+	tc->cwnd += tc->snd_mss;
+    }
+  else if (ack_type == TCP_CC_PARTIALACK)
+    {
+      /* Partial window deflation as per RFC 6582 Sec. 3.2 */
+      if (!tcp_opts_sack_permitted (&tc->rcv_opts))
+	{
+	  tc->cwnd = (tc->cwnd > tc->bytes_acked + tc->snd_mss) ?
+	    tc->cwnd - tc->bytes_acked : tc->snd_mss;
+	  if (tc->bytes_acked > tc->snd_mss)
+	    tc->cwnd += tc->snd_mss;
+	}
+    }
+}
+
+static void
+cubic_conn_init (tcp_connection_t * tc)
+{
+  cubic_data_t *cd = (cubic_data_t *) tcp_cc_data (tc);
+
+  tc->ssthresh = tc->snd_wnd;
+  tc->cwnd = tcp_initial_cwnd (tc);
+  cd->w_max = 0;
+  cd->K = 0;
+  cd->acc_bytes = 0;
+  cd->t_start = 0;
+}
+
+const static tcp_cc_algorithm_t tcp_cubic = {
+  .congestion = cubic_congestion,
+  .recovered = cubic_recovered,
+  .loss = cubic_loss,
+  .rcv_ack = cubic_rcv_ack,
+  .rcv_cong_ack = cubic_rcv_cong_ack,
+  .init = cubic_conn_init
+};
+
+clib_error_t *
+cubic_init (vlib_main_t * vm)
+{
+  clib_error_t *error = 0;
+
+  tcp_cc_algo_register (TCP_CC_CUBIC, &tcp_cubic);
+
+  return error;
+}
+
+VLIB_INIT_FUNCTION (cubic_init);
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -456,6 +456,7 @@ tcp_update_rtt (tcp_connection_t * tc, u32 ack)
     goto done;
 
   tcp_estimate_rtt (tc, mrtt);
+  tc->mrtt = mrtt;
 
 done:
 
@@ -946,6 +947,7 @@ void
 tcp_cc_fastrecovery_exit (tcp_connection_t * tc)
 {
   tc->cc_algo->recovered (tc);
+  tcp_connection_tx_pacer_update (tc);
   tc->snd_rxt_bytes = 0;
   tc->rcv_dupacks = 0;
   tc->snd_nxt = tc->snd_una_max;
@@ -1006,6 +1008,7 @@ tcp_cc_update (tcp_connection_t * tc, vlib_buffer_t * b)
   /* Congestion avoidance */
   tc->cc_algo->rcv_ack (tc);
   tc->tsecr_last_ack = tc->rcv_opts.tsecr;
+  tcp_connection_tx_pacer_update (tc);
 
   /* If a cumulative ack, make sure dupacks is 0 */
   tc->rcv_dupacks = 0;
@@ -1199,8 +1202,30 @@ partial_ack:
 void
 tcp_cc_init (tcp_connection_t * tc)
 {
-  tc->cc_algo = tcp_cc_algo_get (TCP_CC_NEWRENO);
+  tcp_main_t *tm = vnet_get_tcp_main ();
+  tc->cc_algo = tcp_cc_algo_get (tm->cc_algo);
+  tc->cc_algo->init (tc);
+}
+
+/**
+ * Switch the congestion control algorithm of a connection
+ *
+ * The new algorithm starts from the current congestion window and slow
+ * start threshold instead of the initial ones.
+ */
+void
+tcp_cc_algo_set (tcp_connection_t * tc, tcp_cc_algorithm_type_e type)
+{
+  u32 cwnd = tc->cwnd, ssthresh = tc->ssthresh;
+
+  tc->cc_algo = tcp_cc_algo_get (type);
+  memset (tc->cc_data, 0, sizeof (tc->cc_data));
   tc->cc_algo->init (tc);
+  if (tc->state >= TCP_STATE_ESTABLISHED)
+    {
+      tc->cwnd = cwnd;
+      tc->ssthresh = ssthresh;
+    }
 }
 
 /**
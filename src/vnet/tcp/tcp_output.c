@@ -1341,8 +1341,15 @@ tcp_rtx_timeout_cc (tcp_connection_t * tc)
     tcp_cc_fastrecovery_exit (tc);
 
   /* Start again from the beginning */
-  tc->ssthresh = clib_max (tcp_flight_size (tc) / 2, 2 * tc->snd_mss);
-  tc->cwnd = tcp_loss_wnd (tc);
+  if (tc->cc_algo->loss)
+    {
+      tc->cc_algo->loss (tc);
+    }
+  else
+    {
+      tc->ssthresh = clib_max (tcp_flight_size (tc) / 2, 2 * tc->snd_mss);
+      tc->cwnd = tcp_loss_wnd (tc);
+    }
   tc->snd_congestion = tc->snd_una_max;
   tc->rtt_ts = 0;
   tcp_recovery_on (tc);
@@ -1967,6 +1974,17 @@ tcp_push_header (transport_connection_t * tconn, vlib_buffer_t * b)
   tcp_connection_t *tc;
 
   tc = (tcp_connection_t *) tconn;
+
+  /* Super-segment, have it split into snd_mss sized segments late */
+  if (b->current_length + b->total_length_not_including_first_buffer
+      > tc->snd_mss)
+    {
+      b->flags |= VNET_BUFFER_F_GSO;
+      vnet_buffer2 (b)->gso.size = tc->snd_mss;
+      vnet_buffer2 (b)->gso.l4_hdr_sz = tc->snd_opts_len
+	+ sizeof (tcp_header_t);
+    }
+
   tcp_push_hdr_i (tc, b, TCP_STATE_ESTABLISHED, 0);
   ASSERT (seq_leq (tc->snd_una_max, tc->snd_una + tc->snd_wnd));
 
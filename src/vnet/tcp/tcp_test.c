@@ -13,6 +13,7 @@
  * limitations under the License.
  */
 #include <vnet/tcp/tcp.h>
+#include <math.h>
 
 #define TCP_TEST_I(_cond, _comment, _args...)			\
 ({								\
@@ -1426,6 +1427,225 @@ tcp_test_fifo5 (vlib_main_t * vm, unformat_input_t * input)
   return 0;
 }
 
+/*
+ * In place reads, with and without wrap
+ */
+static int
+tcp_test_fifo6 (vlib_main_t * vm, unformat_input_t * input)
+{
+  svm_fifo_t *f;
+  u32 fifo_size = 400, offset = 350, j = 0;
+  svm_fifo_iovec_t iov[2];
+  u8 *test_data = 0;
+  int i, rv, verbose = 0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "verbose"))
+	verbose = 1;
+      else
+	{
+	  clib_error_t *e = clib_error_return
+	    (0, "unknown input `%U'", format_unformat_error, input);
+	  clib_error_report (e);
+	  return -1;
+	}
+    }
+
+  f = fifo_prepare (fifo_size);
+  svm_fifo_init_pointers (f, offset);
+
+  vec_validate (test_data, 199);
+  for (i = 0; i < vec_len (test_data); i++)
+    test_data[i] = i % 0xff;
+
+  /* Nothing to read */
+  rv = svm_fifo_peek_in_place (f, 0, 100, iov);
+  TCP_TEST ((rv == -2), "peek empty returned %d", rv);
+
+  /*
+   * Enqueue 200 bytes, 50 fit before the end of the fifo
+   */
+  svm_fifo_enqueue_nowait (f, 200, test_data);
+  if (verbose)
+    vlib_cli_output (vm, "fifo after enqueue: %U", format_svm_fifo, f, 1);
+
+  rv = svm_fifo_peek_in_place (f, 0, 1000, iov);
+  TCP_TEST ((rv == 200), "referenced %d expected %u", rv, 200);
+  TCP_TEST ((iov[0].data == &f->data[offset]), "first piece in place");
+  TCP_TEST ((iov[0].len == 50), "first piece len %u expected %u",
+	    iov[0].len, 50);
+  TCP_TEST ((iov[1].data == &f->data[0]), "second piece in place");
+  TCP_TEST ((iov[1].len == 150), "second piece len %u expected %u",
+	    iov[1].len, 150);
+  if (compare_data (iov[0].data, test_data, 0, iov[0].len, &j))
+    TCP_TEST (0, "[%d] first piece %u expected %u", j, iov[0].data[j],
+	      test_data[j]);
+  if (compare_data (iov[1].data, test_data + 50, 0, iov[1].len, &j))
+    TCP_TEST (0, "[%d] second piece %u expected %u", j, iov[1].data[j],
+	      test_data[50 + j]);
+
+  /* Data stays in the fifo until dropped */
+  TCP_TEST ((svm_fifo_max_dequeue (f) == 200), "max dequeue %u",
+	    svm_fifo_max_dequeue (f));
+
+  /*
+   * Read 20 bytes at offset 60, past the wrap
+   */
+  rv = svm_fifo_peek_in_place (f, 60, 20, iov);
+  TCP_TEST ((rv == 20), "referenced %d expected %u", rv, 20);
+  TCP_TEST ((iov[0].data == &f->data[10]), "offset piece in place");
+  TCP_TEST ((iov[0].len == 20 && iov[1].len == 0), "lens %u %u",
+	    iov[0].len, iov[1].len);
+  if (compare_data (iov[0].data, test_data + 60, 0, iov[0].len, &j))
+    TCP_TEST (0, "[%d] offset piece %u expected %u", j, iov[0].data[j],
+	      test_data[60 + j]);
+
+  /*
+   * Release what was read
+   */
+  rv = svm_fifo_dequeue_drop (f, 200);
+  TCP_TEST ((rv == 200), "dropped %d expected %u", rv, 200);
+  TCP_TEST ((svm_fifo_max_dequeue (f) == 0), "max dequeue %u",
+	    svm_fifo_max_dequeue (f));
+  rv = svm_fifo_peek_in_place (f, 0, 100, iov);
+  TCP_TEST ((rv == -2), "peek empty returned %d", rv);
+
+  svm_fifo_free (f);
+  vec_free (test_data);
+  return 0;
+}
+
+/*
+ * Elastic fifo, chunks allocated as data arrives and freed once read
+ */
+static int
+tcp_test_fifo7 (vlib_main_t * vm, unformat_input_t * input)
+{
+  svm_fifo_chunk_pool_t _cp, *cp = &_cp;
+  u32 fifo_size = 4 * SVM_FIFO_CHUNK_SIZE, offset, j = 0;
+  volatile u32 lock = 0;
+  svm_fifo_iovec_t iov[2];
+  u8 *test_data = 0, *data_buf = 0, *c;
+  int i, rv, verbose = 0;
+  svm_fifo_t *f;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "verbose"))
+	verbose = 1;
+      else
+	{
+	  clib_error_t *e = clib_error_return
+	    (0, "unknown input `%U'", format_unformat_error, input);
+	  clib_error_report (e);
+	  return -1;
+	}
+    }
+
+  svm_fifo_chunk_pool_init (cp, clib_mem_get_heap (), &lock,
+			    SVM_FIFO_CHUNK_SIZE);
+  f = svm_fifo_create_elastic (fifo_size, cp);
+  TCP_TEST ((f != 0), "elastic fifo created");
+  TCP_TEST ((svm_fifo_create_elastic (fifo_size + 1, cp) == 0),
+	    "size must be a multiple of the chunk size");
+  TCP_TEST ((svm_fifo_n_chunks (f) == 0), "no chunks before data");
+
+  /* Start 1000 bytes before the end of the ring, to test the wrap */
+  offset = fifo_size - 1000;
+  svm_fifo_init_pointers (f, offset);
+
+  vec_validate (test_data, 8000);
+  for (i = 0; i < vec_len (test_data); i++)
+    test_data[i] = i % 0xff;
+  vec_validate (data_buf, fifo_size);
+
+  /*
+   * 100 bytes in order, 2000 out of order 5000 bytes after
+   */
+  rv = svm_fifo_enqueue_nowait (f, 100, test_data);
+  TCP_TEST ((rv == 100), "enqueued %d expected %u", rv, 100);
+  TCP_TEST ((svm_fifo_n_chunks (f) == 1), "chunks %u expected %u",
+	    svm_fifo_n_chunks (f), 1);
+
+  rv = svm_fifo_enqueue_with_offset (f, 5000, 2000, test_data + 5100);
+  TCP_TEST ((rv == 0), "ooo enqueue returned %d", rv);
+  TCP_TEST ((svm_fifo_n_chunks (f) == 2), "chunks %u expected %u",
+	    svm_fifo_n_chunks (f), 2);
+  TCP_TEST ((svm_fifo_number_ooo_segments (f) == 1), "ooo segments %u",
+	    svm_fifo_number_ooo_segments (f));
+
+  /*
+   * Fill the hole, that wraps, and collect the ooo segment
+   */
+  rv = svm_fifo_enqueue_nowait (f, 5000, test_data + 100);
+  TCP_TEST ((rv == 7000), "enqueued %d expected %u", rv, 7000);
+  TCP_TEST ((svm_fifo_max_dequeue (f) == 7100), "max dequeue %u",
+	    svm_fifo_max_dequeue (f));
+  TCP_TEST ((svm_fifo_n_chunks (f) == 3), "chunks %u expected %u",
+	    svm_fifo_n_chunks (f), 3);
+  if (verbose)
+    vlib_cli_output (vm, "fifo after collect: %U", format_svm_fifo, f, 1);
+
+  /* In place reads don't cross chunks boundaries unless they must */
+  rv = svm_fifo_peek_in_place (f, 0, 7100, iov);
+  TCP_TEST ((rv == 1000 + SVM_FIFO_CHUNK_SIZE), "referenced %d expected %u",
+	    rv, 1000 + SVM_FIFO_CHUNK_SIZE);
+  TCP_TEST ((iov[0].len == 1000), "first piece len %u", iov[0].len);
+  if (compare_data (iov[0].data, test_data, 0, iov[0].len, &j))
+    TCP_TEST (0, "[%d] first piece %u expected %u", j, iov[0].data[j],
+	      test_data[j]);
+  if (compare_data (iov[1].data, test_data + 1000, 0, iov[1].len, &j))
+    TCP_TEST (0, "[%d] second piece %u expected %u", j, iov[1].data[j],
+	      test_data[1000 + j]);
+
+  /*
+   * Drain. Chunks head moved past are returned to the pool
+   */
+  rv = svm_fifo_dequeue_nowait (f, 7100, data_buf);
+  TCP_TEST ((rv == 7100), "dequeued %d expected %u", rv, 7100);
+  if (compare_data (data_buf, test_data, 0, 7100, &j))
+    TCP_TEST (0, "[%d] dequeued %u expected %u", j, data_buf[j],
+	      test_data[j]);
+  TCP_TEST ((svm_fifo_n_chunks (f) == 1), "chunks %u expected %u",
+	    svm_fifo_n_chunks (f), 1);
+  TCP_TEST ((cp->n_chunks == 3 && cp->n_free_chunks == 2),
+	    "pool chunks %u free %u", cp->n_chunks, cp->n_free_chunks);
+
+  /*
+   * Fill it up. The producer does not wrap into the chunk head is in
+   */
+  rv = svm_fifo_enqueue_nowait (f, fifo_size, test_data);
+  TCP_TEST ((rv == fifo_size - (7100 - 1000 - SVM_FIFO_CHUNK_SIZE)),
+	    "enqueued %d", rv);
+  TCP_TEST ((svm_fifo_max_enqueue (f) == 0), "max enqueue %u",
+	    svm_fifo_max_enqueue (f));
+  TCP_TEST ((svm_fifo_n_chunks (f) == 4), "chunks %u expected %u",
+	    svm_fifo_n_chunks (f), 4);
+  TCP_TEST ((cp->n_chunks == 4 && cp->n_free_chunks == 0),
+	    "pool chunks %u free %u", cp->n_chunks, cp->n_free_chunks);
+
+  rv = svm_fifo_dequeue_drop (f, 100);
+  TCP_TEST ((rv == 100), "dropped %d expected %u", rv, 100);
+  rv = svm_fifo_peek (f, 0, 1000, data_buf);
+  if (compare_data (data_buf, test_data + 100, 0, rv, &j))
+    TCP_TEST (0, "[%d] peeked %u expected %u", j, data_buf[j],
+	      test_data[100 + j]);
+
+  svm_fifo_free (f);
+  TCP_TEST ((cp->n_free_chunks == cp->n_chunks), "pool chunks %u free %u",
+	    cp->n_chunks, cp->n_free_chunks);
+
+  while ((c = cp->free_chunks))
+    {
+      cp->free_chunks = *(u8 **) c;
+      clib_mem_free (c);
+    }
+  vec_free (test_data);
+  vec_free (data_buf);
+  return 0;
+}
+
 /* *INDENT-OFF* */
 svm_fifo_trace_elem_t fifo_trace[] = {};
 /* *INDENT-ON* */
@@ -1518,6 +1738,14 @@ tcp_test_fifo (vlib_main_t * vm, unformat_input_t * input)
       res = tcp_test_fifo5 (vm, input);
       if (res)
 	return res;
+
+      res = tcp_test_fifo6 (vm, input);
+      if (res)
+	return res;
+
+      res = tcp_test_fifo7 (vm, input);
+      if (res)
+	return res;
     }
   else
     {
@@ -1541,6 +1769,14 @@ tcp_test_fifo (vlib_main_t * vm, unformat_input_t * input)
 	{
 	  res = tcp_test_fifo5 (vm, input);
 	}
+      else if (unformat (input, "fifo6"))
+	{
+	  res = tcp_test_fifo6 (vm, input);
+	}
+      else if (unformat (input, "fifo7"))
+	{
+	  res = tcp_test_fifo7 (vm, input);
+	}
       else if (unformat (input, "replay"))
 	{
 	  res = tcp_test_fifo_replay (vm, input);
@@ -1706,6 +1942,330 @@ tcp_test_session (vlib_main_t * vm, unformat_input_t * input)
   return rv;
 }
 
+typedef struct
+{
+  f64 bw;			/**< bottleneck bandwidth, Mbps */
+  f64 rtt;			/**< propagation delay, ms */
+  f64 loss;			/**< random loss probability */
+  u32 buffer;			/**< bottleneck buffer, packets */
+  u32 duration;			/**< simulated time, s */
+  u32 seed;
+  u8 verbose;
+} tcp_test_cc_cfg_t;
+
+/**
+ * Run a bulk transfer over a simulated bottleneck and return the goodput
+ * in Mbps.
+ *
+ * The path is modeled one round trip at a time: the packets in flight
+ * fill the pipe first and then the bottleneck queue, whose occupancy adds
+ * to the rtt. Packets that do not fit the queue are tail dropped and the
+ * rest are randomly dropped with the configured probability. Acks are
+ * evenly spread over the round and fed to the congestion control
+ * algorithm, which sees simulated time through tcp_time_now (). A round
+ * with losses triggers a one rtt fast recovery.
+ */
+static f64
+tcp_test_cc_run (vlib_main_t * vm, tcp_test_cc_cfg_t * cfg,
+		 tcp_cc_algorithm_type_e type)
+{
+  tcp_main_t *tm = vnet_get_tcp_main ();
+  u32 thread_index = vlib_get_thread_index ();
+  u32 seed = cfg->seed, saved_time, in_flight, lost, i, n_rounds = 0;
+  f64 mss_bytes, pkts_per_ms, bdp, queue, rtt, now = 0, end;
+  u64 delivered = 0;
+  tcp_connection_t _tc, *tc = &_tc;
+  u8 in_recovery = 0;
+
+  saved_time = tm->time_now[thread_index];
+  tm->time_now[thread_index] = 0;
+
+  memset (tc, 0, sizeof (*tc));
+  tc->state = TCP_STATE_ESTABLISHED;
+  tc->snd_mss = 1448;
+  tc->snd_wnd = 1 << 30;
+  tc->rcv_opts.flags |= TCP_OPTS_FLAG_SACK_PERMITTED;
+  tc->cc_algo = tcp_cc_algo_get (type);
+  tc->cc_algo->init (tc);
+
+  mss_bytes = tc->snd_mss;
+  pkts_per_ms = cfg->bw * 1e3 / 8 / mss_bytes;
+  bdp = pkts_per_ms * cfg->rtt;
+  end = cfg->duration * 1e3;
+
+  while (now < end)
+    {
+      in_flight = clib_max (clib_min (tc->cwnd, tc->snd_wnd) / tc->snd_mss,
+			    1);
+      queue = clib_max ((f64) in_flight - bdp, 0);
+      lost = 0;
+      if (queue > cfg->buffer)
+	{
+	  lost = queue - cfg->buffer;
+	  queue = cfg->buffer;
+	}
+      rtt = cfg->rtt + queue / pkts_per_ms;
+
+      tc->snd_una = 0;
+      tc->snd_una_max = in_flight * tc->snd_mss;
+
+      for (i = 0; i < in_flight - lost; i++)
+	{
+	  if (cfg->loss && random_f64 (&seed) < cfg->loss)
+	    {
+	      lost++;
+	      continue;
+	    }
+	  delivered += tc->snd_mss;
+	  if (in_recovery)
+	    continue;
+
+	  tm->time_now[thread_index] = now + rtt * (i + 1) / in_flight;
+	  tc->bytes_acked = tc->snd_mss;
+	  tc->snd_una += tc->snd_mss;
+	  tc->mrtt = clib_max ((u32) rtt, 1);
+	  tc->srtt = tc->srtt ? (7 * tc->srtt + tc->mrtt) / 8 : tc->mrtt;
+	  tc->cc_algo->rcv_ack (tc);
+	}
+
+      now += rtt;
+      tm->time_now[thread_index] = now;
+      n_rounds++;
+
+      /* Retransmissions went out in this round, recovery is done */
+      if (in_recovery)
+	{
+	  tc->cc_algo->recovered (tc);
+	  in_recovery = 0;
+	}
+
+      if (lost)
+	{
+	  tc->snd_una = 0;
+	  tc->snd_una_max = in_flight * tc->snd_mss;
+	  tc->cc_algo->congestion (tc);
+	  tc->cwnd = tc->ssthresh;
+	  in_recovery = 1;
+	}
+
+      if (cfg->verbose > 1)
+	vlib_cli_output (vm, "%U: t %.3fs cwnd %u ssthresh %u rtt %.1f lost %u",
+			 format_tcp_cc_algo, type, now / 1e3, tc->cwnd,
+			 tc->ssthresh, rtt, lost);
+    }
+
+  tm->time_now[thread_index] = saved_time;
+
+  if (cfg->verbose)
+    vlib_cli_output (vm, "%U: %u rounds, final cwnd %u ssthresh %u",
+		     format_tcp_cc_algo, type, n_rounds, tc->cwnd,
+		     tc->ssthresh);
+
+  return (f64) delivered * 8 / (now * 1e3);
+}
+
+/**
+ * Retransmit timeout with cubic. The window must collapse to the loss
+ * window and, once slow start is over, the new epoch must bring cwnd back
+ * to the window at the time of the timeout after K seconds.
+ */
+static int
+tcp_test_cc_cubic_rto (vlib_main_t * vm)
+{
+  tcp_main_t *tm = vnet_get_tcp_main ();
+  u32 thread_index = vlib_get_thread_index ();
+  u32 saved_time, now, epoch = 0, in_flight, i;
+  tcp_connection_t _tc, *tc = &_tc;
+  f64 K;
+
+  saved_time = tm->time_now[thread_index];
+  tm->time_now[thread_index] = now = 1000;
+
+  memset (tc, 0, sizeof (*tc));
+  tc->state = TCP_STATE_ESTABLISHED;
+  tc->snd_mss = 1448;
+  tc->snd_wnd = 1 << 30;
+  tc->srtt = 100;
+  tc->cc_algo = tcp_cc_algo_get (TCP_CC_CUBIC);
+  tc->cc_algo->init (tc);
+  tc->cwnd = 100 * tc->snd_mss;
+  tc->ssthresh = 50 * tc->snd_mss;
+
+  TCP_TEST ((tc->cc_algo->loss != 0), "cubic has a loss handler");
+  tc->cc_algo->loss (tc);
+  TCP_TEST ((tc->cwnd == tcp_loss_wnd (tc)), "cwnd %u is loss window",
+	    tc->cwnd);
+  TCP_TEST ((tc->ssthresh == 70 * tc->snd_mss), "ssthresh %u is 70 mss",
+	    tc->ssthresh);
+
+  /* W_max is 100 segments, cwnd is 70 segments when slow start ends */
+  K = cbrt ((100 - 70) / 0.4);
+
+  while (!epoch || now < epoch + K * 1000)
+    {
+      in_flight = clib_max (tc->cwnd / tc->snd_mss, 1);
+      for (i = 0; i < in_flight; i++)
+	{
+	  if (!epoch && !tcp_in_slowstart (tc))
+	    epoch = tm->time_now[thread_index];
+	  tm->time_now[thread_index] = now + 100 * (i + 1) / in_flight;
+	  tc->bytes_acked = tc->snd_mss;
+	  tc->cc_algo->rcv_ack (tc);
+	}
+      now += 100;
+      if (now >= 60000)
+	break;
+    }
+
+  TCP_TEST ((epoch != 0), "epoch started at %u after slow start", epoch);
+
+  TCP_TEST ((tc->cwnd >= 95 * tc->snd_mss && tc->cwnd <= 105 * tc->snd_mss),
+	    "cwnd %u segments back at w_max after K", tc->cwnd / tc->snd_mss);
+
+  tm->time_now[thread_index] = saved_time;
+  return 0;
+}
+
+static int
+tcp_test_cc (vlib_main_t * vm, unformat_input_t * input)
+{
+  tcp_test_cc_cfg_t _cfg = {
+    .bw = 1000,
+    .rtt = 100,
+    .loss = 1e-5,
+    .duration = 60,
+    .seed = 0xdeadbeef,
+  }, *cfg = &_cfg;
+  f64 tput[TCP_CC_N_ALGORITHMS];
+  u32 type = ~0, buffer = ~0;
+  int i;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "algo %U", unformat_tcp_cc_algo, &type))
+	;
+      else if (unformat (input, "bw %f", &cfg->bw))
+	;
+      else if (unformat (input, "rtt %f", &cfg->rtt))
+	;
+      else if (unformat (input, "loss %f", &cfg->loss))
+	;
+      else if (unformat (input, "buffer %u", &buffer))
+	;
+      else if (unformat (input, "time %u", &cfg->duration))
+	;
+      else if (unformat (input, "seed %u", &cfg->seed))
+	;
+      else if (unformat (input, "verbose %u", &i))
+	cfg->verbose = i;
+      else if (unformat (input, "verbose"))
+	cfg->verbose = 1;
+      else
+	{
+	  vlib_cli_output (vm, "parse error: '%U'", format_unformat_error,
+			   input);
+	  return -1;
+	}
+    }
+
+  /* Default to a quarter of the bdp worth of buffering */
+  cfg->buffer = buffer != ~0 ? buffer :
+    cfg->bw * 1e3 / 8 / 1448 * cfg->rtt / 4;
+
+  vlib_cli_output (vm, "bw %.0fMbps rtt %.0fms loss %.2e buffer %u pkts "
+		   "time %us", cfg->bw, cfg->rtt, cfg->loss, cfg->buffer,
+		   cfg->duration);
+
+  for (i = 0; i < TCP_CC_N_ALGORITHMS; i++)
+    {
+      if (type != ~0 && i != type)
+	continue;
+      tput[i] = tcp_test_cc_run (vm, cfg, i);
+      vlib_cli_output (vm, "%U: %.2f Mbps", format_tcp_cc_algo, i, tput[i]);
+      TCP_TEST ((tput[i] > 0 && tput[i] <= cfg->bw * 1.001),
+		"%U throughput %.2f is within link bw", format_tcp_cc_algo,
+		i, tput[i]);
+    }
+
+  if (type == ~0 || type == TCP_CC_CUBIC)
+    if (tcp_test_cc_cubic_rto (vm))
+      return -1;
+
+  if (type != ~0)
+    return 0;
+
+  /* On a long fat path with random losses, cubic and bbr should both be
+   * able to make better use of the link than newreno */
+  if (cfg->loss && cfg->bw * cfg->rtt >= 1e4)
+    {
+      TCP_TEST ((tput[TCP_CC_CUBIC] > tput[TCP_CC_NEWRENO]),
+		"cubic %.2f should beat newreno %.2f", tput[TCP_CC_CUBIC],
+		tput[TCP_CC_NEWRENO]);
+      TCP_TEST ((tput[TCP_CC_BBR] > tput[TCP_CC_NEWRENO]),
+		"bbr %.2f should beat newreno %.2f", tput[TCP_CC_BBR],
+		tput[TCP_CC_NEWRENO]);
+    }
+
+  return 0;
+}
+
+/**
+ * Pacer rate and knob. With pacing enabled, a connection in congestion
+ * avoidance must not send more than 1.25 cwnd per srtt, in bursts no
+ * larger than the bucket. With pacing disabled the connection is not paced.
+ */
+static int
+tcp_test_pacer (vlib_main_t * vm, unformat_input_t * input)
+{
+  tcp_main_t *tm = vnet_get_tcp_main ();
+  tcp_connection_t _tc, *tc = &_tc;
+  f64 now = 0, rate, expected;
+  u32 burst, sent = 0, max_burst = 0;
+  u8 saved_pacing = tm->tx_pacing;
+
+  memset (tc, 0, sizeof (*tc));
+  tc->snd_mss = 1448;
+  tc->srtt = 10;
+  tc->cwnd = 100 * tc->snd_mss;
+  tc->ssthresh = tc->cwnd;
+
+  tm->tx_pacing = 0;
+  tcp_connection_tx_pacer_update (tc);
+  TCP_TEST (!transport_connection_is_tx_paced (&tc->connection),
+	    "not paced with pacing disabled");
+
+  tm->tx_pacing = 1;
+  tcp_connection_tx_pacer_update (tc);
+  tm->tx_pacing = saved_pacing;
+  TCP_TEST (transport_connection_is_tx_paced (&tc->connection),
+	    "paced with pacing enabled");
+
+  expected = 1.25 * tc->cwnd / (tc->srtt * TCP_TICK);
+  TCP_TEST ((tc->c_pacer.bytes_per_sec == expected),
+	    "pacing rate %.0f is %.0f", tc->c_pacer.bytes_per_sec, expected);
+
+  /* Send full segments for 1s, whenever the pacer allows */
+  while (now < 1.0)
+    {
+      burst = transport_connection_tx_pacer_burst (&tc->connection, now);
+      burst -= burst % tc->snd_mss;
+      max_burst = clib_max (max_burst, burst);
+      transport_connection_tx_pacer_update_bytes (&tc->connection, burst);
+      sent += burst;
+      now += clib_max (transport_connection_tx_pacer_wait (&tc->connection,
+							    tc->snd_mss),
+		       TRANSPORT_PACER_TICK);
+    }
+
+  rate = sent / now;
+  TCP_TEST ((rate <= expected && rate >= 0.9 * expected),
+	    "paced send rate %.0f close to %.0f", rate, expected);
+  TCP_TEST ((max_burst <= tc->c_pacer.max_burst),
+	    "max burst %u within bucket %u", max_burst, tc->c_pacer.max_burst);
+
+  return 0;
+}
+
 static clib_error_t *
 tcp_test (vlib_main_t * vm,
 	  unformat_input_t * input, vlib_cli_command_t * cmd_arg)
@@ -1730,6 +2290,14 @@ tcp_test (vlib_main_t * vm,
 	{
 	  res = tcp_test_lookup (vm, input);
 	}
+      else if (unformat (input, "cc"))
+	{
+	  res = tcp_test_cc (vm, input);
+	}
+      else if (unformat (input, "pacer"))
+	{
+	  res = tcp_test_pacer (vm, input);
+	}
       else
 	break;
     }
@@ -1970,6 +1970,8 @@ static void *vl_api_af_packet_create_t_print
     s = format (s, "hw_addr random ");
   else
     s = format (s, "hw_addr %U ", format_ethernet_address, mp->hw_addr);
+  if (mp->num_rx_queues)
+    s = format (s, "num_rx_queues %u ", mp->num_rx_queues);
 
   FINISH;
 }
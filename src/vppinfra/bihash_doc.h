@@ -72,7 +72,7 @@ typedef struct
   volatile u32 *writer_lock;  /**< Writer lock, in its own cache line */
     BVT (clib_bihash_value) ** working_copies;
 					    /**< Working copies (various sizes), to avoid locking against readers */
-  clib_bihash_bucket_t saved_bucket; /**< Saved bucket pointer */
+  u8 per_bucket_lock;		     /**< Writers lock buckets, not the table */
   u32 nbuckets;			     /**< Number of hash buckets */
   u32 log2_nbuckets;		     /**< lg(nbuckets) */
   u8 *name;			     /**< hash table name */
@@ -99,6 +99,17 @@ a power of two
 void clib_bihash_init
   (clib_bihash * h, char *name, u32 nbuckets, uword memory_size);
 
+/** Let writers on different threads update a bi-hash table in parallel
+
+    Writers then lock the bucket they update, rather than the whole
+    table; the writer lock only serializes page allocation.
+    Call once, after clib_bihash_init and before the first add.
+
+    @param h - the bi-hash table
+*/
+
+void clib_bihash_enable_per_bucket_lock (clib_bihash * h);
+
 /** Destroy a bounded index extensible hash table
     @param h - the bi-hash table to free
 */
@@ -116,6 +127,19 @@ void clib_bihash_free (clib_bihash * h);
 */
 int clib_bihash_add_del (clib_bihash * h, clib_bihash_kv * add_v, int is_add);
 
+/** Add or delete a batch of (key,value) pairs from a bi-hash table
+
+    @param h - the bi-hash table
+    @param kvs - the (key,value) pairs to add or delete
+    @param n_kvs - number of pairs
+    @param is_add - add=1, delete=0
+    @returns number of pairs that could not be added or deleted
+    @note Unless per-bucket locking is enabled, the writer lock is
+    taken once for the whole batch, instead of once per pair
+*/
+u32 clib_bihash_add_del_batch (clib_bihash * h, clib_bihash_kv * kvs,
+			       u32 n_kvs, int is_add);
+
 
 /** Search a bi-hash table
 
@@ -43,12 +43,51 @@ void BV (clib_bihash_init)
   clib_mem_set_heap (oldheap);
 }
 
+void BV (clib_bihash_enable_per_bucket_lock) (BVT (clib_bihash) * h)
+{
+  void *oldheap;
+
+  /*
+   * Writers from different threads now share the table without the
+   * writer lock, so the per-thread working copy vectors are sized
+   * for all threads up front, as they cannot be resized under them.
+   */
+  oldheap = clib_mem_set_heap (h->mheap);
+  vec_validate (h->working_copies, CLIB_MAX_MHEAPS - 1);
+  vec_validate_init_empty (h->working_copy_lengths, CLIB_MAX_MHEAPS - 1, ~0);
+  clib_mem_set_heap (oldheap);
+
+  h->per_bucket_lock = 1;
+}
+
 void BV (clib_bihash_free) (BVT (clib_bihash) * h)
 {
   mheap_free (h->mheap);
   memset (h, 0, sizeof (*h));
 }
 
+/*
+ * With per-bucket locking the writer lock only serializes use of the
+ * table's heap and freelists; otherwise it is held for the whole update.
+ */
+static inline void
+BV (alloc_lock) (BVT (clib_bihash) * h)
+{
+  if (h->per_bucket_lock)
+    while (__sync_lock_test_and_set (h->writer_lock, 1))
+      ;
+}
+
+static inline void
+BV (alloc_unlock) (BVT (clib_bihash) * h)
+{
+  if (h->per_bucket_lock)
+    {
+      CLIB_MEMORY_BARRIER ();
+      h->writer_lock[0] = 0;
+    }
+}
+
 static
 BVT (clib_bihash_value) *
 BV (value_alloc) (BVT (clib_bihash) * h, u32 log2_pages)
@@ -56,6 +95,8 @@ BV (value_alloc) (BVT (clib_bihash) * h, u32 log2_pages)
   BVT (clib_bihash_value) * rv = 0;
   void *oldheap;
 
+  BV (alloc_lock) (h);
+
   ASSERT (h->writer_lock[0]);
   if (log2_pages >= vec_len (h->freelists) || h->freelists[log2_pages] == 0)
     {
@@ -71,6 +112,8 @@ BV (value_alloc) (BVT (clib_bihash) * h, u32 log2_pages)
   h->freelists[log2_pages] = rv->next_free;
 
 initialize:
+  BV (alloc_unlock) (h);
+
   ASSERT (rv);
   /*
    * Latest gcc complains that the length arg is zero
@@ -85,16 +128,25 @@ static void
 BV (value_free) (BVT (clib_bihash) * h, BVT (clib_bihash_value) * v,
 		 u32 log2_pages)
 {
+  BV (alloc_lock) (h);
+
   ASSERT (h->writer_lock[0]);
 
   ASSERT (vec_len (h->freelists) > log2_pages);
 
   v->next_free = h->freelists[log2_pages];
   h->freelists[log2_pages] = v;
+
+  BV (alloc_unlock) (h);
 }
 
+/*
+ * Called with the bucket locked; saved_bucket is set to the bucket as it
+ * was, lock bit included.
+ */
 static inline void
-BV (make_working_copy) (BVT (clib_bihash) * h, BVT (clib_bihash_bucket) * b)
+BV (make_working_copy) (BVT (clib_bihash) * h, BVT (clib_bihash_bucket) * b,
+			BVT (clib_bihash_bucket) * saved_bucket)
 {
   BVT (clib_bihash_value) * v;
   BVT (clib_bihash_bucket) working_bucket __attribute__ ((aligned (8)));
@@ -105,6 +157,7 @@ BV (make_working_copy) (BVT (clib_bihash) * h, BVT (clib_bihash_bucket) * b)
 
   if (thread_index >= vec_len (h->working_copies))
     {
+      ASSERT (h->per_bucket_lock == 0);
       oldheap = clib_mem_set_heap (h->mheap);
       vec_validate (h->working_copies, thread_index);
       vec_validate_init_empty (h->working_copy_lengths, thread_index, ~0);
@@ -119,11 +172,13 @@ BV (make_working_copy) (BVT (clib_bihash) * h, BVT (clib_bihash_bucket) * b)
   working_copy = h->working_copies[thread_index];
   log2_working_copy_length = h->working_copy_lengths[thread_index];
 
-  h->saved_bucket.as_u64 = b->as_u64;
-  oldheap = clib_mem_set_heap (h->mheap);
+  saved_bucket->as_u64 = b->as_u64;
 
   if (b->log2_pages > log2_working_copy_length)
     {
+      BV (alloc_lock) (h);
+      oldheap = clib_mem_set_heap (h->mheap);
+
       if (working_copy)
 	clib_mem_free (working_copy);
 
@@ -132,13 +187,10 @@ BV (make_working_copy) (BVT (clib_bihash) * h, BVT (clib_bihash_bucket) * b)
 	 CLIB_CACHE_LINE_BYTES);
       h->working_copy_lengths[thread_index] = b->log2_pages;
       h->working_copies[thread_index] = working_copy;
-    }
 
-  clib_mem_set_heap (oldheap);
-
-  /* Lock the bucket... */
-  while (BV (clib_bihash_lock_bucket) (b) == 0)
-    ;
+      clib_mem_set_heap (oldheap);
+      BV (alloc_unlock) (h);
+    }
 
   v = BV (clib_bihash_get_value) (h, b->offset);
 
@@ -242,11 +294,12 @@ BV (split_and_rehash_linear)
   return new_values;
 }
 
-int BV (clib_bihash_add_del)
-  (BVT (clib_bihash) * h, BVT (clib_bihash_kv) * add_v, int is_add)
+static inline int BV (clib_bihash_add_del_inline)
+  (BVT (clib_bihash) * h, BVT (clib_bihash_kv) * add_v, int is_add,
+   int have_writer_lock)
 {
   u32 bucket_index;
-  BVT (clib_bihash_bucket) * b, tmp_b;
+  BVT (clib_bihash_bucket) * b, tmp_b, saved_bucket;
   BVT (clib_bihash_value) * v, *new_v, *save_new_v, *working_copy;
   int rv = 0;
   int i, limit;
@@ -265,7 +318,16 @@ int BV (clib_bihash_add_del)
 
   tmp_b.linear_search = 0;
 
-  while (__sync_lock_test_and_set (h->writer_lock, 1))
+  if (h->per_bucket_lock == 0 && !have_writer_lock)
+    while (__sync_lock_test_and_set (h->writer_lock, 1))
+      ;
+
+  /*
+   * Lock the bucket. This disables its cache and, with per-bucket
+   * locking, serializes its writers. The bucket stays locked, i.e. every
+   * update of it below carries the lock bit, until the unlock.
+   */
+  while (BV (clib_bihash_lock_bucket) (b) == 0)
     ;
 
   /* First elt in the bucket? */
@@ -282,15 +344,16 @@ int BV (clib_bihash_add_del)
       *v->kvp = *add_v;
       tmp_b.as_u64 = 0;
       tmp_b.offset = BV (clib_bihash_get_offset) (h, v);
+      tmp_b.cache_lru = 1 << 15;
 
       b->as_u64 = tmp_b.as_u64;
       goto unlock;
     }
 
   /* Note: this leaves the cache disabled */
-  BV (make_working_copy) (h, b);
+  BV (make_working_copy) (h, b, &saved_bucket);
 
-  v = BV (clib_bihash_get_value) (h, h->saved_bucket.offset);
+  v = BV (clib_bihash_get_value) (h, saved_bucket.offset);
 
   limit = BIHASH_KVP_PER_PAGE;
   v += (b->linear_search == 0) ? hash & ((1 << b->log2_pages) - 1) : 0;
@@ -310,7 +373,7 @@ int BV (clib_bihash_add_del)
 	      clib_memcpy (&(v->kvp[i]), add_v, sizeof (*add_v));
 	      CLIB_MEMORY_BARRIER ();
 	      /* Restore the previous (k,v) pairs */
-	      b->as_u64 = h->saved_bucket.as_u64;
+	      b->as_u64 = saved_bucket.as_u64;
 	      goto unlock;
 	    }
 	}
@@ -320,7 +383,7 @@ int BV (clib_bihash_add_del)
 	    {
 	      clib_memcpy (&(v->kvp[i]), add_v, sizeof (*add_v));
 	      CLIB_MEMORY_BARRIER ();
-	      b->as_u64 = h->saved_bucket.as_u64;
+	      b->as_u64 = saved_bucket.as_u64;
 	      goto unlock;
 	    }
 	}
@@ -334,16 +397,16 @@ int BV (clib_bihash_add_del)
 	    {
 	      memset (&(v->kvp[i]), 0xff, sizeof (*(add_v)));
 	      CLIB_MEMORY_BARRIER ();
-	      b->as_u64 = h->saved_bucket.as_u64;
+	      b->as_u64 = saved_bucket.as_u64;
 	      goto unlock;
 	    }
 	}
       rv = -3;
-      b->as_u64 = h->saved_bucket.as_u64;
+      b->as_u64 = saved_bucket.as_u64;
       goto unlock;
     }
 
-  old_log2_pages = h->saved_bucket.log2_pages;
+  old_log2_pages = saved_bucket.log2_pages;
   new_log2_pages = old_log2_pages + 1;
   mark_bucket_linear = 0;
 
@@ -405,36 +468,74 @@ int BV (clib_bihash_add_del)
 expand_ok:
   /* Keep track of the number of linear-scan buckets */
   if (tmp_b.linear_search ^ mark_bucket_linear)
-    h->linear_buckets += (mark_bucket_linear == 1) ? 1 : -1;
+    __sync_fetch_and_add (&h->linear_buckets,
+			  (mark_bucket_linear == 1) ? 1 : -1);
 
   tmp_b.log2_pages = new_log2_pages;
   tmp_b.offset = BV (clib_bihash_get_offset) (h, save_new_v);
   tmp_b.linear_search = mark_bucket_linear;
+  tmp_b.cache_lru = 1 << 15;
 
   CLIB_MEMORY_BARRIER ();
   b->as_u64 = tmp_b.as_u64;
-  v = BV (clib_bihash_get_value) (h, h->saved_bucket.offset);
+  v = BV (clib_bihash_get_value) (h, saved_bucket.offset);
   BV (value_free) (h, v, old_log2_pages);
 
 unlock:
-  BV (clib_bihash_reset_cache) (b);
-  BV (clib_bihash_unlock_bucket) (b);
-  CLIB_MEMORY_BARRIER ();
-  h->writer_lock[0] = 0;
+  BV (clib_bihash_reset_cache_and_unlock) (b);
+  if (h->per_bucket_lock == 0 && !have_writer_lock)
+    {
+      CLIB_MEMORY_BARRIER ();
+      h->writer_lock[0] = 0;
+    }
   return rv;
 }
 
+int BV (clib_bihash_add_del)
+  (BVT (clib_bihash) * h, BVT (clib_bihash_kv) * add_v, int is_add)
+{
+  return BV (clib_bihash_add_del_inline) (h, add_v, is_add, 0);
+}
+
+/*
+ * Same as n calls to clib_bihash_add_del, but the writer lock is taken
+ * once for all. With per-bucket locking, buckets are still locked one
+ * at a time. Returns the number of updates that failed.
+ */
+u32 BV (clib_bihash_add_del_batch)
+  (BVT (clib_bihash) * h, BVT (clib_bihash_kv) * kvs, u32 n_kvs, int is_add)
+{
+  u32 i, n_failed = 0;
+
+  if (h->per_bucket_lock == 0)
+    while (__sync_lock_test_and_set (h->writer_lock, 1))
+      ;
+
+  for (i = 0; i < n_kvs; i++)
+    if (BV (clib_bihash_add_del_inline) (h, kvs + i, is_add,
+					 1 /* have_writer_lock */ ))
+      n_failed++;
+
+  if (h->per_bucket_lock == 0)
+    {
+      CLIB_MEMORY_BARRIER ();
+      h->writer_lock[0] = 0;
+    }
+  return n_failed;
+}
+
 int BV (clib_bihash_search)
   (BVT (clib_bihash) * h,
    BVT (clib_bihash_kv) * search_key, BVT (clib_bihash_kv) * valuep)
 {
   u64 hash;
+  u64 page_hash;
   u32 bucket_index;
   BVT (clib_bihash_value) * v;
 #if BIHASH_KVP_CACHE_SIZE > 0
   BVT (clib_bihash_kv) * kvp;
 #endif
-  BVT (clib_bihash_bucket) * b;
+  BVT (clib_bihash_bucket) * b, bucket;
   int i, limit;
 
   ASSERT (valuep);
@@ -444,7 +545,10 @@ int BV (clib_bihash_search)
   bucket_index = hash & (h->nbuckets - 1);
   b = &h->buckets[bucket_index];
 
-  if (b->offset == 0)
+again:
+  bucket.as_u64 = *(volatile u64 *) &b->as_u64;
+
+  if (bucket.offset == 0)
     return -1;
 
 #if BIHASH_KVP_CACHE_SIZE > 0
@@ -465,13 +569,14 @@ int BV (clib_bihash_search)
     }
 #endif
 
-  hash >>= h->log2_nbuckets;
+  page_hash = hash >> h->log2_nbuckets;
 
-  v = BV (clib_bihash_get_value) (h, b->offset);
+  v = BV (clib_bihash_get_value) (h, bucket.offset);
   limit = BIHASH_KVP_PER_PAGE;
-  v += (b->linear_search == 0) ? hash & ((1 << b->log2_pages) - 1) : 0;
-  if (PREDICT_FALSE (b->linear_search))
-    limit <<= b->log2_pages;
+  v += (bucket.linear_search == 0) ?
+    page_hash & ((1 << bucket.log2_pages) - 1) : 0;
+  if (PREDICT_FALSE (bucket.linear_search))
+    limit <<= bucket.log2_pages;
 
   for (i = 0; i < limit; i++)
     {
@@ -496,6 +601,14 @@ int BV (clib_bihash_search)
 	  return 0;
 	}
     }
+
+  /*
+   * A miss may be an artifact of an update of the bucket racing with the
+   * search, in which case the bucket has changed; if so, look again.
+   */
+  if (PREDICT_FALSE (*(volatile u64 *) &b->as_u64 != bucket.as_u64))
+    goto again;
+
   return -1;
 }
 
@@ -78,7 +78,9 @@ typedef struct
 
     BVT (clib_bihash_value) ** working_copies;
   int *working_copy_lengths;
-    BVT (clib_bihash_bucket) saved_bucket;
+
+  /* Writers serialize per bucket, not on the writer lock */
+  u8 per_bucket_lock;
 
   u32 nbuckets;
   u32 log2_nbuckets;
@@ -164,12 +166,9 @@ static inline u8 BV (clib_bihash_get_lru) (BVT (clib_bihash_bucket) * b)
 #endif
 }
 
-static inline void BV (clib_bihash_reset_cache) (BVT (clib_bihash_bucket) * b)
+static inline u16 BV (clib_bihash_initial_lru) (void)
 {
-#if BIHASH_KVP_CACHE_SIZE > 0
-  u16 initial_lru_value;
-
-  memset (b->cache, 0xff, sizeof (b->cache));
+  u16 initial_lru_value = 0;
 
   /*
    * We'll want the cache to be loaded from slot 0 -> slot N, so
@@ -186,7 +185,14 @@ static inline void BV (clib_bihash_reset_cache) (BVT (clib_bihash_bucket) * b)
   else if (BIHASH_KVP_CACHE_SIZE == 5)
     initial_lru_value = (0 << 12) | (1 << 9) | (2 << 6) | (3 << 3) | (4 << 0);
 
-  b->cache_lru = initial_lru_value;
+  return initial_lru_value;
+}
+
+static inline void BV (clib_bihash_reset_cache) (BVT (clib_bihash_bucket) * b)
+{
+#if BIHASH_KVP_CACHE_SIZE > 0
+  memset (b->cache, 0xff, sizeof (b->cache));
+  b->cache_lru = BV (clib_bihash_initial_lru) ();
 #endif
 }
 
@@ -216,6 +222,28 @@ static inline void BV (clib_bihash_unlock_bucket)
   b->as_u64 = tmp_b.as_u64;
 }
 
+/*
+ * Empty the cache of a bucket we hold the lock of, and release the lock.
+ * The lock bit lives in cache_lru, so the new lru order and the unlock
+ * go out in a single store: the bucket is never seen unlocked with
+ * a stale cache.
+ */
+static inline void BV (clib_bihash_reset_cache_and_unlock)
+  (BVT (clib_bihash_bucket) * b)
+{
+  BVT (clib_bihash_bucket) tmp_b;
+
+  tmp_b.as_u64 = b->as_u64;
+#if BIHASH_KVP_CACHE_SIZE > 0
+  memset (b->cache, 0xff, sizeof (b->cache));
+  tmp_b.cache_lru = BV (clib_bihash_initial_lru) ();
+#else
+  tmp_b.cache_lru &= ~(1 << 15);
+#endif
+  CLIB_MEMORY_BARRIER ();
+  b->as_u64 = tmp_b.as_u64;
+}
+
 static inline void *BV (clib_bihash_get_value) (BVT (clib_bihash) * h,
 						uword offset)
 {
@@ -240,10 +268,15 @@ static inline uword BV (clib_bihash_get_offset) (BVT (clib_bihash) * h,
 void BV (clib_bihash_init)
   (BVT (clib_bihash) * h, char *name, u32 nbuckets, uword memory_size);
 
+void BV (clib_bihash_enable_per_bucket_lock) (BVT (clib_bihash) * h);
+
 void BV (clib_bihash_free) (BVT (clib_bihash) * h);
 
 int BV (clib_bihash_add_del) (BVT (clib_bihash) * h,
 			      BVT (clib_bihash_kv) * add_v, int is_add);
+u32 BV (clib_bihash_add_del_batch) (BVT (clib_bihash) * h,
+				    BVT (clib_bihash_kv) * kvs, u32 n_kvs,
+				    int is_add);
 int BV (clib_bihash_search) (BVT (clib_bihash) * h,
 			     BVT (clib_bihash_kv) * search_v,
 			     BVT (clib_bihash_kv) * return_v);
@@ -259,9 +292,10 @@ static inline int BV (clib_bihash_search_inline)
   (BVT (clib_bihash) * h, BVT (clib_bihash_kv) * key_result)
 {
   u64 hash;
+  u64 page_hash;
   u32 bucket_index;
   BVT (clib_bihash_value) * v;
-  BVT (clib_bihash_bucket) * b;
+  BVT (clib_bihash_bucket) * b, bucket;
 #if BIHASH_KVP_CACHE_SIZE > 0
   BVT (clib_bihash_kv) * kvp;
 #endif
@@ -272,7 +306,10 @@ static inline int BV (clib_bihash_search_inline)
   bucket_index = hash & (h->nbuckets - 1);
   b = &h->buckets[bucket_index];
 
-  if (b->offset == 0)
+again:
+  bucket.as_u64 = *(volatile u64 *) &b->as_u64;
+
+  if (bucket.offset == 0)
     return -1;
 
 #if BIHASH_KVP_CACHE_SIZE > 0
@@ -293,15 +330,16 @@ static inline int BV (clib_bihash_search_inline)
     }
 #endif
 
-  hash >>= h->log2_nbuckets;
+  page_hash = hash >> h->log2_nbuckets;
 
-  v = BV (clib_bihash_get_value) (h, b->offset);
+  v = BV (clib_bihash_get_value) (h, bucket.offset);
 
   /* If the bucket has unresolvable collisions, use linear search */
   limit = BIHASH_KVP_PER_PAGE;
-  v += (b->linear_search == 0) ? hash & ((1 << b->log2_pages) - 1) : 0;
-  if (PREDICT_FALSE (b->linear_search))
-    limit <<= b->log2_pages;
+  v += (bucket.linear_search == 0) ?
+    page_hash & ((1 << bucket.log2_pages) - 1) : 0;
+  if (PREDICT_FALSE (bucket.linear_search))
+    limit <<= bucket.log2_pages;
 
   for (i = 0; i < limit; i++)
     {
@@ -326,17 +364,25 @@ static inline int BV (clib_bihash_search_inline)
 	  return 0;
 	}
     }
+
+  /*
+   * A miss may be an artifact of an update of the bucket racing with the
+   * search, in which case the bucket has changed; if so, look again.
+   */
+  if (PREDICT_FALSE (*(volatile u64 *) &b->as_u64 != bucket.as_u64))
+    goto again;
+
   return -1;
 }
 
-static inline int BV (clib_bihash_search_inline_2)
-  (BVT (clib_bihash) * h,
+static inline int BV (clib_bihash_search_inline_2_with_hash)
+  (BVT (clib_bihash) * h, u64 hash,
    BVT (clib_bihash_kv) * search_key, BVT (clib_bihash_kv) * valuep)
 {
-  u64 hash;
+  u64 page_hash;
   u32 bucket_index;
   BVT (clib_bihash_value) * v;
-  BVT (clib_bihash_bucket) * b;
+  BVT (clib_bihash_bucket) * b, bucket;
 #if BIHASH_KVP_CACHE_SIZE > 0
   BVT (clib_bihash_kv) * kvp;
 #endif
@@ -344,12 +390,13 @@ static inline int BV (clib_bihash_search_inline_2)
 
   ASSERT (valuep);
 
-  hash = BV (clib_bihash_hash) (search_key);
-
   bucket_index = hash & (h->nbuckets - 1);
   b = &h->buckets[bucket_index];
 
-  if (b->offset == 0)
+again:
+  bucket.as_u64 = *(volatile u64 *) &b->as_u64;
+
+  if (bucket.offset == 0)
     return -1;
 
   /* Check the cache, if currently unlocked */
@@ -370,14 +417,15 @@ static inline int BV (clib_bihash_search_inline_2)
     }
 #endif
 
-  hash >>= h->log2_nbuckets;
-  v = BV (clib_bihash_get_value) (h, b->offset);
+  page_hash = hash >> h->log2_nbuckets;
+  v = BV (clib_bihash_get_value) (h, bucket.offset);
 
   /* If the bucket has unresolvable collisions, use linear search */
   limit = BIHASH_KVP_PER_PAGE;
-  v += (b->linear_search == 0) ? hash & ((1 << b->log2_pages) - 1) : 0;
-  if (PREDICT_FALSE (b->linear_search))
-    limit <<= b->log2_pages;
+  v += (bucket.linear_search == 0) ?
+    page_hash & ((1 << bucket.log2_pages) - 1) : 0;
+  if (PREDICT_FALSE (bucket.linear_search))
+    limit <<= bucket.log2_pages;
 
   for (i = 0; i < limit; i++)
     {
@@ -403,9 +451,90 @@ static inline int BV (clib_bihash_search_inline_2)
 	  return 0;
 	}
     }
+
+  /*
+   * A miss may be an artifact of an update of the bucket racing with the
+   * search, in which case the bucket has changed; if so, look again.
+   */
+  if (PREDICT_FALSE (*(volatile u64 *) &b->as_u64 != bucket.as_u64))
+    goto again;
+
   return -1;
 }
 
+static inline int BV (clib_bihash_search_inline_2)
+  (BVT (clib_bihash) * h,
+   BVT (clib_bihash_kv) * search_key, BVT (clib_bihash_kv) * valuep)
+{
+  u64 hash;
+
+  hash = BV (clib_bihash_hash) (search_key);
+
+  return BV (clib_bihash_search_inline_2_with_hash) (h, hash, search_key,
+						     valuep);
+}
+
+#ifndef BIHASH_SEARCH_BATCH_SIZE
+#define BIHASH_SEARCH_BATCH_SIZE 8
+#endif
+
+/*
+ * Search for n_keys keys, a group of BIHASH_SEARCH_BATCH_SIZE at a
+ * time. For each group the hashes are computed and the buckets
+ * prefetched, then the kv pages the buckets point to are prefetched,
+ * then the pages are searched; so the cache misses of the keys in a
+ * group overlap. rvs[i] is set as clib_bihash_search_inline_2 would
+ * return for search_keys[i], and valuesp[i] is the kv found.
+ * Returns the number of keys found.
+ */
+static inline int BV (clib_bihash_search_batch)
+  (BVT (clib_bihash) * h,
+   BVT (clib_bihash_kv) * search_keys,
+   BVT (clib_bihash_kv) * valuesp, int *rvs, u32 n_keys)
+{
+  u64 hashes[BIHASH_SEARCH_BATCH_SIZE];
+  BVT (clib_bihash_bucket) * b;
+  BVT (clib_bihash_value) * v;
+  u32 i, n, n_found = 0;
+
+  while (n_keys > 0)
+    {
+      n = clib_min (n_keys, BIHASH_SEARCH_BATCH_SIZE);
+
+      for (i = 0; i < n; i++)
+	{
+	  hashes[i] = BV (clib_bihash_hash) (&search_keys[i]);
+	  b = &h->buckets[hashes[i] & (h->nbuckets - 1)];
+	  CLIB_PREFETCH (b, sizeof (*b), LOAD);
+	}
+
+      for (i = 0; i < n; i++)
+	{
+	  b = &h->buckets[hashes[i] & (h->nbuckets - 1)];
+	  if (b->offset == 0)
+	    continue;
+	  v = BV (clib_bihash_get_value) (h, b->offset);
+	  if (PREDICT_TRUE (b->linear_search == 0))
+	    v += (hashes[i] >> h->log2_nbuckets) & ((1 << b->log2_pages) - 1);
+	  CLIB_PREFETCH (v, sizeof (*v), LOAD);
+	}
+
+      for (i = 0; i < n; i++)
+	{
+	  rvs[i] = BV (clib_bihash_search_inline_2_with_hash)
+	    (h, hashes[i], &search_keys[i], &valuesp[i]);
+	  n_found += (rvs[i] == 0);
+	}
+
+      search_keys += n;
+      valuesp += n;
+      rvs += n;
+      n_keys -= n;
+    }
+
+  return n_found;
+}
+
 #endif /* __included_bihash_template_h__ */
 
 /** @endcond */
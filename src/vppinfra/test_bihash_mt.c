@@ -0,0 +1,337 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Multi-threaded add/delete/lookup stress test of the bihash, with the
+ * writer lock and with per-bucket locking.
+ *
+ * Each writer thread adds, checks and deletes its own set of keys, over
+ * and over; the reader threads meanwhile lookup a set of keys that are
+ * never deleted. Readers do not lock, so a lookup racing with the reuse
+ * of the page it is searching can still miss; such misses are counted,
+ * they should be rare. The writers must not fail.
+ *
+ * Built for bihash_8_8, and for bihash_16_8 (TEST_BIHASH_MT_16_8) where
+ * lookups also fill the per-bucket kvp caches under the bucket lock.
+ */
+
+#include <vppinfra/time.h>
+#include <vppinfra/cache.h>
+#include <vppinfra/error.h>
+
+#ifdef TEST_BIHASH_MT_16_8
+#include <vppinfra/bihash_16_8.h>
+#else
+#include <vppinfra/bihash_8_8.h>
+#endif
+#include <vppinfra/bihash_template.h>
+
+#include <vppinfra/bihash_template.c>
+
+#include <pthread.h>
+
+#define MAX_THREADS 64
+
+typedef struct
+{
+  void *tm;
+  int thread_index;
+  u64 nops;
+  u64 nerrors;
+} thread_data_t;
+
+typedef struct
+{
+  u32 nbuckets;
+  u32 nitems;
+  u32 nstable;
+  u32 iterations;
+  int nwriters;
+  int nreaders;
+  volatile int writers_done;
+  u64 *stable_keys;
+    BVT (clib_bihash) hash;
+  clib_time_t clib_time;
+  unformat_input_t *input;
+  pthread_t writer_threads[MAX_THREADS];
+  pthread_t reader_threads[MAX_THREADS];
+  thread_data_t wthread_data[MAX_THREADS];
+  thread_data_t rthread_data[MAX_THREADS];
+} test_main_t;
+
+test_main_t test_main;
+
+/* Unique keys, stable keys are those of thread 0 */
+static inline u64
+test_key (int thread_index, u32 i)
+{
+  return ((((u64) thread_index << 32) | (i + 1)) * 0x9e3779b97f4a7c15ULL);
+}
+
+static inline void
+test_set_key (BVT (clib_bihash_kv) * kv, u64 key)
+{
+#ifdef TEST_BIHASH_MT_16_8
+  kv->key[0] = key;
+  kv->key[1] = key >> 32;
+#else
+  kv->key = key;
+#endif
+}
+
+static void *
+writer_thread (void *arg)
+{
+  thread_data_t *data = arg;
+  test_main_t *tm = data->tm;
+  BVT (clib_bihash) * h = &tm->hash;
+  BVT (clib_bihash_kv) kv, value;
+  u32 i, j;
+
+  /* the bihash keeps its working copies per-thread */
+  __os_thread_index = data->thread_index;
+
+  for (j = 0; j < tm->iterations; j++)
+    {
+      for (i = 0; i < tm->nitems; i++)
+	{
+	  test_set_key (&kv, test_key (data->thread_index, i));
+	  kv.value = i;
+	  BV (clib_bihash_add_del) (h, &kv, 1 /* is_add */ );
+	}
+      for (i = 0; i < tm->nitems; i++)
+	{
+	  test_set_key (&kv, test_key (data->thread_index, i));
+	  if (BV (clib_bihash_search) (h, &kv, &value) || value.value != i)
+	    data->nerrors++;
+	}
+      for (i = 0; i < tm->nitems; i++)
+	{
+	  test_set_key (&kv, test_key (data->thread_index, i));
+	  if (BV (clib_bihash_add_del) (h, &kv, 0 /* is_add */ ))
+	    data->nerrors++;
+	}
+      data->nops += 2 * tm->nitems;
+    }
+
+  return NULL;
+}
+
+static void *
+reader_thread (void *arg)
+{
+  thread_data_t *data = arg;
+  test_main_t *tm = data->tm;
+  BVT (clib_bihash) * h = &tm->hash;
+  BVT (clib_bihash_kv) kv, value;
+  u32 i;
+
+  __os_thread_index = data->thread_index;
+
+  while (!tm->writers_done)
+    {
+      for (i = 0; i < tm->nstable; i++)
+	{
+	  test_set_key (&kv, tm->stable_keys[i]);
+	  if (BV (clib_bihash_search_inline_2) (h, &kv, &value)
+	      || value.value != i)
+	    data->nerrors++;
+	}
+      data->nops += tm->nstable;
+    }
+
+  return NULL;
+}
+
+static u64
+test_bihash_mt_run (test_main_t * tm, int per_bucket_lock)
+{
+  BVT (clib_bihash) * h = &tm->hash;
+  BVT (clib_bihash_kv) kv;
+  u64 nerrors = 0, nmisses = 0, nwrites = 0, nreads = 0;
+  f64 before, delta;
+  int i;
+
+  BV (clib_bihash_init) (h, "test", tm->nbuckets, 1ULL << 30);
+  if (per_bucket_lock)
+    BV (clib_bihash_enable_per_bucket_lock) (h);
+
+  for (i = 0; i < tm->nstable; i++)
+    {
+      test_set_key (&kv, tm->stable_keys[i]);
+      kv.value = i;
+      BV (clib_bihash_add_del) (h, &kv, 1 /* is_add */ );
+    }
+
+  tm->writers_done = 0;
+  before = clib_time_now (&tm->clib_time);
+
+  /* thread index 0 is main's */
+  for (i = 0; i < tm->nreaders; i++)
+    {
+      tm->rthread_data[i] = (thread_data_t)
+      {
+      .tm = tm,.thread_index = 1 + i};
+      if (pthread_create (&tm->reader_threads[i], NULL, reader_thread,
+			  &tm->rthread_data[i]))
+	{
+	  perror ("pthread_create()");
+	  abort ();
+	}
+    }
+  for (i = 0; i < tm->nwriters; i++)
+    {
+      tm->wthread_data[i] = (thread_data_t)
+      {
+      .tm = tm,.thread_index = 1 + tm->nreaders + i};
+      if (pthread_create (&tm->writer_threads[i], NULL, writer_thread,
+			  &tm->wthread_data[i]))
+	{
+	  perror ("pthread_create()");
+	  abort ();
+	}
+    }
+
+  for (i = 0; i < tm->nwriters; i++)
+    {
+      pthread_join (tm->writer_threads[i], NULL);
+      nwrites += tm->wthread_data[i].nops;
+      nerrors += tm->wthread_data[i].nerrors;
+    }
+  delta = clib_time_now (&tm->clib_time) - before;
+
+  tm->writers_done = 1;
+  for (i = 0; i < tm->nreaders; i++)
+    {
+      pthread_join (tm->reader_threads[i], NULL);
+      nreads += tm->rthread_data[i].nops;
+      nmisses += tm->rthread_data[i].nerrors;
+    }
+
+  fformat (stdout, "%s: %d writers, %d readers\n",
+	   per_bucket_lock ? "per-bucket lock" : "writer lock",
+	   tm->nwriters, tm->nreaders);
+  if (delta > 0)
+    fformat (stdout, "  %.f add/dels per second, %.f searches per second\n",
+	     (f64) nwrites / delta, (f64) nreads / delta);
+  fformat (stdout, "  %lld add/dels, %lld searches in %.6f seconds\n",
+	   nwrites, nreads, delta);
+  fformat (stdout, "  %lld writer errors, %lld reader misses\n",
+	   nerrors, nmisses);
+
+  /* only the stable keys remain */
+  for (i = 0; i < tm->nstable; i++)
+    {
+      test_set_key (&kv, tm->stable_keys[i]);
+      if (BV (clib_bihash_add_del) (h, &kv, 0 /* is_add */ ))
+	nerrors++;
+    }
+  if (tm->nstable)
+    fformat (stdout, "%U", BV (format_bihash), h, 0 /* verbose */ );
+
+  BV (clib_bihash_free) (h);
+
+  return nerrors;
+}
+
+static clib_error_t *
+test_bihash_mt (test_main_t * tm)
+{
+  u64 nerrors;
+  int i;
+
+  for (i = 0; i < tm->nstable; i++)
+    vec_add1 (tm->stable_keys, test_key (0, i));
+
+  nerrors = test_bihash_mt_run (tm, 0);
+  nerrors += test_bihash_mt_run (tm, 1);
+
+  vec_free (tm->stable_keys);
+
+  if (nerrors)
+    return clib_error_return (0, "%lld errors", nerrors);
+  return 0;
+}
+
+clib_error_t *
+test_bihash_mt_main (test_main_t * tm)
+{
+  unformat_input_t *i = tm->input;
+
+  while (unformat_check_input (i) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (i, "nbuckets %d", &tm->nbuckets))
+	;
+      else if (unformat (i, "nitems %d", &tm->nitems))
+	;
+      else if (unformat (i, "stable %d", &tm->nstable))
+	;
+      else if (unformat (i, "iterations %d", &tm->iterations))
+	;
+      else if (unformat (i, "writers %d", &tm->nwriters))
+	;
+      else if (unformat (i, "readers %d", &tm->nreaders))
+	;
+      else
+	return clib_error_return (0, "unknown input '%U'",
+				  format_unformat_error, i);
+    }
+
+  if (tm->nwriters > MAX_THREADS || tm->nreaders > MAX_THREADS)
+    return clib_error_return (0, "at most %d writers and %d readers",
+			      MAX_THREADS, MAX_THREADS);
+
+  return test_bihash_mt (tm);
+}
+
+#ifdef CLIB_UNIX
+int
+main (int argc, char *argv[])
+{
+  unformat_input_t i;
+  clib_error_t *error;
+  test_main_t *tm = &test_main;
+
+  clib_mem_init (0, 1ULL << 30);
+
+  tm->input = &i;
+  tm->nbuckets = 1 << 16;
+  tm->nitems = 10000;
+  tm->nstable = 10000;
+  tm->iterations = 20;
+  tm->nwriters = 4;
+  tm->nreaders = 2;
+  clib_time_init (&tm->clib_time);
+
+  unformat_init_command_line (&i, argv);
+  error = test_bihash_mt_main (tm);
+  unformat_free (&i);
+
+  if (error)
+    {
+      clib_error_report (error);
+      return 1;
+    }
+  return 0;
+}
+#endif /* CLIB_UNIX */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -236,6 +236,180 @@ test_bihash (test_main_t * tm)
   return 0;
 }
 
+/*
+ * Compare the lookup rate of one-at-a-time searches with that of batched
+ * searches, in tables too large for the cache.
+ */
+static clib_error_t *
+test_bihash_batch (test_main_t * tm)
+{
+  u32 sizes[] = { 1 << 20, 10 << 20 };
+  u32 n_sizes = ARRAY_LEN (sizes);
+  u32 n_lookups = 1 << 20;
+  BVT (clib_bihash_kv) kv, *keys = 0, *values = 0;
+  u32 *order = 0;
+  int *rvs = 0;
+  BVT (clib_bihash) * h;
+  u32 i, j, k, nitems;
+  f64 before, delta;
+  uword n_found;
+
+  h = &tm->hash;
+
+  /* nitems on the command line selects a single table size */
+  if (tm->nitems != 5)
+    {
+      sizes[0] = tm->nitems;
+      n_sizes = 1;
+    }
+
+  vec_validate (keys, n_lookups - 1);
+  vec_validate (values, n_lookups - 1);
+  vec_validate (rvs, n_lookups - 1);
+  vec_validate (order, n_lookups - 1);
+
+  for (k = 0; k < n_sizes; k++)
+    {
+      nitems = sizes[k];
+
+      BV (clib_bihash_init) (h, "test", max_pow2 (nitems / 2), 2ULL << 30);
+
+      fformat (stdout, "Add %d items...\n", nitems);
+
+      /* a bijection on u64, so the keys are unique */
+      for (i = 0; i < nitems; i++)
+	{
+	  kv.key = (u64) (i + 1) * 0x9e3779b97f4a7c15ULL;
+	  kv.value = i + 1;
+	  BV (clib_bihash_add_del) (h, &kv, 1 /* is_add */ );
+	}
+
+      /* lookup the items in random order, so as to miss in the cache */
+      for (i = 0; i < n_lookups; i++)
+	{
+	  order[i] = random_u64 (&tm->seed) % nitems;
+	  keys[i].key = (u64) (order[i] + 1) * 0x9e3779b97f4a7c15ULL;
+	}
+
+      for (j = 0; j < tm->search_iter; j++)
+	{
+	  before = clib_time_now (&tm->clib_time);
+	  for (i = 0; i < n_lookups; i++)
+	    {
+	      rvs[i] = BV (clib_bihash_search_inline_2) (h, &keys[i],
+							 &values[i]);
+	    }
+	  delta = clib_time_now (&tm->clib_time) - before;
+
+	  fformat (stdout, "%d items: %.f single searches per second\n",
+		   nitems, (f64) n_lookups / delta);
+
+	  before = clib_time_now (&tm->clib_time);
+	  n_found = BV (clib_bihash_search_batch) (h, keys, values, rvs,
+						   n_lookups);
+	  delta = clib_time_now (&tm->clib_time) - before;
+
+	  fformat (stdout, "%d items: %.f batch searches per second\n",
+		   nitems, (f64) n_lookups / delta);
+
+	  if (n_found != n_lookups)
+	    clib_warning ("batch search found %lld of %d keys",
+			  n_found, n_lookups);
+	  for (i = 0; i < n_lookups; i++)
+	    if (rvs[i] || values[i].value != (u64) (order[i] + 1))
+	      clib_warning ("[%d] batch search for key %lld returned %lld, "
+			    "not %lld", i, keys[i].key, values[i].value,
+			    (u64) (order[i] + 1));
+	}
+
+      BV (clib_bihash_free) (h);
+    }
+
+  vec_free (keys);
+  vec_free (values);
+  vec_free (rvs);
+  vec_free (order);
+
+  return 0;
+}
+
+/*
+ * Add and delete the items in batches, one writer lock acquisition per
+ * batch, and check the result against one-at-a-time searches.
+ */
+static clib_error_t *
+test_bihash_add_batch (test_main_t * tm)
+{
+  u32 batch_size = 256, i, n, n_failed;
+  BVT (clib_bihash_kv) kv, *kvs = 0;
+  BVT (clib_bihash) * h;
+  f64 before, delta;
+
+  h = &tm->hash;
+
+  BV (clib_bihash_init) (h, "test", tm->nbuckets, 3ULL << 30);
+
+  vec_validate (kvs, tm->nitems - 1);
+  for (i = 0; i < tm->nitems; i++)
+    {
+      kvs[i].key = (u64) (i + 1) * 0x9e3779b97f4a7c15ULL;
+      kvs[i].value = i + 1;
+    }
+
+  fformat (stdout, "Add %d items, %d per batch...\n", tm->nitems,
+	   batch_size);
+
+  n_failed = 0;
+  before = clib_time_now (&tm->clib_time);
+  for (i = 0; i < tm->nitems; i += n)
+    {
+      n = clib_min (batch_size, tm->nitems - i);
+      n_failed += BV (clib_bihash_add_del_batch) (h, kvs + i, n,
+						  1 /* is_add */ );
+    }
+  delta = clib_time_now (&tm->clib_time) - before;
+
+  if (delta > 0)
+    fformat (stdout, "%.f batched adds per second\n", tm->nitems / delta);
+  if (n_failed)
+    return clib_error_return (0, "%d batched adds failed", n_failed);
+
+  for (i = 0; i < tm->nitems; i++)
+    {
+      kv.key = kvs[i].key;
+      if (BV (clib_bihash_search) (h, &kv, &kv) < 0)
+	return clib_error_return (0, "[%d] key %lld not found after add",
+				  i, kvs[i].key);
+      if (kv.value != (u64) (i + 1))
+	return clib_error_return (0, "[%d] key %lld has value %lld, not %d",
+				  i, kvs[i].key, kv.value, i + 1);
+    }
+
+  fformat (stdout, "Delete the items, %d per batch...\n", batch_size);
+
+  for (i = 0; i < tm->nitems; i += n)
+    {
+      n = clib_min (batch_size, tm->nitems - i);
+      n_failed += BV (clib_bihash_add_del_batch) (h, kvs + i, n,
+						  0 /* is_add */ );
+    }
+  if (n_failed)
+    return clib_error_return (0, "%d batched deletes failed", n_failed);
+
+  /* Deleting again must fail for every item */
+  n_failed = BV (clib_bihash_add_del_batch) (h, kvs, tm->nitems, 0);
+  if (n_failed != tm->nitems)
+    return clib_error_return (0, "%d of %d items left after delete",
+			      tm->nitems - n_failed, tm->nitems);
+
+  fformat (stdout, "%U", BV (format_bihash), h, 0 /* very verbose */ );
+
+  vec_free (kvs);
+  BV (clib_bihash_free) (h);
+
+  return 0;
+}
+
 clib_error_t *
 test_bihash_cache (test_main_t * tm)
 {
@@ -297,6 +471,10 @@ test_bihash_main (test_main_t * tm)
 	which = 1;
       else if (unformat (i, "cache"))
 	which = 2;
+      else if (unformat (i, "batch"))
+	which = 3;
+      else if (unformat (i, "add-batch"))
+	which = 4;
 
       else if (unformat (i, "verbose"))
 	tm->verbose = 1;
@@ -319,6 +497,14 @@ test_bihash_main (test_main_t * tm)
       error = test_bihash_cache (tm);
       break;
 
+    case 3:
+      error = test_bihash_batch (tm);
+      break;
+
+    case 4:
+      error = test_bihash_add_batch (tm);
+      break;
+
     default:
       return clib_error_return (0, "no such test?");
     }
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vppinfra/format.h>
+#include <vppinfra/random.h>
+#include <vppinfra/toeplitz.h>
+
+/* the default key from the Microsoft RSS verification suite */
+static u8 test_key[40] = {
+  0x6d, 0x5a, 0x56, 0xda, 0x25, 0x5b, 0x0e, 0xc2,
+  0x41, 0x67, 0x25, 0x3d, 0x43, 0xa3, 0x8f, 0xb0,
+  0xd0, 0xca, 0x2b, 0xcb, 0xae, 0x7b, 0x30, 0xb4,
+  0x77, 0xcb, 0x2d, 0xa3, 0x80, 0x30, 0xf2, 0x0c,
+  0x6a, 0x42, 0xb7, 0x3b, 0xbe, 0xac, 0x01, 0xfa,
+};
+
+typedef struct
+{
+  u8 src[4], dst[4];
+  u16 src_port, dst_port;
+  u32 hash_ip, hash_tcp;
+} test_toeplitz_vector_t;
+
+static test_toeplitz_vector_t test_vectors[] = {
+  {{66, 9, 149, 187}, {161, 142, 100, 80}, 2794, 1766,
+   0x323e8fc2, 0x51ccc178},
+  {{199, 92, 111, 2}, {65, 69, 140, 83}, 14230, 4739,
+   0xd718262a, 0xc626b0ea},
+  {{24, 19, 198, 95}, {12, 22, 207, 184}, 12898, 38024,
+   0xd2d0a5de, 0x5c2b394a},
+  {{38, 27, 205, 30}, {209, 142, 163, 6}, 48228, 2217,
+   0x82989176, 0xafc7327f},
+  {{153, 39, 163, 191}, {202, 188, 127, 2}, 44251, 1303,
+   0x5d1809c5, 0x10e828a2},
+};
+
+static void
+test_toeplitz_tuple (u8 * data, test_toeplitz_vector_t * v)
+{
+  clib_memcpy (data, v->src, 4);
+  clib_memcpy (data + 4, v->dst, 4);
+  data[8] = v->src_port >> 8;
+  data[9] = v->src_port;
+  data[10] = v->dst_port >> 8;
+  data[11] = v->dst_port;
+}
+
+int
+test_toeplitz_main (unformat_input_t * input)
+{
+  u8 key[CLIB_TOEPLITZ_SYMMETRIC_KEY_SIZE];
+  u8 data[12], swapped[12];
+  u32 seed = 0, n_iter = 10000;
+  u32 i, j, h;
+  int verbose = 0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "iter %d", &n_iter))
+	;
+      else if (unformat (input, "seed %d", &seed))
+	;
+      else if (unformat (input, "verbose"))
+	verbose = 1;
+      else
+	{
+	  clib_warning ("unknown input `%U'", format_unformat_error, input);
+	  return 1;
+	}
+    }
+
+  for (i = 0; i < ARRAY_LEN (test_vectors); i++)
+    {
+      test_toeplitz_vector_t *v = test_vectors + i;
+
+      test_toeplitz_tuple (data, v);
+
+      h = clib_toeplitz_hash (test_key, sizeof (test_key), data, 8);
+      if (h != v->hash_ip)
+	{
+	  clib_warning ("vector %d: ip hash 0x%08x expected 0x%08x",
+			i, h, v->hash_ip);
+	  return 1;
+	}
+
+      h = clib_toeplitz_hash (test_key, sizeof (test_key), data, 12);
+      if (h != v->hash_tcp)
+	{
+	  clib_warning ("vector %d: tcp hash 0x%08x expected 0x%08x",
+			i, h, v->hash_tcp);
+	  return 1;
+	}
+      if (verbose)
+	fformat (stdout, "vector %d: 0x%08x 0x%08x\n", i, v->hash_ip, h);
+    }
+
+  /* the symmetric key hashes both directions of a flow the same */
+  clib_toeplitz_symmetric_key (key, sizeof (key));
+  for (i = 0; i < n_iter; i++)
+    {
+      u32 a, b;
+
+      for (j = 0; j < sizeof (data); j++)
+	data[j] = random_u32 (&seed);
+
+      clib_memcpy (swapped, data + 4, 4);
+      clib_memcpy (swapped + 4, data, 4);
+      clib_memcpy (swapped + 8, data + 10, 2);
+      clib_memcpy (swapped + 10, data + 8, 2);
+
+      a = clib_toeplitz_hash (key, sizeof (key), data, sizeof (data));
+      b = clib_toeplitz_hash (key, sizeof (key), swapped, sizeof (swapped));
+      if (a != b)
+	{
+	  clib_warning ("iteration %d: symmetric hash 0x%08x != 0x%08x",
+			i, a, b);
+	  return 1;
+	}
+
+      /* linearity, which the port search in the NAT relies on */
+      memset (swapped, 0, sizeof (swapped));
+      swapped[10] = data[10];
+      swapped[11] = data[11];
+      b = clib_toeplitz_hash (key, sizeof (key), swapped, sizeof (swapped));
+      data[10] = data[11] = 0;
+      if ((clib_toeplitz_hash (key, sizeof (key), data, sizeof (data)) ^ b)
+	  != a)
+	{
+	  clib_warning ("iteration %d: hash is not linear", i);
+	  return 1;
+	}
+    }
+
+  fformat (stdout, "toeplitz: %d vectors and %d random tuples OK\n",
+	   ARRAY_LEN (test_vectors), n_iter);
+  return 0;
+}
+
+#ifdef CLIB_UNIX
+int
+main (int argc, char *argv[])
+{
+  unformat_input_t i;
+  int ret;
+
+  unformat_init_command_line (&i, argv);
+  ret = test_toeplitz_main (&i);
+  unformat_free (&i);
+
+  return ret;
+}
+#endif /* CLIB_UNIX */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
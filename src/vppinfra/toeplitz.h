@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __included_toeplitz_h__
+#define __included_toeplitz_h__
+
+#include <vppinfra/types.h>
+
+/*
+ * Toeplitz hash, as computed by NICs to spread received packets over
+ * their RSS queues. Software that needs to predict the queue a flow will
+ * arrive on computes the same hash over the same input: for IPv4 TCP and
+ * UDP that is the source address, destination address, source port and
+ * destination port, all in network byte order.
+ *
+ * The hash is linear over GF(2): hash (a ^ b) == hash (a) ^ hash (b).
+ * Zero input bytes contribute nothing and are skipped, so hashing a tuple
+ * that differs only in a couple of bytes is cheap.
+ */
+
+/*
+ * Symmetric RSS key: a repeated 16 bit pattern makes the hash of a
+ * tuple equal to the hash of the tuple with source and destination swapped,
+ * so both directions of a flow land on the same queue.
+ */
+#define CLIB_TOEPLITZ_SYMMETRIC_KEY_SIZE 40
+#define clib_toeplitz_symmetric_key_byte(i) (((i) & 1) ? 0x5a : 0x6d)
+
+always_inline u32
+clib_toeplitz_hash (const u8 * key, u32 key_len, const u8 * data,
+		    u32 n_bytes)
+{
+  u32 hash = 0;
+  u64 window;
+  u32 i, j;
+
+  for (i = 0; i < n_bytes; i++)
+    {
+      if (data[i] == 0)
+	continue;
+
+      /* the 64 key bits starting at bit 8 * i */
+      window = 0;
+      for (j = 0; j < 8; j++)
+	window = (window << 8) | (i + j < key_len ? key[i + j] : 0);
+
+      for (j = 0; j < 8; j++)
+	if (data[i] & (0x80 >> j))
+	  hash ^= (u32) ((window << j) >> 32);
+    }
+
+  return hash;
+}
+
+always_inline void
+clib_toeplitz_symmetric_key (u8 * key, u32 key_len)
+{
+  u32 i;
+
+  for (i = 0; i < key_len; i++)
+    key[i] = clib_toeplitz_symmetric_key_byte (i);
+}
+
+#endif /* __included_toeplitz_h__ */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -26,5 +26,22 @@ class TestFIB(VppTestCase):
             self.logger.critical(error)
         self.assertEqual(error.find("Failed"), -1)
 
+    def test_fib_mtrie(self):
+        """ FIB mtrie full and compressed ply comparison """
+        error = self.vapi.cli("test fib mtrie routes 20000 lookups 1000000")
+
+        if error:
+            self.logger.info(error)
+        self.assertEqual(error.find("Failed"), -1)
+
+    def test_fib_ip6_lpm(self):
+        """ FIB IPv6 binary search on prefix lengths """
+        error = self.vapi.cli("test fib ip6-lpm prefixes 20000 "
+                              "lookups 1000000")
+
+        if error:
+            self.logger.info(error)
+        self.assertEqual(error.find("Failed"), -1)
+
 if __name__ == '__main__':
     unittest.main(testRunner=VppTestRunner)
@@ -1281,6 +1281,62 @@ class TestNAT44(MethodHolder):
                 server2_n += 1
         self.assertTrue(server1_n > server2_n)
 
+    def test_static_lb_session_expire(self):
+        """ NAT44 local service load balancing session expiry """
+        external_addr_n = socket.inet_pton(socket.AF_INET, self.nat_addr)
+        external_port = 80
+        local_port = 8080
+        server1 = self.pg0.remote_hosts[0]
+        server2 = self.pg0.remote_hosts[1]
+
+        locals = [{'addr': server1.ip4n,
+                   'port': local_port,
+                   'probability': 50},
+                  {'addr': server2.ip4n,
+                   'port': local_port,
+                   'probability': 50}]
+
+        self.nat44_add_address(self.nat_addr)
+        self.vapi.nat44_add_del_lb_static_mapping(external_addr_n,
+                                                  external_port,
+                                                  IP_PROTOS.tcp,
+                                                  local_num=len(locals),
+                                                  locals=locals)
+        self.vapi.nat44_interface_add_del_feature(self.pg0.sw_if_index)
+        self.vapi.nat44_interface_add_del_feature(self.pg1.sw_if_index,
+                                                  is_inside=0)
+        self.vapi.nat_det_set_timeouts(2, 2, 2, 2)
+
+        try:
+            p = (Ether(src=self.pg1.remote_mac, dst=self.pg1.local_mac) /
+                 IP(src=self.pg1.remote_ip4, dst=self.nat_addr) /
+                 TCP(sport=12345, dport=external_port))
+            self.pg1.add_stream(p)
+            self.pg_enable_capture(self.pg_interfaces)
+            self.pg_start()
+            self.pg0.get_capture(1)
+
+            sessions = 0
+            for server in [server1, server2]:
+                sessions += len(self.vapi.nat44_user_session_dump(
+                    server.ip4n, 0))
+            self.assertEqual(sessions, 1)
+
+            sleep(10)
+
+            for server in [server1, server2]:
+                sessions = self.vapi.nat44_user_session_dump(server.ip4n, 0)
+                self.assertEqual(len(sessions), 0)
+
+            # both endpoint dependent keys of the session must be gone
+            out = self.vapi.cli("show nat44 detail")
+            for table in ["in2out-ed", "out2in-ed"]:
+                hdr = out.index("Hash table %s" % table)
+                active = out[hdr:].split("active elements")[0].split()[-1]
+                self.assertEqual(int(active), 0, "%s entries left" % table)
+        finally:
+            self.vapi.nat_det_set_timeouts()
+
     def test_multiple_inside_interfaces(self):
         """ NAT44 multiple non-overlapping address space inside interfaces """
 